@@ -22,72 +22,62 @@
 
 #include <vle/extension/decision/Agent.hpp>
 #include <vle/extension/decision/Activity.hpp>
+#include <vle/extension/decision/PlanPrototype.hpp>
 #include <vle/devs/Executive.hpp>
 #include <vle/devs/ExecutiveDbg.hpp>
 #include <vle/utils/Package.hpp>
-#include <vle/utils/Rand.hpp>
 #include <vle/utils/i18n.hpp>
 #include <boost/unordered_map.hpp>
+#include <algorithm>
 #include <fstream>
+#include <map>
 #include "global.hpp"
 #include "gnuplot.hpp"
 #include "crop.hpp"
+#include "farm-weather.hpp"
 #include "strategic.hpp"
 #include "lu.hpp"
+#include "itk.hpp"
 
 namespace safihr {
 
-struct CropSoilState
+/// Dense state of the plots of the farm, one column per attribute indexed
+/// by the plot number. It is sized from @e Farm.txt and the rotation when
+/// the farmer is built, so the facts and the predicates of a day address
+/// the plots directly.
+struct PlotStates
 {
-    CropSoilState()
-        : ru(0.0)
-        , harvestable(false)
-    {}
-
-    double ru;
-    bool harvestable;
-};
-
-struct CropSoilStateList
-{
-    void insert(const std::string& name)
+    void resize(std::size_t plots)
     {
-        lst.insert(
-            std::make_pair <std::string, CropSoilState>(
-                name, CropSoilState()));
+        ru.assign(plots, 0.0);
+        harvestable.assign(plots, 0);
+        itk.assign(plots, 0);
     }
 
-    const CropSoilState& get(const std::string& plot) const
-    {
-        const_iterator it = lst.find(plot);
-        if (it == lst.end())
-            throw vle::utils::ModellingError(
-                vle::fmt("crop soil state: unknown plot %1%") % plot);
-
-        return it->second;
-    }
+    std::size_t size() const { return ru.size(); }
 
-    CropSoilState& get(const std::string& plot)
+    /// Check the plot index of a fact or an activity metadata.
+    std::size_t check(int plot) const
     {
-        iterator it = lst.find(plot);
-        if (it == lst.end())
+        if (plot < 0 or static_cast <std::size_t>(plot) >= ru.size())
             throw vle::utils::ModellingError(
-                vle::fmt("crop soil state: unknown plot %1%") % plot);
+                vle::fmt("plot states: unknown plot %1%") % plot);
 
-        return it->second;
+        return static_cast <std::size_t>(plot);
     }
 
-    typedef std::map <std::string, CropSoilState> container_type;
-    typedef container_type::const_iterator const_iterator;
-    typedef container_type::iterator iterator;
-
-    container_type lst;
+    std::vector <double> ru; ///< Last ru received from the plot.
+    std::vector <char> harvestable; ///< The current crop is harvestable.
+    std::vector <int> itk; ///< Year of the current ITK in the rotation.
 };
 
 class Farmer : public vle::devs::Executive,
-               public vle::extension::decision::KnowledgeBase
+               public FarmWeather
 {
     typedef vle::extension::decision::Activities::result_t ActivityList;
+    typedef std::map <std::string, vle::extension::decision::PlanPrototype>
+        ItkPrototypes;
+    typedef boost::unordered_map <std::string, int> PlotPorts;
 
     Plots m_rotation;
     Crops m_crops;
@@ -137,6 +127,7 @@ class Farmer : public vle::devs::Executive,
 
             addOutputPort(operatingsystem_model_name(), lu);
             addInputPort(farmer_model_name(), lu);
+            m_plot_ports[lu] = static_cast <int>(i);
 
             createModelFromClass("class_p", lu);
             addConnection(meteo_model_name(), "out", lu, "meteo");
@@ -153,53 +144,68 @@ class Farmer : public vle::devs::Executive,
                       const vle::extension::decision::Activity& activity,
                       vle::devs::ExternalEventList& lst);
 
-    void register_facts();
-    template <typename Container>
-    void prediction_update(Container &con);
-    void rain_fact(const vle::value::Value& value);
-    void etp_fact(const vle::value::Value& value);
-    void ru_fact(const std::string& port, const vle::value::Value& value);
-    void harvestable_fact(const std::string& port, const vle::value::Value& value);
+    void ru_fact(int plot, const vle::value::Value& value);
+    void harvestable_fact(int plot, const vle::value::Value& value);
 
     void register_predicates();
-    double get_sum_rain(int day_number) const;
-    double get_sum_petp(int day_number) const;
+    unsigned int history_window(std::string* itk) const;
 
     bool is_harvestable(const std::string& activity,
                         const std::string& rule,
-                        const vle::extension::decision::PredicateParameters& param);
+                        const vle::extension::decision::ActivityMetadata& metadata,
+                        const vle::extension::decision::TypedPredicateParameters& param);
     bool is_penetrability_plot_valid(const std::string& activity, const std::string& rule,
-                                     const vle::extension::decision::PredicateParameters& param);
-    bool is_rain_quantity_valid(const std::string& activity, const std::string& rule,
-                                const vle::extension::decision::PredicateParameters& param);
-    bool is_rain_quantity_sum_valid(const std::string& activity, const std::string& rule,
-                                    const vle::extension::decision::PredicateParameters& param);
-    bool is_petp_quantity_sum_valid(const std::string& activity, const std::string& rule,
-                                    const vle::extension::decision::PredicateParameters& param);
-    bool is_etp_quantity_valid(const std::string& activity, const std::string& rule,
-                               const vle::extension::decision::PredicateParameters& param);
+                                     const vle::extension::decision::ActivityMetadata& metadata,
+                                     const vle::extension::decision::TypedPredicateParameters& param);
 
-    void strategic_assign_crop(const vle::devs::Time& time)
+    /**
+     * Get the prototype of the ITK @e filename. The prototype is built from
+     * the shared ItkCatalogue on the first call, next calls reuse it.
+     */
+    const vle::extension::decision::PlanPrototype&
+        itk_prototype(const std::string& filename)
     {
-        vle::utils::Package pack("safihr");
+        ItkPrototypes::iterator it = m_itks.find(filename);
+        if (it != m_itks.end())
+            return it->second;
+
+        return m_itks.insert(std::make_pair(
+                filename, vle::extension::decision::PlanPrototype(
+                    *this, ItkCatalogue::instance().get(filename))))
+            .first->second;
+    }
+
+    /// Get the plot of the input port @e port or -1. The ports of the land
+    /// units are known from farm_initialize, the name of another port is
+    /// parsed once.
+    int plot_of_port(const std::string& port)
+    {
+        PlotPorts::const_iterator it = m_plot_ports.find(port);
+        if (it != m_plot_ports.end())
+            return it->second;
+
+        const int plot = plot_port_index(port);
+        m_plot_ports.insert(std::make_pair(port, plot));
+        return plot;
+    }
 
+    void strategic_assign_crop(const vle::devs::Time& time)
+    {
         for (size_t i = 0, e = m_rotation.size(); i != e; ++i) {
-            m_crop_soil_state.insert((vle::fmt("p%1%") % i).str());
+            m_plots.itk[i] = 0;
 
             std::string filename = (vle::fmt("ITK0-%1%.txt") %
                                     m_rotation.get(i).current_crop()).str();
-            std::string filepath = pack.getDataFile(filename);
-            std::ifstream ifs(filepath.c_str());
-            if (not ifs.is_open())
-                throw vle::utils::ModellingError(
-                    vle::fmt("farmer: fail to open %1%") % filepath);
 
             try {
-                plan().fill(ifs, time, (vle::fmt("_%1%_p%2%") % 0 % i).str());
+                itk_prototype(filename).instantiate(
+                    time, (vle::fmt("_%1%_p%2%") % 0 % i).str(),
+                    boost::bind(&make_activity_metadata, _1, 0,
+                                static_cast <int>(i)));
             } catch (const std::exception& e) {
                 throw vle::utils::ModellingError(
                     vle::fmt("farmer: fail to read %1% (plot: %2%): %3%") %
-                    filepath % i % e.what());
+                    filename % i % e.what());
             }
 
             DTraceModel(vle::fmt("agent assign crop: %1% to plot: %2%") %
@@ -221,37 +227,36 @@ class Farmer : public vle::devs::Executive,
         if (not activity.isInDoneState())
             return;
 
-        std::string operation, crop, plot;
-        int index, year;
+        (void)name;
 
-        split_activity_name(name, &operation, &index, &crop, &year, &plot);
+        int plotid = activity.metadata().plot;
+        std::size_t plot = m_plots.check(plotid);
 
         // Cleanup previous crop harvestable boolean
-        m_crop_soil_state.get(plot).harvestable = false;
+        m_plots.harvestable[plot] = false;
+        plan().activities().factsChanged();
 
         // Get the next crop and instantiate it.
-        int plotid = boost::lexical_cast <int>(plot.substr(1, std::string::npos));
         const std::string& newcrop = m_rotation.get(plotid).next_crop();
+        m_plots.itk[plot] = static_cast <int>(m_rotation.get(plotid).current);
 
-        vle::utils::Package pack("safihr");
-        std::string filepath = pack.getDataFile((vle::fmt("ITK-%1%.txt") % newcrop).str());
+        std::string filename = (vle::fmt("ITK-%1%.txt") % newcrop).str();
 
         try {
-            std::ifstream ifs(filepath.c_str());
-
             DTraceModel(
                 vle::fmt("agent assign winter crop %1% to plot %2% with load time %3%")
                 % newcrop % plotid
                 % vle::utils::DateTime::toJulianDay(m_time + 1));
 
-            plan().fill(ifs,
-                        m_time + 1,
-                        (vle::fmt("_%1%_p%2%") % m_rotation.get(plotid).current
-                         % plotid).str());
+            itk_prototype(filename).instantiate(
+                m_time + 1,
+                (vle::fmt("_%1%_p%2%") % m_plots.itk[plot] % plotid).str(),
+                boost::bind(&make_activity_metadata, _1, m_plots.itk[plot],
+                            plotid));
         } catch (const std::exception& e) {
             throw vle::utils::ModellingError(
                 vle::fmt("farmer fails to append itk %1% from file %2% for plot %3% (%4%)")
-                % newcrop % filepath % plotid % e.what());
+                % newcrop % filename % plotid % e.what());
         }
     }
 
@@ -260,6 +265,8 @@ public:
            const vle::devs::InitEventList& evts)
         : vle::devs::Executive(mdl, evts)
         , m_prediction_size(7)
+        , m_forecast_members(16)
+        , m_history_size(0)
     {
         vle::utils::Package pack("safihr");
 
@@ -300,6 +307,12 @@ public:
                     "Crop.txt");
         }
 
+        m_plots.resize(std::max(m_lus.lus.size(), m_rotation.size()));
+
+        // Load the ITK of all the crops before the simulation, once per
+        // process.
+        ItkCatalogue::instance();
+
         if (evts.exist("prediction-size"))
             m_prediction_size = evts.getInt("prediction-size");
 
@@ -307,12 +320,74 @@ public:
             throw vle::utils::ModellingError(
                 "farmer: prediction size is too small");
 
-        m_rain_prediction.resize(m_prediction_size + 2);
-        m_etp_prediction.resize(m_prediction_size + 2);
+        // The sum_rain and sum_R-PET predicates read windows of the rain
+        // and etp histories. By default, the histories hold the largest
+        // window of the ITK, a smaller history-size would make these
+        // predicates false forever.
+        std::string window_itk;
+        unsigned int window = history_window(&window_itk);
+
+        if (evts.exist("history-size")) {
+            m_history_size = evts.getInt("history-size");
+
+            if (m_history_size <= 0)
+                throw vle::utils::ModellingError(
+                    "farmer: history size is too small");
+
+            if (static_cast <unsigned int>(m_history_size) < window)
+                throw vle::utils::ModellingError(
+                    vle::fmt("farmer: history size %1% is smaller than the "
+                             "%2% days read by the predicates of %3%")
+                    % m_history_size % window % window_itk);
+        } else {
+            m_history_size = std::max(window, 1u);
+        }
+
+        if (evts.exist("compaction"))
+            plan().activities().setCompaction(evts.getBoolean("compaction"));
+
+        if (evts.exist("predicate-cache"))
+            plan().activities().setPredicateCache(
+                evts.getBoolean("predicate-cache"));
+
+        if (evts.exist("topological-order"))
+            plan().activities().setTopologicalOrder(
+                evts.getBoolean("topological-order"));
+
+        if (evts.exist("temporal-propagation"))
+            plan().activities().setTemporalPropagation(
+                evts.getBoolean("temporal-propagation"));
+
+        if (evts.exist("process-mode")) {
+            typedef vle::extension::decision::Activities Activities;
+            const std::string& mode(evts.getString("process-mode"));
+
+            if (mode == "full-scan")
+                plan().activities().setProcessMode(Activities::FullScan);
+            else if (mode == "incremental")
+                plan().activities().setProcessMode(Activities::Incremental);
+            else if (mode == "differential")
+                plan().activities().setProcessMode(Activities::Differential);
+            else
+                throw vle::utils::ModellingError(
+                    vle::fmt("farmer: unknown process mode `%1%'") % mode);
+        }
+
+        if (evts.exist("forecast-members"))
+            m_forecast_members = evts.getInt("forecast-members");
+
+        if (m_forecast_members <= 0)
+            throw vle::utils::ModellingError(
+                "farmer: forecast members is too small");
+
+        register_weather(m_history_size, m_forecast_members,
+                         m_prediction_size);
+
+        if (evts.exist("forecast-seed"))
+            rain_forecast().seed(evts.getInt("forecast-seed"));
 
         register_updates();
         register_predicates();
-        register_facts();
         register_outputs();
     }
 
@@ -417,6 +492,7 @@ public:
                                     const vle::devs::Time& time)
     {
         m_time = time;
+        bool plots_changed = false;
 
         for (vle::devs::ExternalEventList::const_iterator it = events.begin();
              it != events.end(); ++it) {
@@ -441,29 +517,43 @@ public:
                 TraceModel("farmer receives meteo");
                 applyFact("rain", *atts.get("rain"));
                 applyFact("etp", *atts.get("etp"));
-            } else if (port[0] == 'p') {
-                TraceModel("farmer receives ru");
-                if (atts.exist("ru"))
-                    ru_fact(port, atts);
-                if (atts.exist("harvestable"))
-                    harvestable_fact(port, atts);
             } else {
-                assert(false);
-                vle::value::Map::const_iterator jt = atts.value().find("value");
-                if (jt == atts.end()) {
-                    jt = atts.value().find("init");
-                }
-
-                if (jt == atts.end() or not jt->second) {
-                    throw vle::utils::ModellingError(
-                        vle::fmt(_("Decision: no value in this message: `%1%'"))
-                        % (*it));
+                const int plot = plot_of_port(port);
+
+                if (plot >= 0) {
+                    TraceModel("farmer receives ru");
+                    if (atts.exist("ru")) {
+                        ru_fact(plot, atts);
+                        plots_changed = true;
+                    }
+                    if (atts.exist("harvestable")) {
+                        harvestable_fact(plot, atts);
+                        plots_changed = true;
+                    }
+                } else {
+                    assert(false);
+                    vle::value::Map::const_iterator jt =
+                        atts.value().find("value");
+                    if (jt == atts.end()) {
+                        jt = atts.value().find("init");
+                    }
+
+                    if (jt == atts.end() or not jt->second) {
+                        throw vle::utils::ModellingError(
+                            vle::fmt(_("Decision: no value in this message: `%1%'"))
+                            % (*it));
+                    }
+
+                    applyFact(port, *jt->second);
                 }
-
-                applyFact(port, *jt->second);
             }
         }
 
+        // The plot states are not facts of the knowledge base: notify the
+        // activities once, after all the plots of the day.
+        if (plots_changed)
+            plan().activities().factsChanged();
+
         mState = UpdateFact;
     }
 
@@ -478,16 +568,15 @@ private:
 
     vle::extension::decision::KnowledgeBase::Result mNextChangeTime;
     vle::devs::Time m_time;
-    vle::utils::Rand m_rand;
     State mState;
 
-    CropSoilStateList m_crop_soil_state;
+    PlotStates m_plots;
+    PlotPorts m_plot_ports;
+    ItkPrototypes m_itks;
 
-    std::deque <double> m_rain;
-    std::deque <double> m_etp;
-    std::vector <double> m_rain_prediction;
-    std::vector <double> m_etp_prediction;
     size_t m_prediction_size;
+    int m_forecast_members;
+    int m_history_size;
 };
 
 
@@ -512,12 +601,15 @@ void Farmer::activity_out(const std::string& name,
     (void)activity;
 
     if (activity.isInStartedState()) {
-        std::string crop, plot, order = "other";
-        split_activity_name(name, NULL, NULL, &crop, NULL, &plot);
+        const vle::extension::decision::ActivityMetadata& metadata =
+            activity.metadata();
+        std::string plot = landunit_model_name(metadata.plot);
+        const std::string& crop = metadata.crop;
+        std::string order = "other";
 
-        if (name.find("Seeding") != std::string::npos or name.find("Sowing") != std::string::npos)
+        if (metadata.operation == vle::extension::decision::ActivityOperationSow)
             order = "sow";
-        else if (name.find("Harvest") != std::string::npos)
+        else if (metadata.operation == vle::extension::decision::ActivityOperationHarvest)
             order = "harvest";
 
         vle::devs::ExternalEvent *evt = new vle::devs::ExternalEvent("os");
@@ -530,89 +622,36 @@ void Farmer::activity_out(const std::string& name,
         // the duration. Default, the duration of any activity is one day.
         double speed = 1.0;
         if (activity.speed() > 0.0)
-            speed = m_lus.lus.at(split_plot_name(plot)).sau / activity.speed();
+            speed = m_lus.lus.at(metadata.plot).sau / activity.speed();
 
         evt->putAttribute("duration", new vle::value::Double(speed));
 
         DTraceModel(vle::fmt("activity %1% sends output to %2% order %3% "
                              "for a duration of %4% (%5%/%6%)")
                     % name % plot % order % speed
-                    % m_lus.lus.at(split_plot_name(plot)).sau
+                    % m_lus.lus.at(metadata.plot).sau
                     % activity.speed());
 
         lst.push_back(evt);
     }
 }
 
-void Farmer::register_facts()
-{
-    addFacts(this) +=
-        F("rain", &Farmer::rain_fact),
-        F("etp", &Farmer::etp_fact);
-}
-
-template <typename Container>
-void Farmer::prediction_update(Container &con)
-{
-    for (size_t i = 2, e = con.size(); i != e; ++i) {
-        double sum = std::accumulate(con.begin(), con.begin() + i, 0.0);
-        double mean = sum / i;
-        double diff = std::abs(con[i - 2] - con[i - 1]);
-
-        con[i] = m_rand.normal(mean, diff == 0.0 ? 1.0 : 0.0);
-    }
-}
-
-void Farmer::rain_fact(const vle::value::Value& value)
+void Farmer::ru_fact(int plot, const vle::value::Value& value)
 {
-    double rain_quantity =  vle::value::toDouble(value);
-
-    m_rain.push_front(rain_quantity);
-
-    if (m_time)
-        m_rain_prediction[0] = m_rain_prediction[1];
-    else
-        m_rain_prediction[0] = rain_quantity;
-
-    m_rain_prediction[1] = rain_quantity;
+    double& ru = m_plots.ru[m_plots.check(plot)];
 
-    prediction_update(m_rain_prediction);
+    ru = vle::value::toMapValue(value).getDouble("ru");
 
-    TraceModel("rain_fact updated");
+    DTraceModel(vle::fmt("ru_fact for p%1%=%2%") % plot % ru);
 }
 
-void Farmer::etp_fact(const vle::value::Value& value)
-{
-    double etp_quantity = vle::value::toDouble(value);
-
-    m_etp.push_front(etp_quantity);
-
-    if (m_time)
-        m_etp_prediction[0] = m_etp_prediction[1];
-    else
-        m_etp_prediction[0] = etp_quantity;
-
-    m_etp_prediction[1] = etp_quantity;
-
-    prediction_update(m_etp_prediction);
-
-    TraceModel("etp_fact updated");
-}
-
-void Farmer::ru_fact(const std::string& port, const vle::value::Value& value)
-{
-    m_crop_soil_state.get(port).ru = vle::value::toMapValue(value).getDouble("ru");
-
-    DTraceModel(vle::fmt("ru_fact for %1%=%2%") % port % m_crop_soil_state.get(port).ru);
-}
-
-void Farmer::harvestable_fact(const std::string& port, const vle::value::Value& value)
+void Farmer::harvestable_fact(int plot, const vle::value::Value& value)
 {
     (void)value;
 
-    m_crop_soil_state.get(port).harvestable = true;
+    m_plots.harvestable[m_plots.check(plot)] = true;
 
-    DTraceModel(vle::fmt("harvestable_fact for %1%=%2%") % port % true);
+    DTraceModel(vle::fmt("harvestable_fact for p%1%=%2%") % plot % true);
 }
 
 //
@@ -621,166 +660,90 @@ void Farmer::harvestable_fact(const std::string& port, const vle::value::Value&
 
 void Farmer::register_predicates()
 {
+    // The harvestable and penetrability predicates read the plot states
+    // which are updated outside the applyFact function and must not be
+    // cached.
     addPredicates(this) +=
-        P("harvestable", &Farmer::is_harvestable),
-        P("penetrability", &Farmer::is_penetrability_plot_valid),
-        P("rain", &Farmer::is_rain_quantity_valid),
-        P("sum_rain", &Farmer::is_rain_quantity_sum_valid),
-        P("sum_R-PET", &Farmer::is_petp_quantity_sum_valid),
-        P("etp", &Farmer::is_etp_quantity_valid);
+        P("harvestable", &Farmer::is_harvestable,
+          vle::extension::decision::PredicateSignature()),
+        P("penetrability", &Farmer::is_penetrability_plot_valid,
+          vle::extension::decision::PredicateSignature()
+          .addOperator("penetrability_operator")
+          .addReal("penetrability_threshold"));
 }
 
 bool Farmer::is_harvestable(const std::string& activity,
                             const std::string& rule,
-                            const vle::extension::decision::PredicateParameters& param)
+                            const vle::extension::decision::ActivityMetadata& metadata,
+                            const vle::extension::decision::TypedPredicateParameters& param)
 {
+    (void)activity;
     (void)rule;
     (void)param;
 
-    std::string plot;
-    split_activity_name(activity, NULL, NULL, NULL, NULL, &plot);
-
-    return m_crop_soil_state.get(plot).harvestable;
+    return m_plots.harvestable[m_plots.check(metadata.plot)];
 }
 
 bool Farmer::is_penetrability_plot_valid(const std::string& activity,
                                          const std::string& rule,
-                                         const vle::extension::decision::PredicateParameters& param)
-{
-    (void)rule;
-
-    std::string op = param.getString("penetrability_operator");
-    double value = param.getDouble("penetrability_threshold");
-
-    std::string plot;
-    split_activity_name(activity, NULL, NULL, NULL, NULL, &plot);
-
-    if (op == "<")
-        return m_crop_soil_state.get(plot).ru < value;
-
-    if (op == ">=")
-        return m_crop_soil_state.get(plot).ru >= value;
-
-    if (op == "=") {
-        DTraceModel(vle::fmt("penetrability %1% %2% == %3% (%4%)")
-                    % op % value % m_crop_soil_state.get(plot).ru
-                    % (is_almost_equal(m_crop_soil_state.get(plot).ru, value)));
-
-        return is_almost_equal(m_crop_soil_state.get(plot).ru, value);
-    }
-
-    throw vle::utils::ModellingError(
-        vle::fmt("farmer predicate penetrability: unknown operator %1%") % op);
-}
-
-bool Farmer::is_rain_quantity_valid(const std::string& activity,
-                                    const std::string& rule,
-                                    const vle::extension::decision::PredicateParameters& param)
+                                         const vle::extension::decision::ActivityMetadata& metadata,
+                                         const vle::extension::decision::TypedPredicateParameters& param)
 {
     (void)activity;
     (void)rule;
 
-    std::string op = param.getString("rain_operator");
-    double value = param.getDouble("rain_threshold");
-
-    if (op == "<=")
-        return m_rain_prediction[1] <= value;
-
-    if (op == ">=")
-        return m_rain_prediction[1] >= value;
-
-    if (op == "=")
-        return is_almost_equal(m_rain_prediction[1], value);
-
-    throw vle::utils::ModellingError(
-        vle::fmt("farmer predicate rain: unknown operator %1%") % op);
-}
-
-double Farmer::get_sum_rain(int day_number) const
-{
-    if (day_number <= 2)
-        return (m_rain_prediction[0] + m_rain_prediction[1]) / 2.0;
-
-    return std::accumulate(m_rain.begin(), m_rain.begin() + day_number,
-                           0.0) / day_number;
-}
-
-double Farmer::get_sum_petp(int day_number) const
-{
-    std::vector <double> petp(day_number);
-
-    std::transform(m_rain.begin(), m_rain.begin() + day_number,
-                   m_etp.begin(),
-                   petp.begin(),
-                   std::minus <double>());
-
-    return std::accumulate(petp.begin(), petp.end(),
-                           0.0) / (double)day_number;
-}
-
-bool Farmer::is_rain_quantity_sum_valid(const std::string& activity,
-                                        const std::string& rule,
-                                        const vle::extension::decision::PredicateParameters& param)
-{
-    (void)activity;
-    (void)rule;
-
-    std::string op = param.getString("sum_rain_operator");
-    double number = param.getDouble("sum_rain_number");
-    double value = param.getDouble("sum_rain_threshold");
-
-    if (m_rain.size() < static_cast <size_t>(number)) {
-        DTraceModel(vle::fmt("Farmer: not enough rain in memory (%1%/%2%)")
-                    % number % m_rain.size());
-        return false;
+    vle::extension::decision::PredicateOperator op = param.getOperator(0);
+    double value = param.getReal(0);
+    double ru = m_plots.ru[m_plots.check(metadata.plot)];
+
+    switch (op) {
+    case vle::extension::decision::PredicateOperatorLess:
+        return ru < value;
+    case vle::extension::decision::PredicateOperatorGreaterEqual:
+        return ru >= value;
+    case vle::extension::decision::PredicateOperatorEqual:
+        DTraceModel(vle::fmt("penetrability = %1% == %2% (%3%)")
+                    % value % ru % (is_almost_equal(ru, value)));
+
+        return is_almost_equal(ru, value);
+    default:
+        break;
     }
 
-    if (op == "<=")
-        return get_sum_rain(static_cast <int>(number)) <= value;
-
     throw vle::utils::ModellingError(
-        vle::fmt("farmer predicate sum_rain: unknown operator %1%") % op);
+        vle::fmt("farmer predicate penetrability: unsupported operator %1%") %
+        vle::extension::decision::toString(op));
 }
 
-bool Farmer::is_petp_quantity_sum_valid(const std::string& activity,
-                                        const std::string& rule,
-                                        const vle::extension::decision::PredicateParameters& param)
+unsigned int Farmer::history_window(std::string* itk) const
 {
-    (void)activity;
-    (void)rule;
+    const ItkCatalogue& itks = ItkCatalogue::instance();
+    unsigned int window = 0;
 
-    std::string op = param.getString("sum_R-PET_operator");
-    double day_number = param.getDouble("sum_R-PET_number");
-    double value = param.getDouble("sum_R-PET_threshold");
+    for (ItkCatalogue::const_iterator it = itks.begin(); it != itks.end();
+         ++it) {
+        unsigned int current;
 
-    if (day_number < 0 or m_etp.size() < static_cast <size_t>(day_number)) {
-        DTraceModel(vle::fmt("Farmer: not enough etp in memory (%1%/%2%)")
-                    % day_number % m_etp.size());
-        return false;
-    }
-
-    if (op == "<=")
-        return get_sum_petp(static_cast <int>(day_number)) <= value;
-
-    throw vle::utils::ModellingError(
-        vle::fmt("farmer predicate sum_R-PET: unknown operator %1%") % op);
-}
-
-bool Farmer::is_etp_quantity_valid(const std::string& activity,
-                                   const std::string& rule,
-                                   const vle::extension::decision::PredicateParameters& param)
-{
-    (void)activity;
-    (void)rule;
+        try {
+            const vle::extension::decision::PlanBinaryView& plan =
+                it->second->view();
 
-    std::string op = param.getString("etp_operator");
-    double value = param.getDouble("etp_threshold");
+            current = std::max(
+                predicate_window(plan, "sum_rain", "sum_rain_number"),
+                predicate_window(plan, "sum_R-PET", "sum_R-PET_number"));
+        } catch (const std::exception& e) {
+            throw vle::utils::ModellingError(
+                vle::fmt("farmer: bad predicate in itk %1% (%2%)")
+                % it->first % e.what());
+        }
 
-    if (op == "<=")
-        return m_rain_prediction[1] <= value;
+        if (current > window) {
+            window = current;
+            *itk = it->first;
+        }
+    }
 
-    throw vle::utils::ModellingError(
-        vle::fmt("farmer predicate rain: unknown operator %1%") % op);
+    return window;
 }
 
 } // namespace safihr
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "farm-weather.hpp"
+#include "global.hpp"
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/Trace.hpp>
+#include <vle/utils/i18n.hpp>
+#include <vle/value/Double.hpp>
+#include <algorithm>
+
+namespace safihr {
+
+void FarmWeather::register_weather(int history_size, int members,
+                                   std::size_t prediction_size)
+{
+    addFacts(this) +=
+        F("rain", &FarmWeather::rain_fact),
+        F("etp", &FarmWeather::etp_fact);
+
+    // The rain and etp values of the latest days feed the sum_rain and
+    // sum_R-PET predicates.
+    m_rain = &addFactHistory("rain", history_size);
+    m_etp = &addFactHistory("etp", history_size);
+
+    m_rain_forecast.resize(members, prediction_size);
+
+    addPredicates(this) +=
+        P("rain", &FarmWeather::is_rain_quantity_valid,
+          vle::extension::decision::PredicateSignature()
+          .addOperator("rain_operator")
+          .addReal("rain_threshold")),
+        P("sum_rain", &FarmWeather::is_rain_quantity_sum_valid,
+          vle::extension::decision::PredicateSignature()
+          .addOperator("sum_rain_operator")
+          .addReal("sum_rain_number")
+          .addReal("sum_rain_threshold")),
+        P("sum_R-PET", &FarmWeather::is_petp_quantity_sum_valid,
+          vle::extension::decision::PredicateSignature()
+          .addOperator("sum_R-PET_operator")
+          .addReal("sum_R-PET_number")
+          .addReal("sum_R-PET_threshold")),
+        P("etp", &FarmWeather::is_etp_quantity_valid,
+          vle::extension::decision::PredicateSignature()
+          .addOperator("etp_operator")
+          .addReal("etp_threshold")),
+        P("forecast_rain", &FarmWeather::is_rain_forecast_valid,
+          vle::extension::decision::PredicateSignature()
+          .addOperator("forecast_rain_operator")
+          .addReal("forecast_rain_number")
+          .addReal("forecast_rain_threshold")
+          .addReal("forecast_rain_probability"));
+
+    // Weather predicates only read the rain and etp facts.
+    setPredicateScope("rain", vle::extension::decision::PredicateGlobal);
+    setPredicateScope("sum_rain", vle::extension::decision::PredicateGlobal);
+    setPredicateScope("sum_R-PET", vle::extension::decision::PredicateGlobal);
+    setPredicateScope("etp", vle::extension::decision::PredicateGlobal);
+    setPredicateScope("forecast_rain",
+                      vle::extension::decision::PredicateGlobal);
+}
+
+void FarmWeather::rain_fact(const vle::value::Value& value)
+{
+    double rain_quantity =  vle::value::toDouble(value);
+
+    m_rain_forecast.observe(rain_quantity);
+
+    TraceModel("rain_fact updated");
+}
+
+void FarmWeather::etp_fact(const vle::value::Value& value)
+{
+    (void)value;
+
+    TraceModel("etp_fact updated");
+}
+
+bool FarmWeather::is_rain_quantity_valid(const std::string& activity,
+                                    const std::string& rule,
+                                    const vle::extension::decision::ActivityMetadata& metadata,
+                                    const vle::extension::decision::TypedPredicateParameters& param)
+{
+    (void)activity;
+    (void)rule;
+    (void)metadata;
+
+    vle::extension::decision::PredicateOperator op = param.getOperator(0);
+    double value = param.getReal(0);
+    double rain = m_rain->empty() ? 0.0 : m_rain->at(0);
+
+    switch (op) {
+    case vle::extension::decision::PredicateOperatorLessEqual:
+        return rain <= value;
+    case vle::extension::decision::PredicateOperatorGreaterEqual:
+        return rain >= value;
+    case vle::extension::decision::PredicateOperatorEqual:
+        return is_almost_equal(rain, value);
+    default:
+        break;
+    }
+
+    throw vle::utils::ModellingError(
+        vle::fmt("farmer predicate rain: unsupported operator %1%") %
+        vle::extension::decision::toString(op));
+}
+
+double FarmWeather::get_sum_rain(int day_number) const
+{
+    if (day_number <= 2)
+        return m_rain->mean(std::min <size_t>(2u, m_rain->size()));
+
+    return m_rain->mean(day_number);
+}
+
+double FarmWeather::get_sum_petp(int day_number) const
+{
+    return (m_rain->sum(day_number) - m_etp->sum(day_number)) /
+        (double)day_number;
+}
+
+bool FarmWeather::is_rain_quantity_sum_valid(const std::string& activity,
+                                        const std::string& rule,
+                                        const vle::extension::decision::ActivityMetadata& metadata,
+                                        const vle::extension::decision::TypedPredicateParameters& param)
+{
+    (void)activity;
+    (void)rule;
+    (void)metadata;
+
+    vle::extension::decision::PredicateOperator op = param.getOperator(0);
+    double number = param.getReal(0);
+    double value = param.getReal(1);
+
+    if (m_rain->size() < static_cast <size_t>(number)) {
+        DTraceModel(vle::fmt("Farmer: not enough rain in memory (%1%/%2%)")
+                    % number % m_rain->size());
+        return false;
+    }
+
+    if (op == vle::extension::decision::PredicateOperatorLessEqual)
+        return get_sum_rain(static_cast <int>(number)) <= value;
+
+    throw vle::utils::ModellingError(
+        vle::fmt("farmer predicate sum_rain: unsupported operator %1%") %
+        vle::extension::decision::toString(op));
+}
+
+bool FarmWeather::is_petp_quantity_sum_valid(const std::string& activity,
+                                        const std::string& rule,
+                                        const vle::extension::decision::ActivityMetadata& metadata,
+                                        const vle::extension::decision::TypedPredicateParameters& param)
+{
+    (void)activity;
+    (void)rule;
+    (void)metadata;
+
+    vle::extension::decision::PredicateOperator op = param.getOperator(0);
+    double day_number = param.getReal(0);
+    double value = param.getReal(1);
+
+    if (day_number < 0 or m_etp->size() < static_cast <size_t>(day_number)
+        or m_rain->size() < static_cast <size_t>(day_number)) {
+        DTraceModel(vle::fmt("Farmer: not enough etp in memory (%1%/%2%)")
+                    % day_number % m_etp->size());
+        return false;
+    }
+
+    if (op == vle::extension::decision::PredicateOperatorLessEqual)
+        return get_sum_petp(static_cast <int>(day_number)) <= value;
+
+    throw vle::utils::ModellingError(
+        vle::fmt("farmer predicate sum_R-PET: unsupported operator %1%") %
+        vle::extension::decision::toString(op));
+}
+
+bool FarmWeather::is_etp_quantity_valid(const std::string& activity,
+                                   const std::string& rule,
+                                   const vle::extension::decision::ActivityMetadata& metadata,
+                                   const vle::extension::decision::TypedPredicateParameters& param)
+{
+    (void)activity;
+    (void)rule;
+    (void)metadata;
+
+    vle::extension::decision::PredicateOperator op = param.getOperator(0);
+    double value = param.getReal(0);
+
+    if (op == vle::extension::decision::PredicateOperatorLessEqual)
+        return (m_etp->empty() ? 0.0 : m_etp->at(0)) <= value;
+
+    throw vle::utils::ModellingError(
+        vle::fmt("farmer predicate etp: unsupported operator %1%") %
+        vle::extension::decision::toString(op));
+}
+
+bool FarmWeather::is_rain_forecast_valid(const std::string& activity,
+                                    const std::string& rule,
+                                    const vle::extension::decision::ActivityMetadata& metadata,
+                                    const vle::extension::decision::TypedPredicateParameters& param)
+{
+    (void)activity;
+    (void)rule;
+    (void)metadata;
+
+    vle::extension::decision::PredicateOperator op = param.getOperator(0);
+    double day_number = param.getReal(0);
+    double value = param.getReal(1);
+    double probability = param.getReal(2);
+
+    if (day_number < 0 or day_number > m_rain_forecast.horizon())
+        throw vle::utils::ModellingError(
+            vle::fmt("farmer predicate forecast_rain: %1% days over a "
+                     "prediction size of %2%") % day_number
+            % m_rain_forecast.horizon());
+
+    if (op == vle::extension::decision::PredicateOperatorLessEqual)
+        return m_rain_forecast.probability_sum_less_equal(
+            static_cast <size_t>(day_number), value) >= probability;
+
+    throw vle::utils::ModellingError(
+        vle::fmt("farmer predicate forecast_rain: unsupported operator %1%")
+        % vle::extension::decision::toString(op));
+}
+
+} // namespace safihr
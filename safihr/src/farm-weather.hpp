@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef SAFIHR_FARM_WEATHER_HPP
+#define SAFIHR_FARM_WEATHER_HPP
+
+#include <vle/extension/decision/KnowledgeBase.hpp>
+#include <vle/extension/decision/FactHistory.hpp>
+#include <cstddef>
+#include <string>
+#include "forecast.hpp"
+
+namespace safihr {
+
+/// Knowledge base of the weather of the farm: the rain and etp facts, their
+/// histories, the rain forecast and the predicates which read them. The
+/// Farmer derives from it and adds the predicates of the plots.
+class FarmWeather : public vle::extension::decision::KnowledgeBase
+{
+public:
+    FarmWeather()
+        : m_rain(0), m_etp(0)
+    {}
+
+    virtual ~FarmWeather()
+    {}
+
+    /// Add the rain and etp facts, with histories of @e history_size days,
+    /// a forecast of @e members trajectories over @e prediction_size days
+    /// and the rain, sum_rain, sum_R-PET, etp and forecast_rain predicates.
+    void register_weather(int history_size, int members,
+                          std::size_t prediction_size);
+
+    Forecast& rain_forecast() { return m_rain_forecast; }
+
+private:
+    void rain_fact(const vle::value::Value& value);
+    void etp_fact(const vle::value::Value& value);
+
+    double get_sum_rain(int day_number) const;
+    double get_sum_petp(int day_number) const;
+
+    bool is_rain_quantity_valid(const std::string& activity, const std::string& rule,
+                                const vle::extension::decision::ActivityMetadata& metadata,
+                                const vle::extension::decision::TypedPredicateParameters& param);
+    bool is_rain_quantity_sum_valid(const std::string& activity, const std::string& rule,
+                                    const vle::extension::decision::ActivityMetadata& metadata,
+                                    const vle::extension::decision::TypedPredicateParameters& param);
+    bool is_petp_quantity_sum_valid(const std::string& activity, const std::string& rule,
+                                    const vle::extension::decision::ActivityMetadata& metadata,
+                                    const vle::extension::decision::TypedPredicateParameters& param);
+    bool is_etp_quantity_valid(const std::string& activity, const std::string& rule,
+                               const vle::extension::decision::ActivityMetadata& metadata,
+                               const vle::extension::decision::TypedPredicateParameters& param);
+    bool is_rain_forecast_valid(const std::string& activity, const std::string& rule,
+                                const vle::extension::decision::ActivityMetadata& metadata,
+                                const vle::extension::decision::TypedPredicateParameters& param);
+
+    const vle::extension::decision::FactHistory <double>* m_rain;
+    const vle::extension::decision::FactHistory <double>* m_etp;
+    Forecast m_rain_forecast;
+};
+
+}
+
+#endif
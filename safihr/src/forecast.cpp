@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "forecast.hpp"
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/i18n.hpp>
+#include <cmath>
+
+namespace safihr {
+
+namespace {
+
+/// The default state and the multiplier of the xorshift64* generator,
+/// built from 32 bits halves: C++03 has no 64 bits literals.
+const boost::uint64_t default_state =
+    (static_cast <boost::uint64_t>(0x9E3779B9UL) << 32) | 0x7F4A7C15UL;
+const boost::uint64_t multiplier =
+    (static_cast <boost::uint64_t>(0x2545F491UL) << 32) | 0x4F6CDD1DUL;
+
+}
+
+Forecast::Forecast()
+    : m_members(0)
+    , m_horizon(0)
+    , m_previous(0.0)
+    , m_latest(0.0)
+    , m_mean(0.0)
+    , m_m2(0.0)
+    , m_count(0)
+    , m_state(default_state)
+{
+}
+
+void Forecast::resize(std::size_t members, std::size_t horizon)
+{
+    if (members == 0 or horizon == 0)
+        throw vle::utils::ModellingError(
+            vle::fmt("forecast: bad ensemble of %1% members over %2% days")
+            % members % horizon);
+
+    m_members = members;
+    m_horizon = horizon;
+
+    m_values.assign(members * horizon, 0.0);
+    m_sums.assign(members * horizon, 0.0);
+    m_noise.assign(members * horizon + 1, 0.0);
+    m_running.assign(members, 0.0);
+    m_means.assign(horizon, 0.0);
+
+    m_previous = m_latest = m_mean = m_m2 = 0.0;
+    m_count = 0;
+}
+
+void Forecast::seed(boost::uint64_t seed)
+{
+    m_state = seed ? seed : default_state;
+}
+
+void Forecast::draw()
+{
+    const std::size_t size = m_noise.size() & ~std::size_t(1);
+    double *noise = &m_noise[0];
+    boost::uint64_t state = m_state;
+
+    for (std::size_t i = 0; i != size; ++i) {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+
+        // 53 random bits in (0, 1]: the logarithm below stays finite.
+        noise[i] = ((state * multiplier >> 11) + 1.0) *
+            (1.0 / 9007199254740992.0);
+    }
+
+    m_state = state;
+
+    const double two_pi = 6.283185307179586;
+    for (std::size_t i = 0; i != size; i += 2) {
+        const double radius = std::sqrt(-2.0 * std::log(noise[i]));
+        const double angle = two_pi * noise[i + 1];
+
+        noise[i] = radius * std::cos(angle);
+        noise[i + 1] = radius * std::sin(angle);
+    }
+}
+
+void Forecast::observe(double value)
+{
+    if (m_members == 0)
+        throw vle::utils::ModellingError(
+            "forecast: observation of an empty ensemble");
+
+    m_previous = m_count ? m_latest : value;
+    m_latest = value;
+
+    ++m_count;
+    const double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+
+    const double sigma = m_count > 1 ? std::sqrt(m_m2 / (m_count - 1)) : 0.0;
+    const std::size_t members = m_members;
+
+    draw();
+
+    double *running = &m_running[0];
+    for (std::size_t k = 0; k != members; ++k)
+        running[k] = m_previous + m_latest;
+
+    for (std::size_t day = 0; day != m_horizon; ++day) {
+        const double inverse = 1.0 / (day + 2);
+        const double *noise = &m_noise[day * members];
+        const double *before = day ? &m_sums[(day - 1) * members] : 0;
+        double *values = &m_values[day * members];
+        double *sums = &m_sums[day * members];
+        double total = 0.0;
+
+        for (std::size_t k = 0; k != members; ++k) {
+            double x = running[k] * inverse + sigma * noise[k];
+            x = x < 0.0 ? 0.0 : x;
+
+            values[k] = x;
+            running[k] += x;
+            sums[k] = before ? before[k] + x : x;
+            total += x;
+        }
+
+        m_means[day] = total / members;
+    }
+}
+
+double Forecast::expected_sum(std::size_t days) const
+{
+    if (days > m_horizon)
+        throw vle::utils::ModellingError(
+            vle::fmt("forecast: %1% days over a horizon of %2% days")
+            % days % m_horizon);
+
+    double result = 0.0;
+    for (std::size_t day = 0; day != days; ++day)
+        result += m_means[day];
+
+    return result;
+}
+
+double Forecast::probability_sum_less_equal(std::size_t days,
+                                            double threshold) const
+{
+    if (days > m_horizon)
+        throw vle::utils::ModellingError(
+            vle::fmt("forecast: %1% days over a horizon of %2% days")
+            % days % m_horizon);
+
+    if (days == 0)
+        return threshold >= 0.0 ? 1.0 : 0.0;
+
+    const double *sums = &m_sums[(days - 1) * m_members];
+    std::size_t count = 0;
+
+    for (std::size_t k = 0; k != m_members; ++k)
+        count += sums[k] <= threshold;
+
+    return static_cast <double>(count) / m_members;
+}
+
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SAFIHR_FORECAST_HPP
+#define SAFIHR_FORECAST_HPP
+
+#include <boost/cstdint.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace safihr {
+
+/// Ensemble forecast of a daily weather variable, rain or etp. Each of the
+/// @e members trajectories covers the next @e horizon days: the value of a
+/// day is drawn from a normal law centred on the mean of the trajectory so
+/// far (the two latest observations and the previous forecast days) with
+/// the standard deviation of the observations. Values are clamped at zero.
+///
+/// The trajectories are stored day-major in contiguous arrays: the members
+/// of one day are adjacent, so that each update loop runs over the members
+/// with running sums and a day costs O(members * horizon).
+class Forecast
+{
+public:
+    Forecast();
+
+    /// Resize the ensemble and forget the observations.
+    void resize(std::size_t members, std::size_t horizon);
+
+    /// Seed the random generator of the ensemble.
+    void seed(boost::uint64_t seed);
+
+    /// Add the value observed today and draw a new ensemble.
+    void observe(double value);
+
+    /// Get the value of the day @e day (0 is tomorrow) of a member.
+    double value(std::size_t day, std::size_t member) const
+    { return m_values[day * m_members + member]; }
+
+    /// Get the ensemble mean of the day @e day (0 is tomorrow).
+    double mean(std::size_t day) const { return m_means[day]; }
+
+    /// Get the ensemble mean of the total over the next @e days days.
+    double expected_sum(std::size_t days) const;
+
+    /// Get the probability that the total over the next @e days days is
+    /// less than or equal to @e threshold: the proportion of members.
+    /// @throw vle::utils::ModellingError if @e days exceeds the horizon.
+    double probability_sum_less_equal(std::size_t days,
+                                      double threshold) const;
+
+    std::size_t members() const { return m_members; }
+    std::size_t horizon() const { return m_horizon; }
+    std::size_t observations() const { return m_count; }
+
+private:
+    /// Fill m_noise with standard normal deviates: the uniforms are drawn
+    /// in a first loop and transformed by pairs (Box-Muller) in a second.
+    void draw();
+
+    std::size_t m_members;
+    std::size_t m_horizon;
+
+    std::vector <double> m_values; ///< horizon * members forecast values.
+    std::vector <double> m_sums; ///< horizon * members cumulative totals.
+    std::vector <double> m_noise; ///< horizon * members normal deviates.
+    std::vector <double> m_running; ///< members running trajectory sums.
+    std::vector <double> m_means; ///< horizon ensemble means.
+
+    double m_previous; ///< The observation of yesterday.
+    double m_latest; ///< The observation of today.
+    double m_mean; ///< Running mean of the observations.
+    double m_m2; ///< Running sum of squared deviations (Welford).
+    std::size_t m_count;
+
+    boost::uint64_t m_state; ///< xorshift64* state.
+};
+
+}
+
+#endif
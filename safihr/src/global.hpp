@@ -27,11 +27,13 @@
 #include <vle/utils/i18n.hpp>
 #include <vle/utils/DateTime.hpp>
 #include <vle/utils/Exception.hpp>
+#include <vle/extension/decision/ActivityMetadata.hpp>
 #include <boost/algorithm/string/iter_find.hpp>
 #include <boost/algorithm/string/finder.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/cast.hpp>
+#include <algorithm>
 #include <exception>
 #include <limits>
 #include <map>
@@ -83,6 +85,28 @@ inline int split_plot_name(const std::string& plotname)
     }
 }
 
+/**
+ * Get the plot index of the input port @e p<i> of the farmer. The name is
+ * read in place: no allocation, no exception.
+ *
+ * @return the plot index or -1 if @e port is not a plot port.
+ */
+inline int plot_port_index(const std::string& port)
+{
+    if (port.size() < 2 or port.size() > 10 or port[0] != 'p')
+        return -1;
+
+    int plot = 0;
+    for (std::string::size_type i = 1, e = port.size(); i != e; ++i) {
+        if (port[i] < '0' or port[i] > '9')
+            return -1;
+
+        plot = plot * 10 + (port[i] - '0');
+    }
+
+    return plot;
+}
+
 /**
  * From the current @time, compute the next 1 january.
  *
@@ -164,6 +188,58 @@ inline void split_activity_name(const std::string& activity,
     }
 }
 
+/**
+ * Build the metadata of an activity from its identifier in an ITK file
+ * (operation_crop or operation_index_crop, the index is made of digits),
+ * the year of the ITK and the plot. Called for each activity when the ITK
+ * is loaded, the identifier is read in place.
+ */
+inline vle::extension::decision::ActivityMetadata
+make_activity_metadata(const std::string& id, int year, int plot)
+{
+    vle::extension::decision::ActivityMetadata metadata;
+
+    metadata.year = year;
+    metadata.plot = plot;
+
+    std::string::size_type first = id.find('_');
+    std::string::size_type last = id.rfind('_');
+
+    if (first == std::string::npos)
+        throw vle::utils::ModellingError(
+            vle::fmt("Bad activity name: %1%") % id);
+
+    metadata.crop.assign(id, last + 1, std::string::npos);
+
+    if (first != last) {
+        if (last - first < 2 or last - first > 10)
+            throw vle::utils::ModellingError(
+                vle::fmt("Bad activity name: %1%") % id);
+
+        metadata.index = 0;
+        for (std::string::size_type i = first + 1; i != last; ++i) {
+            if (id[i] < '0' or id[i] > '9')
+                throw vle::utils::ModellingError(
+                    vle::fmt("Bad activity name: %1%") % id);
+
+            metadata.index = metadata.index * 10 + (id[i] - '0');
+        }
+    }
+
+    std::string::const_iterator operation = id.begin() + first;
+
+    if (std::search(id.begin(), operation, "Seeding", "Seeding" + 7) !=
+        operation or
+        std::search(id.begin(), operation, "Sowing", "Sowing" + 6) !=
+        operation)
+        metadata.operation = vle::extension::decision::ActivityOperationSow;
+    else if (std::search(id.begin(), operation, "Harvest", "Harvest" + 7) !=
+             operation)
+        metadata.operation = vle::extension::decision::ActivityOperationHarvest;
+
+    return metadata;
+}
+
 inline double stod(const std::string &str)
 {
     try {
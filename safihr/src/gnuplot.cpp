@@ -334,36 +334,75 @@ struct grantt_observation
         : min(vle::devs::infinity)
         , max(vle::devs::negativeInfinity)
     {
+        typedef std::map < std::string,
+                const vle::extension::decision::ArchivedActivity* > archived_t;
+
         vle::extension::decision::Activities::const_iterator it, et;
-        std::string operation, crop, plot;
-        int index, year;
+        archived_t archived;
+        archived_t::const_iterator jt, ft;
+
+        /* Archived activities are merged by name with the activities to keep
+         * the order of the output. */
+        for (vle::extension::decision::ActivityArchive::const_iterator at =
+                 activities.archive().begin();
+             at != activities.archive().end(); ++at)
+            archived[at->first] = &at->second;
+
+        it = activities.begin();
+        et = activities.end();
+        jt = archived.begin();
+        ft = archived.end();
+
+        while (it != et or jt != ft) {
+            if (jt == ft or (it != et and it->first < jt->first)) {
+                insert(it->first, it->second);
+                ++it;
+            } else {
+                insert(jt->first, *jt->second);
+                ++jt;
+            }
+        }
 
-        for (it = activities.begin(), et = activities.end();  it != et; ++it) {
-            split_activity_name(it->first, &operation, &index, &crop, &year, &plot);
+        crops.sort();
+        plots.sort();
+        all.sort();
+    }
 
-            double begin = it->second.startedDate();
-            if (vle::devs::isInfinity(begin))
-                continue;
+    template <typename T>
+    void insert(const std::string& name, const T& activity)
+    {
+        const vle::extension::decision::ActivityMetadata& metadata =
+            activity.metadata();
+        std::string operation, crop, plot;
+        int index, year;
 
-            double end = it->second.doneDate();
-            if (vle::devs::isInfinity(end)) {
-                end = it->second.ffDate();
-                if (vle::devs::isInfinity(end))
-                    continue;
-            }
+        if (metadata.plot >= 0) {
+            operation = name.substr(0, name.find('_'));
+            crop = metadata.crop;
+            year = metadata.year;
+            plot = landunit_model_name(metadata.plot);
+        } else {
+            split_activity_name(name, &operation, &index, &crop, &year, &plot);
+        }
 
-            min = std::min(min, begin);
-            max = std::max(max, end);
+        double begin = activity.startedDate();
+        if (vle::devs::isInfinity(begin))
+            return;
 
-            crops.insert(crop, plot, operation, year, begin, end);
-            plots.insert(crop, plot, operation, year, begin, end);
-            all.insert(crop, plot, operation, year, begin, end);
-            csv.insert(crop, plot, operation, year, begin, end);
+        double end = activity.doneDate();
+        if (vle::devs::isInfinity(end)) {
+            end = activity.ffDate();
+            if (vle::devs::isInfinity(end))
+                return;
         }
 
-        crops.sort();
-        plots.sort();
-        all.sort();
+        min = std::min(min, begin);
+        max = std::max(max, end);
+
+        crops.insert(crop, plot, operation, year, begin, end);
+        plots.insert(crop, plot, operation, year, begin, end);
+        all.insert(crop, plot, operation, year, begin, end);
+        csv.insert(crop, plot, operation, year, begin, end);
     }
 
     void write()
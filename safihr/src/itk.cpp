@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "itk.hpp"
+#include "crop.hpp"
+#include <vle/extension/decision/PlanBinary.hpp>
+#include <vle/utils/Package.hpp>
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/i18n.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <set>
+
+namespace safihr {
+
+namespace {
+
+/// A pool of ITK files read by the workers. Each worker takes the next file
+/// until the list is empty.
+struct ItkLoader
+{
+    ItkLoader(const std::vector <std::string>& files)
+        : files(files), plans(files.size()), errors(files.size()), next(0)
+    {}
+
+    void work()
+    {
+        for (;;) {
+            std::vector <std::string>::size_type i;
+
+            {
+                boost::mutex::scoped_lock lock(mutex);
+                if (next == files.size())
+                    return;
+                i = next++;
+            }
+
+            try {
+                plans[i].reset(new vle::extension::decision::PlanBinaryFile(
+                        files[i]));
+                errors[i] = validate_itk(plans[i]->view());
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        }
+    }
+
+    const std::vector <std::string>& files;
+    std::vector <ItkCatalogue::container_type::mapped_type> plans;
+    std::vector <std::string> errors;
+    std::vector <std::string>::size_type next;
+    boost::mutex mutex;
+};
+
+boost::once_flag catalogue_flag = BOOST_ONCE_INIT;
+boost::scoped_ptr <ItkCatalogue> catalogue;
+
+/// Read the crops and load the catalogue. If it throws, the flag stays
+/// unset and the next call to ItkCatalogue::instance tries again.
+void load_catalogue()
+{
+    vle::utils::Package pack("safihr");
+
+    std::ifstream ifs(pack.getDataFile("Crop.txt").c_str());
+    if (not ifs.is_open())
+        throw vle::utils::ModellingError(
+            vle::fmt("itk: fails to open %1%") % "Crop.txt");
+
+    Crops crops;
+    ifs >> crops;
+    if (ifs.fail())
+        throw vle::utils::ModellingError(
+            vle::fmt("itk: error while reading file %1%") % "Crop.txt");
+
+    std::string datadir = boost::filesystem::path(
+        pack.getDataFile("Crop.txt")).parent_path().string();
+
+    catalogue.reset(new ItkCatalogue(crops, datadir,
+                                     boost::thread::hardware_concurrency()));
+}
+
+}
+
+const ItkCatalogue& ItkCatalogue::instance()
+{
+    boost::call_once(catalogue_flag, &load_catalogue);
+
+    return *catalogue;
+}
+
+ItkCatalogue::ItkCatalogue(const Crops& crops, const std::string& datadir,
+                           unsigned int workers)
+{
+    std::vector <std::string> names, files;
+
+    for (Crops::const_iterator it = crops.crops.begin(),
+         et = crops.crops.end(); it != et; ++it) {
+        names.push_back((vle::fmt("ITK0-%1%.txt") % it->id).str());
+        names.push_back((vle::fmt("ITK-%1%.txt") % it->id).str());
+    }
+
+    for (size_t i = 0, e = names.size(); i != e; ++i)
+        files.push_back((boost::filesystem::path(datadir) /
+                         names[i]).string());
+
+    ItkLoader loader(files);
+
+    workers = std::max(1u, std::min(workers,
+                                    static_cast <unsigned int>(files.size())));
+
+    boost::thread_group group;
+    for (unsigned int i = 1; i < workers; ++i)
+        group.create_thread(boost::bind(&ItkLoader::work, &loader));
+
+    loader.work();
+    group.join_all();
+
+    for (size_t i = 0, e = files.size(); i != e; ++i) {
+        if (not loader.errors[i].empty())
+            m_errors[names[i]] = loader.errors[i];
+        else
+            m_itks[names[i]] = loader.plans[i];
+    }
+}
+
+const vle::extension::decision::PlanBinaryView&
+ItkCatalogue::get(const std::string& filename) const
+{
+    const_iterator it = m_itks.find(filename);
+
+    if (it == m_itks.end()) {
+        errors_type::const_iterator error = m_errors.find(filename);
+
+        if (error != m_errors.end())
+            throw vle::utils::ModellingError(
+                vle::fmt("itk: invalid ITK file %1%: %2%") % filename
+                % error->second);
+
+        throw vle::utils::ModellingError(
+            vle::fmt("itk: unknown ITK file %1%") % filename);
+    }
+
+    return it->second->view();
+}
+
+std::string validate_itk(const vle::extension::decision::PlanBinaryView& plan)
+{
+    typedef vle::extension::decision::PlanBinaryView view_type;
+
+    std::set <std::string> ids;
+
+    for (boost::uint32_t i = 0; i < plan.activities(); ++i) {
+        view_type::Activity act = plan.activity(i);
+
+        if (not ids.insert(act.id).second)
+            return (vle::fmt("activity %1% defined twice") % act.id).str();
+    }
+
+    if (ids.empty())
+        return "no activity";
+
+    for (boost::uint32_t i = 0; i < plan.precedences(); ++i) {
+        view_type::Precedence prec = plan.precedence(i);
+        const char* keys[] = { "first", "second" };
+        const char* names[] = { prec.firstName, prec.secondName };
+        boost::uint32_t indices[] = { prec.first, prec.second };
+
+        for (int k = 0; k < 2; ++k) {
+            if (*names[k] == '\0')
+                return (vle::fmt("precedence without %1%") % keys[k]).str();
+
+            if (indices[k] == view_type::npos)
+                return (vle::fmt("precedence with unknown activity %1%") %
+                        names[k]).str();
+        }
+    }
+
+    return std::string();
+}
+
+unsigned int predicate_window(const vle::extension::decision::PlanBinaryView& plan,
+                              const std::string& type,
+                              const std::string& parameter)
+{
+    typedef vle::extension::decision::PlanBinaryView view_type;
+
+    unsigned int window = 0;
+
+    for (boost::uint32_t i = 0; i < plan.predicates(); ++i) {
+        view_type::Predicate pred = plan.predicate(i);
+
+        if (not pred.type or type != pred.type)
+            continue;
+
+        for (boost::uint32_t j = 0; j < pred.parameters; ++j) {
+            view_type::Parameter param = plan.parameter(pred.parameter + j);
+
+            if (parameter != param.name)
+                continue;
+
+            if (param.type != view_type::ParameterReal or
+                not (param.real >= 1.0 and param.real <= 100000.0) or
+                param.real != std::floor(param.real))
+                throw vle::utils::ModellingError(
+                    vle::fmt("predicate %1%: %2% must be a positive number "
+                             "of days") % pred.id % parameter);
+
+            window = std::max(window, static_cast <unsigned int>(param.real));
+        }
+    }
+
+    return window;
+}
+
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef SAFIHR_ITK_HPP
+#define SAFIHR_ITK_HPP
+
+#include <vle/extension/decision/PlanBinary.hpp>
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace safihr {
+
+struct Crops;
+
+/// The ITK catalogue stores the compiled plans of all the crops: @e
+/// ITK0-id.txt for the first year and @e ITK-id.txt for the next years. A
+/// plan compiled by @e decision-compile next to its text is mapped into
+/// memory, other plans are compiled while the catalogue is loaded.
+/// It is loaded once per process, in parallel, and then only read: all the
+/// Farmer instances share it without lock. An ITK which fails to load does
+/// not fail the catalogue: its error is kept and thrown by the get
+/// function, when a Farmer uses this ITK.
+class ItkCatalogue
+{
+public:
+    typedef std::map <std::string,
+                      boost::shared_ptr <vle::extension::decision::PlanBinaryFile> >
+        container_type;
+    typedef container_type::const_iterator const_iterator;
+
+    typedef std::map <std::string, std::string> errors_type;
+
+    /// Get the catalogue of the process. The first call reads the crops of
+    /// @e Crop.txt and loads their ITK from the data of the @e safihr
+    /// package. It is thread-safe.
+    /// @throw vle::utils::ModellingError if @e Crop.txt cannot be read,
+    /// the next call tries again.
+    static const ItkCatalogue& instance();
+
+    /// Load the ITK of the crops from the directory @e datadir with at most
+    /// @e workers threads.
+    ItkCatalogue(const Crops& crops, const std::string& datadir,
+                 unsigned int workers);
+
+    /// Get the plan of the ITK file @e filename, for example @e
+    /// ITK-W.txt.
+    /// @throw vle::utils::ModellingError if the ITK is unknown or if it
+    /// failed to load.
+    const vle::extension::decision::PlanBinaryView&
+        get(const std::string& filename) const;
+
+    /// Get the errors of the ITK which failed to load, by file name.
+    const errors_type& errors() const { return m_errors; }
+
+    const_iterator begin() const { return m_itks.begin(); }
+    const_iterator end() const { return m_itks.end(); }
+    container_type::size_type size() const { return m_itks.size(); }
+
+private:
+    container_type m_itks; ///< The ITK loaded.
+    errors_type m_errors; ///< The error of each ITK which failed to load.
+};
+
+/// Check the activities and the precedences of an ITK: each activity has an
+/// identifier and each precedence links two activities of the ITK.
+/// @return an empty string or the description of the first error.
+std::string validate_itk(const vle::extension::decision::PlanBinaryView& plan);
+
+/// Get the largest number of days read by the predicates of type @e type
+/// in @e plan, given by their real parameter @e parameter, or 0 if no
+/// predicate has this type.
+/// @throw vle::utils::ModellingError if a number of days is not a
+/// positive integer.
+unsigned int predicate_window(const vle::extension::decision::PlanBinaryView& plan,
+                              const std::string& type,
+                              const std::string& parameter);
+
+}
+
+#endif
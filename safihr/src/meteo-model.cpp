@@ -23,71 +23,43 @@
 #include <vle/devs/Dynamics.hpp>
 #include <vle/devs/DynamicsDbg.hpp>
 #include <vle/utils/Package.hpp>
-#include <boost/algorithm/string.hpp>
-#include <fstream>
 #include <string>
-#include <deque>
-#include <exception>
 #include "global.hpp"
+#include "meteo.hpp"
 
 namespace safihr {
 
-struct MeteoData
-{
-    double rain;
-    double etp;
-};
-
-std::istream& operator>>(std::istream &is, MeteoData &data)
-{
-    std::string temp;
-
-    return is >> temp >> data.rain >> data.etp;
-}
-
-struct MeteoCompletedata
-{
-    std::deque <MeteoData> data;
-};
-
-std::istream& operator>>(std::istream &is, MeteoCompletedata &data)
-{
-    while (is) {
-        data.data.push_back(MeteoData());
-
-        is >> data.data.back();
-        if (is.fail()) {
-            data.data.pop_back();         // the pushed MeteoData
-            is.setstate(std::ios::eofbit);
-            return is;
-        }
-    }
-
-    return is;
-}
-
 class Meteo : public vle::devs::Dynamics
 {
-    MeteoCompletedata m_data;
-    size_t m_it;
+    MeteoTable m_data;
+    vle::devs::Time m_begin;
+    size_t m_day;
+
+    /// Get the row of the date @e time: the number of days since the
+    /// beginning of the simulation, the data are read again from the first
+    /// row when they are exhausted.
+    size_t day(const vle::devs::Time& time) const
+    {
+        return static_cast <size_t>(time - m_begin + 0.5) % m_data.size();
+    }
 
 public:
     Meteo(const vle::devs::DynamicsInit &init,
           const vle::devs::InitEventList &evts)
         : vle::devs::Dynamics(init, evts)
+        , m_begin(0.0)
+        , m_day(0)
     {
         vle::utils::Package package("safihr");
 
-        std::ifstream file(
-            package.getDataFile(evts.getString("filename")).c_str());
-
-        if (!file)
-            throw std::runtime_error("meteo: failed to open data");
+        bool cache = true;
+        if (evts.exist("cache"))
+            cache = evts.getBoolean("cache");
 
-        std::string header;
-        std::getline(file, header);
+        m_data.load(package.getDataFile(evts.getString("filename")), cache);
 
-        file >> m_data;
+        if (m_data.empty())
+            throw vle::utils::ModellingError("meteo: empty data");
     }
 
     virtual ~Meteo()
@@ -96,9 +68,8 @@ public:
 
     virtual vle::devs::Time init(const vle::devs::Time &time)
     {
-        (void)time;
-
-        m_it = 0;
+        m_begin = time;
+        m_day = 0;
 
         return 0.0;
     }
@@ -110,12 +81,7 @@ public:
 
     virtual void internalTransition(const vle::devs::Time &time)
     {
-        (void)time;
-
-        if (m_it == m_data.data.size())
-            m_it = 0;
-        else
-            ++m_it;
+        m_day = day(time + timeAdvance());
     }
 
     virtual void output(const vle::devs::Time &time,
@@ -126,8 +92,8 @@ public:
         vle::devs::ExternalEvent *ret = new vle::devs::ExternalEvent("out");
         vle::value::Map &msg = ret->attributes();
 
-        msg.addDouble("rain", m_data.data[m_it].rain);
-        msg.addDouble("etp", m_data.data[m_it].etp);
+        msg.addDouble("rain", m_data.rain(m_day));
+        msg.addDouble("etp", m_data.etp(m_day));
 
         output.push_back(ret);
     }
@@ -136,10 +102,13 @@ public:
         const vle::devs::ObservationEvent &event) const
     {
         if (event.onPort("rain"))
-            return new vle::value::Double(m_data.data[m_it].rain);
+            return new vle::value::Double(m_data.rain(m_day));
 
         if (event.onPort("etp"))
-            return new vle::value::Double(m_data.data[m_it].etp);
+            return new vle::value::Double(m_data.etp(m_day));
+
+        if (event.onPort("date"))
+            return new vle::value::Double(m_data.julian_day(m_day));
 
         return vle::devs::Dynamics::observation(event);
     }
@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "meteo.hpp"
+#include <vle/extension/decision/Number.hpp>
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/i18n.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace safihr {
+
+namespace {
+
+using vle::extension::decision::parseReal;
+
+/// Header of the binary cache, followed by the julian day, rain and etp
+/// columns of @e rows doubles each.
+struct CacheHeader
+{
+    char magic[8];
+    boost::uint64_t rows;
+    boost::uint64_t source_size;
+    boost::int64_t source_time;
+};
+
+const char cache_magic[8] = { 'S', 'A', 'F', 'M', 'E', 'T', 'O', '1' };
+
+inline bool is_blank(char c)
+{
+    return c == ' ' or c == '\t' or c == '\r';
+}
+
+inline const char *skip_blanks(const char *it, const char *last)
+{
+    while (it != last and is_blank(*it))
+        ++it;
+
+    return it;
+}
+
+/// Read an unsigned integer.
+/// @return the end of the number or 0 if there is no digit.
+inline const char *parse_int(const char *it, const char *last, int *out)
+{
+    const char *begin = it;
+    int result = 0;
+
+    while (it != last and *it >= '0' and *it <= '9' and it - begin < 9) {
+        result = result * 10 + (*it - '0');
+        ++it;
+    }
+
+    *out = result;
+
+    return it == begin ? 0 : it;
+}
+
+/// Julian day number of a gregorian date, as vle::utils::DateTime.
+inline double julian_day_number(int day, int month, int year)
+{
+    int a = (14 - month) / 12;
+    long y = year + 4800 - a;
+    long m = month + 12 * a - 3;
+
+    return day + (153 * m + 2) / 5 + 365 * y + y / 4 - y / 100 + y / 400 -
+        32045;
+}
+
+}
+
+MeteoTable::MeteoTable()
+    : m_julian_day(0)
+    , m_rain(0)
+    , m_etp(0)
+    , m_size(0)
+{
+}
+
+void MeteoTable::clear()
+{
+    if (m_file.is_open())
+        m_file.close();
+
+    m_parsed_julian_day.clear();
+    m_parsed_rain.clear();
+    m_parsed_etp.clear();
+
+    m_julian_day = m_rain = m_etp = 0;
+    m_size = 0;
+}
+
+void MeteoTable::parse(const char *first, const char *last)
+{
+    clear();
+
+    const std::size_t lines = std::count(first, last, '\n') + 1;
+    m_parsed_julian_day.reserve(lines);
+    m_parsed_rain.reserve(lines);
+    m_parsed_etp.reserve(lines);
+
+    const char *it = std::find(first, last, '\n');
+    std::size_t line = 1;
+
+    while (it != last) {
+        ++it;
+        ++line;
+
+        it = skip_blanks(it, last);
+        if (it == last or *it == '\n')
+            continue;
+
+        int day, month, year;
+        double rain, etp;
+        const char *end = parse_int(it, last, &day);
+
+        if (end and end != last and *end == '/')
+            end = parse_int(end + 1, last, &month);
+        else
+            end = 0;
+
+        if (end and end != last and *end == '/')
+            end = parse_int(end + 1, last, &year);
+        else
+            end = 0;
+
+        if (end and end != last and is_blank(*end))
+            end = parseReal(skip_blanks(end, last), last, &rain);
+        else
+            end = 0;
+
+        if (end and end != last and is_blank(*end))
+            end = parseReal(skip_blanks(end, last), last, &etp);
+        else
+            end = 0;
+
+        if (end)
+            end = skip_blanks(end, last);
+
+        if (not end or (end != last and *end != '\n') or month < 1 or
+            month > 12 or day < 1 or day > 31)
+            throw vle::utils::ModellingError(
+                vle::fmt("meteo: malformed row at line %1%") % line);
+
+        m_parsed_julian_day.push_back(julian_day_number(day, month, year));
+        m_parsed_rain.push_back(rain);
+        m_parsed_etp.push_back(etp);
+
+        it = end;
+    }
+
+    m_size = m_parsed_rain.size();
+    if (m_size) {
+        m_julian_day = &m_parsed_julian_day[0];
+        m_rain = &m_parsed_rain[0];
+        m_etp = &m_parsed_etp[0];
+    }
+}
+
+void MeteoTable::load(const std::string& filename, bool cache)
+{
+    const std::string cachename = filename + ".cache";
+
+    try {
+        if (cache and read_cache(cachename, filename))
+            return;
+
+        boost::iostreams::mapped_file_source text;
+        if (boost::filesystem::file_size(filename) > 0)
+            text.open(filename);
+
+        if (text.is_open())
+            parse(text.data(), text.data() + text.size());
+        else
+            clear();
+    } catch (const std::ios_base::failure& e) {
+        throw vle::utils::ModellingError(
+            vle::fmt("meteo: failed to read %1%: %2%") % filename % e.what());
+    } catch (const boost::filesystem::filesystem_error& e) {
+        throw vle::utils::ModellingError(
+            vle::fmt("meteo: failed to read %1%: %2%") % filename % e.what());
+    }
+
+    if (cache)
+        write_cache(cachename, filename);
+}
+
+bool MeteoTable::read_cache(const std::string& cachename,
+                            const std::string& filename)
+{
+    namespace fs = boost::filesystem;
+
+    boost::system::error_code ec;
+    const boost::uintmax_t size = fs::file_size(cachename, ec);
+    if (ec or size < sizeof(CacheHeader))
+        return false;
+
+    clear();
+
+    CacheHeader header;
+    try {
+        m_file.open(cachename);
+        std::memcpy(&header, m_file.data(), sizeof(header));
+
+        if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) or
+            header.source_size != fs::file_size(filename) or
+            header.source_time != fs::last_write_time(filename) or
+            size != sizeof(header) + 3 * header.rows * sizeof(double)) {
+            clear();
+            return false;
+        }
+    } catch (const std::exception& /*e*/) {
+        clear();
+        return false;
+    }
+
+    const double *columns = reinterpret_cast <const double*>(
+        m_file.data() + sizeof(header));
+
+    m_size = header.rows;
+    m_julian_day = columns;
+    m_rain = columns + m_size;
+    m_etp = columns + 2 * m_size;
+
+    return true;
+}
+
+void MeteoTable::write_cache(const std::string& cachename,
+                             const std::string& filename) const
+{
+    namespace fs = boost::filesystem;
+
+    // Write a unique temporary file then rename it, so simulations which
+    // load the same file at the same time never read a partial cache.
+    try {
+        CacheHeader header;
+        std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+        header.rows = m_size;
+        header.source_size = fs::file_size(filename);
+        header.source_time = fs::last_write_time(filename);
+
+        fs::path tmp = fs::path(cachename).parent_path() /
+            fs::unique_path("%%%%-%%%%-%%%%.tmp");
+
+        {
+            std::ofstream out(tmp.string().c_str(), std::ios::binary);
+            out.write(reinterpret_cast <const char*>(&header),
+                      sizeof(header));
+            if (m_size) {
+                out.write(reinterpret_cast <const char*>(m_julian_day),
+                          m_size * sizeof(double));
+                out.write(reinterpret_cast <const char*>(m_rain),
+                          m_size * sizeof(double));
+                out.write(reinterpret_cast <const char*>(m_etp),
+                          m_size * sizeof(double));
+            }
+
+            if (not out) {
+                boost::system::error_code ec;
+                fs::remove(tmp, ec);
+                return;
+            }
+        }
+
+        boost::system::error_code ec;
+        fs::rename(tmp, cachename, ec);
+        if (ec)
+            fs::remove(tmp, ec);
+    } catch (const std::exception& /*e*/) {
+        // The cache is only an optimization: a read-only data directory is
+        // not an error.
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SAFIHR_METEO_HPP
+#define SAFIHR_METEO_HPP
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace safihr {
+
+/// Daily meteo data in columns: the julian day, the rain and the etp of each
+/// row are stored in three contiguous arrays.
+///
+/// The text file has a header line then one row per day: a date @e d/m/y,
+/// the rain and the etp, separated by blanks. It is mapped in memory and
+/// parsed in place. A binary copy of the columns, @e filename.cache, is
+/// written next to it: the next loads map the cache directly while it
+/// matches the size and the modification time of the text file. The cache
+/// uses the byte order of the host.
+class MeteoTable : boost::noncopyable
+{
+public:
+    MeteoTable();
+
+    /// Load the file @e filename, from its cache if @e cache is true and the
+    /// cache is up to date. A missing cache is written when @e cache is
+    /// true; failing to write it is not an error.
+    /// @throw vle::utils::ModellingError if the file can not be read or a
+    /// row is malformed.
+    void load(const std::string& filename, bool cache = true);
+
+    /// Parse the text of a meteo file, header line included.
+    /// @throw vle::utils::ModellingError if a row is malformed.
+    void parse(const char *first, const char *last);
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /// True if the columns are mapped from the cache.
+    bool cached() const { return m_file.is_open(); }
+
+    double julian_day(std::size_t day) const { return m_julian_day[day]; }
+    double rain(std::size_t day) const { return m_rain[day]; }
+    double etp(std::size_t day) const { return m_etp[day]; }
+
+    const double *julian_days() const { return m_julian_day; }
+    const double *rains() const { return m_rain; }
+    const double *etps() const { return m_etp; }
+
+private:
+    bool read_cache(const std::string& cachename,
+                    const std::string& filename);
+    void write_cache(const std::string& cachename,
+                     const std::string& filename) const;
+    void clear();
+
+    boost::iostreams::mapped_file_source m_file; ///< Mapped cache.
+    std::vector <double> m_parsed_julian_day; ///< Columns of the text.
+    std::vector <double> m_parsed_rain;
+    std::vector <double> m_parsed_etp;
+
+    const double *m_julian_day;
+    const double *m_rain;
+    const double *m_etp;
+    std::size_t m_size;
+};
+
+}
+
+#endif
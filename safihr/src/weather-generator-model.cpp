@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <vle/devs/Dynamics.hpp>
+#include <vle/devs/DynamicsDbg.hpp>
+#include <vle/utils/Package.hpp>
+#include <string>
+#include "global.hpp"
+#include "meteo.hpp"
+#include "weather.hpp"
+
+namespace safihr {
+
+/// Generate the rain and the etp of each day from a stochastic weather
+/// calibrated on a meteo file. A day depends only on the seed and on its
+/// date: a simulation restarted at any date gets the same weather.
+class WeatherGenerator : public vle::devs::Dynamics
+{
+    StochasticWeather m_weather;
+    long m_day;
+    double m_rain;
+    double m_etp;
+
+    void generate(const vle::devs::Time& time)
+    {
+        m_day = static_cast <long>(time + 0.5);
+        m_weather.generate(m_day, &m_rain, &m_etp);
+    }
+
+public:
+    WeatherGenerator(const vle::devs::DynamicsInit &init,
+                     const vle::devs::InitEventList &evts)
+        : vle::devs::Dynamics(init, evts)
+        , m_day(0)
+        , m_rain(0.0)
+        , m_etp(0.0)
+    {
+        vle::utils::Package package("safihr");
+
+        bool cache = true;
+        if (evts.exist("cache"))
+            cache = evts.getBoolean("cache");
+
+        double threshold = 0.1;
+        if (evts.exist("wet-threshold"))
+            threshold = evts.getDouble("wet-threshold");
+
+        {
+            MeteoTable data;
+            data.load(package.getDataFile(evts.getString("filename")), cache);
+            m_weather.calibrate(data, threshold);
+        }
+
+        if (evts.exist("seed"))
+            m_weather.seed(evts.getInt("seed"));
+    }
+
+    virtual ~WeatherGenerator()
+    {}
+
+    virtual vle::devs::Time init(const vle::devs::Time &time)
+    {
+        generate(time);
+
+        return 0.0;
+    }
+
+    virtual vle::devs::Time timeAdvance() const
+    {
+        return 1.0;
+    }
+
+    virtual void internalTransition(const vle::devs::Time &time)
+    {
+        generate(time + timeAdvance());
+    }
+
+    virtual void output(const vle::devs::Time &time,
+                        vle::devs::ExternalEventList &output) const
+    {
+        (void)time;
+
+        vle::devs::ExternalEvent *ret = new vle::devs::ExternalEvent("out");
+        vle::value::Map &msg = ret->attributes();
+
+        msg.addDouble("rain", m_rain);
+        msg.addDouble("etp", m_etp);
+
+        output.push_back(ret);
+    }
+
+    virtual vle::value::Value * observation(
+        const vle::devs::ObservationEvent &event) const
+    {
+        if (event.onPort("rain"))
+            return new vle::value::Double(m_rain);
+
+        if (event.onPort("etp"))
+            return new vle::value::Double(m_etp);
+
+        if (event.onPort("date"))
+            return new vle::value::Double(m_day);
+
+        return vle::devs::Dynamics::observation(event);
+    }
+};
+
+}
+
+DECLARE_DYNAMICS_DBG(safihr::WeatherGenerator)
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "weather.hpp"
+#include "meteo.hpp"
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/i18n.hpp>
+#include <boost/math/special_functions/erf.hpp>
+#include <boost/math/special_functions/gamma.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace safihr {
+
+namespace {
+
+/// The constants of the splitmix64 finalizer, built from 32 bits halves:
+/// C++03 has no 64 bits literals.
+const boost::uint64_t golden =
+    (static_cast <boost::uint64_t>(0x9E3779B9UL) << 32) | 0x7F4A7C15UL;
+const boost::uint64_t mix1 =
+    (static_cast <boost::uint64_t>(0xBF58476DUL) << 32) | 0x1CE4E5B9UL;
+const boost::uint64_t mix2 =
+    (static_cast <boost::uint64_t>(0x94D049BBUL) << 32) | 0x133111EBUL;
+
+/// The random streams of a day.
+enum Stream { OCCURRENCE, RAIN, ETP, DRIZZLE };
+
+/// Beyond this number of undecided days, the occurrence is drawn from the
+/// stationary law of the chain.
+const int max_lookback = 366;
+
+const double pi = 3.14159265358979323846;
+const double sqrt2 = 1.41421356237309504880;
+
+/// Scores are bounded by the normal quantile of this probability.
+const double min_probability = 1e-300;
+
+inline boost::uint64_t mix(boost::uint64_t x)
+{
+    x += golden;
+    x = (x ^ (x >> 30)) * mix1;
+    x = (x ^ (x >> 27)) * mix2;
+    return x ^ (x >> 31);
+}
+
+/// Running sums of one calendar month.
+struct MonthSums
+{
+    MonthSums()
+        : n00(0), n01(0), n10(0), n11(0), wet(0), dry(0), drizzle(0)
+        , rain(0.0), rain2(0.0), drizzle_rain(0.0), etp_dry(0.0), etp_dry2(0.0)
+        , etp_wet(0.0), etp_wet2(0.0)
+    {}
+
+    MonthSums& operator+=(const MonthSums& other)
+    {
+        n00 += other.n00;
+        n01 += other.n01;
+        n10 += other.n10;
+        n11 += other.n11;
+        wet += other.wet;
+        dry += other.dry;
+        drizzle += other.drizzle;
+        rain += other.rain;
+        rain2 += other.rain2;
+        drizzle_rain += other.drizzle_rain;
+        etp_dry += other.etp_dry;
+        etp_dry2 += other.etp_dry2;
+        etp_wet += other.etp_wet;
+        etp_wet2 += other.etp_wet2;
+        return *this;
+    }
+
+    long n00, n01, n10, n11, wet, dry, drizzle;
+    double rain, rain2, drizzle_rain, etp_dry, etp_dry2, etp_wet, etp_wet2;
+};
+
+inline double variance(double sum, double sum2, long n)
+{
+    return n > 1 ? std::max(0.0, (sum2 - sum * sum / n) / (n - 1)) : 0.0;
+}
+
+/// Estimate the parameters of a month from its sums, the missing ones are
+/// read in @e fallback.
+WeatherMonth estimate(const MonthSums& s, const WeatherMonth& fallback)
+{
+    WeatherMonth ret(fallback);
+
+    if (s.n00 + s.n01 > 0)
+        ret.p01 = static_cast <double>(s.n01) / (s.n00 + s.n01);
+    if (s.n10 + s.n11 > 0)
+        ret.p11 = static_cast <double>(s.n11) / (s.n10 + s.n11);
+
+    if (s.wet > 0) {
+        double mean = s.rain / s.wet;
+        double var = variance(s.rain, s.rain2, s.wet);
+
+        if (var > 0.0) {
+            ret.shape = mean * mean / var;
+            ret.scale = var / mean;
+        } else {
+            ret.shape = 1.0;
+            ret.scale = mean;
+        }
+
+        ret.etp_wet_mean = s.etp_wet / s.wet;
+        ret.etp_wet_sd = std::sqrt(variance(s.etp_wet, s.etp_wet2, s.wet));
+    }
+
+    if (s.dry > 0) {
+        ret.drizzle = static_cast <double>(s.drizzle) / s.dry;
+        ret.drizzle_mean = s.drizzle > 0 ? s.drizzle_rain / s.drizzle : 0.0;
+        ret.etp_dry_mean = s.etp_dry / s.dry;
+        ret.etp_dry_sd = std::sqrt(variance(s.etp_dry, s.etp_dry2, s.dry));
+    }
+
+    return ret;
+}
+
+/// Get the normal score of the rain over the threshold @e rain of a wet
+/// day: the normal quantile of its gamma probability. The lower or the
+/// upper tail is used to keep the precision of large scores.
+double normal_score(double rain, const WeatherMonth& month)
+{
+    double x = std::max(0.0, rain / month.scale);
+    double p = boost::math::gamma_p(month.shape, x);
+
+    if (p < 0.5)
+        return -sqrt2 * boost::math::erfc_inv(
+            2.0 * std::max(p, min_probability));
+
+    double q = boost::math::gamma_q(month.shape, x);
+    return sqrt2 * boost::math::erfc_inv(2.0 * std::max(q, min_probability));
+}
+
+/// Get the rain over the threshold of the normal score @e score: the
+/// inverse of normal_score.
+double rain_quantile(double score, const WeatherMonth& month)
+{
+    double p = 0.5 * boost::math::erfc(-score / sqrt2);
+
+    if (p < 0.5)
+        return month.scale * boost::math::gamma_p_inv(
+            month.shape, std::max(p, min_probability));
+
+    return month.scale * boost::math::gamma_q_inv(
+        month.shape, std::max(0.5 * boost::math::erfc(score / sqrt2),
+                              min_probability));
+}
+
+}
+
+int month_of_julian_day(long day)
+{
+    long a = day + 32044;
+    long b = (4 * a + 3) / 146097;
+    long c = a - 146097 * b / 4;
+    long d = (4 * c + 3) / 1461;
+    long e = c - 1461 * d / 4;
+    long m = (5 * e + 2) / 153;
+
+    return static_cast <int>(m + 3 - 12 * (m / 10));
+}
+
+StochasticWeather::StochasticWeather()
+    : m_correlation(0.0)
+    , m_wet_threshold(0.0)
+    , m_seed(golden)
+{
+}
+
+void StochasticWeather::calibrate(const MeteoTable& table,
+                                  double wet_threshold)
+{
+    if (table.empty())
+        throw vle::utils::ModellingError(
+            "weather: calibration from empty data");
+
+    MonthSums sums[12], all;
+
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        MonthSums& s = sums[month_of_julian_day(
+                static_cast <long>(table.julian_day(i))) - 1];
+        bool wet = table.rain(i) > wet_threshold;
+        double excess = table.rain(i) - wet_threshold;
+        double etp = table.etp(i);
+
+        if (wet) {
+            s.wet++;
+            s.rain += excess;
+            s.rain2 += excess * excess;
+            s.etp_wet += etp;
+            s.etp_wet2 += etp * etp;
+        } else {
+            s.dry++;
+            if (table.rain(i) > 0.0) {
+                s.drizzle++;
+                s.drizzle_rain += table.rain(i);
+            }
+            s.etp_dry += etp;
+            s.etp_dry2 += etp * etp;
+        }
+
+        if (i > 0 and table.julian_day(i) == table.julian_day(i - 1) + 1) {
+            if (table.rain(i - 1) > wet_threshold)
+                (wet ? s.n11 : s.n10)++;
+            else
+                (wet ? s.n01 : s.n00)++;
+        }
+    }
+
+    for (int m = 0; m < 12; ++m)
+        all += sums[m];
+
+    WeatherMonth global = estimate(all, WeatherMonth());
+    for (int m = 0; m < 12; ++m)
+        m_months[m] = estimate(sums[m], global);
+
+    double szz = 0.0, sze = 0.0, see = 0.0;
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        if (table.rain(i) <= wet_threshold)
+            continue;
+
+        const WeatherMonth& m = month(month_of_julian_day(
+                static_cast <long>(table.julian_day(i))));
+        if (m.etp_wet_sd <= 0.0)
+            continue;
+
+        double z = normal_score(table.rain(i) - wet_threshold, m);
+        double e = (table.etp(i) - m.etp_wet_mean) / m.etp_wet_sd;
+        szz += z * z;
+        sze += z * e;
+        see += e * e;
+    }
+
+    m_correlation = szz > 0.0 and see > 0.0 ?
+        std::max(-0.99, std::min(0.99, sze / std::sqrt(szz * see))) : 0.0;
+    m_wet_threshold = wet_threshold;
+}
+
+double StochasticWeather::uniform(long day, unsigned int stream,
+                                  unsigned int index) const
+{
+    boost::uint64_t counter = (static_cast <boost::uint64_t>(stream) << 32)
+        | index;
+    boost::uint64_t x = mix(m_seed ^ mix(static_cast <boost::uint64_t>(day)
+                                         ^ mix(counter)));
+
+    return (static_cast <double>(x >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+double StochasticWeather::normal(long day, unsigned int stream,
+                                 unsigned int index) const
+{
+    double u1 = uniform(day, stream, 2 * index);
+    double u2 = uniform(day, stream, 2 * index + 1);
+
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * pi * u2);
+}
+
+bool StochasticWeather::wet(long day) const
+{
+    long first = day;
+    bool state = false;
+    int lookback = 0;
+
+    for (;; --first, ++lookback) {
+        const WeatherMonth& m = month(month_of_julian_day(first));
+        double u = uniform(first, OCCURRENCE, 0);
+
+        if (u < std::min(m.p01, m.p11)) {
+            state = true;
+            break;
+        }
+
+        if (u >= std::max(m.p01, m.p11)) {
+            state = false;
+            break;
+        }
+
+        if (lookback == max_lookback) {
+            double denominator = 1.0 - m.p11 + m.p01;
+            state = u < (denominator > 0.0 ? m.p01 / denominator : 0.5);
+            break;
+        }
+    }
+
+    while (first < day) {
+        ++first;
+        const WeatherMonth& m = month(month_of_julian_day(first));
+        state = uniform(first, OCCURRENCE, 0) < (state ? m.p11 : m.p01);
+    }
+
+    return state;
+}
+
+void StochasticWeather::generate(long day, double *rain, double *etp) const
+{
+    const WeatherMonth& m = month(month_of_julian_day(day));
+    double noise = normal(day, ETP, 0);
+
+    if (wet(day) and m.scale > 0.0) {
+        double score = normal(day, RAIN, 0);
+        *rain = m_wet_threshold + rain_quantile(score, m);
+        noise = m_correlation * score +
+            std::sqrt(1.0 - m_correlation * m_correlation) * noise;
+        *etp = std::max(0.0, m.etp_wet_mean + m.etp_wet_sd * noise);
+    } else {
+        *rain = uniform(day, DRIZZLE, 0) < m.drizzle ? m.drizzle_mean : 0.0;
+        *etp = std::max(0.0, m.etp_dry_mean + m.etp_dry_sd * noise);
+    }
+}
+
+}
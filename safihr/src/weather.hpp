@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2014 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SAFIHR_WEATHER_HPP
+#define SAFIHR_WEATHER_HPP
+
+#include <boost/cstdint.hpp>
+
+namespace safihr {
+
+class MeteoTable;
+
+/// Parameters of one calendar month of the stochastic weather.
+struct WeatherMonth
+{
+    WeatherMonth()
+        : p01(0.0), p11(0.0), shape(1.0), scale(0.0)
+        , drizzle(0.0), drizzle_mean(0.0)
+        , etp_dry_mean(0.0), etp_dry_sd(0.0)
+        , etp_wet_mean(0.0), etp_wet_sd(0.0)
+    {}
+
+    double p01; ///< Probability of a wet day after a dry day.
+    double p11; ///< Probability of a wet day after a wet day.
+    double shape; ///< Shape of the gamma law of the rain over the threshold.
+    double scale; ///< Scale of the gamma law of the rain over the threshold.
+    double drizzle; ///< Probability of rain under the threshold on a dry day.
+    double drizzle_mean; ///< Mean rain of these days.
+    double etp_dry_mean;
+    double etp_dry_sd;
+    double etp_wet_mean;
+    double etp_wet_sd;
+};
+
+/// Stochastic daily weather: a two-state Markov chain for the rain
+/// occurrence, a gamma law for the rain of a wet day and a normal etp
+/// conditioned by the occurrence and correlated with the rain amount. The
+/// parameters of each calendar month are calibrated from a meteo file.
+///
+/// The rain of a wet day is the gamma quantile of a normal score, and the
+/// etp noise is correlated with this score: the calibration computes the
+/// score of an observed rain with the same transformation. A dry day
+/// receives the mean drizzle of the month, under the wet threshold, with
+/// its observed frequency, so the generated rain keeps the observed total.
+///
+/// The random numbers of a day are a hash of the seed, the julian day and
+/// a counter (counter-based generator): any day is generated on demand, in
+/// any order, with the same result and without storing the series. The
+/// occurrence of a day depends on the previous day only when its uniform
+/// falls between p01 and p11, so the chain is read backward until a day
+/// decided whatever its previous state, usually one or two days.
+class StochasticWeather
+{
+public:
+    StochasticWeather();
+
+    /// Estimate the parameters of each month from the rows of @e table. A
+    /// day is wet when its rain exceeds @e wet_threshold. A month without
+    /// data uses the parameters of the whole table.
+    /// @throw vle::utils::ModellingError if @e table is empty.
+    void calibrate(const MeteoTable& table, double wet_threshold = 0.1);
+
+    void seed(boost::uint64_t seed) { m_seed = seed; }
+
+    /// Generate the rain and the etp of the julian day @e day.
+    void generate(long day, double *rain, double *etp) const;
+
+    /// Get the rain occurrence of the julian day @e day.
+    bool wet(long day) const;
+
+    /// Get the parameters of the month @e month, from 1 to 12.
+    const WeatherMonth& month(int month) const { return m_months[month - 1]; }
+
+    /// Get the correlation between the etp and the rain of wet days.
+    double correlation() const { return m_correlation; }
+
+private:
+    double uniform(long day, unsigned int stream, unsigned int index) const;
+    double normal(long day, unsigned int stream, unsigned int index) const;
+
+    WeatherMonth m_months[12];
+    double m_correlation;
+    double m_wet_threshold;
+    boost::uint64_t m_seed;
+};
+
+/// Get the month, from 1 to 12, of the julian day number @e day.
+int month_of_julian_day(long day);
+
+}
+
+#endif
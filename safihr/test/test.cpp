@@ -35,14 +35,27 @@
 
 #include "lu.hpp"
 #include "crop.hpp"
+#include "forecast.hpp"
+#include "meteo.hpp"
+#include "weather.hpp"
 #include "strategic.hpp"
+#include "farm-weather.hpp"
+#include "global.hpp"
+#include "itk.hpp"
+#include <vle/extension/decision/KnowledgeBase.hpp>
+#include <vle/extension/decision/PlanPrototype.hpp>
 #include <vle/utils/Package.hpp>
 #include <vle/utils/Path.hpp>
 #include <vle/utils/ModuleManager.hpp>
+#include <vle/value/Double.hpp>
 #include <vle/vle.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/bind.hpp>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cmath>
+#include <vector>
 
 struct F
 {
@@ -89,3 +102,586 @@ BOOST_AUTO_TEST_CASE(test_lus)
 
     BOOST_REQUIRE(lu1 == lu2);
 }
+
+BOOST_AUTO_TEST_CASE(test_forecast)
+{
+    safihr::Forecast constant;
+    constant.resize(8, 5);
+
+    for (int i = 0; i < 10; ++i)
+        constant.observe(2.0);
+
+    for (size_t day = 0; day < constant.horizon(); ++day) {
+        BOOST_REQUIRE_CLOSE(constant.mean(day), 2.0, 1e-9);
+        for (size_t k = 0; k < constant.members(); ++k)
+            BOOST_REQUIRE_CLOSE(constant.value(day, k), 2.0, 1e-9);
+    }
+
+    BOOST_REQUIRE_CLOSE(constant.expected_sum(3), 6.0, 1e-9);
+    BOOST_REQUIRE_EQUAL(constant.probability_sum_less_equal(3, 6.5), 1.0);
+    BOOST_REQUIRE_EQUAL(constant.probability_sum_less_equal(3, 5.5), 0.0);
+    BOOST_REQUIRE_THROW(constant.probability_sum_less_equal(6, 1.0),
+                        vle::utils::ModellingError);
+
+    safihr::Forecast rain;
+    rain.resize(1000, 7);
+    rain.seed(42);
+
+    const double observations[] = { 1.0, 3.0, 0.0, 5.0, 2.0, 2.0, 8.0, 0.0 };
+    for (size_t i = 0; i < sizeof(observations) / sizeof(double); ++i)
+        rain.observe(observations[i]);
+
+    double previous = 0.0;
+    for (int threshold = 0; threshold <= 200; threshold += 5) {
+        double probability = rain.probability_sum_less_equal(7, threshold);
+        BOOST_REQUIRE(probability >= previous);
+        previous = probability;
+    }
+    BOOST_REQUIRE_EQUAL(previous, 1.0);
+
+    for (size_t day = 0; day < rain.horizon(); ++day) {
+        double sum = 0.0;
+        for (size_t k = 0; k < rain.members(); ++k) {
+            BOOST_REQUIRE(rain.value(day, k) >= 0.0);
+            sum += rain.value(day, k);
+        }
+        BOOST_REQUIRE_CLOSE(rain.mean(day), sum / rain.members(), 1e-9);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_plot_port_index)
+{
+    BOOST_REQUIRE_EQUAL(safihr::plot_port_index("p0"), 0);
+    BOOST_REQUIRE_EQUAL(safihr::plot_port_index("p42"), 42);
+    BOOST_REQUIRE_EQUAL(safihr::plot_port_index("p9999"), 9999);
+    BOOST_REQUIRE_EQUAL(safihr::plot_port_index(safihr::landunit_model_name(12)),
+                        12);
+    BOOST_REQUIRE_EQUAL(safihr::plot_port_index("p"), -1);
+    BOOST_REQUIRE_EQUAL(safihr::plot_port_index("p1a"), -1);
+    BOOST_REQUIRE_EQUAL(safihr::plot_port_index("ack"), -1);
+    BOOST_REQUIRE_EQUAL(safihr::plot_port_index("meteo"), -1);
+    BOOST_REQUIRE_EQUAL(safihr::plot_port_index(""), -1);
+}
+
+BOOST_AUTO_TEST_CASE(test_meteo_table)
+{
+    const std::string text("Date\tPluie\tETP\n"
+                           "1/1/1987\t13.5\t0.6\r\n"
+                           "02/01/1987 2.3 0.8\n"
+                           "\n"
+                           "3/1/1987\t0\t1e-1\n");
+
+    safihr::MeteoTable table;
+    table.parse(text.data(), text.data() + text.size());
+    BOOST_REQUIRE_EQUAL(table.size(), 3u);
+    BOOST_REQUIRE_EQUAL(table.julian_day(0), 2446797.0);
+    BOOST_REQUIRE_EQUAL(table.julian_day(2), 2446799.0);
+    BOOST_REQUIRE_EQUAL(table.rain(0), 13.5);
+    BOOST_REQUIRE_EQUAL(table.rain(1), 2.3);
+    BOOST_REQUIRE_EQUAL(table.etp(1), 0.8);
+    BOOST_REQUIRE_EQUAL(table.etp(2), 0.1);
+
+    const std::string bad("Date\tPluie\tETP\n1/1/1987\t13.5\n");
+    BOOST_REQUIRE_THROW(table.parse(bad.data(), bad.data() + bad.size()),
+                        vle::utils::ModellingError);
+
+    vle::utils::Package pack("safihr");
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+    std::string filename = (dir / "meteo87-90.csv").string();
+    boost::filesystem::copy_file(pack.getDataFile("meteo87-90.csv"),
+                                 filename);
+
+    safihr::MeteoTable parsed, cached;
+    parsed.load(filename);
+    BOOST_REQUIRE(not parsed.cached());
+    BOOST_REQUIRE(boost::filesystem::exists(filename + ".cache"));
+    cached.load(filename);
+    BOOST_REQUIRE(cached.cached());
+
+    BOOST_REQUIRE_EQUAL(parsed.size(), 1461u);
+    BOOST_REQUIRE_EQUAL(cached.size(), parsed.size());
+    for (size_t i = 0; i < parsed.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(cached.julian_day(i), parsed.julian_day(i));
+        BOOST_REQUIRE_EQUAL(cached.rain(i), parsed.rain(i));
+        BOOST_REQUIRE_EQUAL(cached.etp(i), parsed.etp(i));
+    }
+
+    std::ifstream ifs(filename.c_str());
+    std::string header, date;
+    double rain, etp;
+    std::getline(ifs, header);
+    for (size_t i = 0; ifs >> date >> rain >> etp; ++i) {
+        BOOST_REQUIRE_EQUAL(parsed.rain(i), rain);
+        BOOST_REQUIRE_EQUAL(parsed.etp(i), etp);
+    }
+
+    boost::filesystem::remove_all(dir);
+}
+
+/// Get the dates of @e years years from 1987-1-1, julian day 2446797, in
+/// the format of the meteo files.
+static std::vector <std::string> meteo_dates(int years)
+{
+    const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    std::vector <std::string> dates;
+
+    for (int y = 1987; y < 1987 + years; ++y) {
+        bool leap = (y % 4 == 0 and y % 100 != 0) or y % 400 == 0;
+
+        for (int m = 1; m <= 12; ++m) {
+            for (int d = 1; d <= days[m - 1] + (m == 2 and leap); ++d) {
+                std::ostringstream os;
+                os << d << '/' << m << '/' << y;
+                dates.push_back(os.str());
+            }
+        }
+    }
+
+    return dates;
+}
+
+BOOST_AUTO_TEST_CASE(test_weather)
+{
+    BOOST_REQUIRE_EQUAL(safihr::month_of_julian_day(2446797), 1);
+    BOOST_REQUIRE_EQUAL(safihr::month_of_julian_day(2446827), 1);
+    BOOST_REQUIRE_EQUAL(safihr::month_of_julian_day(2446828), 2);
+    BOOST_REQUIRE_EQUAL(safihr::month_of_julian_day(2447527), 12);
+
+    vle::utils::Package pack("safihr");
+    safihr::MeteoTable table;
+    table.load(pack.getDataFile("meteo87-90.csv"), false);
+
+    safihr::StochasticWeather weather;
+    BOOST_REQUIRE_THROW(weather.calibrate(safihr::MeteoTable()),
+                        vle::utils::ModellingError);
+    weather.calibrate(table);
+    weather.seed(42);
+
+    for (int m = 1; m <= 12; ++m) {
+        BOOST_REQUIRE(weather.month(m).p01 >= 0.0);
+        BOOST_REQUIRE(weather.month(m).p11 <= 1.0);
+        BOOST_REQUIRE(weather.month(m).shape > 0.0);
+        BOOST_REQUIRE(weather.month(m).scale > 0.0);
+    }
+    BOOST_REQUIRE(std::abs(weather.correlation()) < 1.0);
+
+    /* A day is the same whatever the order of the generation. */
+    const long first = 2446797;
+    const long days = 1000;
+    std::vector <double> rains(days), etps(days);
+    for (long i = 0; i < days; ++i)
+        weather.generate(first + i, &rains[i], &etps[i]);
+
+    for (long i = days - 1; i >= 0; i -= 7) {
+        double rain, etp;
+        weather.generate(first + i, &rain, &etp);
+        BOOST_REQUIRE_EQUAL(rain, rains[i]);
+        BOOST_REQUIRE_EQUAL(etp, etps[i]);
+        BOOST_REQUIRE_EQUAL(weather.wet(first + i), rain > 0.1);
+    }
+
+    safihr::StochasticWeather other(weather);
+    other.seed(43);
+    long differences = 0;
+    for (long i = 0; i < days; ++i) {
+        double rain, etp;
+        other.generate(first + i, &rain, &etp);
+        differences += rain != rains[i];
+    }
+    BOOST_REQUIRE(differences > days / 10);
+
+    /* Thirty generated years look like the calibration years. */
+    double observed_rain = 0.0, observed_etp = 0.0;
+    long observed_wet = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+        observed_rain += table.rain(i);
+        observed_etp += table.etp(i);
+        observed_wet += table.rain(i) > 0.1;
+    }
+
+    const long years = 30 * 365;
+    double rain_sum = 0.0, etp_sum = 0.0;
+    long wet = 0;
+    for (long i = 0; i < years; ++i) {
+        double rain, etp;
+        weather.generate(first + i, &rain, &etp);
+        rain_sum += rain;
+        etp_sum += etp;
+        wet += rain > 0.1;
+    }
+
+    /* The drizzle of the dry days is part of the observed rain. */
+    const double size = static_cast <double>(table.size());
+    BOOST_REQUIRE_CLOSE(wet / (double)years, observed_wet / size, 2.0);
+    BOOST_REQUIRE_CLOSE(rain_sum / years, observed_rain / size, 5.0);
+    BOOST_REQUIRE_CLOSE(etp_sum / years, observed_etp / size, 1.0);
+
+    /*
+     * A calibration from a generated series finds the correlation of the
+     * generator: the score of a generated rain is the normal number which
+     * has drawn it. The etp of the wet days of the synthetic observations
+     * decreases with the rain.
+     */
+    std::vector <std::string> dates = meteo_dates(100);
+    std::ostringstream observed;
+    observed << "J/M/A\tPluie\tETP\n";
+    for (size_t i = 0; i < table.size(); ++i) {
+        double rain = table.rain(i);
+        double etp = table.etp(i) + (rain > 0.1 ? 2.0 / (1.0 + rain) : 0.0);
+        observed << dates[i] << '\t' << rain << '\t' << etp << '\n';
+    }
+
+    safihr::MeteoTable synthetic;
+    std::string text = observed.str();
+    synthetic.parse(text.data(), text.data() + text.size());
+    weather.calibrate(synthetic);
+    BOOST_REQUIRE(weather.correlation() < -0.5);
+
+    std::ostringstream generated;
+    generated << "J/M/A\tPluie\tETP\n";
+    for (size_t i = 0; i < dates.size(); ++i) {
+        double rain, etp;
+        weather.generate(first + i, &rain, &etp);
+        generated << dates[i] << '\t' << rain << '\t' << etp << '\n';
+    }
+
+    safihr::MeteoTable series;
+    text = generated.str();
+    series.parse(text.data(), text.data() + text.size());
+
+    safihr::StochasticWeather recalibrated;
+    recalibrated.calibrate(series);
+    BOOST_REQUIRE_SMALL(recalibrated.correlation() - weather.correlation(),
+                        0.02);
+
+    for (int m = 1; m <= 12; ++m) {
+        BOOST_REQUIRE_SMALL(recalibrated.month(m).p01 - weather.month(m).p01,
+                            0.05);
+        BOOST_REQUIRE_SMALL(recalibrated.month(m).p11 - weather.month(m).p11,
+                            0.05);
+        BOOST_REQUIRE_SMALL(recalibrated.month(m).drizzle -
+                            weather.month(m).drizzle, 0.02);
+    }
+}
+
+namespace {
+
+namespace vmd = vle::extension::decision;
+
+/// A knowledge base with the predicates of the Farmer. As in the Farmer,
+/// the states of the plots are not facts of the knowledge base: they are
+/// changed directly and notified with Activities::factsChanged.
+class FarmerPlans : public vmd::KnowledgeBase
+{
+public:
+    FarmerPlans(std::size_t plots)
+        : ru(plots, 0.0), harvestable(plots, 0), ends(0)
+    {
+        addPredicates(this) +=
+            P("harvestable", &FarmerPlans::is_harvestable,
+              vmd::PredicateSignature()),
+            P("penetrability", &FarmerPlans::penetrability,
+              vmd::PredicateSignature()
+              .addOperator("penetrability_operator")
+              .addReal("penetrability_threshold")),
+            P("rain", &FarmerPlans::rain_quantity,
+              vmd::PredicateSignature()
+              .addOperator("rain_operator")
+              .addReal("rain_threshold")),
+            P("sum_rain", &FarmerPlans::rain_sum,
+              vmd::PredicateSignature()
+              .addOperator("sum_rain_operator")
+              .addReal("sum_rain_number")
+              .addReal("sum_rain_threshold")),
+            P("sum_R-PET", &FarmerPlans::petp_sum,
+              vmd::PredicateSignature()
+              .addOperator("sum_R-PET_operator")
+              .addReal("sum_R-PET_number")
+              .addReal("sum_R-PET_threshold")),
+            P("etp", &FarmerPlans::etp_quantity,
+              vmd::PredicateSignature()
+              .addOperator("etp_operator")
+              .addReal("etp_threshold"));
+
+        addOutputFunctions(this) += O("out", &FarmerPlans::out);
+        addUpdateFunctions(this) += U("itk_end", &FarmerPlans::itk_end);
+
+        m_rain = &addFactHistory("rain", 30);
+        m_etp = &addFactHistory("etp", 30);
+    }
+
+    void set_plot(std::size_t plot, double value, bool mature)
+    {
+        ru[plot] = value;
+        harvestable[plot] = mature;
+        plan().activities().factsChanged();
+    }
+
+    std::vector <double> ru;
+    std::vector <char> harvestable;
+    int ends;
+
+private:
+    const vmd::FactHistory <double>* m_rain;
+    const vmd::FactHistory <double>* m_etp;
+
+    double last(const vmd::FactHistory <double>& history) const
+    {
+        return history.empty() ? 0.0 : history.at(0);
+    }
+
+    double mean(const vmd::FactHistory <double>& history, double days) const
+    {
+        std::size_t n = std::min(history.size(),
+                                 static_cast <std::size_t>(days));
+        return n == 0 ? 0.0 : history.mean(n);
+    }
+
+    bool is_harvestable(const std::string&, const std::string&,
+                        const vmd::ActivityMetadata& metadata,
+                        const vmd::TypedPredicateParameters&)
+    {
+        return harvestable.at(metadata.plot);
+    }
+
+    bool penetrability(const std::string&, const std::string&,
+                       const vmd::ActivityMetadata& metadata,
+                       const vmd::TypedPredicateParameters& param)
+    {
+        return vmd::comparePredicateOperator(param.getOperator(0),
+                                             ru.at(metadata.plot),
+                                             param.getReal(0));
+    }
+
+    bool rain_quantity(const std::string&, const std::string&,
+                       const vmd::ActivityMetadata&,
+                       const vmd::TypedPredicateParameters& param)
+    {
+        return vmd::comparePredicateOperator(param.getOperator(0),
+                                             last(*m_rain),
+                                             param.getReal(0));
+    }
+
+    bool rain_sum(const std::string&, const std::string&,
+                  const vmd::ActivityMetadata&,
+                  const vmd::TypedPredicateParameters& param)
+    {
+        return vmd::comparePredicateOperator(
+            param.getOperator(0), mean(*m_rain, param.getReal(0)),
+            param.getReal(1));
+    }
+
+    bool petp_sum(const std::string&, const std::string&,
+                  const vmd::ActivityMetadata&,
+                  const vmd::TypedPredicateParameters& param)
+    {
+        return vmd::comparePredicateOperator(
+            param.getOperator(0),
+            mean(*m_rain, param.getReal(0)) - mean(*m_etp, param.getReal(0)),
+            param.getReal(1));
+    }
+
+    bool etp_quantity(const std::string&, const std::string&,
+                      const vmd::ActivityMetadata&,
+                      const vmd::TypedPredicateParameters& param)
+    {
+        return vmd::comparePredicateOperator(param.getOperator(0),
+                                             last(*m_etp),
+                                             param.getReal(0));
+    }
+
+    void out(const std::string&, const vmd::Activity&,
+             vle::devs::ExternalEventList&)
+    {
+    }
+
+    void itk_end(const std::string&, const vmd::Activity& activity)
+    {
+        if (activity.isInDoneState())
+            ends++;
+    }
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(test_farmer_plans_differential)
+{
+    vle::utils::Package pack("safihr");
+    std::ifstream crops_file(pack.getDataFile("Crop.txt").c_str());
+    BOOST_REQUIRE(crops_file.is_open());
+
+    safihr::Crops crops;
+    crops_file >> crops;
+    BOOST_REQUIRE(not crops.crops.empty());
+
+    // Each plot gets the ITK of the first and of the second year of a
+    // crop. The incremental engine is checked against the full scan at
+    // each call to the process function.
+    const std::size_t plots = crops.crops.size();
+    const vle::devs::Time start = 2446797.0; // 1987-1-1
+    FarmerPlans kb(plots);
+    kb.plan().activities().setProcessMode(vmd::Activities::Differential);
+
+    for (std::size_t i = 0; i < plots; ++i) {
+        for (int year = 0; year < 2; ++year) {
+            std::string filename = (vle::fmt(year == 0 ? "ITK0-%1%.txt" :
+                                             "ITK-%1%.txt")
+                                    % crops.crops[i].id).str();
+            std::ifstream ifs(pack.getDataFile(filename).c_str());
+            BOOST_REQUIRE(ifs.is_open());
+
+            vmd::PlanPrototype itk(kb, ifs);
+            itk.instantiate(start + 365.0 * year,
+                            (vle::fmt("_%1%_p%2%") % year % i).str(),
+                            boost::bind(&safihr::make_activity_metadata, _1,
+                                        year, static_cast <int>(i)));
+        }
+    }
+
+    // The weather is received every other day, so that the plot states
+    // also change alone.
+    unsigned long seed = 1987;
+    for (vle::devs::Time time = start; time < start + 3 * 365.0; ++time) {
+        seed = (seed * 1103515245 + 12345) % 2147483648UL;
+        if (static_cast <long>(time) % 2 == 0) {
+            kb.applyFact("rain", vle::value::Double((seed >> 8) % 5 == 0 ?
+                                                    (seed >> 4) % 20 : 0.0));
+            kb.applyFact("etp", vle::value::Double((seed >> 12) % 6));
+        }
+
+        for (std::size_t i = 0; i < plots; ++i) {
+            seed = (seed * 1103515245 + 12345) % 2147483648UL;
+            kb.set_plot(i, 30.0 + (seed >> 8) % 16, (seed >> 12) % 4 == 0);
+        }
+
+        kb.processChanges(time);
+
+        vmd::Activities::result_t started = kb.activities().startedAct();
+        for (vmd::Activities::result_t::iterator it = started.begin();
+             it != started.end(); ++it)
+            kb.setActivityDone((*it)->first, time);
+    }
+
+    BOOST_REQUIRE(kb.ends > 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_farm_weather)
+{
+    const std::string plan(
+        "predicates {\n"
+        "    predicate { id = \"rain_5\"; type = \"rain\";\n"
+        "        parameter { rain_operator = \"<=\"; rain_threshold = 5; } }\n"
+        "    predicate { id = \"etp_5\"; type = \"etp\";\n"
+        "        parameter { etp_operator = \"<=\"; etp_threshold = 5; } }\n"
+        "    predicate { id = \"etp_6\"; type = \"etp\";\n"
+        "        parameter { etp_operator = \">=\"; etp_threshold = 6; } }\n"
+        "}\n"
+        "rules {\n"
+        "    rule { id = \"dry\"; predicates = \"rain_5\"; }\n"
+        "    rule { id = \"cool\"; predicates = \"etp_5\"; }\n"
+        "    rule { id = \"hot\"; predicates = \"etp_6\"; }\n"
+        "}\n"
+        "activities {\n"
+        "    activity { id = \"Dry\"; rules = \"dry\"; }\n"
+        "    activity { id = \"Cool\"; rules = \"cool\"; }\n"
+        "    activity { id = \"Hot\"; rules = \"hot\"; }\n"
+        "}\n");
+
+    safihr::FarmWeather kb;
+    kb.register_weather(10, 4, 3);
+    kb.plan().fill(plan);
+
+    const vmd::Activity& dry = kb.activities().get("Dry")->second;
+    const vmd::Activity& cool = kb.activities().get("Cool")->second;
+    const vmd::Activity& hot = kb.activities().get("Hot")->second;
+
+    kb.applyFact("rain", vle::value::Double(10.0));
+    kb.applyFact("etp", vle::value::Double(1.0));
+    BOOST_REQUIRE(not dry.validRules("Dry"));
+    BOOST_REQUIRE(cool.validRules("Cool"));
+
+    kb.applyFact("rain", vle::value::Double(1.0));
+    kb.applyFact("etp", vle::value::Double(10.0));
+    BOOST_REQUIRE(dry.validRules("Dry"));
+    BOOST_REQUIRE(not cool.validRules("Cool"));
+
+    BOOST_REQUIRE_THROW(hot.validRules("Hot"), vle::utils::ModellingError);
+    try {
+        hot.validRules("Hot");
+    } catch (const vle::utils::ModellingError& e) {
+        BOOST_REQUIRE_EQUAL(std::string(e.what()),
+                            "farmer predicate etp: unsupported operator >=");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_itk_catalogue)
+{
+    vle::utils::Package pack("safihr");
+    std::ifstream crops_file(pack.getDataFile("Crop.txt").c_str());
+    BOOST_REQUIRE(crops_file.is_open());
+
+    safihr::Crops crops;
+    crops_file >> crops;
+
+    // The ITK of the crops of the package, and a crop X with an invalid
+    // ITK-X.txt and no ITK0-X.txt.
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+
+    for (size_t i = 0; i < crops.crops.size(); ++i) {
+        const std::string names[] = {
+            "ITK0-" + crops.crops[i].id + ".txt",
+            "ITK-" + crops.crops[i].id + ".txt" };
+
+        for (int j = 0; j < 2; ++j)
+            boost::filesystem::copy_file(pack.getDataFile(names[j]),
+                                         dir / names[j]);
+    }
+
+    {
+        std::ofstream ofs((dir / "ITK-X.txt").string().c_str());
+        ofs << "activities { activity { id = \"A\"; }\n";
+    }
+
+    safihr::Crop invalid;
+    invalid.id = "X";
+    crops.crops.push_back(invalid);
+
+    const size_t loaded = 2 * (crops.crops.size() - 1);
+    safihr::ItkCatalogue sequential(crops, dir.string(), 1);
+    BOOST_REQUIRE_EQUAL(sequential.size(), loaded);
+
+    for (unsigned int workers = 2; workers <= 16; workers *= 2) {
+        safihr::ItkCatalogue itks(crops, dir.string(), workers);
+
+        BOOST_REQUIRE_EQUAL(itks.size(), loaded);
+        BOOST_REQUIRE_EQUAL(itks.errors().size(), 2u);
+        BOOST_REQUIRE(itks.errors().count("ITK-X.txt"));
+        BOOST_REQUIRE(itks.errors().count("ITK0-X.txt"));
+
+        for (safihr::ItkCatalogue::const_iterator it = sequential.begin();
+             it != sequential.end(); ++it) {
+            BOOST_REQUIRE_EQUAL(itks.get(it->first).activities(),
+                                it->second->view().activities());
+            BOOST_REQUIRE_EQUAL(itks.get(it->first).precedences(),
+                                it->second->view().precedences());
+        }
+
+        BOOST_REQUIRE_THROW(itks.get("ITK-X.txt"), vle::utils::ModellingError);
+        BOOST_REQUIRE_THROW(itks.get("ITK0-X.txt"),
+                            vle::utils::ModellingError);
+        BOOST_REQUIRE_THROW(itks.get("ITK-Y.txt"), vle::utils::ModellingError);
+
+        try {
+            itks.get("ITK-X.txt");
+        } catch (const vle::utils::ModellingError& e) {
+            BOOST_REQUIRE(std::string(e.what()).find(
+                    "itk: invalid ITK file ITK-X.txt: ") == 0);
+        }
+    }
+
+    boost::filesystem::remove_all(dir);
+}
@@ -31,17 +31,28 @@
 
 #include <vle/extension/decision/Activities.hpp>
 #include <vle/extension/decision/Activity.hpp>
+#include <vle/extension/decision/ActivityArchive.hpp>
+#include <vle/extension/decision/ActivityMetadata.hpp>
 #include <vle/extension/decision/Agent.hpp>
+#include <vle/extension/decision/DeadlineQueue.hpp>
+#include <vle/extension/decision/FactHistory.hpp>
 #include <vle/extension/decision/Facts.hpp>
+#include <vle/extension/decision/HorizonIndex.hpp>
 #include <vle/extension/decision/KnowledgeBase.hpp>
 #include <vle/extension/decision/Library.hpp>
+#include <vle/extension/decision/Number.hpp>
 #include <vle/extension/decision/Plan.hpp>
+#include <vle/extension/decision/PlanBinary.hpp>
+#include <vle/extension/decision/PlanParser.hpp>
+#include <vle/extension/decision/PlanPrototype.hpp>
 #include <vle/extension/decision/PrecedenceConstraint.hpp>
 #include <vle/extension/decision/PrecedencesGraph.hpp>
 #include <vle/extension/decision/Predicates.hpp>
 #include <vle/extension/decision/Rule.hpp>
 #include <vle/extension/decision/Rules.hpp>
+#include <vle/extension/decision/StaticPlan.hpp>
 #include <vle/extension/decision/Table.hpp>
+#include <vle/extension/decision/TemporalNetwork.hpp>
 #include <vle/extension/decision/Version.hpp>
 
 #endif
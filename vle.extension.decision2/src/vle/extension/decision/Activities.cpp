@@ -29,6 +29,8 @@
 #include <vle/extension/decision/Activities.hpp>
 #include <vle/utils/Exception.hpp>
 #include <vle/utils/i18n.hpp>
+#include <algorithm>
+#include <iterator>
 #include <numeric>
 
 namespace vle { namespace extension { namespace decision {
@@ -37,14 +39,10 @@ Activity& Activities::add(const std::string& name, const Activity& act,
                           const Activity::OutFct& out,
                           const Activity::AckFct& ack)
 {
-    iterator it(m_lst.find(name));
-
-    if (it != m_lst.end()) {
-        throw utils::ArgError(
-            vle::fmt(_("Decision: activity '%1%' already exist")) % name);
-    }
+    iterator inserted = create(name, act);
+    Activity& a(inserted->second);
+    track(inserted);
 
-    Activity& a((*m_lst.insert(value_type(name, act)).first).second);
     if (out) {
         a.addOutputFunction(out);
     }
@@ -60,14 +58,10 @@ Activity& Activities::add(const std::string& name,
                           const Activity::OutFct& out,
                           const Activity::AckFct& ack)
 {
-    iterator it(m_lst.find(name));
+    iterator inserted = create(name);
+    Activity& a(inserted->second);
+    track(inserted);
 
-    if (it != m_lst.end()) {
-        throw utils::ArgError(
-            vle::fmt(_("Decision: activity '%1%' already exist")) % name);
-    }
-
-    Activity& a((*m_lst.insert(value_type(name, Activity())).first).second);
     if (out) {
         a.addOutputFunction(out);
     }
@@ -99,6 +93,85 @@ Activity& Activities::add(const std::string& name,
     return result;
 }
 
+Activities::iterator Activities::emplace(const std::string& name)
+{
+    iterator inserted = create(name);
+    track(inserted);
+    return inserted;
+}
+
+Activities::iterator Activities::emplace(const std::string& name,
+                                         const Activity& act)
+{
+    iterator inserted = create(name, act);
+    track(inserted);
+    return inserted;
+}
+
+Activities::iterator Activities::adopt(const std::string& name,
+                                       Activity& act)
+{
+    iterator inserted = create(name);
+    inserted->second.swap(act);
+    track(inserted);
+    return inserted;
+}
+
+/**
+ * @brief Reserve room for extra elements without defeating the geometric
+ * growth of the vector when bulk insertions are repeated.
+ */
+template < typename V >
+static inline void reserveExtra(V& vector, std::size_t extra)
+{
+    const std::size_t needed = vector.size() + extra;
+
+    if (needed > vector.capacity()) {
+        vector.reserve(std::max(needed, 2 * vector.capacity()));
+    }
+}
+
+void Activities::reserve(size_type size)
+{
+    reserveExtra(m_added, size);
+
+    if (m_topological) {
+        reserveExtra(m_order, size);
+    }
+}
+
+Activities::iterator Activities::create(const std::string& name,
+                                        const Activity& act)
+{
+    std::pair < iterator, bool > inserted(m_lst.end(), false);
+
+    if (m_archive.empty() or not m_archive.exist(name)) {
+        inserted = m_lst.insert(value_type(name, act));
+    }
+
+    if (not inserted.second) {
+        throw utils::ArgError(
+            vle::fmt(_("Decision: activity '%1%' already exist")) % name);
+    }
+
+    return inserted.first;
+}
+
+void Activities::track(iterator activity)
+{
+    m_added.push_back(activity);
+    activity->second.m_lists = 0;
+    rank(activity);
+
+    if (m_propagation) {
+        m_network.touch(activity);
+    }
+
+    /* The first evaluation adds the activity to a state list. */
+    markDirty(activity);
+    m_listsStale = true;
+}
+
 void Activities::remove(const std::string& name)
 {
     iterator it(m_lst.find(name));
@@ -110,6 +183,22 @@ void Activities::remove(const std::string& name)
     m_lst.erase(it);
 }
 
+void Activities::addPrecedenceConstraint(const PrecedenceConstraint& pc)
+{
+    m_graph.add(pc);
+
+    if (m_topological and
+        pc.first()->second.m_rank >= pc.second()->second.m_rank) {
+        m_orderStale = true;
+    }
+
+    if (m_propagation) {
+        m_network.touch(find(pc.second()->first), true);
+    }
+
+    markDirty(pc.second());
+}
+
 void Activities::addStartToStartConstraint(const std::string& acti,
                                            const std::string& actj,
                                            const devs::Time& mintimelag,
@@ -142,13 +231,46 @@ void Activities::addFinishToStartConstraint(const std::string& acti,
 
 devs::Time Activities::nextDate(const devs::Time& time)
 {
-    devs::Time result = devs::infinity;
+    if (time < m_nextTimesDate) {
+        m_nextTimes.clear();
+        m_added.clear();
 
-    for (iterator activity = begin(); activity != end(); ++activity) {
-        result = std::min(result, activity->second.nextTime(time));
+        for (iterator activity = begin(); activity != end(); ++activity) {
+            m_added.push_back(activity);
+        }
     }
 
-    return result;
+    m_nextTimesDate = time;
+
+    for (result_t::iterator it = m_added.begin(); it != m_added.end(); ++it) {
+        devs::Time date = (*it)->second.nextTime(time);
+
+        if (date != devs::infinity) {
+            m_nextTimes.update(*it, date);
+        }
+    }
+    m_added.clear();
+
+    /*
+     * A date in the queue is never greater than the real next date of its
+     * activity: the top is the result if its date is still valid.
+     */
+    while (not m_nextTimes.empty()) {
+        iterator activity = m_nextTimes.top().activity;
+        devs::Time date = activity->second.nextTime(time);
+
+        if (date == m_nextTimes.top().date) {
+            return date;
+        }
+
+        if (date == devs::infinity) {
+            m_nextTimes.pop();
+        } else {
+            m_nextTimes.update(activity, date);
+        }
+    }
+
+    return devs::infinity;
 }
 
 Activities::const_result_t
@@ -158,6 +280,11 @@ Activities::beforeTimeHorizonAct(
 {
     Activities::const_result_t beforeHorizonAct;
 
+    if (m_horizon) {
+        m_horizonIndex.find(lowerBound, upperBound, beforeHorizonAct);
+        return beforeHorizonAct;
+    }
+
     for (const_iterator activity = begin(); activity != end(); ++activity) {
         switch (activity->second.state()) {
         case Activity::WAIT:
@@ -181,56 +308,59 @@ Activities::beforeTimeHorizonAct(
 
 void Activities::removeWaitedAct(Activities::iterator it)
 {
-    removeAct(m_waitedAct, it);
+    eraseAct(Waited, it);
 }
 
 void Activities::removeStartedAct(Activities::iterator it)
 {
-    removeAct(m_startedAct, it);
+    eraseAct(Started, it);
 }
 
 void Activities::removeFailedAct(Activities::iterator it)
 {
-    removeAct(m_failedAct, it);
+    eraseAct(Failed, it);
 }
 
 void Activities::removeFFAct(Activities::iterator it)
 {
-    removeAct(m_ffAct, it);
+    eraseAct(FF, it);
 }
 
 void Activities::removeEndedAct(Activities::iterator it)
 {
-    removeAct(m_endedAct, it);
+    eraseAct(Ended, it);
 }
 
 void Activities::addWaitedAct(Activities::iterator it)
 {
-    addAct(m_waitedAct, it);
+    pushAct(Waited, it);
 }
 
 void Activities::addStartedAct(Activities::iterator it)
 {
-    addAct(m_startedAct, it);
+    pushAct(Started, it);
 }
 
 void Activities::addFailedAct(Activities::iterator it)
 {
-    addAct(m_failedAct, it);
+    pushAct(Failed, it);
 }
 
 void Activities::addFFAct(Activities::iterator it)
 {
-    addAct(m_ffAct, it);
+    pushAct(FF, it);
 }
 
 void Activities::addEndedAct(Activities::iterator it)
 {
-    addAct(m_endedAct, it);
+    pushAct(Ended, it);
 }
 
 void Activities::setWaitedAct(Activities::iterator it)
 {
+    markDirty(it);
+    markSuccessorsDirty(it);
+
     switch (it->second.state()) {
     case Activity::WAIT:
         removeWaitedAct(it);
@@ -262,6 +392,9 @@ void Activities::setWaitedAct(Activities::iterator it)
 
 void Activities::setStartedAct(Activities::iterator it)
 {
+    markDirty(it);
+    markSuccessorsDirty(it);
+
     switch (it->second.state()) {
     case Activity::WAIT:
         removeWaitedAct(it);
@@ -289,6 +422,9 @@ void Activities::setStartedAct(Activities::iterator it)
 
 void Activities::setFailedAct(Activities::iterator it)
 {
+    markDirty(it);
+    markSuccessorsDirty(it);
+
     switch (it->second.state()) {
     case Activity::WAIT:
         removeWaitedAct(it);
@@ -316,6 +452,9 @@ void Activities::setFailedAct(Activities::iterator it)
 
 void Activities::setFFAct(Activities::iterator it)
 {
+    markDirty(it);
+    markSuccessorsDirty(it);
+
     switch (it->second.state()) {
     case Activity::WAIT:
         removeWaitedAct(it);
@@ -343,6 +482,9 @@ void Activities::setFFAct(Activities::iterator it)
 
 void Activities::setEndedAct(Activities::iterator it)
 {
+    markDirty(it);
+    markSuccessorsDirty(it);
+
     switch (it->second.state()) {
     case Activity::WAIT:
         removeWaitedAct(it);
@@ -384,69 +526,634 @@ void Activities::addAct(Activities::result_t& lst, Activities::iterator it)
 void Activities::updateLatestActivitiesList(Activities::result_t& lst,
                                             Activities::iterator it)
 {
-    removeAct(m_latestWaitedAct, it);
-    removeAct(m_latestStartedAct, it);
-    removeAct(m_latestEndedAct, it);
-    removeAct(m_latestFFAct, it);
-    removeAct(m_latestFailedAct, it);
+    for (int i = LatestWaited; i <= LatestEnded; ++i) {
+        eraseAct((List)i, it);
+    }
+
+    for (int i = Waited; i <= LatestEnded; ++i) {
+        if (&lst == &list((List)i)) {
+            pushAct((List)i, it);
+            return;
+        }
+    }
 
     addAct(lst, it);
 }
 
 void Activities::clearLatestActivitiesLists()
 {
-    m_latestWaitedAct.clear();
-    m_latestStartedAct.clear();
-    m_latestFFAct.clear();
-    m_latestFailedAct.clear();
-    m_latestEndedAct.clear();
+    for (int i = LatestWaited; i <= LatestEnded; ++i) {
+        clearAct((List)i);
+    }
+}
+
+Activities::result_t& Activities::list(List list) const
+{
+    switch (list) {
+    case Waited:
+        return m_waitedAct;
+    case Started:
+        return m_startedAct;
+    case Failed:
+        return m_failedAct;
+    case FF:
+        return m_ffAct;
+    case Ended:
+        return m_endedAct;
+    case LatestWaited:
+        return m_latestWaitedAct;
+    case LatestStarted:
+        return m_latestStartedAct;
+    case LatestFailed:
+        return m_latestFailedAct;
+    case LatestFF:
+        return m_latestFFAct;
+    case LatestEnded:
+        return m_latestEndedAct;
+    }
+
+    throw utils::InternalError(_("Decision: unknown activity list"));
+}
+
+/*
+ * The position stored in the activity is the position of its first
+ * occurrence in the list. An activity pushed again only increments the
+ * number of duplicates of the list.
+ */
+void Activities::pushAct(List list, iterator activity)
+{
+    result_t& lst = this->list(list);
+    Activity& act = activity->second;
+
+    if (act.m_lists & (1u << list)) {
+        ++m_duplicates[list];
+    } else {
+        act.m_lists |= 1u << list;
+        act.m_slots[list] = lst.size();
+    }
+
+    lst.push_back(activity);
+}
+
+/*
+ * Like the std::find and vector::erase of removeAct, remove the first
+ * occurrence of the activity. The list is searched for another occurrence
+ * only if it has duplicates.
+ */
+void Activities::eraseAct(List list, iterator activity)
+{
+    Activity& act = activity->second;
+
+    if (not (act.m_lists & (1u << list))) {
+        return;
+    }
+
+    result_t& lst = this->list(list);
+    std::size_t slot = act.m_slots[list];
+
+    lst[slot] = m_lst.end();
+    act.m_lists &= ~(1u << list);
+    ++m_holes;
+
+    if (m_duplicates[list] > 0) {
+        for (std::size_t i = slot + 1; i < lst.size(); ++i) {
+            if (lst[i] == activity) {
+                act.m_lists |= 1u << list;
+                act.m_slots[list] = i;
+                --m_duplicates[list];
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Remove the tail of the list. The removed occurrences are the first ones
+ * or duplicates.
+ */
+void Activities::truncateAct(List list, result_t::size_type size)
+{
+    result_t& lst = this->list(list);
+
+    for (result_t::size_type i = size; i < lst.size(); ++i) {
+        if (lst[i] == m_lst.end()) {
+            continue;
+        }
+
+        Activity& act = lst[i]->second;
+        if ((act.m_lists & (1u << list)) and act.m_slots[list] == i) {
+            act.m_lists &= ~(1u << list);
+        } else {
+            --m_duplicates[list];
+        }
+    }
+
+    lst.resize(size);
+}
+
+void Activities::clearAct(List list)
+{
+    result_t& lst = this->list(list);
+
+    for (result_t::iterator it = lst.begin(); it != lst.end(); ++it) {
+        if (*it != m_lst.end()) {
+            (*it)->second.m_lists &= ~(1u << list);
+        }
+    }
+
+    lst.clear();
+    m_duplicates[list] = 0;
+}
+
+void Activities::purge() const
+{
+    if (m_holes == 0) {
+        return;
+    }
+
+    for (int l = Waited; l <= LatestEnded; ++l) {
+        result_t& lst = list((List)l);
+        result_t::size_type j = 0;
+
+        for (result_t::size_type i = 0; i < lst.size(); ++i) {
+            if (const_iterator(lst[i]) == m_lst.end()) {
+                continue;
+            }
+
+            Activity& act = lst[i]->second;
+            if ((act.m_lists & (1u << l)) and act.m_slots[l] == i) {
+                act.m_slots[l] = j;
+            }
+            lst[j++] = lst[i];
+        }
+
+        lst.resize(j);
+    }
+
+    m_holes = 0;
 }
 
 Activities::Result
 Activities::process(const devs::Time& time)
 {
-    devs::Time nextDate = devs::infinity;
-    Result update = std::make_pair(false, devs::infinity);
-    bool isUpdated = false;
+    purge();
 
-    do {
-        m_waitedAct.clear();
-        m_startedAct.clear();
-        m_ffAct.clear();
-        m_failedAct.clear();
-        m_endedAct.clear();
+    if (m_compaction) {
+        compact();
+    }
+
+    if (m_topological and m_orderStale) {
+        rebuildOrder();
+    }
+
+    if (m_propagation) {
+        propagate(time);
+    }
+
+    m_cache.setTime(time);
+    m_passes = 0;
+
+    switch (m_mode) {
+    case Incremental:
+        return processIncremental(time);
+    case Differential:
+        return processDifferential(time);
+    case FullScan:
+    default:
+        return processFullScan(time, true);
+    }
+}
+
+void Activities::setTemporalPropagation(bool propagation)
+{
+    m_propagation = propagation;
+    m_network.clear();
 
+    if (not m_propagation) {
         for (iterator activity = begin(); activity != end(); ++activity) {
-            switch (activity->second.state()) {
-            case Activity::WAIT:
-                update = processWaitState(activity, time);
-                break;
+            Activity& act = activity->second;
+
+            if (not devs::isNegativeInfinity(act.m_earliest) or
+                not devs::isNegativeInfinity(act.m_earliestOffset)) {
+                act.m_earliest = devs::negativeInfinity;
+                act.m_earliestOffset = devs::negativeInfinity;
+                m_added.push_back(activity);
+                markDirty(activity);
+            }
+        }
+    }
+}
 
-            case Activity::STARTED:
-                update = processStartedState(activity, time);
-                break;
+/*
+ * The network only reports the activities whose bounds have been computed
+ * again or which have become infeasible with the date. The earliest start
+ * of the others grows with the date through their offset.
+ */
+void Activities::propagate(const devs::Time& time)
+{
+    m_network.propagate(m_lst, m_graph, time);
 
-            case Activity::FF:
-                update = processFFState(activity, time);
-                break;
+    const TemporalNetwork::result_t& changed = m_network.changed();
+    for (TemporalNetwork::result_t::const_iterator it = changed.begin();
+         it != changed.end(); ++it) {
+        iterator activity = *it;
+        Activity& act = activity->second;
 
-            case Activity::DONE:
-                update = processEndedState(activity, time);
-                break;
+        if (not act.isInWaitState()) {
+            continue;
+        }
 
-            case Activity::FAILED:
-                update = processFailedState(activity, time);
-                break;
+        devs::Time earliest = m_network.earliestStart(&act);
+        devs::Time offset = m_network.startOffset(&act);
+
+        if (earliest != act.m_earliest or offset != act.m_earliestOffset) {
+            act.m_earliest = earliest;
+            act.m_earliestOffset = offset;
+            m_added.push_back(activity);
+            markDirty(activity);
+        } else if (m_network.infeasible(&act)) {
+            markDirty(activity);
+        }
+    }
+}
+
+bool Activities::isArchivable(iterator activity) const
+{
+    if (not activity->second.isInDoneState() and
+        not activity->second.isInFailedState()) {
+        return false;
+    }
+
+    PrecedencesGraph::findIn in = m_graph.findPrecedenceIn(activity);
+    for (PrecedencesGraph::iteratorIn it = in.first; it != in.second; ++it) {
+        if (not it->first()->second.isInDoneState() and
+            not it->first()->second.isInFailedState()) {
+            return false;
+        }
+    }
+
+    PrecedencesGraph::findOut out = m_graph.findPrecedenceOut(activity);
+    for (PrecedencesGraph::iteratorOut it = out.first; it != out.second;
+         ++it) {
+        if (not it->second()->second.isInDoneState() and
+            not it->second()->second.isInFailedState()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Activities::size_type Activities::compact()
+{
+    purge();
+
+    std::set < const Activity* > latest;
+    const result_t* lists[] = { &m_latestWaitedAct, &m_latestStartedAct,
+        &m_latestFailedAct, &m_latestFFAct, &m_latestEndedAct };
+
+    for (int i = 0; i < 5; ++i) {
+        for (result_t::const_iterator it = lists[i]->begin();
+             it != lists[i]->end(); ++it) {
+            latest.insert(&(*it)->second);
+        }
+    }
+
+    result_t candidates(m_endedAct);
+    candidates.insert(candidates.end(), m_failedAct.begin(),
+                      m_failedAct.end());
+
+    std::set < const Activity* > archived;
+    std::vector < PrecedenceConstraint > removed;
+
+    for (result_t::iterator it = candidates.begin(); it != candidates.end();
+         ++it) {
+        iterator activity = *it;
+
+        if (latest.find(&activity->second) != latest.end() or
+            not isArchivable(activity)) {
+            continue;
+        }
+
+        if (m_propagation) {
+            m_network.erase(activity, m_graph);
+        }
+
+        removed.clear();
+        m_graph.remove(activity, removed);
+        for (std::vector < PrecedenceConstraint >::const_iterator jt =
+             removed.begin(); jt != removed.end(); ++jt) {
+            m_archive.add(*jt);
+        }
+
+        m_archive.add(activity->first, activity->second);
+        archived.insert(&activity->second);
+    }
+
+    if (archived.empty()) {
+        return 0;
+    }
+
+    for (result_t::iterator it = candidates.begin(); it != candidates.end();
+         ++it) {
+        if (archived.find(&(*it)->second) != archived.end()) {
+            while ((*it)->second.m_lists & (1u << Ended)) {
+                eraseAct(Ended, *it);
+            }
+            while ((*it)->second.m_lists & (1u << Failed)) {
+                eraseAct(Failed, *it);
+            }
+        }
+    }
+    purge();
+
+    {
+        result_t kept;
+        for (result_t::iterator it = m_added.begin(); it != m_added.end();
+             ++it) {
+            if (archived.find(&(*it)->second) == archived.end()) {
+                kept.push_back(*it);
+            }
+        }
+        m_added.swap(kept);
+    }
+
+    for (result_t::iterator it = candidates.begin(); it != candidates.end();
+         ++it) {
+        iterator activity = *it;
+
+        if (archived.find(&activity->second) != archived.end()) {
+            forget(activity);
+        }
+    }
+
+    /* The addresses of the archived activities are keys of the cache. */
+    m_cache.clear();
+
+    return archived.size();
+}
+
+void Activities::forget(iterator activity)
+{
+    m_nextTimes.erase(activity);
+    m_evaluated.erase(&activity->second);
+    m_wakes.erase(activity);
+    m_nexts.erase(activity);
+    m_blocked.erase(&activity->second);
+    m_dirty.erase(activity);
+    m_pass.erase(activity);
+    m_horizonIndex.erase(activity);
+    m_lst.erase(activity);
+    m_orderStale = m_topological;
+}
+
+void Activities::setHorizonIndex(bool horizon)
+{
+    m_horizon = horizon;
+
+    if (m_horizon) {
+        m_horizonIndex.assign(m_lst);
+    } else {
+        m_horizonIndex.clear();
+    }
+}
+
+void Activities::setProcessMode(ProcessMode mode)
+{
+    m_mode = mode;
+    m_evaluated.clear();
+    m_wakes.clear();
+    m_nexts.clear();
+    m_blocked.clear();
+    m_dirty.clear();
+    m_pass.clear();
+    m_listsStale = true;
+
+    if (m_mode != FullScan) {
+        for (iterator activity = begin(); activity != end(); ++activity) {
+            m_dirty.insert(activity);
+        }
+    }
+}
+
+void Activities::setTopologicalOrder(bool topological)
+{
+    m_topological = topological;
+
+    if (m_topological) {
+        rebuildOrder();
+    } else {
+        for (iterator activity = begin(); activity != end(); ++activity) {
+            activity->second.m_rank = 0;
+        }
+
+        m_order.clear();
+        m_rank = 0;
+        m_cycles = 0;
+        m_orderStale = false;
+        m_listsStale = true;
+
+        dirty_t dirty(m_dirty.begin(), m_dirty.end());
+        m_dirty.swap(dirty);
+        dirty_t pass(m_pass.begin(), m_pass.end());
+        m_pass.swap(pass);
+    }
+}
+
+void Activities::rank(iterator activity)
+{
+    if (m_topological) {
+        activity->second.m_rank = ++m_rank;
+        m_order.push_back(activity);
+    } else {
+        activity->second.m_rank = 0;
+    }
+}
+
+/*
+ * Kahn's algorithm: an activity is ready when all its predecessors are
+ * ordered and the ready activities are ordered by name. If no activity is
+ * ready, the remaining activities are in cycles (e.g. the SS and FF
+ * constraints of a During relation): the first one by name is ordered
+ * before its predecessors.
+ */
+void Activities::rebuildOrder()
+{
+    std::set < iterator, CompareName > ready;
+    boost::unordered_map < const Activity*, std::size_t > degrees;
+    iterator remaining = begin();
 
-            default:
-                throw utils::InternalError(_("Decision: unknown state"));
+    m_order.clear();
+    m_order.reserve(m_lst.size());
+    m_cycles = 0;
+
+    for (iterator activity = begin(); activity != end(); ++activity) {
+        PrecedencesGraph::findIn in = m_graph.findPrecedenceIn(activity);
+        std::size_t degree = std::distance(in.first, in.second);
+
+        if (degree == 0) {
+            ready.insert(activity);
+        } else {
+            degrees[&activity->second] = degree;
+        }
+    }
+
+    while (m_order.size() < m_lst.size()) {
+        if (ready.empty()) {
+            while (degrees[&remaining->second] == 0) {
+                ++remaining;
             }
+            degrees[&remaining->second] = 0;
+            ready.insert(remaining);
+            ++m_cycles;
+        }
+
+        iterator activity = *ready.begin();
+        ready.erase(ready.begin());
+        m_order.push_back(activity);
+        activity->second.m_rank = m_order.size();
+
+        PrecedencesGraph::findOut out = m_graph.findPrecedenceOut(activity);
+        for (PrecedencesGraph::iteratorOut it = out.first; it != out.second;
+             ++it) {
+            std::size_t& degree = degrees[&it->second()->second];
+
+            if (degree > 0 and --degree == 0) {
+                ready.insert(find(it->second()->first));
+            }
+        }
+    }
+
+    m_rank = m_order.size();
+    m_orderStale = false;
+    m_listsStale = true;
+
+    /* The ranks changed: the sets are sorted again. */
+    dirty_t dirty(m_dirty.begin(), m_dirty.end());
+    m_dirty.swap(dirty);
+    dirty_t pass(m_pass.begin(), m_pass.end());
+    m_pass.swap(pass);
+}
+
+void Activities::factsChanged()
+{
+    m_cache.factsChanged();
+
+    for (blocked_t::iterator it = m_blocked.begin(); it != m_blocked.end();
+         ++it) {
+        markDirty(it->second);
+    }
+}
+
+void Activities::markDirty(iterator activity)
+{
+    if (m_horizon) {
+        m_horizonIndex.invalidate(activity);
+    }
+
+    if (m_mode == FullScan) {
+        return;
+    }
+
+    if (m_inPass and CompareOrder()(m_cursor, activity)) {
+        m_pass.insert(activity);
+    } else {
+        m_dirty.insert(activity);
+    }
+}
+
+void Activities::markDirty(const_iterator activity)
+{
+    if (m_mode != FullScan or m_horizon) {
+        markDirty(find(activity->first));
+    }
+}
+
+/*
+ * Called when the state of the activity changes: the state lists are no
+ * longer in the processing order and are rebuilt by the incremental engine,
+ * and the temporal network computes the bounds of the activity again.
+ */
+void Activities::markSuccessorsDirty(iterator activity)
+{
+    if (m_propagation) {
+        m_network.touch(activity);
+    }
+
+    if (m_mode == FullScan) {
+        return;
+    }
+
+    m_listsStale = true;
+
+    PrecedencesGraph::findOut out = m_graph.findPrecedenceOut(activity);
+    for (PrecedencesGraph::iteratorOut it = out.first; it != out.second;
+         ++it) {
+        markDirty(it->second());
+    }
+}
+
+Activities::Result
+Activities::evaluate(iterator activity, const devs::Time& time,
+                     bool* blocked)
+{
+    Result result;
+    Activity::State state = activity->second.state();
+
+    switch (state) {
+    case Activity::WAIT:
+        result = processWaitState(activity, time, blocked);
+        break;
+    case Activity::STARTED:
+        result = processStartedState(activity, time);
+        break;
+    case Activity::FF:
+        result = processFFState(activity, time);
+        break;
+    case Activity::DONE:
+        result = processEndedState(activity, time);
+        break;
+    case Activity::FAILED:
+        result = processFailedState(activity, time);
+        break;
+    default:
+        throw utils::InternalError(_("Decision: unknown state"));
+    }
+
+    if (m_horizon and state != activity->second.state()) {
+        m_horizonIndex.invalidate(activity);
+    }
+
+    if (m_propagation and state != activity->second.state()) {
+        m_network.touch(activity);
+    }
+
+    return result;
+}
+
+Activities::Result
+Activities::processFullScan(const devs::Time& time, bool updates)
+{
+    devs::Time nextDate = devs::infinity;
+    Result update = std::make_pair(false, devs::infinity);
+    bool isUpdated = false;
+
+    do {
+        for (int i = Waited; i <= Ended; ++i) {
+            clearAct((List)i);
+        }
+        ++m_passes;
+
+        result_t::size_type position = 0;
+        for (iterator activity = firstInOrder(); activity != end();
+             activity = nextInOrder(activity, position)) {
+            update = evaluate(activity, time, 0);
 
             if (not isUpdated and update.first) {
                 isUpdated = true;
             }
 
-            if (update.first) {
+            if (updates and update.first) {
                 activity->second.update(activity->first);
             }
 
@@ -466,31 +1173,383 @@ Activities::process(const devs::Time& time)
     return std::make_pair(isUpdated, nextDate);
 }
 
+/*
+ * The incremental engine reproduces the passes of the full scan: the dirty
+ * activities are evaluated in the processing order (by name or
+ * topological), an activity marked after the cursor is evaluated in the
+ * current pass and an activity marked before the cursor in the next pass.
+ * Like the full scan, a new pass starts only if the last activity of the
+ * order was updated.
+ * Activities not evaluated during the first pass contribute to the next
+ * date with the dates computed during their latest evaluation.
+ */
+Activities::Result
+Activities::processIncremental(const devs::Time& time)
+{
+    devs::Time nextDate = devs::infinity;
+    bool isUpdated = false;
+    bool again = false;
+    bool first = true;
+
+    {
+        std::vector < DeadlineQueue::Element > reached;
+
+        while (not m_wakes.empty() and m_wakes.top().date <= time) {
+            DeadlineQueue::Element top = m_wakes.top();
+            m_wakes.pop();
+
+            if (m_evaluated[&top.activity->second] != time) {
+                markDirty(top.activity);
+            } else {
+                reached.push_back(top);
+            }
+        }
+
+        for (std::vector < DeadlineQueue::Element >::iterator it =
+             reached.begin(); it != reached.end(); ++it) {
+            m_wakes.update(it->activity, it->date);
+        }
+    }
+
+    /*
+     * The process functions append the evaluated activities to the state
+     * lists. If no state changed, the lists are truncated to their initial
+     * sizes, otherwise they are rebuilt.
+     */
+    result_t::size_type sizes[Ended + 1];
+    for (int i = Waited; i <= Ended; ++i) {
+        sizes[i] = list((List)i).size();
+    }
+
+    m_inPass = true;
+
+    try {
+        do {
+            again = false;
+            m_pass.swap(m_dirty);
+            ++m_passes;
+
+            while (not m_pass.empty()) {
+                iterator activity = *m_pass.begin();
+                m_pass.erase(m_pass.begin());
+                m_cursor = activity;
+
+                bool blocked = false;
+                Result update = evaluate(activity, time, &blocked);
+                devs::Time next = devs::infinity;
+
+                if (update.first) {
+                    isUpdated = true;
+                    activity->second.update(activity->first);
+                }
+
+                if (update.second != time and
+                    update.second != devs::negativeInfinity) {
+                    next = std::min(next, update.second);
+                }
+
+                devs::Time nextActivityDate = activity->second.nextTime(time);
+                if (nextActivityDate != time and
+                    nextActivityDate != devs::negativeInfinity) {
+                    next = std::min(next, nextActivityDate);
+                }
+
+                nextDate = std::min(nextDate, next);
+                m_evaluated[&activity->second] = time;
+
+                if (activity->second.isInDoneState() or
+                    activity->second.isInFailedState()) {
+                    m_wakes.erase(activity);
+                    m_nexts.erase(activity);
+                } else {
+                    m_wakes.update(activity, wakeTime(activity, time));
+                    m_nexts.update(activity, next);
+
+                    if (update.first) {
+                        markDirty(activity);
+                    }
+                }
+
+                if (blocked) {
+                    m_blocked[&activity->second] = activity;
+                } else {
+                    m_blocked.erase(&activity->second);
+                }
+
+                if (update.first) {
+                    markSuccessorsDirty(activity);
+                }
+
+                again = update.first and activity == lastInOrder();
+            }
+
+            if (first and not m_nexts.empty()) {
+                nextDate = std::min(nextDate, m_nexts.top().date);
+            }
+            first = false;
+        } while (again);
+    } catch (...) {
+        m_inPass = false;
+        throw;
+    }
+
+    m_inPass = false;
+
+    if (m_listsStale) {
+        rebuildLists();
+    } else {
+        for (int i = Waited; i <= Ended; ++i) {
+            truncateAct((List)i, sizes[i]);
+        }
+    }
+
+    return std::make_pair(isUpdated, nextDate);
+}
+
+void Activities::rebuildLists()
+{
+    for (int i = Waited; i <= Ended; ++i) {
+        clearAct((List)i);
+    }
+
+    result_t::size_type position = 0;
+    for (iterator activity = firstInOrder(); activity != end();
+         activity = nextInOrder(activity, position)) {
+        if (m_evaluated.find(&activity->second) == m_evaluated.end()) {
+            continue;
+        }
+
+        switch (activity->second.state()) {
+        case Activity::WAIT:
+            pushAct(Waited, activity);
+            break;
+        case Activity::STARTED:
+            pushAct(Started, activity);
+            break;
+        case Activity::FF:
+            pushAct(FF, activity);
+            break;
+        case Activity::DONE:
+            pushAct(Ended, activity);
+            break;
+        case Activity::FAILED:
+            pushAct(Failed, activity);
+            break;
+        }
+    }
+
+    m_listsStale = false;
+}
+
+static inline void keepEarliest(devs::Time& result, const devs::Time& date,
+                                const devs::Time& time)
+{
+    if (time <= date and date < result) {
+        result = date;
+    }
+}
+
+devs::Time Activities::wakeTime(iterator activity,
+                                const devs::Time& time) const
+{
+    devs::Time result = devs::infinity;
+    const Activity& act = activity->second;
+
+    if (act.isInDoneState() or act.isInFailedState()) {
+        return result;
+    }
+
+    if (act.date() & Activity::START) {
+        keepEarliest(result, act.start(), time);
+    }
+    if (act.date() & Activity::FINISH) {
+        keepEarliest(result, act.finish(), time);
+    }
+    if (act.date() & Activity::MINS) {
+        keepEarliest(result, act.minstart(), time);
+    }
+    if (act.date() & Activity::MAXS) {
+        keepEarliest(result, act.maxstart(), time);
+    }
+    if (act.date() & Activity::MINF) {
+        keepEarliest(result, act.minfinish(), time);
+    }
+    if (act.date() & Activity::MAXF) {
+        keepEarliest(result, act.maxfinish(), time);
+    }
+
+    PrecedencesGraph::findIn in = m_graph.findPrecedenceIn(activity);
+    for (PrecedencesGraph::iteratorIn it = in.first; it != in.second; ++it) {
+        const Activity& first = it->first()->second;
+        const devs::Time dates[] = { first.startedDate(), first.ffDate(),
+            first.doneDate() };
+
+        for (int i = 0; i < 3; ++i) {
+            keepEarliest(result, dates[i], time);
+            keepEarliest(result, dates[i] + it->mintimelag(), time);
+            keepEarliest(result, dates[i] + it->maxtimelag(), time);
+        }
+    }
+
+    return result;
+}
+
+struct Activities::Snapshot
+{
+    std::vector < std::pair < iterator, Activity > > activities;
+    result_t lists[10];
+    std::size_t duplicates[10];
+};
+
+void Activities::save(Snapshot& snapshot) const
+{
+    purge();
+    snapshot.activities.clear();
+
+    for (activities_t::const_iterator it = m_lst.begin(); it != m_lst.end();
+         ++it) {
+        iterator activity = const_cast < activities_t& >(m_lst).find(
+            it->first);
+        snapshot.activities.push_back(
+            std::make_pair(activity, activity->second));
+    }
+
+    for (int i = Waited; i <= LatestEnded; ++i) {
+        snapshot.lists[i] = list((List)i);
+        snapshot.duplicates[i] = m_duplicates[i];
+    }
+}
+
+void Activities::restore(const Snapshot& snapshot)
+{
+    for (std::vector < std::pair < iterator, Activity > >::const_iterator it =
+         snapshot.activities.begin(); it != snapshot.activities.end(); ++it) {
+        it->first->second = it->second;
+    }
+
+    for (int i = Waited; i <= LatestEnded; ++i) {
+        list((List)i) = snapshot.lists[i];
+        m_duplicates[i] = snapshot.duplicates[i];
+    }
+    m_holes = 0;
+
+    /* Restored activities can have an earlier next date. */
+    m_nextTimesDate = devs::infinity;
+
+    if (m_horizon) {
+        for (iterator activity = begin(); activity != end(); ++activity) {
+            m_horizonIndex.invalidate(activity);
+        }
+    }
+}
+
+void Activities::compare(const Snapshot& expected,
+                         const Result& expectedResult,
+                         const Result& result) const
+{
+    std::set < const Activity* > known;
+
+    purge();
+
+    for (std::vector < std::pair < iterator, Activity > >::const_iterator it =
+         expected.activities.begin(); it != expected.activities.end(); ++it) {
+        const Activity& a = it->first->second;
+        const Activity& b = it->second;
+
+        if (a.state() != b.state() or a.startedDate() != b.startedDate() or
+            a.ffDate() != b.ffDate() or a.doneDate() != b.doneDate()) {
+            throw utils::InternalError(
+                vle::fmt(_("Decision: incremental process differs from the "
+                           "full scan on activity '%1%'")) % it->first->first);
+        }
+        known.insert(&a);
+    }
+
+    const result_t* lists[] = { &m_waitedAct, &m_startedAct, &m_failedAct,
+        &m_ffAct, &m_endedAct, &m_latestWaitedAct, &m_latestStartedAct,
+        &m_latestFailedAct, &m_latestFFAct, &m_latestEndedAct };
+
+    for (int i = 0; i < 10; ++i) {
+        result_t filtered;
+
+        for (result_t::const_iterator it = lists[i]->begin();
+             it != lists[i]->end(); ++it) {
+            if (known.find(&(*it)->second) != known.end()) {
+                filtered.push_back(*it);
+            }
+        }
+
+        if (filtered != expected.lists[i]) {
+            throw utils::InternalError(
+                vle::fmt(_("Decision: incremental process differs from the "
+                           "full scan on the list %1%")) % i);
+        }
+    }
+
+    if (expectedResult != result) {
+        throw utils::InternalError(
+            vle::fmt(_("Decision: incremental process differs from the "
+                       "full scan: (%1%, %2%) instead of (%3%, %4%)")) %
+            result.first % result.second % expectedResult.first %
+            expectedResult.second);
+    }
+}
+
+/*
+ * The full scan is run first without the update functions, its results
+ * are saved and the activities are restored before running the incremental
+ * engine. Update functions which modify the plan are not supported.
+ */
+Activities::Result
+Activities::processDifferential(const devs::Time& time)
+{
+    Snapshot before, expected;
+
+    save(before);
+    Result expectedResult = processFullScan(time, false);
+    save(expected);
+    restore(before);
+
+    Result result = processIncremental(time);
+    compare(expected, expectedResult, result);
+
+    return result;
+}
+
 Activities::Result
 Activities::processWaitState(iterator activity,
-                             const devs::Time& time)
+                             const devs::Time& time,
+                             bool* blocked)
 {
-    PrecedenceConstraint::Result newstate = updateState(activity, time);
+    PrecedenceConstraint::Result newstate =
+        m_propagation and m_network.infeasible(&activity->second) ?
+        std::make_pair(PrecedenceConstraint::Failed, devs::infinity) :
+        updateState(activity, time);
     Result update = std::make_pair(false, newstate.second);
 
     switch (newstate.first) {
     case PrecedenceConstraint::Valid:
     case PrecedenceConstraint::Inapplicable:
-        if (activity->second.validRules(activity->first)) {
+        if (activity->second.validRules(activity->first,
+                                        m_cache.enabled() ? &m_cache : 0)) {
             activity->second.start(time);
-            m_startedAct.push_back(activity);
-            m_latestStartedAct.push_back(activity);
+            pushAct(Started, activity);
+            pushAct(LatestStarted, activity);
             update.first = true;
             break;
         }
+
+        if (blocked) {
+            *blocked = true;
+        }
     case PrecedenceConstraint::Wait:
-        m_waitedAct.push_back(activity);
+        pushAct(Waited, activity);
         update.first = false;
         break;
     case PrecedenceConstraint::Failed:
         activity->second.fail(time);
-        m_failedAct.push_back(activity);
-        m_latestFailedAct.push_back(activity);
+        pushAct(Failed, activity);
+        pushAct(LatestFailed, activity);
         update.first = true;
         break;
     }
@@ -509,13 +1568,13 @@ Activities::processStartedState(iterator activity,
     case PrecedenceConstraint::Valid:
     case PrecedenceConstraint::Inapplicable:
     case PrecedenceConstraint::Wait:
-        m_startedAct.push_back(activity);
+        pushAct(Started, activity);
         update.first = false;
         break;
     case PrecedenceConstraint::Failed:
         activity->second.fail(time);
-        m_failedAct.push_back(activity);
-        m_latestFailedAct.push_back(activity);
+        pushAct(Failed, activity);
+        pushAct(LatestFailed, activity);
         update.first = true;
         break;
     }
@@ -534,18 +1593,18 @@ Activities::processFFState(iterator activity,
     case PrecedenceConstraint::Valid:
     case PrecedenceConstraint::Inapplicable:
         activity->second.end(time);
-        m_endedAct.push_back(activity);
-        m_latestEndedAct.push_back(activity);
+        pushAct(Ended, activity);
+        pushAct(LatestEnded, activity);
         update.first = true;
         break;
     case PrecedenceConstraint::Wait:
-        m_ffAct.push_back(activity);
+        pushAct(FF, activity);
         update.first = false;
         break;
     case PrecedenceConstraint::Failed:
         activity->second.fail(time);
-        m_failedAct.push_back(activity);
-        m_latestFailedAct.push_back(activity);
+        pushAct(Failed, activity);
+        pushAct(LatestFailed, activity);
         update.first = true;
         break;
     }
@@ -558,7 +1617,7 @@ Activities::processFailedState(iterator activity,
                                const devs::Time& /* time */)
 {
     Result update = std::make_pair(false, devs::infinity);
-    m_failedAct.push_back(activity);
+    pushAct(Failed, activity);
     return update;
 }
 
@@ -567,7 +1626,7 @@ Activities::processEndedState(iterator activity,
                               const devs::Time& /* time */)
 {
     Result update = std::make_pair(false, devs::infinity);
-    m_endedAct.push_back(activity);
+    pushAct(Ended, activity);
     return update;
 }
 
@@ -30,9 +30,15 @@
 #define VLE_EXT_DECISION_ACTIVITIES_HPP 1
 
 #include <vle/extension/decision/Activity.hpp>
+#include <vle/extension/decision/ActivityArchive.hpp>
+#include <vle/extension/decision/DeadlineQueue.hpp>
+#include <vle/extension/decision/HorizonIndex.hpp>
 #include <vle/extension/decision/PrecedenceConstraint.hpp>
 #include <vle/extension/decision/PrecedencesGraph.hpp>
+#include <vle/extension/decision/TemporalNetwork.hpp>
 #include <vle/utils/Exception.hpp>
+#include <boost/unordered_map.hpp>
+#include <set>
 
 namespace vle { namespace extension { namespace decision {
 
@@ -54,6 +60,28 @@ public:
      */
     typedef std::pair < bool, devs::Time > Result;
 
+    /**
+     * @brief Define how the process function evaluates the activities.
+     */
+    enum ProcessMode {
+        FullScan, /**< Each pass evaluates all the activities (default). */
+        Incremental, /**< Each pass evaluates only the dirty activities. */
+        Differential /**< Run the full scan and the incremental engine and
+                       throw an utils::InternalError if they disagree. */
+    };
+
+    Activities()
+        : m_compaction(false), m_horizon(false),
+        m_nextTimesDate(devs::negativeInfinity),
+        m_mode(FullScan), m_inPass(false), m_listsStale(true),
+        m_topological(false), m_orderStale(false), m_rank(0), m_cycles(0),
+        m_passes(0), m_propagation(false), m_holes(0)
+    {
+        for (int i = 0; i < 10; ++i) {
+            m_duplicates[i] = 0;
+        }
+    }
+
     Activity& add(const std::string& name,
                   const Activity& act,
                   const Activity::OutFct& out = Activity::OutFct(),
@@ -67,10 +95,49 @@ public:
                   const Activity::OutFct& out = Activity::OutFct(),
                   const Activity::AckFct& ack = Activity::AckFct());
 
+    /**
+     * @brief Add a default activity built in place and get its iterator,
+     * without the lookup of a get call.
+     * @param name The name of the activity.
+     * @return An iterator to the new activity.
+     * @throw utils::ArgError if the activity already exists.
+     */
+    iterator emplace(const std::string& name);
+
+    /**
+     * @brief Add a copy of an activity. The copy is built in the node of
+     * the container and shares the rules and the functions of act.
+     * @param name The name of the activity.
+     * @param act The activity to copy.
+     * @return An iterator to the new activity.
+     * @throw utils::ArgError if the activity already exists.
+     */
+    iterator emplace(const std::string& name, const Activity& act);
+
+    /**
+     * @brief Add an activity by exchanging its content with the new one:
+     * nothing is copied and act is left as a default activity.
+     * @param name The name of the activity.
+     * @param act The activity to move into the container.
+     * @return An iterator to the new activity.
+     * @throw utils::ArgError if the activity already exists.
+     */
+    iterator adopt(const std::string& name, Activity& act);
+
+    /**
+     * @brief Prepare the addition of activities: the vectors which grow
+     * with each activity are reserved once.
+     * @param size The number of activities to add.
+     */
+    void reserve(size_type size);
+
     void remove(const std::string& name);
 
-    void addPrecedenceConstraint(const PrecedenceConstraint& pc)
-    { m_graph.add(pc); }
+    /**
+     * @brief Add a precedence constraint between two activities.
+     * @param pc The constraint.
+     */
+    void addPrecedenceConstraint(const PrecedenceConstraint& pc);
 
     /**
      * @brief The predecessor activity (i) must start before the successor
@@ -148,7 +215,9 @@ public:
     { addFinishToStartConstraint(acti, actj, 0, maxtimelag); }
 
     /**
-     * @brief Compute the next date when change in activity status.
+     * @brief Compute the next date when change in activity status. The
+     * dates are stored in a deadline queue so this function runs in
+     * O(log N) amortized if the time does not decrease between calls.
      * @param time The current time.
      * @return A date in range ]devs::Time::negativeInfinity,
      * devs::Time::infinity[.
@@ -162,6 +231,142 @@ public:
      */
     Result process(const devs::Time& time);
 
+    /**
+     * @brief Select the engine used by the process function. Switching to
+     * the Incremental or Differential mode marks all activities dirty.
+     *
+     * The incremental engine re-evaluates an activity only if its state
+     * changed, if one of its predecessors changed, if a date of its time
+     * window or of its precedence constraints is reached or if facts
+     * changed while its rules were rejected. Consequently, activities must
+     * be changed through the Activities or KnowledgeBase API and the
+     * predicates must only depend on the facts.
+     * @param mode The new engine.
+     */
+    void setProcessMode(ProcessMode mode);
+
+    ProcessMode processMode() const { return m_mode; }
+
+    /**
+     * @brief Enable or disable the topological order. If enabled, the
+     * process function evaluates the activities in a topological order of
+     * the precedence constraints, the ties being broken by name, instead of
+     * the order of the names. A predecessor is evaluated before its
+     * successors and a chain of constraints is usually resolved by a single
+     * pass.
+     *
+     * The order is kept up to date when activities are added and is
+     * rebuilt by the next call to the process function when a constraint
+     * is added against the order or when activities are archived.
+     * @param topological true to enable the topological order.
+     */
+    void setTopologicalOrder(bool topological);
+
+    bool topologicalOrder() const { return m_topological; }
+
+    /**
+     * @brief Get the number of cycles of precedence constraints found by
+     * the latest build of the topological order. A cycle is broken by
+     * ordering one of its activities before its predecessors, by name.
+     * Cycles are legal, the SS and FF constraints of a During relation
+     * make one, but a pass may not be enough to resolve them.
+     * @return The number of broken cycles.
+     */
+    size_type cycles() const { return m_cycles; }
+
+    /**
+     * @brief Get the number of passes over the activities done by the
+     * latest call to the process function. In Differential mode, the
+     * passes of the two engines are counted.
+     * @return The number of passes.
+     */
+    unsigned int passes() const { return m_passes; }
+
+    /**
+     * @brief Enable or disable the temporal propagation. If enabled, each
+     * call to the process function first propagates the time windows of
+     * the activities along the SS and FS constraints. An activity in wait
+     * state which cannot start anymore, for instance because a chain of
+     * predecessors cannot finish before its deadline, fails at once
+     * instead of at its deadline, and its next date is not before its
+     * earliest start. The network is kept between the calls: only the
+     * activities added, or whose state or constraints have changed, and
+     * their successors are propagated again.
+     * @param propagation true to enable the temporal propagation.
+     */
+    void setTemporalPropagation(bool propagation);
+
+    bool temporalPropagation() const { return m_propagation; }
+
+    /**
+     * @brief Get the temporal network of the latest propagation.
+     * @return A reference to the temporal network.
+     */
+    const TemporalNetwork& temporalNetwork() const { return m_network; }
+
+    /**
+     * @brief Notify the incremental engine and the predicate cache that
+     * facts have changed. The activities waiting only for their rules are
+     * evaluated by the next call to the process function.
+     */
+    void factsChanged();
+
+    /**
+     * @brief Enable or disable the compaction. If enabled, each call to the
+     * process function starts with a call to the compact function.
+     * @param compaction true to enable the compaction.
+     */
+    void setCompaction(bool compaction) { m_compaction = compaction; }
+
+    bool compaction() const { return m_compaction; }
+
+    /**
+     * @brief Move the activities in DONE or FAILED state into the archive
+     * if all their predecessors and successors are in DONE or FAILED state
+     * and if they are not in the latest lists. Their precedence constraints
+     * are moved into the archive too. Archived activities are no longer
+     * reachable with the get function, use the archive function instead.
+     * @return The number of archived activities.
+     */
+    size_type compact();
+
+    /**
+     * @brief Get the activities removed by the compaction.
+     * @return A reference to the archive.
+     */
+    const ActivityArchive& archive() const { return m_archive; }
+
+    /**
+     * @brief Enable or disable the horizon index. If enabled, the
+     * beforeTimeHorizonAct function searches an interval tree of the time
+     * windows of the activities in wait state instead of scanning all the
+     * activities. The activities are then returned by earliest start, then
+     * by name, instead of by name only.
+     *
+     * An activity is read again by the next query after a change of state
+     * or a call to a set function. Consequently, the time window of an
+     * activity must not be changed after its first evaluation.
+     * @param horizon true to enable the horizon index.
+     */
+    void setHorizonIndex(bool horizon);
+
+    bool horizonIndex() const { return m_horizon; }
+
+    /**
+     * @brief Enable or disable the predicate cache. If enabled, the results
+     * of the predicates with a scope are stored until the time changes or
+     * until the factsChanged function is called. Facts must be changed with
+     * the KnowledgeBase::applyFact function.
+     * @param cache true to enable the predicate cache.
+     */
+    void setPredicateCache(bool cache) { m_cache.setEnabled(cache); }
+
+    /**
+     * @brief Get the predicate cache.
+     * @return A reference to the cache.
+     */
+    const PredicateCache& predicateCache() const { return m_cache; }
+
     /**
      * @brief Returns true if the activity exists, false otherwise
      * @param name the name of an activity
@@ -180,7 +385,7 @@ public:
 
     const_iterator get(const std::string& name) const
     {
-        const_iterator it = m_lst.find(name);
+        const_iterator it = find(name);
         if (it == m_lst.end()) {
             throw utils::ArgError(
                 vle::fmt(_("Decision: unknown activity '%1%'")) % name);
@@ -190,7 +395,7 @@ public:
 
     iterator get(const std::string& name)
     {
-        iterator it = m_lst.find(name);
+        iterator it = find(name);
         if (it == m_lst.end()) {
             throw utils::ArgError(
                 vle::fmt(_("Decision: unknown activity '%1%'")) % name);
@@ -202,27 +407,35 @@ public:
     { return m_graph; }
 
     const Activities::result_t& waitedAct() const
-    { return m_waitedAct; }
+    { purge(); return m_waitedAct; }
     const Activities::result_t& startedAct() const
-    { return m_startedAct; }
+    { purge(); return m_startedAct; }
     const Activities::result_t& failedAct() const
-    { return m_failedAct; }
+    { purge(); return m_failedAct; }
     const Activities::result_t& doneAct() const
-    { return m_ffAct; }
+    { purge(); return m_ffAct; }
     const Activities::result_t& endedAct() const
-    { return m_endedAct; }
+    { purge(); return m_endedAct; }
 
     const Activities::result_t& latestWaitedAct() const
-    { return m_latestWaitedAct; }
+    { purge(); return m_latestWaitedAct; }
     const Activities::result_t& latestStartedAct() const
-    { return m_latestStartedAct; }
+    { purge(); return m_latestStartedAct; }
     const Activities::result_t& latestFailedAct() const
-    { return m_latestFailedAct; }
+    { purge(); return m_latestFailedAct; }
     const Activities::result_t& latestDoneAct() const
-    { return m_latestFFAct; }
+    { purge(); return m_latestFFAct; }
     const Activities::result_t& latestEndedAct() const
-    { return m_latestEndedAct; }
+    { purge(); return m_latestEndedAct; }
 
+    /**
+     * @brief Get the activities in wait state whose time window intersects
+     * [lowerBound, upperBound]. They are sorted by name, or by earliest
+     * start then by name if the horizon index is enabled.
+     * @param lowerBound The begin of the horizon.
+     * @param upperBound The end of the horizon.
+     * @return The activities.
+     */
     Activities::const_result_t beforeTimeHorizonAct(
         const devs::Time& lowerBound,
         const devs::Time& upperBound) const;
@@ -248,6 +461,14 @@ public:
                           Activities::iterator it);
     static void addAct(Activities::result_t& lst,
                        Activities::iterator it);
+
+    /**
+     * @brief Move the activity into a latest list. The activity is removed
+     * from the other latest lists in constant time and the order of the
+     * other activities is kept.
+     * @param lst One of the five latest lists.
+     * @param it The activity to move.
+     */
     void updateLatestActivitiesList(Activities::result_t& lst,
                                     Activities::iterator it);
 
@@ -257,20 +478,171 @@ private:
     activities_t     m_lst;
     PrecedencesGraph m_graph;
 
-    Activities::result_t m_waitedAct;
-    Activities::result_t m_startedAct;
-    Activities::result_t m_failedAct;
-    Activities::result_t m_ffAct;
-    Activities::result_t m_endedAct;
+    /*
+     * Each activity stores its position in the lists, so it is removed in
+     * constant time. A removed activity leaves a hole, the end iterator of
+     * the map: the other activities keep their positions and their order.
+     * The holes are removed by the next read of the lists.
+     */
+    mutable Activities::result_t m_waitedAct;
+    mutable Activities::result_t m_startedAct;
+    mutable Activities::result_t m_failedAct;
+    mutable Activities::result_t m_ffAct;
+    mutable Activities::result_t m_endedAct;
+
+    mutable Activities::result_t m_latestWaitedAct;
+    mutable Activities::result_t m_latestStartedAct;
+    mutable Activities::result_t m_latestFailedAct;
+    mutable Activities::result_t m_latestFFAct;
+    mutable Activities::result_t m_latestEndedAct;
+
+    struct CompareName
+    {
+        bool operator()(iterator x, iterator y) const
+        { return x->first < y->first; }
+
+        bool operator()(const_iterator x, const_iterator y) const
+        { return x->first < y->first; }
+    };
+
+    /*
+     * Order of the evaluation: by rank then by name. All the ranks are 0 if
+     * the topological order is disabled.
+     */
+    struct CompareOrder
+    {
+        bool operator()(iterator x, iterator y) const
+        {
+            return x->second.m_rank < y->second.m_rank or
+                (x->second.m_rank == y->second.m_rank and x->first < y->first);
+        }
+    };
+
+    typedef std::set < iterator, CompareOrder > dirty_t;
+    typedef boost::unordered_map < const Activity*, devs::Time > evaluated_t;
+    typedef boost::unordered_map < const Activity*, iterator > blocked_t;
+
+    struct Snapshot;
+
+    ActivityArchive m_archive;
+    bool            m_compaction;
+    bool            m_horizon;
+    mutable HorizonIndex m_horizonIndex; /**< Refreshed by the queries. */
+    PredicateCache  m_cache;
+
+    /*
+     * The next date of each activity is stored in a deadline queue updated
+     * lazily: a date is recomputed only when it reaches the top of the
+     * queue and new activities are inserted by the next call to nextDate.
+     */
+    DeadlineQueue m_nextTimes;
+    result_t      m_added; /**< Activities not yet in m_nextTimes. */
+    devs::Time    m_nextTimesDate; /**< Date of the latest nextDate call. */
+
+    ProcessMode m_mode;
+    evaluated_t m_evaluated; /**< Date of the latest evaluation. */
+    DeadlineQueue m_wakes; /**< First date, greater or equal to the latest
+                             evaluation, where an evaluation can give
+                             another result. */
+    DeadlineQueue m_nexts; /**< Next date given by the latest evaluation. */
+    blocked_t   m_blocked; /**< Activities in wait state only for rules. */
+    dirty_t     m_dirty; /**< Activities to evaluate in the next pass. */
+    dirty_t     m_pass; /**< Activities to evaluate in the current pass. */
+    iterator    m_cursor; /**< Activity evaluated in the current pass. */
+    bool        m_inPass;
+    bool        m_listsStale;
+
+    bool         m_topological;
+    bool         m_orderStale; /**< m_order must be rebuilt. */
+    result_t     m_order; /**< Activities sorted by rank. */
+    std::size_t  m_rank; /**< Greatest rank given to an activity. */
+    size_type    m_cycles; /**< Cycles broken by the latest order. */
+    unsigned int m_passes; /**< Passes of the latest process call. */
+
+    bool            m_propagation;
+    TemporalNetwork m_network;
+
+    mutable std::size_t m_holes; /**< Holes in the lists. */
+    std::size_t m_duplicates[10]; /**< Occurrences of the activities after
+                                    their first one in each list. */
+
+    Result processFullScan(const devs::Time& time, bool updates);
+    Result processIncremental(const devs::Time& time);
+    Result processDifferential(const devs::Time& time);
+
+    Result evaluate(iterator activity, const devs::Time& time,
+                    bool* blocked);
+
+    void markDirty(iterator activity);
+    void markDirty(const_iterator activity);
+    void markSuccessorsDirty(iterator activity);
+    void rebuildLists();
+    iterator create(const std::string& name,
+                    const Activity& act = Activity());
+    void track(iterator activity);
+    void rebuildOrder();
+    void rank(iterator activity);
+    void propagate(const devs::Time& time);
+
+    iterator firstInOrder()
+    {
+        if (not m_topological) {
+            return begin();
+        }
+        return m_order.empty() ? end() : m_order.front();
+    }
+
+    iterator nextInOrder(iterator activity, result_t::size_type& position)
+    {
+        if (not m_topological) {
+            return ++activity;
+        }
+        return ++position < m_order.size() ? m_order[position] : end();
+    }
+
+    iterator lastInOrder()
+    {
+        return m_topological ? m_order.back() : --end();
+    }
+
+    /**
+     * @brief Index of the lists in the bitmask of the activities.
+     */
+    enum List {
+        Waited, Started, Failed, FF, Ended,
+        LatestWaited, LatestStarted, LatestFailed, LatestFF, LatestEnded
+    };
+
+    result_t& list(List list) const;
+
+    void pushAct(List list, iterator activity);
+    void eraseAct(List list, iterator activity);
+    void truncateAct(List list, result_t::size_type size);
+    void clearAct(List list);
+    void purge() const;
+
+    bool isArchivable(iterator activity) const;
+    void forget(iterator activity);
+
+    iterator find(const std::string& name)
+    {
+        return m_lst.find(name);
+    }
+
+    const_iterator find(const std::string& name) const
+    {
+        return m_lst.find(name);
+    }
 
-    Activities::result_t m_latestWaitedAct;
-    Activities::result_t m_latestStartedAct;
-    Activities::result_t m_latestFailedAct;
-    Activities::result_t m_latestFFAct;
-    Activities::result_t m_latestEndedAct;
+    devs::Time wakeTime(iterator activity, const devs::Time& time) const;
 
+    void save(Snapshot& snapshot) const;
+    void restore(const Snapshot& snapshot);
+    void compare(const Snapshot& expected, const Result& expectedResult,
+                 const Result& result) const;
 
-    Result processWaitState(iterator activity, const devs::Time& time);
+    Result processWaitState(iterator activity, const devs::Time& time,
+                            bool* blocked = 0);
     Result processStartedState(iterator activity, const devs::Time& time);
     Result processFFState(iterator activity, const devs::Time& time);
     Result processFailedState(iterator activity, const devs::Time& time);
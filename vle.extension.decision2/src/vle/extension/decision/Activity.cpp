@@ -30,13 +30,69 @@
 #include <vle/utils/Exception.hpp>
 #include <vle/utils/i18n.hpp>
 #include <boost/format.hpp>
+#include <algorithm>
 
 namespace vle { namespace extension { namespace decision {
 
-bool Activity::validRules(const std::string& activity) const
+Activity::Functions& Activity::functions()
+{
+    if (not mFunctions) {
+        mFunctions.reset(new Functions());
+    } else if (not mFunctions.unique()) {
+        boost::shared_ptr < Functions > copy(new Functions(*mFunctions));
+
+        if (mAckFct == &mFunctions->ack) {
+            mAckFct = &copy->ack;
+        }
+        if (mOutFct == &mFunctions->out) {
+            mOutFct = &copy->out;
+        }
+        if (mUpdateFct == &mFunctions->update) {
+            mUpdateFct = &copy->update;
+        }
+
+        mFunctions = copy;
+    }
+
+    return *mFunctions;
+}
+
+void Activity::swap(Activity& other)
+{
+    std::swap(m_state, other.m_state);
+    m_rules.swap(other.m_rules);
+    std::swap(m_waitall, other.m_waitall);
+    std::swap(m_date, other.m_date);
+    std::swap(m_start, other.m_start);
+    std::swap(m_finish, other.m_finish);
+    std::swap(m_minstart, other.m_minstart);
+    std::swap(m_maxstart, other.m_maxstart);
+    std::swap(m_minfinish, other.m_minfinish);
+    std::swap(m_maxfinish, other.m_maxfinish);
+    std::swap(m_started, other.m_started);
+    std::swap(m_ff, other.m_ff);
+    std::swap(m_done, other.m_done);
+    std::swap(m_speed_ha_per_day, other.m_speed_ha_per_day);
+    m_metadata.swap(other.m_metadata);
+    for (int i = 0; i < 10; ++i) {
+        std::swap(m_slots[i], other.m_slots[i]);
+    }
+    std::swap(m_lists, other.m_lists);
+    std::swap(m_rank, other.m_rank);
+    std::swap(m_earliest, other.m_earliest);
+    std::swap(m_earliestOffset, other.m_earliestOffset);
+    std::swap(mAckFct, other.mAckFct);
+    std::swap(mOutFct, other.mOutFct);
+    std::swap(mUpdateFct, other.mUpdateFct);
+    mFunctions.swap(other.mFunctions);
+}
+
+bool Activity::validRules(const std::string& activity,
+                          PredicateCache* cache) const
 {
     if (not m_rules.empty()) {
-        Rules::result_t result = m_rules.apply(activity);
+        Rules::result_t result = m_rules.apply(activity, m_metadata, cache,
+                                               this);
         return not result.empty();
     }
     return true;
@@ -139,6 +195,11 @@ devs::Time Activity::nextTime(const devs::Time& time)
                 result = devs::infinity;
             }
         }
+
+        if (m_state == WAIT) {
+            result = std::max(result, std::max(m_earliest,
+                                               time + m_earliestOffset));
+        }
         break;
     case DONE:
     case FAILED:
@@ -226,19 +287,26 @@ bool Activity::isAfterTimeConstraint(const devs::Time& time) const
 
 bool Activity::isValidHorizonTimeConstraint(const devs::Time& lowerBound,
                                             const devs::Time& upperBound) const
+{
+    std::pair < devs::Time, devs::Time > window = horizonWindow();
+
+    return window.first <= upperBound and lowerBound <= window.second;
+}
+
+std::pair < devs::Time, devs::Time > Activity::horizonWindow() const
 {
     switch (m_date & (START | FINISH | MINS | MAXS | MINF | MAXF)) {
     case START | FINISH:
-        return m_start <= upperBound and lowerBound <= m_finish;
+        return std::make_pair(m_start, m_finish);
 
     case START | MINF | MAXF:
-        return m_start <= upperBound  and lowerBound <= m_maxfinish;
+        return std::make_pair(m_start, m_maxfinish);
 
     case MINS | MAXS | FINISH:
-        return m_minstart <= upperBound and lowerBound <= m_maxfinish;
+        return std::make_pair(m_minstart, m_maxfinish);
 
     case MINS | MAXS | MINF | MAXF:
-        return m_minstart <= upperBound and lowerBound <= m_maxfinish;
+        return std::make_pair(m_minstart, m_maxfinish);
 
     default:
         break;
@@ -33,6 +33,7 @@
 #include <vle/devs/ExternalEventList.hpp>
 #include <vle/devs/Time.hpp>
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/bind.hpp>
 
 namespace vle { namespace extension { namespace decision {
@@ -95,8 +96,19 @@ public:
         m_started(devs::negativeInfinity),
         m_ff(devs::negativeInfinity),
         m_done(devs::negativeInfinity),
-        m_speed_ha_per_day(-1.0)
-    {}
+        m_speed_ha_per_day(-1.0),
+        m_lists(0),
+        m_rank(0),
+        m_earliest(devs::negativeInfinity),
+        m_earliestOffset(devs::negativeInfinity),
+        mAckFct(0),
+        mOutFct(0),
+        mUpdateFct(0)
+    {
+        for (int i = 0; i < 10; ++i) {
+            m_slots[i] = 0;
+        }
+    }
 
     //
     // Slot functions to acknowledge an change of state, to send and output or
@@ -104,10 +116,19 @@ public:
     //
 
     /**
-     * @brief Assign an acknowledge function to this activity.
+     * @brief Assign a copy of an acknowledge function to this activity.
      * @param fct An acknowledge function.
      */
     void addAcknowledgeFunction(const AckFct& fct)
+    { functions().ack = fct; mAckFct = &functions().ack; }
+
+    /**
+     * @brief Assign an acknowledge function shared with other activities,
+     * for instance a function of the knowledge base. The function is not
+     * copied and must outlive the activity.
+     * @param fct An acknowledge function.
+     */
+    void addAcknowledgeFunction(const AckFct* fct)
     { mAckFct = fct; }
 
     /**
@@ -115,13 +136,21 @@ public:
      * @param name The name of the activity.
      */
     void acknowledge(const std::string& name)
-    { if (mAckFct) { mAckFct(name, *this); } }
+    { if (mAckFct and *mAckFct) { (*mAckFct)(name, *this); } }
 
     /**
-     * @brief Assign an output function to this activity.
+     * @brief Assign a copy of an output function to this activity.
      * @param fct An output function.
      */
     void addOutputFunction(const OutFct& fct)
+    { functions().out = fct; mOutFct = &functions().out; }
+
+    /**
+     * @brief Assign an output function shared with other activities. The
+     * function is not copied and must outlive the activity.
+     * @param fct An output function.
+     */
+    void addOutputFunction(const OutFct* fct)
     { mOutFct = fct; }
 
     /**
@@ -131,13 +160,21 @@ public:
      */
     void output(const std::string& name,
                 devs::ExternalEventList& events)
-    { if (mOutFct) { mOutFct(name, *this, events); } }
+    { if (mOutFct and *mOutFct) { (*mOutFct)(name, *this, events); } }
 
     /**
-     * @brief Assign an update function to this activity.
+     * @brief Assign a copy of an update function to this activity.
      * @param fct An update function.
      */
     void addUpdateFunction(const UpdateFct& fct)
+    { functions().update = fct; mUpdateFct = &functions().update; }
+
+    /**
+     * @brief Assign an update function shared with other activities. The
+     * function is not copied and must outlive the activity.
+     * @param fct An update function.
+     */
+    void addUpdateFunction(const UpdateFct* fct)
     { mUpdateFct = fct; }
 
     /**
@@ -145,7 +182,7 @@ public:
      * @param name The name of the activity.
      */
     void update(const std::string& name)
-    { if (mUpdateFct) { mUpdateFct(name, *this); } }
+    { if (mUpdateFct and *mUpdateFct) { (*mUpdateFct)(name, *this); } }
 
     //
     // Settings the activity.
@@ -157,10 +194,18 @@ public:
     Rule& addRule(const std::string& name)
     { return m_rules.add(name, Rule()); }
 
+    /**
+     * @brief Reference a rule of the plan instead of copying it.
+     * @param rule The rule, its container must outlive the activity.
+     */
+    void addRule(Rules::const_iterator rule)
+    { m_rules.add(rule); }
+
     void setRules(const Rules& rules)
-    { m_rules = rules; }
+    { m_rules.assign(rules); }
 
-    bool validRules(const std::string& activity) const;
+    bool validRules(const std::string& activity,
+                    PredicateCache* cache = 0) const;
 
     //
     // manage time constraint
@@ -197,6 +242,12 @@ public:
     bool isValidHorizonTimeConstraint(const devs::Time& lowerBound,
                                       const devs::Time& upperBound) const;
 
+    /**
+     * @brief Get the time window checked by isValidHorizonTimeConstraint.
+     * @return The earliest start and the latest finish of the activity.
+     */
+    std::pair < devs::Time, devs::Time > horizonWindow() const;
+
     const State& state() const { return m_state; }
     bool isInWaitState() const { return m_state == WAIT; }
     bool isInStartedState() const { return m_state == STARTED; }
@@ -210,7 +261,7 @@ public:
     void end(const devs::Time& date) { m_state = DONE; doneDate(date); }
     void fail(const devs::Time& date) { m_state = FAILED; doneDate(date); }
 
-    const Rules& rules() const { return m_rules; }
+    const SharedRules& rules() const { return m_rules; }
     const DateType& date() const { return m_date; }
     const devs::Time& start() const { return m_start; }
     const devs::Time& finish() const { return m_finish; }
@@ -229,7 +280,9 @@ public:
     void waitOnlyOneFs() { m_waitall = false; }
 
     /**
-     * @brief Compute the next date when change in activity status.
+     * @brief Compute the next date when change in activity status. In wait
+     * state, the date is not before the earliest start given by the
+     * temporal propagation of the Activities container.
      * @param time The current time.
      * @return A date in range ]devs::Time::negativeInfinity,
      * devs::infinity[.
@@ -239,13 +292,30 @@ public:
     void setSpeed(const vle::devs::Time& speed);
     const vle::devs::Time& speed() const { return m_speed_ha_per_day; }
 
+    /**
+     * @brief Assign the metadata of the activity. The metadata are given to
+     * the typed predicates.
+     * @param metadata The new metadata.
+     */
+    void setMetadata(const ActivityMetadata& metadata)
+    { m_metadata = metadata; }
+
+    const ActivityMetadata& metadata() const { return m_metadata; }
+
+    /**
+     * @brief Exchange the content of two activities without copying their
+     * rules, metadata and functions.
+     * @param other The activity to exchange with.
+     */
+    void swap(Activity& other);
+
 private:
     void startedDate(const devs::Time& date) { m_started = date; }
     void ffDate(const devs::Time& date) { m_ff = date; }
     void doneDate(const devs::Time& date) { m_done = date; }
 
     State m_state;
-    Rules m_rules;
+    SharedRules m_rules;
 
     bool m_waitall; /**< if true, all FF relationship must be valid, if
                       false, only one can be used. */
@@ -265,9 +335,46 @@ private:
 
     vle::devs::Time m_speed_ha_per_day;
 
-    AckFct mAckFct;
-    OutFct mOutFct;
-    UpdateFct mUpdateFct;
+    ActivityMetadata m_metadata;
+
+    /*
+     * Positions of the activity in the lists of its Activities container,
+     * maintained by the Activities class to remove an activity from a list
+     * in constant time.
+     */
+    friend class Activities;
+
+    std::size_t m_slots[10]; /**< Position of the first occurrence in the
+                               state lists then in the latest lists. */
+    unsigned int m_lists; /**< Bit i is set if the activity is in the list
+                            i. */
+    std::size_t m_rank; /**< Position in the processing order, 0 if the
+                          activities are processed by name. */
+    devs::Time m_earliest; /**< Earliest start given by the temporal
+                             propagation, the next date of an activity in
+                             wait state is never before it. */
+    devs::Time m_earliestOffset; /**< Delay after the current date before
+                                   which the activity cannot start, the
+                                   earliest start grows with the date. */
+
+    /*
+     * The functions are shared: the slots point to the tables of the
+     * knowledge base or to the functions given by value, stored in a block
+     * shared by the copies of the activity.
+     */
+    struct Functions
+    {
+        AckFct ack;
+        OutFct out;
+        UpdateFct update;
+    };
+
+    const AckFct* mAckFct;
+    const OutFct* mOutFct;
+    const UpdateFct* mUpdateFct;
+    boost::shared_ptr < Functions > mFunctions;
+
+    Functions& functions();
 };
 
 inline std::ostream& operator<<(
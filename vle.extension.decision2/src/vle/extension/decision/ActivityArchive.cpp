@@ -0,0 +1,46 @@
+/*
+ * @file vle/extension/decision/ActivityArchive.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <vle/extension/decision/ActivityArchive.hpp>
+
+namespace vle { namespace extension { namespace decision {
+
+void ActivityArchive::add(const std::string& name, const Activity& activity)
+{
+    std::pair < index_t::iterator, bool > r = m_index.insert(
+        std::make_pair(name, m_lst.size()));
+
+    if (not r.second) {
+        throw utils::ArgError(
+            vle::fmt(_("Decision: activity '%1%' already archived")) % name);
+    }
+
+    m_lst.push_back(value_type(name, ArchivedActivity(activity)));
+}
+
+}}} // namespace vle model decision
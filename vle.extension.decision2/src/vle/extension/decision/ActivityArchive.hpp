@@ -0,0 +1,174 @@
+/*
+ * @file vle/extension/decision/ActivityArchive.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef VLE_EXT_DECISION_ACTIVITYARCHIVE_HPP
+#define VLE_EXT_DECISION_ACTIVITYARCHIVE_HPP 1
+
+#include <vle/extension/decision/Activity.hpp>
+#include <vle/extension/decision/PrecedenceConstraint.hpp>
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/i18n.hpp>
+#include <boost/unordered_map.hpp>
+#include <string>
+#include <vector>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief ArchivedActivity stores the state and the dates of an activity in
+ * a final state (DONE or FAILED). The rules and the slot functions are not
+ * kept.
+ */
+class ArchivedActivity
+{
+public:
+    explicit ArchivedActivity(const Activity& activity)
+        : m_state(activity.state()), m_date(activity.date()),
+        m_start(activity.start()), m_finish(activity.finish()),
+        m_minstart(activity.minstart()), m_maxstart(activity.maxstart()),
+        m_minfinish(activity.minfinish()), m_maxfinish(activity.maxfinish()),
+        m_started(activity.startedDate()), m_ff(activity.ffDate()),
+        m_done(activity.doneDate()), m_metadata(activity.metadata())
+    {}
+
+    const Activity::State& state() const { return m_state; }
+    bool isInFailedState() const { return m_state == Activity::FAILED; }
+    bool isInDoneState() const { return m_state == Activity::DONE; }
+
+    const Activity::DateType& date() const { return m_date; }
+    const devs::Time& start() const { return m_start; }
+    const devs::Time& finish() const { return m_finish; }
+    const devs::Time& minstart() const { return m_minstart; }
+    const devs::Time& maxstart() const { return m_maxstart; }
+    const devs::Time& minfinish() const { return m_minfinish; }
+    const devs::Time& maxfinish() const { return m_maxfinish; }
+
+    const devs::Time& startedDate() const { return m_started; }
+    const devs::Time& doneDate() const { return m_done; }
+    const devs::Time& ffDate() const { return m_ff; }
+
+    const ActivityMetadata& metadata() const { return m_metadata; }
+
+private:
+    Activity::State m_state;
+    Activity::DateType m_date;
+
+    devs::Time m_start;
+    devs::Time m_finish;
+    devs::Time m_minstart;
+    devs::Time m_maxstart;
+    devs::Time m_minfinish;
+    devs::Time m_maxfinish;
+
+    devs::Time m_started;
+    devs::Time m_ff;
+    devs::Time m_done;
+
+    ActivityMetadata m_metadata;
+};
+
+/**
+ * @brief ArchivedPrecedence stores a precedence constraint between two
+ * archived activities.
+ */
+struct ArchivedPrecedence
+{
+    ArchivedPrecedence(const PrecedenceConstraint& pc)
+        : first(pc.first()->first), second(pc.second()->first),
+        type(pc.type()), mintimelag(pc.mintimelag()),
+        maxtimelag(pc.maxtimelag())
+    {}
+
+    std::string first;
+    std::string second;
+    PrecedenceConstraint::Type type;
+    devs::Time mintimelag;
+    devs::Time maxtimelag;
+};
+
+/**
+ * @brief ActivityArchive is an append-only container of the activities
+ * removed from the Activities container by the compaction. Activities are
+ * stored in the order of archiving and can be found by name.
+ */
+class ActivityArchive
+{
+public:
+    typedef std::pair < std::string, ArchivedActivity > value_type;
+    typedef std::vector < value_type > container_type;
+    typedef container_type::const_iterator const_iterator;
+    typedef container_type::size_type size_type;
+    typedef std::vector < ArchivedPrecedence > precedences_t;
+
+    /**
+     * @brief Append an activity to the archive.
+     * @param name The name of the activity.
+     * @param activity The activity to archive.
+     * @throw utils::ArgError if the name is already archived.
+     */
+    void add(const std::string& name, const Activity& activity);
+
+    /**
+     * @brief Append a precedence constraint to the archive.
+     * @param pc The constraint to archive.
+     */
+    void add(const PrecedenceConstraint& pc)
+    { m_precedences.push_back(ArchivedPrecedence(pc)); }
+
+    bool exist(const std::string& name) const
+    { return m_index.find(name) != m_index.end(); }
+
+    const_iterator get(const std::string& name) const
+    {
+        index_t::const_iterator it = m_index.find(name);
+        if (it == m_index.end()) {
+            throw utils::ArgError(
+                vle::fmt(_("Decision: unknown archived activity '%1%'")) %
+                name);
+        }
+        return m_lst.begin() + it->second;
+    }
+
+    const_iterator begin() const { return m_lst.begin(); }
+    const_iterator end() const { return m_lst.end(); }
+    size_type size() const { return m_lst.size(); }
+    bool empty() const { return m_lst.empty(); }
+
+    const precedences_t& precedences() const { return m_precedences; }
+
+private:
+    typedef boost::unordered_map < std::string, size_type > index_t;
+
+    container_type m_lst;
+    index_t m_index;
+    precedences_t m_precedences;
+};
+
+}}} // namespace vle model decision
+
+#endif
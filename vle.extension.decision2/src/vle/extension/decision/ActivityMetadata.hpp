@@ -0,0 +1,85 @@
+/*
+ * @file vle/extension/decision/ActivityMetadata.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef VLE_EXT_DECISION_ACTIVITYMETADATA_HPP
+#define VLE_EXT_DECISION_ACTIVITYMETADATA_HPP 1
+
+#include <boost/function.hpp>
+#include <algorithm>
+#include <string>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief Defines the kind of operation of an activity.
+ */
+enum ActivityOperation
+{
+    ActivityOperationOther, /**< Default kind. */
+    ActivityOperationSow, /**< Seeding or sowing operation. */
+    ActivityOperationHarvest /**< Harvest operation. */
+};
+
+/**
+ * @brief ActivityMetadata stores typed informations attached to an activity
+ * when its plan is loaded. Predicates, output and update functions read
+ * them instead of parsing the name of the activity. Integer fields are -1
+ * when unknown.
+ */
+struct ActivityMetadata
+{
+    ActivityMetadata()
+        : plot(-1), year(-1), index(-1),
+        operation(ActivityOperationOther)
+    {}
+
+    void swap(ActivityMetadata& other)
+    {
+        std::swap(plot, other.plot);
+        std::swap(year, other.year);
+        std::swap(index, other.index);
+        crop.swap(other.crop);
+        std::swap(operation, other.operation);
+    }
+
+    int plot; /**< Index of the plot. */
+    int year; /**< Year of the plan. */
+    int index; /**< Index of the activity in its plan. */
+    std::string crop; /**< Identifier of the crop. */
+    ActivityOperation operation; /**< Kind of operation. */
+};
+
+/**
+ * @brief Defines a function which builds the metadata of an activity from
+ * its identifier in the plan, ie. without the suffix.
+ */
+typedef boost::function <ActivityMetadata (const std::string& id)> ActivityMetadataFunction;
+
+}}} // namespace vle model decision
+
+#endif
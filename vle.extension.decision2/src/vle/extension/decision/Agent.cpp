@@ -186,9 +186,13 @@ value::Value* Agent::observation(
         return new value::String(out.str());
     } else if ((port.compare(0, 9, "Activity_") == 0) and port.size() > 9) {
         std::string activity(port, 9, std::string::npos);
-        const Activity& act(activities().get(activity)->second);
         std::stringstream out;
-        out << act.state();
+        if (not activities().exist(activity) and
+            activities().archive().exist(activity)) {
+            out << activities().archive().get(activity)->second.state();
+        } else {
+            out << activities().get(activity)->second.state();
+        }
         return new value::String(out.str());
     }
 
@@ -0,0 +1,137 @@
+/*
+ * @file vle/extension/decision/DeadlineQueue.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <vle/extension/decision/DeadlineQueue.hpp>
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/i18n.hpp>
+
+namespace vle { namespace extension { namespace decision {
+
+const DeadlineQueue::Element& DeadlineQueue::top() const
+{
+    if (m_heap.empty()) {
+        throw utils::InternalError(_("Decision: empty deadline queue"));
+    }
+
+    return m_heap.front();
+}
+
+void DeadlineQueue::update(iterator activity, const devs::Time& date)
+{
+    std::pair < position_t::iterator, bool > r = m_position.insert(
+        std::make_pair(&activity->second, m_heap.size()));
+
+    if (r.second) {
+        m_heap.push_back(Element(date, activity));
+        up(m_heap.size() - 1);
+    } else {
+        size_type i = r.first->second;
+        devs::Time old = m_heap[i].date;
+
+        m_heap[i].date = date;
+        if (date < old) {
+            up(i);
+        } else if (old < date) {
+            down(i);
+        }
+    }
+}
+
+void DeadlineQueue::erase(iterator activity)
+{
+    position_t::iterator it = m_position.find(&activity->second);
+
+    if (it == m_position.end()) {
+        return;
+    }
+
+    size_type i = it->second;
+    size_type last = m_heap.size() - 1;
+
+    m_position.erase(it);
+
+    if (i != last) {
+        m_heap[i] = m_heap[last];
+        m_position[&m_heap[i].activity->second] = i;
+        m_heap.pop_back();
+
+        up(i);
+        down(i);
+    } else {
+        m_heap.pop_back();
+    }
+}
+
+void DeadlineQueue::up(size_type i)
+{
+    while (i > 0) {
+        size_type parent = (i - 1) / 2;
+
+        if (not (m_heap[i].date < m_heap[parent].date)) {
+            break;
+        }
+
+        swap(i, parent);
+        i = parent;
+    }
+}
+
+void DeadlineQueue::down(size_type i)
+{
+    const size_type size = m_heap.size();
+
+    for (;;) {
+        size_type left = 2 * i + 1;
+        size_type right = left + 1;
+        size_type smallest = i;
+
+        if (left < size and m_heap[left].date < m_heap[smallest].date) {
+            smallest = left;
+        }
+
+        if (right < size and m_heap[right].date < m_heap[smallest].date) {
+            smallest = right;
+        }
+
+        if (smallest == i) {
+            break;
+        }
+
+        swap(i, smallest);
+        i = smallest;
+    }
+}
+
+void DeadlineQueue::swap(size_type i, size_type j)
+{
+    std::swap(m_heap[i], m_heap[j]);
+    m_position[&m_heap[i].activity->second] = i;
+    m_position[&m_heap[j].activity->second] = j;
+}
+
+}}} // namespace vle model decision
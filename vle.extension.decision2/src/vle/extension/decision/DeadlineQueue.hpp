@@ -0,0 +1,115 @@
+/*
+ * @file vle/extension/decision/DeadlineQueue.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef VLE_EXT_DECISION_DEADLINEQUEUE_HPP
+#define VLE_EXT_DECISION_DEADLINEQUEUE_HPP 1
+
+#include <vle/extension/decision/Activity.hpp>
+#include <vle/devs/Time.hpp>
+#include <boost/unordered_map.hpp>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief DeadlineQueue is an indexed binary min-heap of activities sorted
+ * by date. Each activity appears at most once, its date can be changed
+ * or removed in O(log N) and the earliest date is available in O(1).
+ */
+class DeadlineQueue
+{
+public:
+    typedef std::map < std::string, Activity >::iterator iterator;
+
+    struct Element
+    {
+        Element(const devs::Time& d, iterator a)
+            : date(d), activity(a)
+        {}
+
+        devs::Time date;
+        iterator activity;
+    };
+
+    typedef std::vector < Element > container_type;
+    typedef container_type::size_type size_type;
+
+    bool empty() const { return m_heap.empty(); }
+    size_type size() const { return m_heap.size(); }
+
+    /**
+     * @brief Get the element with the earliest date.
+     * @return The top of the heap.
+     * @throw utils::InternalError if the queue is empty.
+     */
+    const Element& top() const;
+
+    /**
+     * @brief Insert the activity with the specified date or change its
+     * date if the activity is already in the queue.
+     * @param activity The activity to insert or update.
+     * @param date The new date.
+     */
+    void update(iterator activity, const devs::Time& date);
+
+    /**
+     * @brief Remove the activity from the queue if it exists.
+     * @param activity The activity to remove.
+     */
+    void erase(iterator activity);
+
+    /**
+     * @brief Remove the element with the earliest date.
+     */
+    void pop() { erase(top().activity); }
+
+    bool exist(iterator activity) const
+    { return m_position.find(&activity->second) != m_position.end(); }
+
+    void clear()
+    {
+        m_heap.clear();
+        m_position.clear();
+    }
+
+private:
+    typedef boost::unordered_map < const Activity*, size_type > position_t;
+
+    container_type m_heap;
+    position_t m_position;
+
+    void up(size_type i);
+    void down(size_type i);
+    void swap(size_type i, size_type j);
+};
+
+}}} // namespace vle model decision
+
+#endif
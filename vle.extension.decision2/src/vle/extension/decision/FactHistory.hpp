@@ -0,0 +1,251 @@
+/*
+ * @file vle/extension/decision/FactHistory.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef VLE_EXT_DECISION_FACTHISTORY_HPP
+#define VLE_EXT_DECISION_FACTHISTORY_HPP 1
+
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/i18n.hpp>
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief FactHistory stores the latest values of a fact in a bounded ring
+ * buffer. A ring of running prefix sums answers the sum and the mean of
+ * the latest values in O(1) and two monotonic deques keep the minimum and
+ * the maximum of the stored values in O(1) amortized.
+ *
+ * @code
+ * FactHistory < double > rain(366);
+ * rain.push(2.5);
+ * rain.push(0.0);
+ * rain.sum(2); // 2.5
+ * rain.at(0); // 0.0, the latest value
+ * @endcode
+ */
+template < typename T >
+class FactHistory
+{
+public:
+    typedef T value_type;
+    typedef typename std::vector < T >::size_type size_type;
+
+    /**
+     * @brief Build an empty history.
+     * @param capacity The number of values kept.
+     * @throw utils::ArgError if capacity is null.
+     */
+    explicit FactHistory(size_type capacity)
+        : m_values(capacity), m_prefix(capacity + 1, T()), m_count(0)
+    {
+        if (capacity == 0) {
+            throw utils::ArgError(
+                _("Decision: fact history needs a capacity"));
+        }
+    }
+
+    /**
+     * @brief Add the latest value. The oldest value is forgotten when the
+     * history is full.
+     * @param value The value to add.
+     */
+    void push(const T& value)
+    {
+        const size_type cap = capacity();
+
+        m_values[m_count % cap] = value;
+        m_prefix[(m_count + 1) % (cap + 1)] =
+            m_prefix[m_count % (cap + 1)] + value;
+        ++m_count;
+
+        while (not m_min.empty() and not (m_min.back().second < value)) {
+            m_min.pop_back();
+        }
+        m_min.push_back(std::make_pair(m_count, value));
+
+        while (not m_max.empty() and not (value < m_max.back().second)) {
+            m_max.pop_back();
+        }
+        m_max.push_back(std::make_pair(m_count, value));
+
+        if (m_count > cap) {
+            if (m_min.front().first + cap <= m_count) {
+                m_min.pop_front();
+            }
+            if (m_max.front().first + cap <= m_count) {
+                m_max.pop_front();
+            }
+        }
+
+        if (m_count % cap == 0) {
+            rebase();
+        }
+    }
+
+    /**
+     * @brief Get a stored value.
+     * @param age The number of values pushed after it: 0 is the latest.
+     * @return The value.
+     * @throw utils::ArgError if age is not less than size().
+     */
+    const T& at(size_type age) const
+    {
+        check(age + 1);
+
+        return m_values[(m_count - 1 - age) % capacity()];
+    }
+
+    /**
+     * @brief Sum of the latest values in O(1).
+     * @param number The number of values, at most size().
+     * @throw utils::ArgError if number is greater than size().
+     */
+    T sum(size_type number) const
+    {
+        check(number);
+
+        const size_type cap = capacity();
+
+        return m_prefix[m_count % (cap + 1)] -
+            m_prefix[(m_count - number) % (cap + 1)];
+    }
+
+    /**
+     * @brief Mean of the latest values in O(1).
+     * @param number The number of values, between 1 and size().
+     * @throw utils::ArgError if number is null or greater than size().
+     */
+    T mean(size_type number) const
+    {
+        if (number == 0) {
+            throw utils::ArgError(
+                _("Decision: fact history mean of zero value"));
+        }
+
+        return sum(number) / static_cast < T >(number);
+    }
+
+    /**
+     * @brief Difference between the latest value and the value pushed
+     * number steps before.
+     * @param number The distance, less than size().
+     * @throw utils::ArgError if number is not less than size().
+     */
+    T difference(size_type number) const
+    {
+        return at(0) - at(number);
+    }
+
+    /**
+     * @brief Get the minimum of the stored values.
+     * @throw utils::ArgError if the history is empty.
+     */
+    const T& minimum() const
+    {
+        check(1);
+
+        return m_min.front().second;
+    }
+
+    /**
+     * @brief Get the maximum of the stored values.
+     * @throw utils::ArgError if the history is empty.
+     */
+    const T& maximum() const
+    {
+        check(1);
+
+        return m_max.front().second;
+    }
+
+    void clear()
+    {
+        std::fill(m_prefix.begin(), m_prefix.end(), T());
+        m_min.clear();
+        m_max.clear();
+        m_count = 0;
+    }
+
+    bool empty() const { return m_count == 0; }
+
+    /**
+     * @brief Get the number of stored values, at most capacity().
+     */
+    size_type size() const
+    { return m_count < capacity() ? m_count : capacity(); }
+
+    size_type capacity() const { return m_values.size(); }
+
+    /**
+     * @brief Get the number of values pushed since the construction or
+     * the latest clear.
+     */
+    size_type count() const { return m_count; }
+
+private:
+    typedef std::deque < std::pair < size_type, T > > extremum_type;
+
+    std::vector < T > m_values;
+    std::vector < T > m_prefix;
+    extremum_type m_min;
+    extremum_type m_max;
+    size_type m_count;
+
+    void check(size_type number) const
+    {
+        if (number > size()) {
+            throw utils::ArgError(
+                fmt(_("Decision: fact history of %1% values, %2% needed"))
+                % size() % number);
+        }
+    }
+
+    /**
+     * @brief Subtract the prefix of the oldest stored value from the ring.
+     * Called once per capacity() pushes, it keeps the magnitude of the
+     * prefix sums, and their rounding errors, bounded.
+     */
+    void rebase()
+    {
+        const size_type cap = capacity();
+        const T base = m_prefix[(m_count - size()) % (cap + 1)];
+
+        for (typename std::vector < T >::iterator it = m_prefix.begin();
+             it != m_prefix.end(); ++it) {
+            *it -= base;
+        }
+    }
+};
+
+}}} // namespace vle model decision
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * @file vle/extension/decision/HorizonIndex.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <vle/extension/decision/HorizonIndex.hpp>
+#include <algorithm>
+#include <functional>
+
+namespace vle { namespace extension { namespace decision {
+
+const HorizonIndex::size_type HorizonIndex::npos = (size_type)-1;
+
+void HorizonIndex::erase(iterator activity)
+{
+    m_pending.erase(&activity->second);
+    remove(&activity->second);
+}
+
+void HorizonIndex::assign(std::map < std::string, Activity >& activities)
+{
+    clear();
+
+    for (iterator it = activities.begin(); it != activities.end(); ++it) {
+        invalidate(it);
+    }
+}
+
+void HorizonIndex::clear()
+{
+    m_nodes.clear();
+    m_free.clear();
+    m_root = npos;
+    m_index.clear();
+    m_pending.clear();
+}
+
+void HorizonIndex::find(const devs::Time& lowerBound,
+                        const devs::Time& upperBound,
+                        result_t& result)
+{
+    refresh();
+    find(m_root, lowerBound, upperBound, result);
+}
+
+void HorizonIndex::refresh()
+{
+    for (pending_t::iterator it = m_pending.begin(); it != m_pending.end();
+         ++it) {
+        remove(it->first);
+
+        if (it->second->second.isInWaitState()) {
+            insert(it->second);
+        }
+    }
+
+    m_pending.clear();
+}
+
+void HorizonIndex::insert(iterator activity)
+{
+    size_type node;
+
+    if (m_free.empty()) {
+        node = m_nodes.size();
+        m_nodes.push_back(Node());
+    } else {
+        node = m_free.back();
+        m_free.pop_back();
+    }
+
+    std::pair < devs::Time, devs::Time > window =
+        activity->second.horizonWindow();
+
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+
+    Node& n = m_nodes[node];
+    n.start = window.first;
+    n.finish = window.second;
+    n.max = window.second;
+    n.activity = activity;
+    n.left = npos;
+    n.right = npos;
+    n.priority = m_seed;
+
+    m_root = insert(m_root, node);
+    m_index[&activity->second] = node;
+}
+
+void HorizonIndex::remove(const Activity* activity)
+{
+    index_t::iterator it = m_index.find(activity);
+
+    if (it != m_index.end()) {
+        m_root = remove(m_root, it->second);
+        m_free.push_back(it->second);
+        m_index.erase(it);
+    }
+}
+
+bool HorizonIndex::less(size_type x, size_type y) const
+{
+    const Node& a = m_nodes[x];
+    const Node& b = m_nodes[y];
+
+    return a.start < b.start or (a.start == b.start and
+                                 a.activity->first < b.activity->first);
+}
+
+void HorizonIndex::update(size_type node)
+{
+    Node& n = m_nodes[node];
+    n.max = n.finish;
+
+    if (n.left != npos) {
+        n.max = std::max(n.max, m_nodes[n.left].max);
+    }
+
+    if (n.right != npos) {
+        n.max = std::max(n.max, m_nodes[n.right].max);
+    }
+}
+
+HorizonIndex::size_type HorizonIndex::insert(size_type root, size_type node)
+{
+    if (root == npos) {
+        update(node);
+        return node;
+    }
+
+    if (less(node, root)) {
+        size_type left = insert(m_nodes[root].left, node);
+        m_nodes[root].left = left;
+
+        if (m_nodes[left].priority > m_nodes[root].priority) {
+            m_nodes[root].left = m_nodes[left].right;
+            m_nodes[left].right = root;
+            update(root);
+            update(left);
+            return left;
+        }
+    } else {
+        size_type right = insert(m_nodes[root].right, node);
+        m_nodes[root].right = right;
+
+        if (m_nodes[right].priority > m_nodes[root].priority) {
+            m_nodes[root].right = m_nodes[right].left;
+            m_nodes[right].left = root;
+            update(root);
+            update(right);
+            return right;
+        }
+    }
+
+    update(root);
+    return root;
+}
+
+HorizonIndex::size_type HorizonIndex::remove(size_type root, size_type node)
+{
+    if (root == node) {
+        return merge(m_nodes[root].left, m_nodes[root].right);
+    }
+
+    if (less(node, root)) {
+        m_nodes[root].left = remove(m_nodes[root].left, node);
+    } else {
+        m_nodes[root].right = remove(m_nodes[root].right, node);
+    }
+
+    update(root);
+    return root;
+}
+
+HorizonIndex::size_type HorizonIndex::merge(size_type left, size_type right)
+{
+    if (left == npos) {
+        return right;
+    }
+
+    if (right == npos) {
+        return left;
+    }
+
+    if (m_nodes[left].priority > m_nodes[right].priority) {
+        m_nodes[left].right = merge(m_nodes[left].right, right);
+        update(left);
+        return left;
+    }
+
+    m_nodes[right].left = merge(left, m_nodes[right].left);
+    update(right);
+    return right;
+}
+
+void HorizonIndex::find(size_type root, const devs::Time& lowerBound,
+                        const devs::Time& upperBound, result_t& result) const
+{
+    if (root == npos or m_nodes[root].max < lowerBound) {
+        return;
+    }
+
+    const Node& n = m_nodes[root];
+
+    find(n.left, lowerBound, upperBound, result);
+
+    if (n.start <= upperBound) {
+        if (lowerBound <= n.finish) {
+            result.push_back(n.activity);
+        }
+
+        find(n.right, lowerBound, upperBound, result);
+    }
+}
+
+}}} // namespace vle model decision
@@ -0,0 +1,145 @@
+/*
+ * @file vle/extension/decision/HorizonIndex.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef VLE_EXT_DECISION_HORIZONINDEX_HPP
+#define VLE_EXT_DECISION_HORIZONINDEX_HPP 1
+
+#include <vle/extension/decision/Activity.hpp>
+#include <vle/devs/Time.hpp>
+#include <boost/unordered_map.hpp>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief HorizonIndex is an interval tree over the time windows of the
+ * activities in wait state, as given by Activity::horizonWindow. The tree
+ * is a treap sorted by earliest start, then by name, where each node
+ * stores the greatest latest finish of its subtree. The subtrees which
+ * finish before the horizon or start after it are skipped, so the k
+ * activities whose window intersects an horizon are found in
+ * O((k + 1) log N) on average.
+ *
+ * The index is refreshed lazily: an invalidated activity is read again,
+ * and inserted if it waits, by the next call to the find function.
+ */
+class HorizonIndex
+{
+public:
+    typedef std::map < std::string, Activity >::iterator iterator;
+    typedef std::map < std::string, Activity >::const_iterator
+        const_iterator;
+    typedef std::vector < const_iterator > result_t;
+    typedef std::vector < int >::size_type size_type;
+
+    HorizonIndex()
+        : m_root(npos), m_seed(2463534242u)
+    {}
+
+    /**
+     * @brief Mark the activity to be read again by the next find.
+     * @param activity The activity which has changed.
+     */
+    void invalidate(iterator activity)
+    { m_pending[&activity->second] = activity; }
+
+    /**
+     * @brief Remove the activity from the index.
+     * @param activity The activity to remove.
+     */
+    void erase(iterator activity);
+
+    /**
+     * @brief Rebuild the index from the activities.
+     * @param activities The activities to index.
+     */
+    void assign(std::map < std::string, Activity >& activities);
+
+    void clear();
+
+    /**
+     * @brief Append to the result the activities in wait state whose time
+     * window intersects [lowerBound, upperBound], in the order of the
+     * tree: by earliest start, then by name.
+     * @param lowerBound The begin of the horizon.
+     * @param upperBound The end of the horizon.
+     * @param result The output vector.
+     */
+    void find(const devs::Time& lowerBound, const devs::Time& upperBound,
+              result_t& result);
+
+    /**
+     * @brief Get the number of activities in the tree, without the
+     * invalidated ones.
+     * @return The number of indexed activities.
+     */
+    size_type size() const { return m_index.size(); }
+
+private:
+    static const size_type npos;
+
+    struct Node
+    {
+        devs::Time start;
+        devs::Time finish;
+        devs::Time max; /**< Greatest finish of the subtree. */
+        const_iterator activity;
+        size_type left;
+        size_type right;
+        unsigned int priority;
+    };
+
+    typedef boost::unordered_map < const Activity*, size_type > index_t;
+    typedef boost::unordered_map < const Activity*, iterator > pending_t;
+
+    std::vector < Node > m_nodes;
+    std::vector < size_type > m_free; /**< Unused nodes of m_nodes. */
+    size_type  m_root;
+    index_t    m_index; /**< Node of each indexed activity. */
+    pending_t  m_pending; /**< Activities to read again. */
+    unsigned int m_seed;
+
+    void refresh();
+    void insert(iterator activity);
+    void remove(const Activity* activity);
+
+    bool less(size_type x, size_type y) const;
+    void update(size_type node);
+    size_type insert(size_type root, size_type node);
+    size_type remove(size_type root, size_type node);
+    size_type merge(size_type left, size_type right);
+    void find(size_type root, const devs::Time& lowerBound,
+              const devs::Time& upperBound, result_t& result) const;
+};
+
+}}} // namespace vle model decision
+
+#endif
@@ -28,11 +28,45 @@
 
 #include <vle/extension/decision/KnowledgeBase.hpp>
 #include <vle/utils/i18n.hpp>
+#include <vle/value/Double.hpp>
+#include <boost/bind.hpp>
 #include <algorithm>
 #include <cassert>
 
 namespace vle { namespace extension { namespace decision {
 
+/**
+ * @brief The fact installed by addFactHistory: record the value, then
+ * apply the previous fact if any.
+ */
+static void recordFact(FactHistory < double >* history, const Fact& fact,
+                       const value::Value& value)
+{
+    history->push(value::toDouble(value));
+
+    if (fact) {
+        fact(value);
+    }
+}
+
+const FactHistory < double >& KnowledgeBase::addFactHistory(
+    const std::string& name,
+    FactHistory < double >::size_type capacity)
+{
+    mFactHistories.add(name, FactHistory < double >(capacity));
+    FactHistory < double >* history = &mFactHistories[name];
+
+    FactsTable::iterator it = mFactsTable.find(name);
+    if (it == mFactsTable.end()) {
+        mFactsTable.add(name, boost::bind(&recordFact, history, Fact(), _1));
+    } else {
+        Fact fact = boost::bind(&recordFact, history, it->second, _1);
+        it->second = fact;
+    }
+
+    return *history;
+}
+
 void KnowledgeBase::setActivityDone(const std::string& name,
                                     const devs::Time& date)
 {
@@ -30,6 +30,7 @@
 #define VLE_EXT_DECISION_KNOWLEDGEBASE_HPP 1
 
 #include <vle/extension/decision/Activities.hpp>
+#include <vle/extension/decision/FactHistory.hpp>
 #include <vle/extension/decision/Facts.hpp>
 #include <vle/extension/decision/Library.hpp>
 #include <vle/extension/decision/Rules.hpp>
@@ -39,7 +40,12 @@
 namespace vle { namespace extension { namespace decision {
 
 typedef Table < Fact > FactsTable;
+typedef Table < FactHistory < double > > FactHistoriesTable;
 typedef Table < PredicateFunction > PredicatesTable;
+typedef std::pair < TypedPredicateFunction, PredicateSignature > TypedPredicateType;
+typedef Table < TypedPredicateType > TypedPredicatesTable;
+typedef std::pair < PredicateScope, PredicateKeyFunction > PredicateScopeType;
+typedef Table < PredicateScopeType > PredicateScopesTable;
 typedef Table < Activity::AckFct > AcknowledgeFunctions;
 typedef Table < Activity::OutFct > OutputFunctions;
 typedef Table < Activity::UpdateFct > UpdateFunctions;
@@ -75,6 +81,18 @@ struct p
     F func;
 };
 
+template < typename F >
+struct tp
+{
+    tp(const std::string& name, F func, const PredicateSignature& signature)
+        : name(name), func(func), signature(signature)
+    {}
+
+    std::string name;
+    F func;
+    PredicateSignature signature;
+};
+
 template < typename F >
 struct o
 {
@@ -164,6 +182,12 @@ struct AddUpdateFunctions
  *      P("pred 3", &KnowledgeBase::randIsTrue,
  *      P("pred 4", &KnowledgeBase::randIsFalse);
  *
+ * // Typed predicates get their parameters resolved when the plan is
+ * // loaded:
+ * addPredicates(this) +=
+ *      P("rain", &KnowledgeBase::rain, PredicateSignature()
+ *        .addOperator("rain_operator").addReal("rain_threshold"));
+ *
  * addOutputFunctions(this) +=
  *      O("output function", &KnowledgeBase::out);
  *
@@ -196,7 +220,31 @@ public:
     { facts().add(name, fact); }
 
     void applyFact(const std::string& name, const value::Value& value)
-    { facts()[name](value); }
+    {
+        facts()[name](value);
+        mPlan.activities().factsChanged();
+    }
+
+    /**
+     * @brief Record the real values of a fact in a bounded history fed by
+     * applyFact. If the fact is already defined, each value is recorded
+     * before the fact is applied, otherwise the fact is defined.
+     * @param name The name of the fact.
+     * @param capacity The number of values kept.
+     * @return The history of the fact.
+     * @throw utils::ArgError if the history already exists.
+     */
+    const FactHistory < double >& addFactHistory(
+        const std::string& name,
+        FactHistory < double >::size_type capacity);
+
+    /**
+     * @brief Get the history of a fact.
+     * @param name The name of the fact.
+     * @throw utils::ArgError if the history does not exist.
+     */
+    const FactHistory < double >& factHistory(const std::string& name) const
+    { return mFactHistories[name]; }
 
     Rule& addRule(const std::string& name)
     { return mPlan.rules().add(name); }
@@ -398,6 +446,20 @@ public:
     const PredicatesTable& predicates() const
     { return mPredicatesTable; }
 
+    /**
+     * @brief Get the table of the scopes of the predicate functions.
+     * @return Table of scopes.
+     */
+    const PredicateScopesTable& predicateScopes() const
+    { return mPredicateScopesTable; }
+
+    /**
+     * @brief Get the table of available typed predicates.
+     * @return Table of available typed predicates.
+     */
+    const TypedPredicatesTable& typedPredicates() const
+    { return mTypedPredicatesTable; }
+
     /**
      * @brief Get the table of available acknowledge functions.
      * @return Table of available acknowledge functions.
@@ -433,6 +495,38 @@ public:
     PredicatesTable& predicates()
     { return mPredicatesTable; }
 
+    /**
+     * @brief Get the table of available typed predicates.
+     * @return Table of available typed predicates.
+     */
+    TypedPredicatesTable& typedPredicates()
+    { return mTypedPredicatesTable; }
+
+    /**
+     * @brief Declare the scope of a predicate function. The predicates of
+     * the plans built with this function get this scope and their results
+     * can be stored into the predicate cache of the activities. The scope
+     * must be declared before the plan is loaded.
+     * @param function The name of the predicate function.
+     * @param scope The scope of the predicate function.
+     * @param key The function to compute the key if scope is
+     * PredicatePerKey.
+     */
+    void setPredicateScope(const std::string& function,
+                           PredicateScope scope,
+                           const PredicateKeyFunction& key =
+                           PredicateKeyFunction())
+    {
+        PredicateScopesTable::iterator it =
+            mPredicateScopesTable.find(function);
+
+        if (it == mPredicateScopesTable.end()) {
+            mPredicateScopesTable.add(function, std::make_pair(scope, key));
+        } else {
+            it->second = std::make_pair(scope, key);
+        }
+    }
+
     /**
      * @brief Get the table of available acknowledge functions.
      * @return Table of available acknowledge functions.
@@ -478,6 +572,13 @@ public:
             return p < X >(name, func);
         }
 
+    template < typename X >
+        tp < X > P(const std::string& name, X func,
+                   const PredicateSignature& signature)
+        {
+            return tp < X >(name, func, signature);
+        }
+
     template < typename X >
         AddOutputFunctions < X > addOutputFunctions(X obj)
         {
@@ -557,7 +658,10 @@ private:
                         this decision knowledge base. */
 
     FactsTable mFactsTable;
+    FactHistoriesTable mFactHistories;
     PredicatesTable mPredicatesTable;
+    TypedPredicatesTable mTypedPredicatesTable;
+    PredicateScopesTable mPredicateScopesTable;
     AcknowledgeFunctions mAckFunctions;
     OutputFunctions mOutFunctions;
     UpdateFunctions mUpdateFunctions;
@@ -594,6 +698,22 @@ AddPredicates < X > operator,(AddPredicates < X > add, p < F > pred)
     return add;
 }
 
+template < typename X, typename F >
+AddPredicates < X > operator+=(AddPredicates < X > add, tp < F > pred)
+{
+    add.kb->typedPredicates().add(pred.name, TypedPredicateType(
+            boost::bind(pred.func, add.kb, _1, _2, _3, _4), pred.signature));
+    return add;
+}
+
+template < typename X, typename F >
+AddPredicates < X > operator,(AddPredicates < X > add, tp < F > pred)
+{
+    add.kb->typedPredicates().add(pred.name, TypedPredicateType(
+            boost::bind(pred.func, add.kb, _1, _2, _3, _4), pred.signature));
+    return add;
+}
+
 template < typename X, typename F >
 AddAcknowledgeFunctions < X > operator+=(AddAcknowledgeFunctions < X > add,
                                          a < F > pred)
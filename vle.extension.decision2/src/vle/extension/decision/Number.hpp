@@ -0,0 +1,116 @@
+/*
+ * @file vle/extension/decision/Number.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VLE_EXT_DECISION_NUMBER_HPP
+#define VLE_EXT_DECISION_NUMBER_HPP 1
+
+#include <cmath>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief Read a decimal number [-+]digits[.digits][(e|E)[-+]digits] in the
+ * C locale, whatever the global locale of the program: unlike std::strtod,
+ * a comma is never a decimal separator. The digits are accumulated in a
+ * double, exact up to 15 digits, then multiplied or divided once by a
+ * power of ten.
+ * @param it, the first character of the number.
+ * @param last, the end of the buffer.
+ * @param out, the number read.
+ * @return the end of the number or 0 if it is malformed.
+ */
+inline const char* parseReal(const char* it, const char* last, double* out)
+{
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+                                     1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+                                     1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+                                     1e20, 1e21, 1e22 };
+
+    bool negative = false;
+    if (it != last and (*it == '-' or *it == '+')) {
+        negative = *it == '-';
+        ++it;
+    }
+
+    double mantissa = 0.0;
+    int exponent = 0;
+    int digits = 0;
+
+    for (; it != last and *it >= '0' and *it <= '9'; ++it, ++digits) {
+        mantissa = mantissa * 10.0 + (*it - '0');
+    }
+
+    if (it != last and *it == '.') {
+        for (++it; it != last and *it >= '0' and *it <= '9';
+             ++it, ++digits) {
+            mantissa = mantissa * 10.0 + (*it - '0');
+            --exponent;
+        }
+    }
+
+    if (digits == 0) {
+        return 0;
+    }
+
+    if (it != last and (*it == 'e' or *it == 'E')) {
+        ++it;
+        bool negativeExponent = false;
+        if (it != last and (*it == '-' or *it == '+')) {
+            negativeExponent = *it == '-';
+            ++it;
+        }
+
+        const char* begin = it;
+        int value = 0;
+        while (it != last and *it >= '0' and *it <= '9' and it - begin < 9) {
+            value = value * 10 + (*it - '0');
+            ++it;
+        }
+
+        if (it == begin) {
+            return 0;
+        }
+
+        exponent += negativeExponent ? -value : value;
+    }
+
+    if (exponent < 0) {
+        mantissa = -exponent <= 22 ? mantissa / powers[-exponent]
+            : mantissa * std::pow(10.0, exponent);
+    } else if (exponent > 0) {
+        mantissa = exponent <= 22 ? mantissa * powers[exponent]
+            : mantissa * std::pow(10.0, exponent);
+    }
+
+    *out = negative ? -mantissa : mantissa;
+
+    return it;
+}
+
+}}} // namespace vle model decision
+
+#endif
@@ -28,6 +28,9 @@
 
 #include <vle/extension/decision/Plan.hpp>
 #include <vle/extension/decision/KnowledgeBase.hpp>
+#include <vle/extension/decision/PlanBinary.hpp>
+#include <vle/extension/decision/PlanParser.hpp>
+#include <vle/extension/decision/PlanPrototype.hpp>
 #include <vle/utils/Parser.hpp>
 #include <vle/utils/i18n.hpp>
 #include <vle/utils/DateTime.hpp>
@@ -37,23 +40,27 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <iterator>
 
 namespace vle { namespace extension { namespace decision {
 
-typedef utils::Block UB;
-typedef utils::Block::Blocks UBB;
-typedef utils::Block::Strings UBS;
-typedef utils::Block::Reals UBR;
-
 using boost::lexical_cast;
 
+namespace {
+
+std::string read(std::istream& stream)
+{
+    return std::string(std::istreambuf_iterator < char >(stream),
+                       std::istreambuf_iterator < char >());
+}
+
+} // anonymous namespace
+
 Plan::Plan(KnowledgeBase& kb, const std::string& buffer)
     : mKb(kb)
 {
     try {
-        std::istringstream in(buffer);
-        utils::Parser parser(in);
-        fill(parser.root(), 0);
+        fillBuffer(buffer, 0, "", ActivityMetadataFunction());
     } catch (const std::exception& e) {
         throw utils::ArgError(fmt(_("Decision plan error in %1%")) % e.what());
     }
@@ -63,8 +70,7 @@ Plan::Plan(KnowledgeBase& kb, std::istream& stream)
     : mKb(kb)
 {
     try {
-        utils::Parser parser(stream);
-        fill(parser.root(), 0);
+        fillBuffer(read(stream), 0, "", ActivityMetadataFunction());
     } catch (const std::exception& e) {
         throw utils::ArgError(fmt(_("Decision plan error: %1%")) % e.what());
     }
@@ -73,9 +79,7 @@ Plan::Plan(KnowledgeBase& kb, std::istream& stream)
 void Plan::fill(const std::string& buffer, const devs::Time& loadTime)
 {
     try {
-        std::istringstream in(buffer);
-        utils::Parser parser(in);
-        fill(parser.root(), loadTime);
+        fillBuffer(buffer, loadTime, "", ActivityMetadataFunction());
     } catch (const std::exception& e) {
         throw utils::ArgError(fmt(_("Decision plan error in %1%")) % e.what());
     }
@@ -85,9 +89,7 @@ void Plan::fill(const std::string& buffer, const devs::Time& loadTime,
                 const std::string suffixe)
 {
     try {
-        std::istringstream in(buffer);
-        utils::Parser parser(in);
-        fill(parser.root(), loadTime, suffixe);
+        fillBuffer(buffer, loadTime, suffixe, ActivityMetadataFunction());
     } catch (const std::exception& e) {
         throw utils::ArgError(fmt(_("Decision plan error in %1%")) % e.what());
     }
@@ -96,8 +98,7 @@ void Plan::fill(const std::string& buffer, const devs::Time& loadTime,
 void Plan::fill(std::istream& stream, const devs::Time& loadTime)
 {
     try {
-        utils::Parser parser(stream);
-        fill(parser.root(), loadTime);
+        fillBuffer(read(stream), loadTime, "", ActivityMetadataFunction());
     } catch (const std::exception& e) {
         throw utils::ArgError(fmt(_("Decision plan error: %1%")) % e.what());
     }
@@ -107,19 +108,53 @@ void Plan::fill(std::istream& stream, const devs::Time& loadTime,
                 const std::string suffixe)
 {
     try {
-        utils::Parser parser(stream);
-        fill(parser.root(), loadTime, suffixe);
+        fillBuffer(read(stream), loadTime, suffixe,
+                   ActivityMetadataFunction());
     } catch (const std::exception& e) {
         throw utils::ArgError(fmt(_("Decision plan error: %1%")) % e.what());
     }
 }
 
+void Plan::fill(const std::string& buffer, const devs::Time& loadTime,
+                const std::string suffixe,
+                const ActivityMetadataFunction& metadata)
+{
+    try {
+        fillBuffer(buffer, loadTime, suffixe, metadata);
+    } catch (const std::exception& e) {
+        throw utils::ArgError(fmt(_("Decision plan error in %1%")) % e.what());
+    }
+}
+
+void Plan::fill(std::istream& stream, const devs::Time& loadTime,
+                const std::string suffixe,
+                const ActivityMetadataFunction& metadata)
+{
+    try {
+        fillBuffer(read(stream), loadTime, suffixe, metadata);
+    } catch (const std::exception& e) {
+        throw utils::ArgError(fmt(_("Decision plan error: %1%")) % e.what());
+    }
+}
+
+void Plan::fillFile(const std::string& filename, const devs::Time& loadTime,
+                    const std::string suffixe,
+                    const ActivityMetadataFunction& metadata)
+{
+    try {
+        PlanBinaryFile file(filename);
+        PlanPrototype(*this, file.view()).instantiate(loadTime, suffixe,
+                                                      metadata);
+    } catch (const std::exception& e) {
+        throw utils::ArgError(fmt(_("Decision plan error in %1%: %2%")) %
+                              filename % e.what());
+    }
+}
+
 void Plan::fill(const std::string& buffer)
 {
     try {
-        std::istringstream in(buffer);
-        utils::Parser parser(in);
-        fill(parser.root(), 0);
+        fillBuffer(buffer, 0, "", ActivityMetadataFunction());
     } catch (const std::exception& e) {
         throw utils::ArgError(fmt(_("Decision plan error in %1%")) % e.what());
     }
@@ -128,439 +163,812 @@ void Plan::fill(const std::string& buffer)
 void Plan::fill(std::istream& stream)
 {
     try {
-        utils::Parser parser(stream);
-        fill(parser.root(), 0);
+        fillBuffer(read(stream), 0, "", ActivityMetadataFunction());
     } catch (const std::exception& e) {
         throw utils::ArgError(fmt(_("Decision plan error: %1%")) % e.what());
     }
 }
 
-void Plan::fill(const utils::Block& root, const devs::Time& loadTime)
+/**
+ * @brief Build a predicate from a predicate function or from a typed
+ * predicate function. The typed parameters are resolved here, once, with
+ * the signature of the typed predicate function.
+ */
+Predicate __make_predicate(const std::string& id,
+                           const std::string& type,
+                           const PredicatesTable& table,
+                           const TypedPredicatesTable& typedTable,
+                           const PredicateParameters& params)
 {
-    fill(root, loadTime, "");
+    PredicatesTable::const_iterator fctit = table.find(type);
+    if (fctit != table.end())
+        return Predicate(id, fctit->second, params);
+
+    TypedPredicatesTable::const_iterator typedit = typedTable.find(type);
+    if (typedit != typedTable.end())
+        return Predicate(id, typedit->second.first, params,
+                         TypedPredicateParameters(typedit->second.second,
+                                                  params));
+
+    throw utils::ArgError(
+        vle::fmt(_("Decision: unknown predicate function %1% in knowledgebase"))
+        % type);
 }
 
-struct AssignStringParameter
+/**
+ * @brief Add a predicate with its sorted parameters to the predicates of a
+ * plan.
+ */
+void __add_predicate(const std::string& id,
+                     const std::string& type,
+                     const PredicateParameters& params,
+                     Predicates& predicates,
+                     const PredicatesTable& table,
+                     const TypedPredicatesTable& typedTable,
+                     const PredicateScopesTable& scopes)
 {
-    PredicateParameters& m_params;
+    if (params.empty()) {
+        TraceModel(vle::fmt("predicate %1% added") % id);
+    } else {
+        TraceModel(vle::fmt("Predicate %1% added with parameters:") % id);
+
+        for (PredicateParameters::const_iterator it = params.begin();
+             it != params.end(); ++it)
+            TraceModel(vle::fmt("    - %1%") % it->first);
+    }
+
+    Predicate pred(__make_predicate(id, type, table, typedTable, params));
+
+    PredicateScopesTable::const_iterator scopeit = scopes.find(type);
+    if (scopeit != scopes.end())
+        pred.setScope(scopeit->second.first, scopeit->second.second);
+
+    predicates.add(pred);
+}
 
-    AssignStringParameter(PredicateParameters& params)
-        : m_params(params)
+/**
+ * @brief PlanBuilder receives the elements read by a PlanParser and fills
+ * the plan item by item. The values of a predicate, rule, activity or
+ * precedence block are kept as tokens pointing into the buffer, then the
+ * item is added to the plan at the end of its block. The tokens are only
+ * copied into a few strings reused from one item to the next, to look up
+ * the rules and the functions of the knowledge base. Like with a
+ * utils::Block, when a key is given more than once, only its first value
+ * is used, except for the list of rules or predicates.
+ */
+class PlanBuilder : public PlanParser::Handler
+{
+public:
+    enum Section {
+        SectionPredicates = 0,
+        SectionRules,
+        SectionActivities,
+        SectionPrecedences,
+        SectionUnknown
+    };
+
+    PlanBuilder(Plan& plan, const devs::Time& loadTime,
+                const std::string& suffixe,
+                const ActivityMetadataFunction& metadata)
+        : mPlan(plan), mLoadTime(loadTime), mSuffixe(suffixe),
+        mMetadata(metadata), mOnly(SectionUnknown), mDepth(0),
+        mSection(SectionUnknown), mActive(false), mInItem(false),
+        mChild(ChildNone)
     {}
 
-    void operator()(const vle::utils::Block::Strings::value_type& p)
+    virtual ~PlanBuilder() {}
+
+    static Section section(const PlanParser::Token& name)
     {
-        m_params.addString(p.first, p.second);
+        for (int i = SectionPredicates; i != SectionUnknown; ++i) {
+            if (name == sections()[i]) {
+                return static_cast < Section >(i);
+            }
+        }
+
+        return SectionUnknown;
     }
-};
 
-struct AssignDoubleParameter
-{
-    PredicateParameters& m_params;
+    /**
+     * @brief Fill only the items of a section, or all the items if
+     * section is SectionUnknown.
+     */
+    void only(Section section)
+    {
+        mOnly = section;
+    }
 
-    AssignDoubleParameter(PredicateParameters& params)
-        : m_params(params)
-    {}
+    virtual void beginBlock(const PlanParser::Token& name)
+    {
+        ++mDepth;
+
+        if (mDepth == 1) {
+            mSection = section(name);
+            mActive = mSection != SectionUnknown and
+                (mOnly == SectionUnknown or mOnly == mSection);
+        } else if (mDepth == 2) {
+            mInItem = mActive and name == items()[mSection];
+            if (mInItem) {
+                mItem.clear();
+            }
+        } else if (mDepth == 3 and mInItem) {
+            if (mSection == SectionPredicates and name == "parameter" and
+                not mItem.parameter) {
+                mItem.parameter = true;
+                mChild = ChildParameter;
+            } else if (mSection == SectionActivities and name == "temporal") {
+                mItem.temporals.push_back(Temporal());
+                mChild = ChildTemporal;
+            }
+        }
+    }
 
-    void operator()(const vle::utils::Block::Reals::value_type& p)
+    virtual void endBlock()
     {
-        m_params.addDouble(p.first, p.second);
+        if (mDepth == 2 and mInItem) {
+            build();
+            mInItem = false;
+        } else if (mDepth == 3) {
+            mChild = ChildNone;
+        }
+
+        --mDepth;
     }
-};
 
-void __fill_predicate(const utils::Block::BlocksResult& root,
-                      Predicates& predicates,
-                      const PredicatesTable& table)
-{
-    for (UBB::const_iterator it = root.first; it != root.second; ++it) {
-        const utils::Block& block = it->second;
+    virtual void string(const PlanParser::Token& key,
+                        const PlanParser::Token& value)
+    {
+        if (not mInItem) {
+            return;
+        }
 
-        UB::StringsResult id = block.strings.equal_range("id");
-        if (id.first == id.second)
-            throw utils::ArgError(_("Decision: predicate needs id"));
+        if (mDepth == 2) {
+            if (key == "id") {
+                first(mItem.id, value);
+            } else if (key == "type") {
+                first(mItem.type, value);
+            } else if (key == "predicates" or key == "rules") {
+                mItem.names.push_back(value);
+            } else if (key == "ack") {
+                first(mItem.ack, value);
+            } else if (key == "output") {
+                first(mItem.output, value);
+            } else if (key == "update") {
+                first(mItem.update, value);
+            } else if (key == "first") {
+                first(mItem.first, value);
+            } else if (key == "second") {
+                first(mItem.second, value);
+            }
+        } else if (mDepth == 3) {
+            if (mChild == ChildParameter) {
+                mItem.parameters.push_back(Parameter(key, value));
+            } else if (mChild == ChildTemporal) {
+                Date* date = temporalDate(key);
+                if (date and not date->string.begin) {
+                    date->string = value;
+                }
+            }
+        }
+    }
 
-        if (not predicates.exist(id.first->second)) {
-            UB::StringsResult type = block.strings.equal_range("type");
-            if (type.first == type.second)
-                throw utils::ArgError(_("Decision: predicate needs type"));
+    virtual void real(const PlanParser::Token& key, double value)
+    {
+        if (not mInItem) {
+            return;
+        }
 
-            PredicatesTable::const_iterator fctit = table.get(type.first->second);
-            if (fctit == table.end())
-                throw utils::ArgError(
-                    vle::fmt(_("Decision: unknown predicate function %1% in knowledgebase"))
-                    % type.first->second);
+        if (mDepth == 2) {
+            if (key == "speed_ha_per_day") {
+                first(mItem.speed, value);
+            } else if (key == "mintimelag") {
+                first(mItem.mintimelag, value);
+            } else if (key == "maxtimelag") {
+                first(mItem.maxtimelag, value);
+            }
+        } else if (mDepth == 3) {
+            if (mChild == ChildParameter) {
+                mItem.parameters.push_back(Parameter(key, value));
+            } else if (mChild == ChildTemporal) {
+                Date* date = temporalDate(key);
+                if (date) {
+                    first(date->real, value);
+                }
+            }
+        }
+    }
 
-            utils::Block::BlocksResult parameters = block.blocks.equal_range("parameter");
-            if (parameters.first == parameters.second) {
-                TraceModel(vle::fmt("predicate %1% added")
-                           % id.first->second);
+    virtual void relativeReal(const PlanParser::Token& key, double value)
+    {
+        if (mInItem and mDepth == 3 and mChild == ChildTemporal) {
+            Date* date = temporalDate(key);
+            if (date) {
+                first(date->relative, value);
+            }
+        }
+    }
 
-                predicates.add(id.first->second, fctit->second);
-            } else {
-                PredicateParameters params;
+    /**
+     * @brief Check if the sections of a buffer are in the order of Plan::fill.
+     */
+    static bool isOrdered(const std::vector < PlanParser::Token >& names)
+    {
+        int last = SectionPredicates;
 
-                std::for_each(parameters.first->second.strings.begin(),
-                              parameters.first->second.strings.end(),
-                              AssignStringParameter(params));
+        for (std::vector < PlanParser::Token >::const_iterator it =
+             names.begin(); it != names.end(); ++it) {
+            int current = section(*it);
 
-                std::for_each(parameters.first->second.reals.begin(),
-                              parameters.first->second.reals.end(),
-                              AssignDoubleParameter(params));
+            if (current != SectionUnknown) {
+                if (current < last) {
+                    return false;
+                }
+                last = current;
+            }
+        }
 
-                params.sort();
+        return true;
+    }
 
-                TraceModel(vle::fmt("Predicate %1% added with parameters:") %
-                            id.first->second);
+private:
+    enum Child { ChildNone, ChildParameter, ChildTemporal };
 
-                for (PredicateParameters::const_iterator it = params.begin();
-                     it != params.end(); ++it)
-                    TraceModel(vle::fmt("    - %1%") % it->first);
+    /**
+     * @brief A real value and whether it was given.
+     */
+    struct Real
+    {
+        Real()
+            : given(false), value(0.0)
+        {}
+
+        bool given;
+        double value;
+    };
+
+    /**
+     * @brief A parameter of a predicate.
+     */
+    struct Parameter
+    {
+        Parameter(const PlanParser::Token& name,
+                  const PlanParser::Token& string)
+            : name(name), string(string), real(0.0)
+        {}
+
+        Parameter(const PlanParser::Token& name, double real)
+            : name(name), real(real)
+        {}
+
+        PlanParser::Token name;
+        PlanParser::Token string; /**< Not set for a real parameter. */
+        double real;
+    };
+
+    /**
+     * @brief The values given to a date of a temporal block.
+     */
+    struct Date
+    {
+        Real real;
+        PlanParser::Token string;
+        Real relative;
+    };
 
-                predicates.add(id.first->second, fctit->second, params);
-            }
-        } else {
-            TraceModel(vle::fmt("Predicate %1% already exists, we forget the new") %
-                        id.first->second);
+    enum DateName { DateStart = 0, DateMinStart, DateMaxStart, DateFinish,
+        DateMinFinish, DateMaxFinish, DateUnknown };
+
+    struct Temporal
+    {
+        Date dates[DateUnknown];
+    };
+
+    /**
+     * @brief The values of the current item. The vectors keep their
+     * capacity from one item to the next.
+     */
+    struct Item
+    {
+        void clear()
+        {
+            id = type = ack = output = update = first = second =
+                PlanParser::Token();
+            names.clear();
+            parameters.clear();
+            parameter = false;
+            temporals.clear();
+            speed = mintimelag = maxtimelag = Real();
         }
+
+        PlanParser::Token id, type, ack, output, update, first, second;
+        std::vector < PlanParser::Token > names;
+        std::vector < Parameter > parameters;
+        bool parameter;
+        std::vector < Temporal > temporals;
+        Real speed, mintimelag, maxtimelag;
+    };
+
+    static const char* const* sections()
+    {
+        static const char* const names[] = {
+            "predicates", "rules", "activities", "precedences" };
+
+        return names;
     }
-}
 
-void Plan::fill(const utils::Block& root, const devs::Time& loadTime,
-                const std::string suffixe)
-{
-    utils::Block::BlocksResult mainpredicates, mainrules, mainactivities,
-        mainprecedences;
+    static const char* const* items()
+    {
+        static const char* const names[] = {
+            "predicate", "rule", "activity", "precedence" };
 
-    mainpredicates = root.blocks.equal_range("predicates");
-    mainrules = root.blocks.equal_range("rules");
-    mainactivities = root.blocks.equal_range("activities");
-    mainprecedences = root.blocks.equal_range("precedences");
+        return names;
+    }
 
-    utils::Block::Blocks::const_iterator it;
+    static const char* const* dates()
+    {
+        static const char* const names[] = {
+            "start", "minstart", "maxstart", "finish", "minfinish",
+            "maxfinish" };
 
-    for (it = mainpredicates.first; it != mainpredicates.second; ++it)
-        __fill_predicate(it->second.blocks.equal_range("predicate"),
-                         mPredicates, mKb.predicates());
+        return names;
+    }
 
-    for (it = mainrules.first; it != mainrules.second; ++it) {
-        utils::Block::BlocksResult rules;
-        rules = it->second.blocks.equal_range("rule");
-        fillRules(rules, loadTime);
+    static void first(PlanParser::Token& token,
+                      const PlanParser::Token& value)
+    {
+        if (not token.begin) {
+            token = value;
+        }
     }
 
-    for (it = mainactivities.first; it != mainactivities.second; ++it) {
-        utils::Block::BlocksResult activities;
-        activities = it->second.blocks.equal_range("activity");
-        fillActivities(activities, loadTime, suffixe);
+    static void first(Real& real, double value)
+    {
+        if (not real.given) {
+            real.given = true;
+            real.value = value;
+        }
     }
 
-    for (it = mainprecedences.first; it != mainprecedences.second; ++it) {
-        utils::Block::BlocksResult precedences;
-        precedences = it->second.blocks.equal_range("precedence");
-        fillPrecedences(precedences, loadTime, suffixe);
+    static const std::string& assign(std::string& str,
+                                     const PlanParser::Token& token)
+    {
+        return str.assign(token.begin, token.size);
     }
-}
 
-void Plan::fillRules(const utils::Block::BlocksResult& rules, const devs::Time&)
-{
-    for (UBB::const_iterator it = rules.first; it != rules.second; ++it) {
-        const utils::Block& block = it->second;
+    Date* temporalDate(const PlanParser::Token& key)
+    {
+        for (int i = DateStart; i != DateUnknown; ++i) {
+            if (key == dates()[i]) {
+                return &mItem.temporals.back().dates[i];
+            }
+        }
 
-        UB::StringsResult id = block.strings.equal_range("id");
-        if (id.first == id.second)
-            throw utils::ArgError(_("Decision: rule needs id"));
+        return 0;
+    }
+
+    void build()
+    {
+        switch (mSection) {
+        case SectionPredicates:
+            buildPredicate();
+            break;
+        case SectionRules:
+            buildRule();
+            break;
+        case SectionActivities:
+            buildActivity();
+            break;
+        case SectionPrecedences:
+            buildPrecedence();
+            break;
+        default:
+            break;
+        }
+    }
 
-        if (not mRules.exist(id.first->second))  {
-            Rule& rule = mRules.add(id.first->second);
+    void buildPredicate()
+    {
+        if (not mItem.id.begin) {
+            throw utils::ArgError(_("Decision: predicate needs id"));
+        }
 
-            UB::StringsResult preds = block.strings.equal_range("predicates");
-            for (UB::Strings::const_iterator jt = preds.first;
-                 jt != preds.second; ++jt) {
+        const std::string& id = assign(mId, mItem.id);
+        if (mPlan.mPredicates.exist(id)) {
+            TraceModel(vle::fmt("Predicate %1% already exists, we forget "
+                                "the new") % id);
+            return;
+        }
 
-                // Trying to found a parametred parameter in this plan.
-                Predicates::const_iterator p = mPredicates.find(jt->second);
-                if (p != mPredicates.end()) {
-                    TraceModel(vle::fmt("rule %1% adds predicate %2%") %
-                                id.first->second % jt->second);
+        if (not mItem.type.begin) {
+            throw utils::ArgError(_("Decision: predicate needs type"));
+        }
 
-                    rule.add(&*p);
-                } else {
-                    // If it fails, trying to use the oldtest API to use
-                    // directly the predicate function.
-                    PredicatesTable::const_iterator p2 = mKb.predicates().get(jt->second);
-                    if (p2 == mKb.predicates().end())
-                        throw vle::utils::ArgError(
-                            vle::fmt(_("Decision: unknown predicate function %1%")) %
-                            jt->second);
-
-                    TraceModel(vle::fmt("rule %1% adds old predicate (c++ function) %2%")
-                                % id.first->second % jt->second);
-
-                    rule.add(p2->second);
-                }
+        PredicateParameters params;
+        for (std::vector < Parameter >::const_iterator it =
+             mItem.parameters.begin(); it != mItem.parameters.end(); ++it) {
+            if (it->string.begin) {
+                params.addString(assign(mKey, it->name),
+                                 assign(mName, it->string));
+            } else {
+                params.addDouble(assign(mKey, it->name), it->real);
             }
-        } else {
-            TraceModel(vle::fmt("Rule %1% already exists, we forget the new") %
-                       id.first->second);
         }
+        params.sort();
+
+        __add_predicate(id, assign(mName, mItem.type), params,
+                        mPlan.mPredicates, mPlan.mKb.predicates(),
+                        mPlan.mKb.typedPredicates(),
+                        mPlan.mKb.predicateScopes());
     }
-}
 
-void Plan::fillActivities(const utils::Block::BlocksResult& acts,
-                          const devs::Time& loadTime)
-{
-    fillActivities(acts, loadTime, "");
-}
+    void buildRule()
+    {
+        if (not mItem.id.begin) {
+            throw utils::ArgError(_("Decision: rule needs id"));
+        }
 
-void Plan::fillActivities(const utils::Block::BlocksResult& acts,
-                          const devs::Time& loadTime,
-                          const std::string suffixe)
-{
-    for (UBB::const_iterator it = acts.first; it != acts.second; ++it) {
-        const utils::Block& block = it->second;
+        const std::string& id = assign(mId, mItem.id);
+        if (mPlan.mRules.exist(id)) {
+            TraceModel(vle::fmt("Rule %1% already exists, we forget the new")
+                       % id);
+            return;
+        }
+
+        Rule& rule = mPlan.mRules.add(id);
+        for (std::vector < PlanParser::Token >::const_iterator it =
+             mItem.names.begin(); it != mItem.names.end(); ++it) {
+            mPlan.addRulePredicate(rule, id, assign(mKey, *it));
+        }
+    }
 
-        UB::StringsResult id = block.strings.equal_range("id");
-        if (id.first == id.second) {
+    void buildActivity()
+    {
+        if (not mItem.id.begin) {
             throw utils::ArgError(_("Decision: activity needs id"));
         }
 
-        Activity& act = mActivities.add(id.first->second + suffixe, Activity());
+        const std::string& id = assign(mId, mItem.id);
+        mName.assign(id);
+        mName.append(mSuffixe);
+        Activity& act = mPlan.mActivities.emplace(mName)->second;
 
-        UB::StringsResult rules = block.strings.equal_range("rules");
-        for (UBS::const_iterator jt = rules.first; jt != rules.second; ++jt) {
-            act.addRule(jt->second, mRules.get(jt->second));
+        if (mMetadata) {
+            act.setMetadata(mMetadata(id));
         }
 
-        UB::StringsResult ack = block.strings.equal_range("ack");
-        if (ack.first != ack.second) {
-            act.addAcknowledgeFunction((mKb.acknowledgeFunctions().get(
-                        ack.first->second))->second);
+        for (std::vector < PlanParser::Token >::const_iterator it =
+             mItem.names.begin(); it != mItem.names.end(); ++it) {
+            act.addRule(mPlan.mRules.lookup(assign(mKey, *it)));
         }
 
-        UB::StringsResult out = block.strings.equal_range("output");
-        if (out .first != out.second) {
-            act.addOutputFunction((mKb.outputFunctions().get(
-                        out.first->second))->second);
+        KnowledgeBase& kb = mPlan.mKb;
+        if (mItem.ack.begin) {
+            act.addAcknowledgeFunction(&kb.acknowledgeFunctions().get(
+                    assign(mKey, mItem.ack))->second);
         }
 
-        UB::StringsResult upd = block.strings.equal_range("update");
-        if (upd.first != upd.second) {
-            act.addUpdateFunction((mKb.updateFunctions().get(
-                        upd.first->second))->second);
+        if (mItem.output.begin) {
+            act.addOutputFunction(&kb.outputFunctions().get(
+                    assign(mKey, mItem.output))->second);
         }
 
-        UB::BlocksResult temporal = block.blocks.equal_range("temporal");
-        if (temporal.first != temporal.second) {
-            fillTemporal(temporal, act, loadTime);
+        if (mItem.update.begin) {
+            act.addUpdateFunction(&kb.updateFunctions().get(
+                    assign(mKey, mItem.update))->second);
+        }
+
+        for (std::vector < Temporal >::const_iterator it =
+             mItem.temporals.begin(); it != mItem.temporals.end(); ++it) {
+            Plan::DateResult result[DateUnknown];
+
+            for (int i = DateStart; i != DateUnknown; ++i) {
+                result[i] = date(dates()[i], it->dates[i]);
+            }
+
+            Plan::setTemporal(act, result[DateStart], result[DateMinStart],
+                              result[DateMaxStart], result[DateFinish],
+                              result[DateMinFinish], result[DateMaxFinish]);
         }
 
-        UB::RealsResult speed = block.reals.equal_range("speed_ha_per_day");
-        if (speed.first != speed.second) {
-            act.setSpeed(speed.first->second);
+        if (mItem.speed.given) {
+            act.setSpeed(mItem.speed.value);
         }
     }
-}
 
-void Plan::fillTemporal(const utils::Block::BlocksResult& temps,
-                        Activity& activity,
-                        const devs::Time& loadTime)
-{
-    for (UBB::const_iterator it = temps.first; it != temps.second; ++it) {
-        const utils::Block& block = it->second;
+    void buildPrecedence()
+    {
+        if (mItem.first.begin) {
+            mId.assign(mItem.first.begin, mItem.first.size);
+            mId.append(mSuffixe);
+        } else {
+            mId.clear();
+        }
 
+        if (mItem.second.begin) {
+            mName.assign(mItem.second.begin, mItem.second.size);
+            mName.append(mSuffixe);
+        } else {
+            mName.clear();
+        }
 
-        DateResult start = getDate("start",block,loadTime);
-        DateResult mins = getDate("minstart",block,loadTime);
-        DateResult maxs = getDate("maxstart",block,loadTime);
-        DateResult finish = getDate("finish",block,loadTime);
-        DateResult minf = getDate("minfinish",block,loadTime);
-        DateResult maxf = getDate("maxfinish",block,loadTime);
+        double mintimelag = mItem.mintimelag.given ?
+            mItem.mintimelag.value : 0.0;
+        double maxtimelag = mItem.maxtimelag.given ?
+            mItem.maxtimelag.value : devs::infinity;
 
-        if (start.first) {
-            if (finish.first) {
-                activity.initStartTimeFinishTime(start.second, finish.second);
-            } else {
-                double vmin, vmax;
-                if (minf.first) {
-                    if (maxf.first) {
-                        vmin = minf.second;
-                        vmax = maxf.second;
-                    } else {
-                        vmin = minf.second;
-                        vmax = devs::infinity;
-                    }
-                } else {
-                    if (maxf.first != maxf.second) {
-                        vmin = 0;
-                        vmax = maxf.second;
-                    } else {
-                        vmin = 0;
-                        vmax = devs::infinity;
-                    }
-                }
-                activity.initStartTimeFinishRange(start.second,vmin,vmax);
-            }
+        Activities& activities = mPlan.mActivities;
+        if (not mItem.type.begin) {
+            throw utils::ArgError(_("Decision: precedences type unknown"));
+        } else if (mItem.type == "SS") {
+            activities.addStartToStartConstraint(mId, mName, mintimelag,
+                                                 maxtimelag);
+        } else if (mItem.type == "FS") {
+            activities.addFinishToStartConstraint(mId, mName, mintimelag,
+                                                  maxtimelag);
+        } else if (mItem.type == "FF") {
+            activities.addFinishToFinishConstraint(mId, mName, mintimelag,
+                                                   maxtimelag);
         } else {
-            double vmin, vmax;
-            if (mins.first) {
-                vmin = mins.second;
-            } else {
-                vmin = devs::negativeInfinity;
-            }
-            if (maxs.first) {
-                vmax = maxs.second;
-            } else {
-                vmax = devs::infinity;
-            }
-            if (finish.first) {
-                activity.initStartRangeFinishTime(vmin, vmax,finish.second);
-            } else {
-                double vminf, vmaxf;
-                if (minf.first) {
-                    if (maxf.first) {
-                        vminf = minf.second;
-                        vmaxf = maxf.second;
-                    } else {
-                        vminf = minf.second;
-                        vmaxf = devs::infinity;
-                    }
-                } else {
-                    if (maxf.first) {
-                        vminf = 0;
-                        vmaxf = maxf.second;
-                    } else {
-                        vminf = 0;
-                        vmaxf = devs::infinity;
-                    }
-                }
-                activity.initStartRangeFinishRange(
-                    vmin, vmax, vminf, vmaxf);
-            }
+            throw utils::ArgError(fmt(
+                    _("Decision: precendence type `%1%' unknown")) %
+                mItem.type.str());
         }
     }
-}
 
-void Plan::fillPrecedences(const utils::Block::BlocksResult& preds,
-                           const devs::Time& loadTime)
-{
-    fillPrecedences(preds, loadTime, "");
-}
+    /**
+     * @brief Get a date given as a real (e.g. julian day 2452132), a date
+     * (e.g. "2001-08-10"), a date relative to the year of the load time
+     * (e.g. "+1-08-10") or a number of days after the load time (e.g.
+     * +10).
+     */
+    Plan::DateResult date(const char* dateName, const Date& date) const
+    {
+        bool hasRealDate = date.real.given;
+        bool hasStringDate = date.string.begin;
+        bool hasRelativeDate = date.relative.given;
+
+        if ((hasRealDate && hasStringDate) ||
+            (hasRealDate && hasRelativeDate) ||
+            (hasStringDate && hasRelativeDate)) {
+            throw utils::ArgError(fmt(_(
+                "Decision: date '%1%' should not be given twice ")) %
+                dateName);
+        }
+
+        if (hasRealDate) {
+            return Plan::DateResult(true, devs::Time(date.real.value));
+        } else if (hasRelativeDate) {
+            return Plan::DateResult(true, mLoadTime +
+                                    devs::Time(date.relative.value));
+        } else if (not hasStringDate) {
+            return Plan::DateResult(false, devs::infinity);
+        }
 
-void Plan::fillPrecedences(const utils::Block::BlocksResult& preds,
-                           const devs::Time&,
-                           const std::string suffixe)
+        const std::string dateString(date.string.str());
+        if (dateString.empty() or dateString[0] != '+') {
+            return Plan::DateResult(true, devs::Time(
+                    (int) utils::DateTime::toJulianDayNumber(dateString)));
+        }
+
+        std::string relativeDate = dateString.substr(1);
+        std::vector< std::string > explosedDate;
+
+        boost::split(explosedDate, relativeDate, boost::is_any_of("-") );
+
+        std::string year = explosedDate[0];
+        std::string month = explosedDate[1];
+        std::string day = explosedDate[2];
+
+        if (utils::DateTime::isValidYear(mLoadTime)) {
+            year = lexical_cast<std::string>(
+                lexical_cast<int>(year) + utils::DateTime::year(mLoadTime));
+
+            return Plan::DateResult(true, devs::Time(
+                    (int) utils::DateTime::toJulianDayNumber(
+                        year + "-" + month + "-" + day)));
+        } else {
+            std::string firstNonLeapYear = "1401";
+
+            int daysOfLastYear = utils::DateTime::dayOfYear(
+                utils::DateTime::toJulianDayNumber(
+                    firstNonLeapYear + "-" + month + "-" + day));
+            int daysOfFullYears = 365 * lexical_cast<int>(year);
+
+            return Plan::DateResult(true, devs::Time(daysOfLastYear +
+                                                     daysOfFullYears));
+        }
+    }
+
+    Plan& mPlan;
+    const devs::Time& mLoadTime;
+    const std::string& mSuffixe;
+    const ActivityMetadataFunction& mMetadata;
+    Section mOnly;
+    int mDepth;
+    Section mSection;
+    bool mActive; /**< The current section is filled. */
+    bool mInItem; /**< The current depth 2 block is an item. */
+    Child mChild;
+    Item mItem;
+    std::string mId, mName, mKey; /**< Reused copies of the tokens. */
+};
+
+void Plan::fillBuffer(const std::string& buffer, const devs::Time& loadTime,
+                      const std::string& suffixe,
+                      const ActivityMetadataFunction& metadata)
 {
-    for (UBB::const_iterator it = preds.first; it != preds.second; ++it) {
-        const utils::Block& block = it->second;
+    const char* begin = buffer.data();
+    const char* end = begin + buffer.size();
+
+    PlanParser parser(begin, end);
 
-        std::string valuefirst, valuesecond;
-        double valuemintl = 0.0;
-        double valuemaxtl = devs::infinity;
+    // sections() reads the whole buffer: a syntax error is thrown before
+    // the builder changes the plan.
+    std::vector < PlanParser::Token > sections = parser.sections();
+    PlanBuilder builder(*this, loadTime, suffixe, metadata);
 
-        UB::StringsResult first = block.strings.equal_range("first");
-        if (first.first != first.second) {
-            valuefirst = first.first->second + suffixe;
+    if (PlanBuilder::isOrdered(sections)) {
+        parser.parse(builder);
+    } else {
+        // The buffer is read once per section, in the order of Plan::fill.
+        for (int i = PlanBuilder::SectionPredicates;
+             i != PlanBuilder::SectionUnknown; ++i) {
+            builder.only(static_cast < PlanBuilder::Section >(i));
+            parser.parse(builder);
         }
+    }
+}
 
-        UB::StringsResult second = block.strings.equal_range("second");
-        if (second.first != second.second) {
-            valuesecond = second.first->second + suffixe;
+void Plan::fillDefinitions(const PlanBinaryView& plan)
+{
+    for (boost::uint32_t i = 0; i < plan.predicates(); ++i) {
+        PlanBinaryView::Predicate pred = plan.predicate(i);
+
+        if (mPredicates.exist(pred.id)) {
+            TraceModel(vle::fmt("Predicate %1% already exists, we forget the new") %
+                        pred.id);
+            continue;
         }
 
-        UB::RealsResult mintl = block.reals.equal_range("mintimelag");
-        if (mintl.first != mintl.second) {
-            valuemintl = mintl.first->second;
+        if (not pred.type)
+            throw utils::ArgError(_("Decision: predicate needs type"));
+
+        // The parameters are sorted by the compiler.
+        PredicateParameters params;
+        for (boost::uint32_t j = 0; j < pred.parameters; ++j) {
+            PlanBinaryView::Parameter param = plan.parameter(pred.parameter + j);
+
+            if (param.type == PlanBinaryView::ParameterString)
+                params.addString(param.name, param.string);
+            else
+                params.addDouble(param.name, param.real);
         }
 
-        UB::RealsResult maxtl = block.reals.equal_range("maxtimelag");
-        if (maxtl.first != maxtl.second) {
-            valuemaxtl = maxtl.first->second;
+        __add_predicate(pred.id, pred.type, params, mPredicates,
+                        mKb.predicates(), mKb.typedPredicates(),
+                        mKb.predicateScopes());
+    }
+
+    for (boost::uint32_t i = 0; i < plan.rules(); ++i) {
+        PlanBinaryView::Rule rule = plan.rule(i);
+
+        if (mRules.exist(rule.id)) {
+            TraceModel(vle::fmt("Rule %1% already exists, we forget the new") %
+                       rule.id);
+            continue;
         }
 
-        UB::StringsResult type = block.strings.equal_range("type");
-        if (type.first != type.second) {
-            if (type.first->second == "SS") {
-                mActivities.addStartToStartConstraint(valuefirst, valuesecond,
-                                                      valuemintl, valuemaxtl);
-            } else if (type.first->second == "FS") {
-                mActivities.addFinishToStartConstraint(valuefirst, valuesecond,
-                                                       valuemintl, valuemaxtl);
-            } else if (type.first->second == "FF") {
-                mActivities.addFinishToFinishConstraint(valuefirst,
-                                                        valuesecond,
-                                                        valuemintl, valuemaxtl);
-            } else {
-                throw utils::ArgError(fmt(
-                        _("Decision: precendence type `%1%' unknown")) %
-                    type.first->second);
-            }
-        } else {
-            throw utils::ArgError(_("Decision: precedences type unknown"));
+        Rule& added = mRules.add(rule.id);
+        for (boost::uint32_t j = 0; j < rule.predicates; ++j) {
+            addRulePredicate(added, rule.id, plan.name(rule.predicate + j));
         }
     }
 }
 
-Plan::DateResult Plan::getDate(const std::string& dateName,
-               const utils::Block& block, const devs::Time& loadTime) const
+void Plan::addRulePredicate(Rule& rule, const std::string& id,
+                            const std::string& predicate)
 {
-    UB::RealsResult dateReal = block.reals.equal_range(dateName);
-    UB::StringsResult dateString = block.strings.equal_range(dateName);
-    UB::RelativeRealsResult dateRelative =
-        block.relativeReals.equal_range(dateName);
-    bool hasRealDate = dateReal.first != dateReal.second;
-    bool hasStringDate = dateString.first != dateString.second;
-
-    bool hasRelativeDate = dateRelative.first != dateRelative.second;
-    if((hasRealDate && hasStringDate) ||
-       (hasRealDate && hasRelativeDate) ||
-       (hasStringDate && hasRelativeDate)) {
-        throw utils::ArgError(fmt(_(
-          "Decision: date '%1%' should not be given twice ")) % dateName);
-    }
-    if (hasRealDate){
-        return DateResult(true,devs::Time((double) dateReal.first->second));
-    } else if (hasStringDate){
-        bool hasRelativeStringDate =  dateString.first->second[0] == '+';
-        if (hasRelativeStringDate) {
-            std::string relativeDate = dateString.first->second.substr(1);
-            std::vector< std::string > explosedDate;
-
-            boost::split(explosedDate, relativeDate, boost::is_any_of("-") );
-
-            std::string year = explosedDate[0];
-            std::string month = explosedDate[1];
-            std::string day = explosedDate[2];
-
-            if (utils::DateTime::isValidYear(loadTime)) {
-
-                year = lexical_cast<std::string>(
-                    lexical_cast<int>(year) +
-                    utils::DateTime::year(loadTime));
-
-                return DateResult(true, devs::Time(
-                                      (int) utils::DateTime::toJulianDayNumber(
-                                          year + "-" + month + "-" + day)));
-            } else {
-                std::string firstNonLeapYear = "1401";
-
-                int daysOfLastYear = utils::DateTime::dayOfYear(
-                    utils::DateTime::toJulianDayNumber(
-                        firstNonLeapYear + "-" + month + "-" + day));
-                int daysOfFullYears = 365 * lexical_cast<int>(year);
-
-                return DateResult(true, devs::Time(daysOfLastYear + daysOfFullYears));
+    // Trying to found a parametred parameter in this plan.
+    Predicates::const_iterator p = mPredicates.find(predicate);
+    if (p != mPredicates.end()) {
+        TraceModel(vle::fmt("rule %1% adds predicate %2%") % id % predicate);
+
+        rule.add(&*p);
+    } else if (mKb.typedPredicates().exist(predicate)) {
+        // A typed predicate function named by the rule gets a predicate of
+        // the same name, without parameters.
+        __add_predicate(predicate, predicate, PredicateParameters(),
+                        mPredicates, mKb.predicates(), mKb.typedPredicates(),
+                        mKb.predicateScopes());
+
+        TraceModel(vle::fmt("rule %1% adds typed predicate %2%") % id
+                   % predicate);
+
+        rule.add(&*mPredicates.find(predicate));
+    } else {
+        // If it fails, trying to use the oldtest API to use
+        // directly the predicate function.
+        PredicatesTable::const_iterator p2 = mKb.predicates().get(predicate);
+        if (p2 == mKb.predicates().end())
+            throw vle::utils::ArgError(
+                vle::fmt(_("Decision: unknown predicate function %1%")) %
+                predicate);
+
+        TraceModel(vle::fmt("rule %1% adds old predicate (c++ function) %2%")
+                    % id % predicate);
+
+        rule.add(p2->second);
+    }
+}
 
-            }
+void Plan::setTemporal(Activity& activity,
+                       const DateResult& start,
+                       const DateResult& mins,
+                       const DateResult& maxs,
+                       const DateResult& finish,
+                       const DateResult& minf,
+                       const DateResult& maxf)
+{
+    if (start.first) {
+        if (finish.first) {
+            activity.initStartTimeFinishTime(start.second, finish.second);
         } else {
-            return DateResult(true,devs::Time(
-                                  (int) utils::DateTime::toJulianDayNumber(
-                                      dateString.first->second)));
+            double vmin, vmax;
+            if (minf.first) {
+                if (maxf.first) {
+                    vmin = minf.second;
+                    vmax = maxf.second;
+                } else {
+                    vmin = minf.second;
+                    vmax = devs::infinity;
+                }
+            } else {
+                if (maxf.first != maxf.second) {
+                    vmin = 0;
+                    vmax = maxf.second;
+                } else {
+                    vmin = 0;
+                    vmax = devs::infinity;
+                }
+            }
+            activity.initStartTimeFinishRange(start.second,vmin,vmax);
         }
-    } else if (hasRelativeDate){
-        return DateResult(true,
-                          loadTime + devs::Time((double) dateRelative.first->second));
     } else {
-        return DateResult(false,devs::infinity);
+        double vmin, vmax;
+        if (mins.first) {
+            vmin = mins.second;
+        } else {
+            vmin = devs::negativeInfinity;
+        }
+        if (maxs.first) {
+            vmax = maxs.second;
+        } else {
+            vmax = devs::infinity;
+        }
+        if (finish.first) {
+            activity.initStartRangeFinishTime(vmin, vmax,finish.second);
+        } else {
+            double vminf, vmaxf;
+            if (minf.first) {
+                if (maxf.first) {
+                    vminf = minf.second;
+                    vmaxf = maxf.second;
+                } else {
+                    vminf = minf.second;
+                    vmaxf = devs::infinity;
+                }
+            } else {
+                if (maxf.first) {
+                    vminf = 0;
+                    vmaxf = maxf.second;
+                } else {
+                    vminf = 0;
+                    vmaxf = devs::infinity;
+                }
+            }
+            activity.initStartRangeFinishRange(
+                vmin, vmax, vminf, vmaxf);
+        }
     }
 }
 
@@ -40,6 +40,7 @@
 namespace vle { namespace extension { namespace decision {
 
 class KnowledgeBase;
+class PlanBinaryView;
 
 /**
  * @brief A Plan stores Rules, Activites (with the PrecedencesGraph). The
@@ -105,6 +106,43 @@ public:
      */
     void fill(std::istream& stream, const devs::Time& loadTime,
               const std::string suffixe);
+    /**
+     * @brief Fill a plan from a string
+     * @param buffer, string representation of the plan
+     * @param loadTime, the time of plan loading.
+     * @param suffixe, the suffix appended to the activities identifiers.
+     * @param metadata, the function called with the identifier of each new
+     * activity to build its metadata.
+     */
+    void fill(const std::string& buffer, const devs::Time& loadTime,
+              const std::string suffixe,
+              const ActivityMetadataFunction& metadata);
+    /**
+     * @brief Fill a plan from a stream
+     * @param stream, stream containing the representation of the plan
+     * @param loadTime, the time of plan loading.
+     * @param suffixe, the suffix appended to the activities identifiers.
+     * @param metadata, the function called with the identifier of each new
+     * activity to build its metadata.
+     */
+    void fill(std::istream& stream, const devs::Time& loadTime,
+              const std::string suffixe,
+              const ActivityMetadataFunction& metadata);
+
+    /**
+     * @brief Fill a plan from a file. If an up-to-date compiled plan
+     * exists next to the file (see PlanBinaryFile), it is mapped into
+     * memory instead of parsing the text.
+     * @param filename, the path of the text plan.
+     * @param loadTime, the time of plan loading.
+     * @param suffixe, the suffix appended to the activities identifiers.
+     * @param metadata, the function called with the identifier of each new
+     * activity to build its metadata.
+     */
+    void fillFile(const std::string& filename, const devs::Time& loadTime,
+                  const std::string suffixe = std::string(),
+                  const ActivityMetadataFunction& metadata =
+                  ActivityMetadataFunction());
 
     const Rules& rules() const { return mRules; }
     const Activities& activities() const { return mActivities; }
@@ -112,37 +150,54 @@ public:
     Activities& activities() { return mActivities; }
 
 private:
-    void fill(const utils::Block& root);
-    void fillRules(const utils::Block::BlocksResult& rules);
-    void fillActivities(const utils::Block::BlocksResult& activities);
-    void fill(const utils::Block& root, const devs::Time& loadTime);
-    void fill(const utils::Block& root, const devs::Time& loadTime,
-              const std::string suffixe);
-    void fillRules(const utils::Block::BlocksResult& rules,
-            const devs::Time& loadTime);
-    void fillActivities(const utils::Block::BlocksResult& activities,
-                        const devs::Time& loadTime);
-    void fillActivities(const utils::Block::BlocksResult& activities,
-                        const devs::Time& loadTime,
-                        const std::string suffixe);
-    void fillTemporal(const utils::Block::BlocksResult& temporals,
-                              Activity& activity,
-                              const devs::Time& loadTime);
-    void fillPrecedences(const utils::Block::BlocksResult& precedences,
-                         const devs::Time& loadTime);
-    void fillPrecedences(const utils::Block::BlocksResult& precedences,
-                         const devs::Time& loadTime,
-                         const std::string suffixe);
+    friend class PlanPrototype;
+    friend class PlanBuilder;
+    friend class StaticPlan;
+
     /**
-     * @brief Get a date into a block with real format (e.g. julian day 2452132)
-     * or a date format (e.g. 2001-08-10)
-     * @param dateName, the name of the date to search (e.g. start, maxfinish)
-     * @param block, the block where to seach
+     * @brief Fill the plan from its text with the PlanParser. The whole
+     * buffer is checked first, so a syntax error leaves the plan unchanged,
+     * then the items are added to the plan while the buffer is read.
+     * @param buffer, string representation of the plan.
      * @param loadTime, the time of plan loading.
+     * @param suffixe, the suffix appended to the activities identifiers.
+     * @param metadata, the function called with the identifier of each new
+     * activity to build its metadata.
+     */
+    void fillBuffer(const std::string& buffer, const devs::Time& loadTime,
+                    const std::string& suffixe,
+                    const ActivityMetadataFunction& metadata);
+
+    /**
+     * @brief Fill the predicates and the rules of the plan from a compiled
+     * plan.
+     * @param plan, the compiled plan.
+     */
+    void fillDefinitions(const PlanBinaryView& plan);
+    /**
+     * @brief Add a predicate of the plan or a predicate function of the
+     * knowledge base to a rule. A typed predicate function is added to the
+     * predicates of the plan, under its name, the first time a rule names
+     * it: its signature must not require parameters.
+     * @param rule, the rule to fill.
+     * @param id, the identifier of the rule.
+     * @param predicate, the name of the predicate.
+     * @throw utils::ArgError if the predicate is unknown or if a typed
+     * predicate function requires parameters.
+     */
+    void addRulePredicate(Rule& rule, const std::string& id,
+                          const std::string& predicate);
+    /**
+     * @brief Assign the time window of an activity from the dates of a
+     * temporal block. A date is ignored if its first member is false.
      */
-    DateResult getDate(const std::string& dateName,
-                       const utils::Block& block,
-                       const devs::Time& loadTime) const;
+    static void setTemporal(Activity& activity,
+                            const DateResult& start,
+                            const DateResult& mins,
+                            const DateResult& maxs,
+                            const DateResult& finish,
+                            const DateResult& minf,
+                            const DateResult& maxf);
 
     KnowledgeBase& mKb;
     Predicates mPredicates;
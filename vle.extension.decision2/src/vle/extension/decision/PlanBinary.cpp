@@ -0,0 +1,766 @@
+/*
+ * @file vle/extension/decision/PlanBinary.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <vle/extension/decision/PlanBinary.hpp>
+#include <vle/extension/decision/PrecedenceConstraint.hpp>
+#include <vle/devs/Time.hpp>
+#include <vle/utils/DateTime.hpp>
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/i18n.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cstring>
+
+namespace vle { namespace extension { namespace decision {
+
+namespace {
+
+typedef utils::Block UB;
+typedef utils::Block::Blocks UBB;
+typedef utils::Block::Strings UBS;
+
+const char PlanBinaryMagic[8] = { 'V', 'L', 'E', 'D', 'P', 'L', 'A', 'N' };
+const std::size_t PlanBinaryHeaderSize = 52;
+const std::size_t PlanBinaryRecordSize[PlanBinaryView::TableCount] = {
+    16, 16, 12, 4, 44, 120, 36, 1 };
+const std::size_t PlanBinaryDateSize = 20;
+
+boost::uint32_t get32(const char* data)
+{
+    const unsigned char* p = reinterpret_cast < const unsigned char* >(data);
+
+    return static_cast < boost::uint32_t >(p[0]) |
+        static_cast < boost::uint32_t >(p[1]) << 8 |
+        static_cast < boost::uint32_t >(p[2]) << 16 |
+        static_cast < boost::uint32_t >(p[3]) << 24;
+}
+
+boost::uint64_t get64(const char* data)
+{
+    return static_cast < boost::uint64_t >(get32(data)) |
+        static_cast < boost::uint64_t >(get32(data + 4)) << 32;
+}
+
+void put32(std::string& out, boost::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast < char >((value >> (8 * i)) & 0xff));
+    }
+}
+
+void put64(std::string& out, boost::uint64_t value)
+{
+    put32(out, static_cast < boost::uint32_t >(value & 0xffffffff));
+    put32(out, static_cast < boost::uint32_t >(value >> 32));
+}
+
+boost::uint64_t fromDouble(double value)
+{
+    boost::uint64_t result;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+double toDouble(boost::uint64_t value)
+{
+    double result;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+/**
+ * @brief A parameter of a predicate, sorted by name before it is written
+ * like PredicateParameters::sort.
+ */
+struct PlanBinaryParameter
+{
+    std::string name;
+    PlanBinaryView::ParameterType type;
+    std::string string;
+    double real;
+
+    bool operator<(const PlanBinaryParameter& other) const
+    {
+        return name < other.name;
+    }
+};
+
+/**
+ * @brief Resolve the blocks of a plan into the tables of a compiled plan.
+ */
+class PlanBinaryWriter
+{
+public:
+    void compile(const utils::Block& root)
+    {
+        UB::BlocksResult preds = root.blocks.equal_range("predicates");
+        for (UBB::const_iterator it = preds.first; it != preds.second; ++it) {
+            predicates(it->second.blocks.equal_range("predicate"));
+        }
+
+        UB::BlocksResult rules = root.blocks.equal_range("rules");
+        for (UBB::const_iterator it = rules.first; it != rules.second; ++it) {
+            this->rules(it->second.blocks.equal_range("rule"));
+        }
+
+        UB::BlocksResult acts = root.blocks.equal_range("activities");
+        for (UBB::const_iterator it = acts.first; it != acts.second; ++it) {
+            activities(it->second.blocks.equal_range("activity"));
+        }
+
+        UB::BlocksResult precs = root.blocks.equal_range("precedences");
+        for (UBB::const_iterator it = precs.first; it != precs.second; ++it) {
+            precedences(it->second.blocks.equal_range("precedence"));
+        }
+    }
+
+    void write(boost::uint64_t sourceSize, std::ostream& out) const
+    {
+        std::string header(PlanBinaryMagic, sizeof(PlanBinaryMagic));
+        put32(header, PlanBinaryVersion);
+        put64(header, sourceSize);
+
+        for (int i = 0; i < PlanBinaryView::TableCount; ++i) {
+            put32(header, size(static_cast < PlanBinaryView::Table >(i)));
+        }
+
+        out.write(header.data(), header.size());
+
+        for (int i = 0; i < PlanBinaryView::TableCount; ++i) {
+            out.write(mTables[i].data(), mTables[i].size());
+        }
+    }
+
+private:
+    boost::uint32_t size(PlanBinaryView::Table table) const
+    {
+        return static_cast < boost::uint32_t >(
+            mTables[table].size() / PlanBinaryRecordSize[table]);
+    }
+
+    void predicates(const UB::BlocksResult& preds)
+    {
+        std::string& out = mTables[PlanBinaryView::TablePredicates];
+
+        for (UBB::const_iterator it = preds.first; it != preds.second; ++it) {
+            const utils::Block& block = it->second;
+            std::vector < PlanBinaryParameter > params;
+
+            UB::BlocksResult parameters = block.blocks.equal_range("parameter");
+            if (parameters.first != parameters.second) {
+                const utils::Block& param = parameters.first->second;
+
+                for (UBS::const_iterator jt = param.strings.begin();
+                     jt != param.strings.end(); ++jt) {
+                    PlanBinaryParameter p;
+                    p.name = jt->first;
+                    p.type = PlanBinaryView::ParameterString;
+                    p.string = jt->second;
+                    p.real = 0.0;
+                    params.push_back(p);
+                }
+
+                for (UB::Reals::const_iterator jt = param.reals.begin();
+                     jt != param.reals.end(); ++jt) {
+                    PlanBinaryParameter p;
+                    p.name = jt->first;
+                    p.type = PlanBinaryView::ParameterReal;
+                    p.real = jt->second;
+                    params.push_back(p);
+                }
+
+                std::stable_sort(params.begin(), params.end());
+            }
+
+            put32(out, string(required(block, "id",
+                                       _("Decision: predicate needs id"))));
+            put32(out, optional(block, "type"));
+            put32(out, size(PlanBinaryView::TableParameters));
+            put32(out, static_cast < boost::uint32_t >(params.size()));
+
+            for (std::vector < PlanBinaryParameter >::const_iterator jt =
+                 params.begin(); jt != params.end(); ++jt) {
+                std::string& table = mTables[PlanBinaryView::TableParameters];
+
+                put32(table, string(jt->name));
+                put32(table, static_cast < boost::uint32_t >(jt->type));
+                put64(table, jt->type == PlanBinaryView::ParameterString ?
+                      string(jt->string) : fromDouble(jt->real));
+            }
+        }
+    }
+
+    void rules(const UB::BlocksResult& rules)
+    {
+        std::string& out = mTables[PlanBinaryView::TableRules];
+
+        for (UBB::const_iterator it = rules.first; it != rules.second; ++it) {
+            const utils::Block& block = it->second;
+
+            put32(out, string(required(block, "id",
+                                       _("Decision: rule needs id"))));
+            names(out, block.strings.equal_range("predicates"));
+        }
+    }
+
+    void activities(const UB::BlocksResult& acts)
+    {
+        std::string& out = mTables[PlanBinaryView::TableActivities];
+
+        for (UBB::const_iterator it = acts.first; it != acts.second; ++it) {
+            const utils::Block& block = it->second;
+            const std::string& id = required(block, "id",
+                                              _("Decision: activity needs id"));
+
+            mIds.insert(std::make_pair(id, size(
+                        PlanBinaryView::TableActivities)));
+
+            put32(out, string(id));
+            put32(out, optional(block, "ack"));
+            put32(out, optional(block, "output"));
+            put32(out, optional(block, "update"));
+            names(out, block.strings.equal_range("rules"));
+
+            UB::BlocksResult temporal = block.blocks.equal_range("temporal");
+            put32(out, size(PlanBinaryView::TableTemporals));
+            put32(out, static_cast < boost::uint32_t >(
+                    std::distance(temporal.first, temporal.second)));
+
+            for (UBB::const_iterator jt = temporal.first;
+                 jt != temporal.second; ++jt) {
+                std::string& table = mTables[PlanBinaryView::TableTemporals];
+                const char* dates[] = { "start", "minstart", "maxstart",
+                    "finish", "minfinish", "maxfinish" };
+
+                for (int i = 0; i < 6; ++i) {
+                    date(table, dates[i], jt->second);
+                }
+            }
+
+            UB::RealsResult speed = block.reals.equal_range("speed_ha_per_day");
+            if (speed.first != speed.second) {
+                put32(out, 1);
+                put64(out, fromDouble(speed.first->second));
+            } else {
+                put32(out, 0);
+                put64(out, fromDouble(0.0));
+            }
+        }
+    }
+
+    void precedences(const UB::BlocksResult& precs)
+    {
+        std::string& out = mTables[PlanBinaryView::TablePrecedences];
+
+        for (UBB::const_iterator it = precs.first; it != precs.second; ++it) {
+            const utils::Block& block = it->second;
+            PrecedenceConstraint::Type type;
+
+            UB::StringsResult str = block.strings.equal_range("type");
+            if (str.first == str.second) {
+                throw utils::ArgError(_("Decision: precedences type unknown"));
+            } else if (str.first->second == "SS") {
+                type = PrecedenceConstraint::SS;
+            } else if (str.first->second == "FS") {
+                type = PrecedenceConstraint::FS;
+            } else if (str.first->second == "FF") {
+                type = PrecedenceConstraint::FF;
+            } else {
+                throw utils::ArgError(fmt(
+                        _("Decision: precendence type `%1%' unknown")) %
+                    str.first->second);
+            }
+
+            UB::StringsResult first = block.strings.equal_range("first");
+            UB::StringsResult second = block.strings.equal_range("second");
+            const std::string& firstName = first.first != first.second ?
+                first.first->second : mEmpty;
+            const std::string& secondName = second.first != second.second ?
+                second.first->second : mEmpty;
+
+            put32(out, static_cast < boost::uint32_t >(type));
+            put32(out, find(firstName));
+            put32(out, find(secondName));
+            put32(out, string(firstName));
+            put32(out, string(secondName));
+            put64(out, fromDouble(real(block, "mintimelag", 0.0)));
+            put64(out, fromDouble(real(block, "maxtimelag", devs::infinity)));
+        }
+    }
+
+    /**
+     * @brief Resolve a date of a temporal block: the relative dates
+     * "+year-month-day" are split and the absolute dates are converted
+     * into julian days.
+     */
+    void date(std::string& out, const std::string& name,
+              const utils::Block& block)
+    {
+        UB::RealsResult dateReal = block.reals.equal_range(name);
+        UB::StringsResult dateString = block.strings.equal_range(name);
+        UB::RelativeRealsResult dateRelative =
+            block.relativeReals.equal_range(name);
+        bool hasRealDate = dateReal.first != dateReal.second;
+        bool hasStringDate = dateString.first != dateString.second;
+        bool hasRelativeDate = dateRelative.first != dateRelative.second;
+
+        if ((hasRealDate && hasStringDate) ||
+            (hasRealDate && hasRelativeDate) ||
+            (hasStringDate && hasRelativeDate)) {
+            throw utils::ArgError(fmt(_(
+                "Decision: date '%1%' should not be given twice ")) % name);
+        }
+
+        PlanBinaryView::DateType type = PlanBinaryView::DateNone;
+        int year = 0;
+        double value = 0.0;
+        boost::uint32_t monthday = PlanBinaryView::npos;
+
+        if (hasRealDate) {
+            type = PlanBinaryView::DateAbsolute;
+            value = dateReal.first->second;
+        } else if (hasStringDate and dateString.first->second[0] == '+') {
+            std::vector < std::string > explosedDate;
+            std::string relativeDate = dateString.first->second.substr(1);
+
+            boost::split(explosedDate, relativeDate, boost::is_any_of("-"));
+
+            if (explosedDate.size() != 3) {
+                throw utils::ArgError(fmt(_(
+                    "Decision: bad relative date '%1%'")) %
+                    dateString.first->second);
+            }
+
+            std::string md = "-" + explosedDate[1] + "-" + explosedDate[2];
+
+            type = PlanBinaryView::DateRelativeDate;
+            year = boost::lexical_cast < int >(explosedDate[0]);
+            value = utils::DateTime::dayOfYear(
+                utils::DateTime::toJulianDayNumber("1401" + md));
+            monthday = string(md);
+        } else if (hasStringDate) {
+            type = PlanBinaryView::DateAbsolute;
+            value = (int)utils::DateTime::toJulianDayNumber(
+                dateString.first->second);
+        } else if (hasRelativeDate) {
+            type = PlanBinaryView::DateRelative;
+            value = dateRelative.first->second;
+        }
+
+        put32(out, static_cast < boost::uint32_t >(type));
+        put32(out, static_cast < boost::uint32_t >(year));
+        put64(out, fromDouble(value));
+        put32(out, monthday);
+    }
+
+    /**
+     * @brief Append the values of a multi-valued key to the names table
+     * and write the first name and the number of names into out.
+     */
+    void names(std::string& out, const UB::StringsResult& values)
+    {
+        std::string& table = mTables[PlanBinaryView::TableNames];
+
+        put32(out, size(PlanBinaryView::TableNames));
+        put32(out, static_cast < boost::uint32_t >(
+                std::distance(values.first, values.second)));
+
+        for (UBS::const_iterator it = values.first; it != values.second;
+             ++it) {
+            put32(table, string(it->second));
+        }
+    }
+
+    static const std::string& required(const utils::Block& block,
+                                       const char* key, const char* error)
+    {
+        UB::StringsResult value = block.strings.equal_range(key);
+
+        if (value.first == value.second) {
+            throw utils::ArgError(error);
+        }
+
+        return value.first->second;
+    }
+
+    static double real(const utils::Block& block, const char* key,
+                       double defaultValue)
+    {
+        UB::RealsResult value = block.reals.equal_range(key);
+
+        return value.first != value.second ? value.first->second :
+            defaultValue;
+    }
+
+    boost::uint32_t optional(const utils::Block& block, const char* key)
+    {
+        UB::StringsResult value = block.strings.equal_range(key);
+
+        return value.first != value.second ? string(value.first->second) :
+            PlanBinaryView::npos;
+    }
+
+    boost::uint32_t find(const std::string& id) const
+    {
+        std::map < std::string, boost::uint32_t >::const_iterator it =
+            mIds.find(id);
+
+        return it == mIds.end() ? PlanBinaryView::npos : it->second;
+    }
+
+    boost::uint32_t string(const std::string& str)
+    {
+        std::string& pool = mTables[PlanBinaryView::TablePool];
+        std::map < std::string, boost::uint32_t >::iterator it =
+            mStrings.find(str);
+
+        if (it != mStrings.end()) {
+            return it->second;
+        }
+
+        boost::uint32_t offset = static_cast < boost::uint32_t >(pool.size());
+        pool.append(str.c_str(), str.size() + 1);
+        mStrings.insert(std::make_pair(str, offset));
+
+        return offset;
+    }
+
+    std::string mTables[PlanBinaryView::TableCount];
+    std::map < std::string, boost::uint32_t > mStrings;
+    std::map < std::string, boost::uint32_t > mIds; /**< First activity of
+                                                      each identifier. */
+    std::string mEmpty;
+};
+
+} // anonymous namespace
+
+PlanBinaryView::PlanBinaryView(const char* data, std::size_t size)
+    : mData(data), mSize(size)
+{
+    if (not isValid(data, size)) {
+        throw utils::ArgError(
+            _("Decision: not a compiled plan or bad version"));
+    }
+
+    boost::uint64_t offset = PlanBinaryHeaderSize;
+
+    for (int i = 0; i < TableCount; ++i) {
+        mSizes[i] = get32(data + 20 + 4 * i);
+        mOffsets[i] = static_cast < std::size_t >(offset);
+        offset += static_cast < boost::uint64_t >(mSizes[i]) *
+            PlanBinaryRecordSize[i];
+    }
+
+    if (offset != size or (mSizes[TablePool] != 0 and
+                           data[size - 1] != '\0')) {
+        throw utils::ArgError(_("Decision: truncated compiled plan"));
+    }
+}
+
+boost::uint64_t PlanBinaryView::sourceSize() const
+{
+    return get64(mData + 12);
+}
+
+PlanBinaryView::Predicate PlanBinaryView::predicate(boost::uint32_t i) const
+{
+    const char* p = record(TablePredicates, i);
+    Predicate result;
+
+    result.id = string(get32(p));
+    result.type = optional(get32(p + 4));
+    result.parameter = get32(p + 8);
+    result.parameters = get32(p + 12);
+    range(TableParameters, result.parameter, result.parameters);
+
+    return result;
+}
+
+PlanBinaryView::Parameter PlanBinaryView::parameter(boost::uint32_t i) const
+{
+    const char* p = record(TableParameters, i);
+    Parameter result;
+
+    result.name = string(get32(p));
+    result.type = static_cast < ParameterType >(get32(p + 4));
+    result.string = 0;
+    result.real = 0.0;
+
+    switch (result.type) {
+    case ParameterString:
+        result.string = string(static_cast < boost::uint32_t >(get64(p + 8)));
+        break;
+    case ParameterReal:
+        result.real = toDouble(get64(p + 8));
+        break;
+    default:
+        throw utils::ArgError(_("Decision: bad record in compiled plan"));
+    }
+
+    return result;
+}
+
+PlanBinaryView::Rule PlanBinaryView::rule(boost::uint32_t i) const
+{
+    const char* p = record(TableRules, i);
+    Rule result;
+
+    result.id = string(get32(p));
+    result.predicate = get32(p + 4);
+    result.predicates = get32(p + 8);
+    range(TableNames, result.predicate, result.predicates);
+
+    return result;
+}
+
+const char* PlanBinaryView::name(boost::uint32_t i) const
+{
+    return string(get32(record(TableNames, i)));
+}
+
+PlanBinaryView::Activity PlanBinaryView::activity(boost::uint32_t i) const
+{
+    const char* p = record(TableActivities, i);
+    Activity result;
+
+    result.id = string(get32(p));
+    result.ack = optional(get32(p + 4));
+    result.output = optional(get32(p + 8));
+    result.update = optional(get32(p + 12));
+    result.rule = get32(p + 16);
+    result.rules = get32(p + 20);
+    result.temporal = get32(p + 24);
+    result.temporals = get32(p + 28);
+    result.hasSpeed = get32(p + 32) != 0;
+    result.speed = toDouble(get64(p + 36));
+    range(TableNames, result.rule, result.rules);
+    range(TableTemporals, result.temporal, result.temporals);
+
+    return result;
+}
+
+PlanBinaryView::Temporal PlanBinaryView::temporal(boost::uint32_t i) const
+{
+    const char* p = record(TableTemporals, i);
+    Temporal result;
+
+    result.start = date(p);
+    result.minstart = date(p + PlanBinaryDateSize);
+    result.maxstart = date(p + 2 * PlanBinaryDateSize);
+    result.finish = date(p + 3 * PlanBinaryDateSize);
+    result.minfinish = date(p + 4 * PlanBinaryDateSize);
+    result.maxfinish = date(p + 5 * PlanBinaryDateSize);
+
+    return result;
+}
+
+PlanBinaryView::Precedence PlanBinaryView::precedence(boost::uint32_t i) const
+{
+    const char* p = record(TablePrecedences, i);
+    Precedence result;
+
+    result.type = get32(p);
+    result.first = get32(p + 4);
+    result.second = get32(p + 8);
+    result.firstName = string(get32(p + 12));
+    result.secondName = string(get32(p + 16));
+    result.mintimelag = toDouble(get64(p + 20));
+    result.maxtimelag = toDouble(get64(p + 28));
+
+    if (result.type > PrecedenceConstraint::FF or
+        (result.first != npos and result.first >= activities()) or
+        (result.second != npos and result.second >= activities())) {
+        throw utils::ArgError(_("Decision: bad record in compiled plan"));
+    }
+
+    return result;
+}
+
+bool PlanBinaryView::isValid(const char* data, std::size_t size)
+{
+    return size >= PlanBinaryHeaderSize and
+        std::memcmp(data, PlanBinaryMagic, sizeof(PlanBinaryMagic)) == 0 and
+        get32(data + 8) == PlanBinaryVersion;
+}
+
+const char* PlanBinaryView::record(Table table, boost::uint32_t i) const
+{
+    if (i >= mSizes[table]) {
+        throw utils::ArgError(_("Decision: bad record in compiled plan"));
+    }
+
+    return mData + mOffsets[table] + i * PlanBinaryRecordSize[table];
+}
+
+void PlanBinaryView::range(Table table, boost::uint32_t first,
+                           boost::uint32_t size) const
+{
+    if (first > mSizes[table] or size > mSizes[table] - first) {
+        throw utils::ArgError(_("Decision: bad record in compiled plan"));
+    }
+}
+
+PlanBinaryView::Date PlanBinaryView::date(const char* p) const
+{
+    Date result;
+
+    result.type = static_cast < DateType >(get32(p));
+    result.year = static_cast < int >(get32(p + 4));
+    result.value = toDouble(get64(p + 8));
+    result.monthday = optional(get32(p + 16));
+
+    if (result.type > DateRelativeDate or
+        (result.type == DateRelativeDate and not result.monthday)) {
+        throw utils::ArgError(_("Decision: bad record in compiled plan"));
+    }
+
+    return result;
+}
+
+const char* PlanBinaryView::string(boost::uint32_t offset) const
+{
+    if (offset >= mSizes[TablePool]) {
+        throw utils::ArgError(_("Decision: bad string in compiled plan"));
+    }
+
+    return mData + mOffsets[TablePool] + offset;
+}
+
+const char* PlanBinaryView::optional(boost::uint32_t offset) const
+{
+    return offset == npos ? 0 : string(offset);
+}
+
+PlanBinaryFile::PlanBinaryFile(const std::string& source)
+{
+    if (map(source)) {
+        return;
+    }
+
+    std::ifstream in(source.c_str());
+    if (not in.is_open()) {
+        throw utils::ArgError(fmt(_("Decision: fail to open plan `%1%'")) %
+                              source);
+    }
+
+    utils::Parser parser(in);
+    std::ostringstream out;
+    writePlanBinary(parser.root(), 0, out);
+
+    mBuffer = out.str();
+    mView.reset(new PlanBinaryView(mBuffer.data(), mBuffer.size()));
+}
+
+bool PlanBinaryFile::map(const std::string& source)
+{
+    namespace fs = boost::filesystem;
+
+    std::string binary = planBinaryPath(source);
+    boost::system::error_code ec;
+
+    if (binary == source or not fs::exists(binary, ec) or
+        fs::file_size(binary, ec) == 0 or ec or
+        fs::last_write_time(binary, ec) < fs::last_write_time(source, ec) or
+        ec) {
+        return false;
+    }
+
+    try {
+        mFile.open(binary);
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    if (PlanBinaryView::isValid(mFile.data(), mFile.size())) {
+        mView.reset(new PlanBinaryView(mFile.data(), mFile.size()));
+
+        if (mView->sourceSize() == fs::file_size(source, ec) and not ec) {
+            return true;
+        }
+
+        mView.reset();
+    }
+
+    mFile.close();
+
+    return false;
+}
+
+void writePlanBinary(const utils::Block& root, boost::uint64_t sourceSize,
+                     std::ostream& out)
+{
+    PlanBinaryWriter writer;
+
+    writer.compile(root);
+    writer.write(sourceSize, out);
+}
+
+std::string planBinaryPath(const std::string& source)
+{
+    boost::filesystem::path path(source);
+
+    return path.replace_extension(".bin").string();
+}
+
+void compilePlanFile(const std::string& source,
+                     const std::string& destination)
+{
+    std::ifstream in(source.c_str());
+    if (not in.is_open()) {
+        throw utils::ArgError(fmt(_("Decision: fail to open plan `%1%'")) %
+                              source);
+    }
+
+    utils::Parser parser(in);
+    std::ostringstream buffer;
+    writePlanBinary(parser.root(), boost::filesystem::file_size(source),
+                    buffer);
+
+    std::ofstream out(destination.c_str(),
+                      std::ios_base::out | std::ios_base::binary |
+                      std::ios_base::trunc);
+    if (not out.is_open()) {
+        throw utils::ArgError(fmt(_("Decision: fail to write plan `%1%'")) %
+                              destination);
+    }
+
+    out << buffer.str();
+
+    if (not out.good()) {
+        throw utils::ArgError(fmt(_("Decision: fail to write plan `%1%'")) %
+                              destination);
+    }
+}
+
+}}} // namespace vle model decision
@@ -0,0 +1,282 @@
+/*
+ * @file vle/extension/decision/PlanBinary.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef VLE_EXT_DECISION_PLANBINARY_HPP
+#define VLE_EXT_DECISION_PLANBINARY_HPP 1
+
+#include <vle/utils/Parser.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
+#include <ostream>
+#include <string>
+#include <cstddef>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief The version of the binary format of the compiled plans. Increment
+ * it when the layout changes, old files are then ignored.
+ */
+const boost::uint32_t PlanBinaryVersion = 2;
+
+/**
+ * @brief PlanBinaryView reads a compiled plan directly from a memory
+ * buffer (a mapped file or a plan compiled in memory) without any
+ * allocation.
+ *
+ * A compiled plan stores the plan resolved into tables of fixed-size
+ * records: the references between records are indices and the strings are
+ * offsets in a deduplicated pool of null-terminated strings. All integers
+ * are stored in little-endian order. The file is composed of:
+ * - a header of 52 bytes: the magic "VLEDPLAN", the version, the size of
+ *   the text source and the size of the eight tables below,
+ * - the predicates (16 bytes): id, type, first parameter, parameters,
+ * - the parameters (16 bytes), sorted by name for each predicate: name,
+ *   type (string or real), value (offset or IEEE 754 double),
+ * - the rules (12 bytes): id, first name, number of predicates,
+ * - the names (4 bytes): the predicates of the rules and the rules of the
+ *   activities,
+ * - the activities (44 bytes): id, acknowledge, output and update
+ *   functions, first name, number of rules, first temporal, number of
+ *   temporals, a flag and the speed,
+ * - the temporals (120 bytes): the six dates start, minstart, maxstart,
+ *   finish, minfinish and maxfinish, each with a type, a number of years,
+ *   a value and the "-month-day" part of the relative dates,
+ * - the precedences (36 bytes): type, index of the first and second
+ *   activities, their identifiers, minimum and maximum time lags,
+ * - the string pool.
+ */
+class PlanBinaryView
+{
+public:
+    /**
+     * @brief An absent string or activity.
+     */
+    static const boost::uint32_t npos = 0xffffffff;
+
+    /**
+     * @brief The tables of a compiled plan, in the order of the file.
+     */
+    enum Table {
+        TablePredicates = 0,
+        TableParameters,
+        TableRules,
+        TableNames,
+        TableActivities,
+        TableTemporals,
+        TablePrecedences,
+        TablePool, /**< Its size is in bytes. */
+        TableCount
+    };
+
+    enum ParameterType {
+        ParameterString = 0,
+        ParameterReal = 1
+    };
+
+    enum DateType {
+        DateNone = 0, /**< No date. */
+        DateAbsolute = 1, /**< value. */
+        DateRelative = 2, /**< loadTime + value. */
+        DateRelativeDate = 3 /**< "+year-month-day", value is the day of
+                               year of "1401-month-day". */
+    };
+
+    struct Predicate
+    {
+        const char* id;
+        const char* type; /**< Null if the predicate has no type. */
+        boost::uint32_t parameter;
+        boost::uint32_t parameters;
+    };
+
+    struct Parameter
+    {
+        const char* name;
+        ParameterType type;
+        const char* string; /**< The value if type is ParameterString. */
+        double real; /**< The value otherwise. */
+    };
+
+    struct Rule
+    {
+        const char* id;
+        boost::uint32_t predicate; /**< First name of the predicates. */
+        boost::uint32_t predicates;
+    };
+
+    struct Activity
+    {
+        const char* id;
+        const char* ack; /**< Null if the activity has no function. */
+        const char* output; /**< Null if the activity has no function. */
+        const char* update; /**< Null if the activity has no function. */
+        boost::uint32_t rule; /**< First name of the rules. */
+        boost::uint32_t rules;
+        boost::uint32_t temporal;
+        boost::uint32_t temporals;
+        bool hasSpeed;
+        double speed;
+    };
+
+    struct Date
+    {
+        DateType type;
+        int year; /**< Years to add to the load time if DateRelativeDate. */
+        double value;
+        const char* monthday; /**< "-month-day" if DateRelativeDate. */
+    };
+
+    struct Temporal
+    {
+        Date start, minstart, maxstart, finish, minfinish, maxfinish;
+    };
+
+    struct Precedence
+    {
+        boost::uint32_t type; /**< A PrecedenceConstraint::Type. */
+        boost::uint32_t first; /**< Index of the activity or npos. */
+        boost::uint32_t second; /**< Index of the activity or npos. */
+        const char* firstName;
+        const char* secondName;
+        double mintimelag;
+        double maxtimelag;
+    };
+
+    /**
+     * @brief Check the header of the buffer.
+     * @param data, the beginning of the compiled plan.
+     * @param size, the size of the buffer.
+     * @throw utils::ArgError if the buffer is not a valid compiled plan or
+     * was produced by another version.
+     */
+    PlanBinaryView(const char* data, std::size_t size);
+
+    boost::uint64_t sourceSize() const;
+    boost::uint32_t predicates() const { return mSizes[TablePredicates]; }
+    boost::uint32_t rules() const { return mSizes[TableRules]; }
+    boost::uint32_t activities() const { return mSizes[TableActivities]; }
+    boost::uint32_t precedences() const { return mSizes[TablePrecedences]; }
+
+    /**
+     * @brief Read a record.
+     * @throw utils::ArgError if the index or the record is out of bounds.
+     */
+    Predicate predicate(boost::uint32_t i) const;
+    Parameter parameter(boost::uint32_t i) const;
+    Rule rule(boost::uint32_t i) const;
+    const char* name(boost::uint32_t i) const;
+    Activity activity(boost::uint32_t i) const;
+    Temporal temporal(boost::uint32_t i) const;
+    Precedence precedence(boost::uint32_t i) const;
+
+    /**
+     * @brief Check if a buffer starts with the header of a compiled plan of
+     * the current version.
+     */
+    static bool isValid(const char* data, std::size_t size);
+
+private:
+    const char* record(Table table, boost::uint32_t i) const;
+    void range(Table table, boost::uint32_t first,
+               boost::uint32_t size) const;
+    Date date(const char* p) const;
+    const char* string(boost::uint32_t offset) const;
+    const char* optional(boost::uint32_t offset) const;
+
+    const char* mData;
+    std::size_t mSize;
+    boost::uint32_t mSizes[TableCount];
+    std::size_t mOffsets[TableCount];
+};
+
+/**
+ * @brief PlanBinaryFile gives the compiled form of a plan file. If a
+ * compiled plan of the current version, newer than the text plan and built
+ * from a source of the same size exists next to it, it is mapped into
+ * memory. Otherwise the text is parsed and compiled into memory.
+ * @code
+ * PlanBinaryFile itk("ITK-BH.txt");
+ * PlanPrototype prototype(kb, itk.view());
+ * @endcode
+ */
+class PlanBinaryFile : boost::noncopyable
+{
+public:
+    /**
+     * @brief Open a plan.
+     * @param source, the path of the text plan.
+     * @throw utils::ArgError if the plan can not be read.
+     */
+    explicit PlanBinaryFile(const std::string& source);
+
+    /**
+     * @brief Check if the compiled plan was used.
+     */
+    bool isMapped() const { return mFile.is_open(); }
+
+    const PlanBinaryView& view() const { return *mView; }
+
+private:
+    bool map(const std::string& source);
+
+    boost::iostreams::mapped_file_source mFile;
+    std::string mBuffer;
+    boost::scoped_ptr < PlanBinaryView > mView;
+};
+
+/**
+ * @brief Write the compiled form of the plan parsed into root.
+ * @param root, the root block produced by the utils::Parser.
+ * @param sourceSize, the size of the text source, stored in the header.
+ * @param out, the output stream, opened in binary mode.
+ * @throw utils::ArgError if the plan is not valid.
+ */
+void writePlanBinary(const utils::Block& root, boost::uint64_t sourceSize,
+                     std::ostream& out);
+
+/**
+ * @brief Get the path of the compiled plan of a text plan: the extension of
+ * the source is replaced by ".bin".
+ */
+std::string planBinaryPath(const std::string& source);
+
+/**
+ * @brief Parse the text plan source and write its compiled form in the
+ * file destination.
+ * @throw utils::ArgError if the source can not be read or parsed or if the
+ * destination can not be written.
+ */
+void compilePlanFile(const std::string& source,
+                     const std::string& destination);
+
+}}} // namespace vle model decision
+
+#endif
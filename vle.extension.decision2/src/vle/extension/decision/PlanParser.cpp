@@ -0,0 +1,249 @@
+/*
+ * @file vle/extension/decision/PlanParser.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <vle/extension/decision/PlanParser.hpp>
+#include <vle/extension/decision/Number.hpp>
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/i18n.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace vle { namespace extension { namespace decision {
+
+namespace {
+
+inline bool isSpace(char c)
+{
+    return c == ' ' or c == '\t' or c == '\n' or c == '\r' or c == '\f' or
+        c == '\v';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' and c <= '9';
+}
+
+inline bool isAlpha(char c)
+{
+    return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or c == '_';
+}
+
+inline bool isIdentifier(char c)
+{
+    return isAlpha(c) or isDigit(c) or c == '-';
+}
+
+/**
+ * @brief Keep the names of the blocks at the top level of the buffer.
+ */
+class SectionsHandler : public PlanParser::Handler
+{
+public:
+    SectionsHandler()
+        : depth(0)
+    {}
+
+    virtual ~SectionsHandler() {}
+
+    virtual void beginBlock(const PlanParser::Token& name)
+    {
+        if (depth++ == 0) {
+            names.push_back(name);
+        }
+    }
+
+    virtual void endBlock() { --depth; }
+    virtual void string(const PlanParser::Token&, const PlanParser::Token&) {}
+    virtual void real(const PlanParser::Token&, double) {}
+    virtual void relativeReal(const PlanParser::Token&, double) {}
+
+    std::vector < PlanParser::Token > names;
+    int depth;
+};
+
+} // anonymous namespace
+
+bool PlanParser::Token::operator==(const char* str) const
+{
+    return std::strlen(str) == size and std::memcmp(begin, str, size) == 0;
+}
+
+void PlanParser::parse(Handler& handler)
+{
+    mPos = mBegin;
+    block(handler);
+
+    if (mPos != mEnd) {
+        error(_("unexpected `}'"));
+    }
+}
+
+std::vector < PlanParser::Token > PlanParser::sections()
+{
+    SectionsHandler handler;
+    parse(handler);
+
+    return handler.names;
+}
+
+void PlanParser::block(Handler& handler)
+{
+    for (;;) {
+        space();
+
+        if (mPos == mEnd or *mPos == '}') {
+            return;
+        }
+
+        Token name = identifier();
+        space();
+
+        if (mPos == mEnd) {
+            error(_("`=' or `{' expected"));
+        }
+
+        if (*mPos == '{') {
+            ++mPos;
+            handler.beginBlock(name);
+            block(handler);
+
+            if (mPos == mEnd) {
+                error(_("block not closed"));
+            }
+
+            ++mPos;
+            handler.endBlock();
+        } else if (*mPos == '=') {
+            ++mPos;
+            values(handler, name);
+        } else {
+            error(_("`=' or `{' expected"));
+        }
+    }
+}
+
+void PlanParser::values(Handler& handler, const Token& key)
+{
+    for (;;) {
+        space();
+
+        if (mPos == mEnd) {
+            error(_("value expected"));
+        }
+
+        if (*mPos == '"') {
+            const char* begin = ++mPos;
+            mPos = std::find(mPos, mEnd, '"');
+            if (mPos == mEnd) {
+                error(_("string not closed"));
+            }
+            handler.string(key, Token(begin, mPos - begin));
+            ++mPos;
+        } else if (*mPos == '+') {
+            ++mPos;
+            handler.relativeReal(key, number());
+        } else if (isDigit(*mPos) or *mPos == '-' or *mPos == '.') {
+            handler.real(key, number());
+        } else if (isAlpha(*mPos)) {
+            handler.string(key, identifier());
+        } else {
+            error(_("value expected"));
+        }
+
+        space();
+
+        if (mPos != mEnd and *mPos == ',') {
+            ++mPos;
+        } else if (mPos != mEnd and *mPos == ';') {
+            ++mPos;
+            return;
+        } else {
+            error(_("`,' or `;' expected"));
+        }
+    }
+}
+
+void PlanParser::space()
+{
+    while (mPos != mEnd) {
+        if (isSpace(*mPos)) {
+            ++mPos;
+        } else if (*mPos == '#') {
+            mPos = std::find(mPos, mEnd, '\n');
+        } else {
+            return;
+        }
+    }
+}
+
+PlanParser::Token PlanParser::identifier()
+{
+    if (mPos == mEnd or not isAlpha(*mPos)) {
+        error(_("identifier expected"));
+    }
+
+    const char* begin = mPos;
+    while (mPos != mEnd and isIdentifier(*mPos)) {
+        ++mPos;
+    }
+
+    return Token(begin, mPos - begin);
+}
+
+double PlanParser::number()
+{
+    double result;
+    const char* end = parseReal(mPos, mEnd, &result);
+
+    if (not end) {
+        error(_("real expected"));
+    }
+
+    mPos = end;
+    return result;
+}
+
+void PlanParser::error(const std::string& message) const
+{
+    int line = 1;
+    int column = 1;
+
+    for (const char* it = mBegin; it != mPos and it != mEnd; ++it) {
+        if (*it == '\n') {
+            ++line;
+            column = 1;
+        } else {
+            ++column;
+        }
+    }
+
+    throw utils::ArgError(fmt(_("Decision: plan parser error at %1%:%2%: %3%"))
+                          % line % column % message);
+}
+
+}}} // namespace vle model decision
@@ -0,0 +1,128 @@
+/*
+ * @file vle/extension/decision/PlanParser.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef VLE_EXT_DECISION_PLANPARSER_HPP
+#define VLE_EXT_DECISION_PLANPARSER_HPP 1
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief PlanParser is a single pass parser of the plan language read from
+ * a memory buffer. It accepts the grammar of the utils::Parser:
+ * @code
+ * # comment
+ * name {
+ *     key = "string", identifier, 1.5, +10;
+ *     name { ... }
+ * }
+ * @endcode
+ * Instead of building a tree, the parser calls a Handler for each block and
+ * each value. Keys and strings are given as tokens pointing into the
+ * buffer: nothing is allocated unless the handler copies them. Numbers are
+ * read with parseReal, in the C locale.
+ */
+class PlanParser
+{
+public:
+    /**
+     * @brief A part of the buffer.
+     */
+    struct Token
+    {
+        Token()
+            : begin(0), size(0)
+        {}
+
+        Token(const char* begin, std::size_t size)
+            : begin(begin), size(size)
+        {}
+
+        std::string str() const { return std::string(begin, size); }
+
+        bool operator==(const char* str) const;
+
+        const char* begin;
+        std::size_t size;
+    };
+
+    /**
+     * @brief Receives the elements of the buffer in the order of the file.
+     */
+    class Handler
+    {
+    public:
+        virtual ~Handler() {}
+
+        virtual void beginBlock(const Token& name) = 0;
+        virtual void endBlock() = 0;
+        virtual void string(const Token& key, const Token& value) = 0;
+        virtual void real(const Token& key, double value) = 0;
+        virtual void relativeReal(const Token& key, double value) = 0;
+    };
+
+    /**
+     * @brief Build a parser for the buffer [begin, end).
+     */
+    PlanParser(const char* begin, const char* end)
+        : mBegin(begin), mEnd(end), mPos(begin)
+    {}
+
+    /**
+     * @brief Parse the buffer and send its content to the handler.
+     * @throw utils::ArgError with the line and the column of the error.
+     */
+    void parse(Handler& handler);
+
+    /**
+     * @brief Check the whole buffer and get the names of the blocks at the
+     * top level of the buffer. Nothing is sent to a handler, so it can be
+     * called before a parse which changes the data of the caller.
+     * @throw utils::ArgError with the line and the column of the error.
+     */
+    std::vector < Token > sections();
+
+private:
+    void block(Handler& handler);
+    void values(Handler& handler, const Token& key);
+    void space();
+    Token identifier();
+    double number();
+    void error(const std::string& message) const;
+
+    const char* mBegin;
+    const char* mEnd;
+    const char* mPos;
+};
+
+}}} // namespace vle model decision
+
+#endif
@@ -0,0 +1,325 @@
+/*
+ * @file vle/extension/decision/PlanPrototype.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <vle/extension/decision/PlanPrototype.hpp>
+#include <vle/extension/decision/KnowledgeBase.hpp>
+#include <vle/utils/i18n.hpp>
+#include <vle/utils/DateTime.hpp>
+#include <cstdio>
+#include <sstream>
+
+namespace vle { namespace extension { namespace decision {
+
+PlanPrototype::PlanPrototype(KnowledgeBase& kb, const std::string& buffer)
+    : mPlan(kb.plan())
+{
+    try {
+        std::istringstream in(buffer);
+        utils::Parser parser(in);
+        compile(parser.root());
+    } catch (const std::exception& e) {
+        throw utils::ArgError(fmt(_("Decision plan error in %1%")) % e.what());
+    }
+}
+
+PlanPrototype::PlanPrototype(KnowledgeBase& kb, std::istream& stream)
+    : mPlan(kb.plan())
+{
+    try {
+        utils::Parser parser(stream);
+        compile(parser.root());
+    } catch (const std::exception& e) {
+        throw utils::ArgError(fmt(_("Decision plan error: %1%")) % e.what());
+    }
+}
+
+PlanPrototype::PlanPrototype(KnowledgeBase& kb, const utils::Block& root)
+    : mPlan(kb.plan())
+{
+    try {
+        compile(root);
+    } catch (const std::exception& e) {
+        throw utils::ArgError(fmt(_("Decision plan error: %1%")) % e.what());
+    }
+}
+
+PlanPrototype::PlanPrototype(KnowledgeBase& kb, const PlanBinaryView& plan)
+    : mPlan(kb.plan())
+{
+    try {
+        compile(plan);
+    } catch (const std::exception& e) {
+        throw utils::ArgError(fmt(_("Decision plan error: %1%")) % e.what());
+    }
+}
+
+PlanPrototype::PlanPrototype(Plan& plan, const PlanBinaryView& view)
+    : mPlan(plan)
+{
+    compile(view);
+}
+
+void PlanPrototype::instantiate(const devs::Time& loadTime,
+                                const std::string& suffixe,
+                                const ActivityMetadataFunction& metadata) const
+{
+    Activities& activities = mPlan.activities();
+    const LoadTime load(loadTime);
+    mInstances.clear();
+    mInstances.reserve(mIds.size());
+    activities.reserve(mIds.size());
+
+    for (size_type i = 0; i < mIds.size(); ++i) {
+        mName.assign(mIds[i]);
+        mName.append(suffixe);
+        Activities::iterator inserted = activities.emplace(mName,
+                                                           mActivities[i]);
+        Activity& act = inserted->second;
+
+        if (metadata) {
+            act.setMetadata(metadata(mIds[i]));
+        }
+
+        for (std::vector < Temporal >::const_iterator it =
+             mTemporals[i].begin(); it != mTemporals[i].end(); ++it) {
+            Plan::setTemporal(act,
+                              evaluate(it->start, load),
+                              evaluate(it->minstart, load),
+                              evaluate(it->maxstart, load),
+                              evaluate(it->finish, load),
+                              evaluate(it->minfinish, load),
+                              evaluate(it->maxfinish, load));
+        }
+
+        mInstances.push_back(inserted);
+    }
+
+    for (std::vector < Precedence >::const_iterator it = mPrecedences.begin();
+         it != mPrecedences.end(); ++it) {
+        Activities::iterator first = it->first != npos ?
+            mInstances[it->first] : find(it->firstName, suffixe);
+        Activities::iterator second = it->second != npos ?
+            mInstances[it->second] : find(it->secondName, suffixe);
+
+        activities.addPrecedenceConstraint(
+            PrecedenceConstraint(first, second, it->type, it->mintimelag,
+                                 it->maxtimelag));
+    }
+}
+
+Activities::iterator PlanPrototype::find(const std::string& id,
+                                         const std::string& suffixe) const
+{
+    mName.assign(id);
+    mName.append(suffixe);
+    return mPlan.activities().get(mName);
+}
+
+void PlanPrototype::compile(const utils::Block& root)
+{
+    std::ostringstream out;
+    writePlanBinary(root, 0, out);
+
+    const std::string buffer(out.str());
+    compile(PlanBinaryView(buffer.data(), buffer.size()));
+}
+
+void PlanPrototype::compile(const PlanBinaryView& plan)
+{
+    mPlan.fillDefinitions(plan);
+
+    mIds.reserve(plan.activities());
+    mActivities.reserve(plan.activities());
+    mTemporals.reserve(plan.activities());
+
+    for (boost::uint32_t i = 0; i < plan.activities(); ++i) {
+        PlanBinaryView::Activity block = plan.activity(i);
+
+        mIds.push_back(block.id);
+        mActivities.push_back(Activity());
+        mTemporals.push_back(std::vector < Temporal >());
+        Activity& act = mActivities.back();
+
+        for (boost::uint32_t j = 0; j < block.rules; ++j) {
+            act.addRule(mPlan.mRules.lookup(plan.name(block.rule + j)));
+        }
+
+        if (block.ack) {
+            act.addAcknowledgeFunction(&mPlan.mKb.acknowledgeFunctions().get(
+                        block.ack)->second);
+        }
+
+        if (block.output) {
+            act.addOutputFunction(&mPlan.mKb.outputFunctions().get(
+                        block.output)->second);
+        }
+
+        if (block.update) {
+            act.addUpdateFunction(&mPlan.mKb.updateFunctions().get(
+                        block.update)->second);
+        }
+
+        for (boost::uint32_t j = 0; j < block.temporals; ++j) {
+            PlanBinaryView::Temporal temporal =
+                plan.temporal(block.temporal + j);
+            Temporal tmp;
+            tmp.start = compileDate(temporal.start);
+            tmp.minstart = compileDate(temporal.minstart);
+            tmp.maxstart = compileDate(temporal.maxstart);
+            tmp.finish = compileDate(temporal.finish);
+            tmp.minfinish = compileDate(temporal.minfinish);
+            tmp.maxfinish = compileDate(temporal.maxfinish);
+            mTemporals.back().push_back(tmp);
+        }
+
+        if (block.hasSpeed) {
+            act.setSpeed(block.speed);
+        }
+    }
+
+    mPrecedences.reserve(plan.precedences());
+
+    for (boost::uint32_t i = 0; i < plan.precedences(); ++i) {
+        PlanBinaryView::Precedence block = plan.precedence(i);
+
+        Precedence pc;
+        pc.type = static_cast < PrecedenceConstraint::Type >(block.type);
+        pc.first = block.first == PlanBinaryView::npos ? npos : block.first;
+        pc.second = block.second == PlanBinaryView::npos ? npos :
+            block.second;
+        pc.firstName = block.firstName;
+        pc.secondName = block.secondName;
+        pc.mintimelag = block.mintimelag;
+        pc.maxtimelag = block.maxtimelag;
+        mPrecedences.push_back(pc);
+    }
+}
+
+/**
+ * @brief Check a month and a day of the month which exist every year, as
+ * the writer of the compiled plan checks them in the year 1401.
+ */
+static bool isMonthDay(int month, int day)
+{
+    static const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30,
+        31 };
+
+    return 1 <= month and month <= 12 and 1 <= day and day <= days[month - 1];
+}
+
+/**
+ * @brief Get the julian day number of a date of the gregorian calendar,
+ * computed as boost::gregorian does without checking the date again.
+ */
+static long julianDayNumber(int year, int month, int day)
+{
+    const int a = (14 - month) / 12;
+    const long y = year + 4800 - a;
+    const long m = month + 12 * a - 3;
+
+    return day + (153 * m + 2) / 5 + 365 * y + y / 4 - y / 100 + y / 400 -
+        32045;
+}
+
+/**
+ * @brief Get the year of a julian day number, the inverse of
+ * julianDayNumber.
+ */
+static int yearOfJulianDayNumber(long day)
+{
+    const long a = day + 32044;
+    const long b = (4 * a + 3) / 146097;
+    const long c = a - (146097 * b) / 4;
+    const long d = (4 * c + 3) / 1461;
+    const long e = c - (1461 * d) / 4;
+    const long m = (5 * e + 2) / 153;
+
+    return 100 * b + d - 4800 + m / 10;
+}
+
+PlanPrototype::Date PlanPrototype::compileDate(
+    const PlanBinaryView::Date& date)
+{
+    Date result;
+
+    switch (date.type) {
+    case PlanBinaryView::DateAbsolute:
+        result.type = Date::Absolute;
+        break;
+    case PlanBinaryView::DateRelative:
+        result.type = Date::Relative;
+        break;
+    case PlanBinaryView::DateRelativeDate:
+        result.type = Date::RelativeDate;
+        result.year = date.year;
+        if (std::sscanf(date.monthday, "-%d-%d", &result.month,
+                        &result.day) != 2 or
+            not isMonthDay(result.month, result.day)) {
+            throw utils::ArgError(fmt(_("Decision: bad relative date `%1%'"))
+                                  % date.monthday);
+        }
+        break;
+    case PlanBinaryView::DateNone:
+    default:
+        return result;
+    }
+
+    result.value = date.value;
+
+    return result;
+}
+
+PlanPrototype::LoadTime::LoadTime(const devs::Time& time)
+    : time(time), validYear(utils::DateTime::isValidYear(time)),
+    year(validYear ? yearOfJulianDayNumber((long)time) : 0)
+{
+}
+
+Plan::DateResult PlanPrototype::evaluate(const Date& date,
+                                         const LoadTime& loadTime)
+{
+    switch (date.type) {
+    case Date::Absolute:
+        return Plan::DateResult(true, date.value);
+    case Date::Relative:
+        return Plan::DateResult(true, loadTime.time + date.value);
+    case Date::RelativeDate:
+        if (loadTime.validYear) {
+            return Plan::DateResult(true, devs::Time(
+                    julianDayNumber(date.year + loadTime.year, date.month,
+                                    date.day)));
+        } else {
+            return Plan::DateResult(true, date.value + 365 * date.year);
+        }
+    case Date::None:
+    default:
+        return Plan::DateResult(false, devs::infinity);
+    }
+}
+
+}}} // namespace vle model decision
@@ -0,0 +1,216 @@
+/*
+ * @file vle/extension/decision/PlanPrototype.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef VLE_EXT_DECISION_PLANPROTOTYPE_HPP
+#define VLE_EXT_DECISION_PLANPROTOTYPE_HPP 1
+
+#include <vle/extension/decision/Plan.hpp>
+#include <vle/extension/decision/ActivityMetadata.hpp>
+#include <vle/extension/decision/PlanBinary.hpp>
+#include <vle/extension/decision/PrecedenceConstraint.hpp>
+#include <vle/utils/Parser.hpp>
+#include <vle/devs/Time.hpp>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace vle { namespace extension { namespace decision {
+
+class KnowledgeBase;
+
+/**
+ * @brief PlanPrototype is a plan parsed once and instantiated many times
+ * with different suffixes and load times.
+ *
+ * The predicates and the rules are added to the plan of the knowledge base
+ * when the prototype is built. Activities are stored as templates with
+ * their rules and functions resolved, their temporal dates are kept
+ * symbolic (absolute, relative to the load time or relative "+y-m-d") and
+ * precedence constraints reference activities by index. The instantiate
+ * function only copies the templates and computes the dates.
+ * @code
+ * PlanPrototype itk(kb, stream);
+ * itk.instantiate(time, "_0_p1");
+ * itk.instantiate(time, "_0_p2");
+ * @endcode
+ */
+class PlanPrototype
+{
+public:
+    typedef std::vector < Activity >::size_type size_type;
+
+    /**
+     * @brief Build a prototype from a string.
+     * @param kb, the knowledge base which receives the plan.
+     * @param buffer, string representation of the plan.
+     * @throw utils::ArgError if the plan is not valid.
+     */
+    PlanPrototype(KnowledgeBase& kb, const std::string& buffer);
+
+    /**
+     * @brief Build a prototype from a stream.
+     * @param kb, the knowledge base which receives the plan.
+     * @param stream, stream containing the representation of the plan.
+     * @throw utils::ArgError if the plan is not valid.
+     */
+    PlanPrototype(KnowledgeBase& kb, std::istream& stream);
+
+    /**
+     * @brief Build a prototype from a parsed plan.
+     * @param kb, the knowledge base which receives the plan.
+     * @param root, the root block produced by the utils::Parser.
+     * @throw utils::ArgError if the plan is not valid.
+     */
+    PlanPrototype(KnowledgeBase& kb, const utils::Block& root);
+
+    /**
+     * @brief Build a prototype from a compiled plan, for instance the view
+     * of a PlanBinaryFile. The view is only read by the constructor.
+     * @param kb, the knowledge base which receives the plan.
+     * @param plan, the compiled plan.
+     * @throw utils::ArgError if the plan is not valid.
+     */
+    PlanPrototype(KnowledgeBase& kb, const PlanBinaryView& plan);
+
+    /**
+     * @brief Add the activities and the precedence constraints of the
+     * prototype to the plan of the knowledge base. It is equivalent to a
+     * call to Plan::fill with the text of the prototype.
+     * @param loadTime, the time of plan loading.
+     * @param suffixe, the suffix appended to the activities identifiers.
+     * @param metadata, the function called with the identifier of each new
+     * activity to build its metadata.
+     * @throw utils::ArgError if an activity already exists.
+     */
+    void instantiate(const devs::Time& loadTime,
+                     const std::string& suffixe,
+                     const ActivityMetadataFunction& metadata =
+                     ActivityMetadataFunction()) const;
+
+    /**
+     * @brief Get the number of activities of the prototype.
+     * @return The number of activities.
+     */
+    size_type size() const { return mIds.size(); }
+
+private:
+    friend class Plan;
+
+    /**
+     * @brief Build a prototype of a plan, used by Plan::fillFile.
+     */
+    PlanPrototype(Plan& plan, const PlanBinaryView& view);
+
+    /**
+     * @brief A date of a temporal block, evaluated with the load time.
+     */
+    struct Date
+    {
+        enum Type {
+            None, /**< No date. */
+            Absolute, /**< value. */
+            Relative, /**< loadTime + value. */
+            RelativeDate /**< "+year-month-day". */
+        };
+
+        Date()
+            : type(None), value(0.0), year(0), month(0), day(0)
+        {}
+
+        Type type;
+        devs::Time value; /**< Day of year of "1401-month-day" if
+                            RelativeDate. */
+        int year; /**< Years to add to the load time. */
+        int month; /**< Month of a RelativeDate. */
+        int day; /**< Day of the month of a RelativeDate. */
+    };
+
+    /**
+     * @brief The load time of an instantiation and its year, computed once
+     * for all the dates.
+     */
+    struct LoadTime
+    {
+        LoadTime(const devs::Time& time);
+
+        devs::Time time;
+        bool validYear; /**< time is a julian day. */
+        int year; /**< Year of time if validYear. */
+    };
+
+    struct Temporal
+    {
+        Date start, minstart, maxstart, finish, minfinish, maxfinish;
+    };
+
+    struct Precedence
+    {
+        PrecedenceConstraint::Type type;
+        size_type first; /**< Index of the activity or npos. */
+        size_type second; /**< Index of the activity or npos. */
+        std::string firstName; /**< Identifier if first is npos. */
+        std::string secondName; /**< Identifier if second is npos. */
+        devs::Time mintimelag;
+        devs::Time maxtimelag;
+    };
+
+    static const size_type npos = static_cast < size_type >(-1);
+
+    void compile(const utils::Block& root);
+    void compile(const PlanBinaryView& plan);
+    static Date compileDate(const PlanBinaryView::Date& date);
+
+    /**
+     * @brief Get an activity of the plan, not created by the prototype,
+     * from its identifier and the suffix of the instantiation.
+     */
+    Activities::iterator find(const std::string& id,
+                              const std::string& suffixe) const;
+
+    static Plan::DateResult evaluate(const Date& date,
+                                     const LoadTime& loadTime);
+
+    Plan& mPlan;
+    std::vector < std::string > mIds;
+    std::vector < Activity > mActivities;
+    std::vector < std::vector < Temporal > > mTemporals;
+    std::vector < Precedence > mPrecedences;
+
+    /*
+     * Buffers reused by the instantiations, instantiate changes the plan
+     * and is not reentrant anyway.
+     */
+    mutable std::string mName; /**< Suffixed identifier. */
+    mutable std::vector < Activities::iterator > mInstances; /**< New
+                                                               activities
+                                                               by index. */
+};
+
+}}} // namespace vle model decision
+
+#endif
@@ -51,12 +51,223 @@ PrecedenceConstraint::PrecedenceConstraint(iterator first,
     }
 }
 
+/*
+ * The result of a precedence constraint depends on the type of the
+ * constraint and on the states of the two activities. Most of the 75
+ * transitions are constant. The others check a time window built with the
+ * time lags and a date of the predecessor: if no condition of the window
+ * matches, the constant result of the transition is returned.
+ */
+namespace {
+
+enum Kernel {
+    Constant, /**< Return the result of the transition. */
+    Impossible, /**< Throw an internal error. */
+    BoundedWindow, /**< Valid until the end of the window. */
+    OpenWindow, /**< Valid without next date. */
+    ReachedWindow /**< Valid without next date, the predecessor date is not
+                    checked. */
+};
+
+enum Origin {
+    NoDate,
+    StartedDate,
+    FFDate,
+    DoneDate
+};
+
+struct Transition
+{
+    Kernel kernel;
+    Origin origin;
+    PrecedenceConstraint::ResultType result;
+};
+
+typedef PrecedenceConstraint PC;
+
+/*
+ * Indexed by [type][state of the predecessor][state of the successor] in
+ * the order of the PrecedenceConstraint::Type and Activity::State enums.
+ */
+const Transition transitions[3][5][5] = {
+    { /* SS */
+        { /* i WAIT */
+            { Constant, NoDate, PC::Wait },
+            { Impossible, NoDate, PC::Failed },
+            { Impossible, NoDate, PC::Failed },
+            { Impossible, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Failed } },
+        { /* i STARTED */
+            { BoundedWindow, StartedDate, PC::Valid },
+            { Constant, NoDate, PC::Valid },
+            { Constant, NoDate, PC::Valid },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } },
+        { /* i FF */
+            { BoundedWindow, StartedDate, PC::Valid },
+            { Constant, NoDate, PC::Valid },
+            { Constant, NoDate, PC::Valid },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } },
+        { /* i DONE */
+            { ReachedWindow, StartedDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } },
+        { /* i FAILED */
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } } },
+    { /* FS */
+        { /* i WAIT */
+            { Constant, NoDate, PC::Wait },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } },
+        { /* i STARTED */
+            { Constant, NoDate, PC::Wait },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } },
+        { /* i FF */
+            { Constant, NoDate, PC::Wait },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } },
+        { /* i DONE */
+            { OpenWindow, DoneDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } },
+        { /* i FAILED */
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Failed } } },
+    { /* FF */
+        { /* i WAIT */
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } },
+        { /* i STARTED */
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Inapplicable },
+            { Constant, NoDate, PC::Failed } },
+        { /* i FF */
+            { BoundedWindow, FFDate, PC::Valid },
+            { BoundedWindow, FFDate, PC::Valid },
+            { BoundedWindow, FFDate, PC::Valid },
+            { Constant, NoDate, PC::Valid },
+            { Constant, NoDate, PC::Failed } },
+        { /* i DONE */
+            { BoundedWindow, FFDate, PC::Failed },
+            { BoundedWindow, FFDate, PC::Failed },
+            { BoundedWindow, FFDate, PC::Failed },
+            { BoundedWindow, FFDate, PC::Failed },
+            { Constant, NoDate, PC::Failed } },
+        { /* i FAILED */
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Failed },
+            { Constant, NoDate, PC::Failed } } }
+};
+
+inline const devs::Time& origin(const Activity& activity, Origin origin)
+{
+    switch (origin) {
+    case StartedDate:
+        return activity.startedDate();
+    case FFDate:
+        return activity.ffDate();
+    default:
+        return activity.doneDate();
+    }
+}
+
+} // anonymous namespace
+
 PrecedenceConstraint::Result
 PrecedenceConstraint::isValid(const devs::Time& time) const
 {
     const Activity& i(first()->second);
     const Activity& j(second()->second);
 
+    if ((unsigned int)m_type > FF or
+        (unsigned int)i.state() > Activity::FAILED or
+        (unsigned int)j.state() > Activity::FAILED) {
+        throw utils::InternalError(fmt(
+                _("Decision: unknown precedence constraint %1%")) %
+            (int)m_type);
+    }
+
+    const Transition& t(transitions[m_type][i.state()][j.state()]);
+
+    switch (t.kernel) {
+    case Constant:
+        return std::make_pair(t.result, devs::infinity);
+
+    case Impossible:
+        throw utils::InternalError(_("Decision: impossible state (SS)"));
+
+    case BoundedWindow:
+    case OpenWindow:
+        {
+            const devs::Time& date = origin(i, t.origin);
+            devs::Time dmin = date + mintimelag();
+            devs::Time dmax = date + maxtimelag();
+            bool bounded = t.kernel == BoundedWindow;
+
+            if (date <= time and time == dmin and time == dmax) {
+                return std::make_pair(Valid, bounded ? dmin : devs::infinity);
+            } else if (date <= time and time < dmin) {
+                return std::make_pair(Wait, dmin);
+            } else if (dmin <= time and time <= dmax) {
+                return std::make_pair(Valid, bounded ? dmax : devs::infinity);
+            } else if (dmax < time) {
+                return std::make_pair(Failed, devs::infinity);
+            }
+        }
+        break;
+
+    case ReachedWindow:
+        {
+            const devs::Time& date = origin(i, t.origin);
+            devs::Time dmin = date + mintimelag();
+            devs::Time dmax = date + maxtimelag();
+
+            if (dmin <= time and time <= dmax) {
+                return std::make_pair(Valid, devs::infinity);
+            } else if (time < dmin) {
+                return std::make_pair(Wait, dmin);
+            } else if (dmax < time) {
+                return std::make_pair(Failed, devs::infinity);
+            }
+        }
+        break;
+    }
+
+    return std::make_pair(t.result, devs::infinity);
+}
+
+PrecedenceConstraint::Result
+PrecedenceConstraint::isValidReference(const devs::Time& time) const
+{
+    const Activity& i(first()->second);
+    const Activity& j(second()->second);
+
     switch (m_type) {
     case SS:
         switch (i.state()) {
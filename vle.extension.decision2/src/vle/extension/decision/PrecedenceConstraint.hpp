@@ -85,8 +85,23 @@ public:
     iterator first() const { return m_first; }
     iterator second() const { return m_second ; }
 
+    /**
+     * @brief Compute the validity of the constraint from a transition table
+     * indexed by the type of the constraint and the states of the two
+     * activities.
+     * @param time The current time.
+     * @return The validity and the next date to check the constraint.
+     */
     Result isValid(const devs::Time& time) const;
 
+    /**
+     * @brief The nested switch implementation of the isValid function. It
+     * is kept as a reference to check the transition table.
+     * @param time The current time.
+     * @return The validity and the next date to check the constraint.
+     */
+    Result isValidReference(const devs::Time& time) const;
+
 private:
     Type       m_type;
     devs::Time m_mintimelag;
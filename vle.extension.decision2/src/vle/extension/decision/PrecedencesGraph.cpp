@@ -29,13 +29,126 @@
 #include <vle/extension/decision/PrecedencesGraph.hpp>
 #include <vle/utils/Algo.hpp>
 #include <vle/utils/i18n.hpp>
+#include <algorithm>
 #include <iterator>
 
 namespace vle { namespace extension { namespace decision {
 
 void PrecedencesGraph::add(const PrecedenceConstraint& p)
 {
-    m_lstin.insert(p);
+    m_edges[&p.second()->second].in.push_back(p);
+    m_edges[&p.first()->second].out.push_back(p);
+    ++m_size;
+}
+
+static bool isSameConstraint(const PrecedenceConstraint& x,
+                             const PrecedenceConstraint& y)
+{
+    return x.first() == y.first() and x.second() == y.second() and
+        x.type() == y.type() and x.mintimelag() == y.mintimelag() and
+        x.maxtimelag() == y.maxtimelag();
+}
+
+void PrecedencesGraph::erase(const Activity* activity,
+                             const PrecedenceConstraint& p,
+                             Precedences Edges::* edges)
+{
+    adjacency_t::iterator it = m_edges.find(activity);
+
+    if (it != m_edges.end()) {
+        Precedences& lst = it->second.*edges;
+
+        for (Precedences::iterator jt = lst.begin(); jt != lst.end(); ++jt) {
+            if (isSameConstraint(*jt, p)) {
+                lst.erase(jt);
+                break;
+            }
+        }
+
+        if (it->second.in.empty() and it->second.out.empty()) {
+            m_edges.erase(it);
+        }
+    }
+}
+
+void PrecedencesGraph::remove(PrecedenceConstraint::iterator activity,
+                              std::vector < PrecedenceConstraint >& removed)
+{
+    adjacency_t::iterator found = m_edges.find(&activity->second);
+
+    if (found == m_edges.end()) {
+        return;
+    }
+
+    Edges edges;
+    edges.in.swap(found->second.in);
+    edges.out.swap(found->second.out);
+    m_edges.erase(found);
+
+    for (Precedences::const_iterator it = edges.in.begin();
+         it != edges.in.end(); ++it) {
+        erase(&it->first()->second, *it, &Edges::out);
+        removed.push_back(*it);
+        --m_size;
+    }
+
+    for (Precedences::const_iterator it = edges.out.begin();
+         it != edges.out.end(); ++it) {
+        if (it->second() == it->first()) {
+            continue; /* A loop is also an in edge, already removed. */
+        }
+        erase(&it->second()->second, *it, &Edges::in);
+        removed.push_back(*it);
+        --m_size;
+    }
+}
+
+struct CompareSuccessor
+{
+    bool operator()(const PrecedencesGraph::Precedences* x,
+                    const PrecedencesGraph::Precedences* y) const
+    { return x->front().second()->first < y->front().second()->first; }
+};
+
+struct ComparePredecessor
+{
+    bool operator()(const PrecedencesGraph::Precedences* x,
+                    const PrecedencesGraph::Precedences* y) const
+    { return x->front().first()->first < y->front().first()->first; }
+};
+
+void PrecedencesGraph::write(std::ostream& o) const
+{
+    std::vector < const Precedences* > in, out;
+
+    for (adjacency_t::const_iterator it = m_edges.begin();
+         it != m_edges.end(); ++it) {
+        if (not it->second.in.empty()) {
+            in.push_back(&it->second.in);
+        }
+        if (not it->second.out.empty()) {
+            out.push_back(&it->second.out);
+        }
+    }
+
+    std::sort(in.begin(), in.end(), CompareSuccessor());
+    std::sort(out.begin(), out.end(), ComparePredecessor());
+
+    o << "PrecedencesGraph:\n1) Out list:\n";
+    for (std::vector < const Precedences* >::const_iterator it = in.begin();
+         it != in.end(); ++it) {
+        for (iteratorIn jt = (*it)->begin(); jt != (*it)->end(); ++jt) {
+            o << "- (" << (*jt) << ")\n";
+        }
+    }
+    o << "PrecedencesGraph:\n1) In list:\n";
+    for (std::vector < const Precedences* >::const_iterator it = out.begin();
+         it != out.end(); ++it) {
+        for (iteratorOut jt = (*it)->begin(); jt != (*it)->end(); ++jt) {
+            o << "- (" << (*jt) << ")\n";
+        }
+    }
+    o << "\n";
 }
 
 }}} // namespace vle model decision
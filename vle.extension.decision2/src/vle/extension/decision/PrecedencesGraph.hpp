@@ -30,68 +30,114 @@
 #define VLE_EXT_DECISION_PRECEDENCESGRAPH_HPP
 
 #include <vle/extension/decision/PrecedenceConstraint.hpp>
-#include <set>
+#include <boost/unordered_map.hpp>
+#include <ostream>
+#include <vector>
 
 namespace vle { namespace extension { namespace decision {
 
+/**
+ * @brief PrecedencesGraph stores the precedence constraints in adjacency
+ * lists: for each activity, the constraints where it is the successor (in
+ * edges) and the constraints where it is the predecessor (out edges). The
+ * two lists of an activity share one entry, found in constant time with
+ * the address of the activity, and keep the insertion order of the
+ * constraints.
+ */
 class PrecedencesGraph
 {
 public:
-    typedef std::multiset < PrecedenceConstraint,
-            PrecedenceConstraintCompareFirst > PrecedencesOut;
-
-    typedef std::multiset < PrecedenceConstraint,
-            PrecedenceConstraintCompareSecond > PrecedencesIn;
+    typedef std::vector < PrecedenceConstraint > Precedences;
+    typedef Precedences::size_type size_type;
 
-    typedef PrecedencesIn::iterator iteratorIn;
-    typedef PrecedencesOut::iterator iteratorOut;
+    typedef Precedences::const_iterator iteratorIn;
+    typedef Precedences::const_iterator iteratorOut;
 
     typedef std::pair < iteratorIn, iteratorIn > findIn;
     typedef std::pair < iteratorOut, iteratorOut > findOut;
 
+    PrecedencesGraph()
+        : m_size(0)
+    {}
+
     void add(const PrecedenceConstraint& p);
 
-    findIn
-        findPrecedenceIn(PrecedenceConstraint::iterator activity) const
-        {
-            return m_lstin.equal_range(
-                PrecedenceConstraint(activity, activity,
-                                     PrecedenceConstraint::FS,
-                                     0.0, 0.0));
-        }
+    /**
+     * @brief Remove all the precedence constraints where the activity is the
+     * predecessor or the successor.
+     * @param activity The activity to disconnect.
+     * @param removed Output parameter filled with the removed constraints.
+     */
+    void remove(PrecedenceConstraint::iterator activity,
+                std::vector < PrecedenceConstraint >& removed);
+
+    /**
+     * @brief Get the constraints where the activity is the successor.
+     * @param activity The successor.
+     * @return A range of constraints in the insertion order.
+     */
+    findIn findPrecedenceIn(PrecedenceConstraint::iterator activity) const
+    { return find(&Edges::in, activity); }
+
+    /**
+     * @brief Get the constraints where the activity is the predecessor.
+     * @param activity The predecessor.
+     * @return A range of constraints in the insertion order.
+     */
+    findOut findPrecedenceOut(PrecedenceConstraint::iterator activity) const
+    { return find(&Edges::out, activity); }
+
+    /**
+     * @brief Get the number of constraints.
+     * @return The number of constraints.
+     */
+    size_type size() const { return m_size; }
+
+    bool empty() const { return m_size == 0; }
+
+    /**
+     * @brief Write the constraints sorted by successor then by
+     * predecessor.
+     * @param o The output stream.
+     */
+    void write(std::ostream& o) const;
 
-    findOut
-        findPrecedenceOut(PrecedenceConstraint::iterator activity) const
-        {
-            return m_lstout.equal_range(
-                PrecedenceConstraint(activity, activity,
-                                     PrecedenceConstraint::FS,
-                                     0.0, 0.0));
+private:
+    struct Edges
+    {
+        Precedences in; /**< Constraints where the activity is the
+                          successor. */
+        Precedences out; /**< Constraints where the activity is the
+                           predecessor. */
+    };
+
+    typedef boost::unordered_map < const Activity*, Edges > adjacency_t;
+
+    std::pair < iteratorIn, iteratorIn > find(
+        Precedences Edges::* edges,
+        PrecedenceConstraint::iterator activity) const
+    {
+        adjacency_t::const_iterator it = m_edges.find(&activity->second);
+        if (it == m_edges.end()) {
+            return std::make_pair(m_empty.begin(), m_empty.end());
         }
+        const Precedences& lst = it->second.*edges;
+        return std::make_pair(lst.begin(), lst.end());
+    }
 
-    const PrecedencesIn& in() const { return m_lstin; }
-    const PrecedencesOut& out() const { return m_lstout; }
+    void erase(const Activity* activity, const PrecedenceConstraint& p,
+               Precedences Edges::* edges);
 
-private:
-    /** Defines the constraints. */
-    PrecedencesIn m_lstin;
-    PrecedencesOut m_lstout;
+    adjacency_t m_edges; /**< Constraints indexed by activity. */
+    Precedences m_empty;
+    size_type m_size;
 };
 
 inline std::ostream&
 operator<<(std::ostream& o, const PrecedencesGraph& p)
 {
-    o << "PrecedencesGraph:\n1) Out list:\n";
-    for (PrecedencesGraph::iteratorOut i = p.in().begin();
-         i != p.in().end(); ++i) {
-        o << "- (" << (*i) << ")\n";
-    }
-    o << "PrecedencesGraph:\n1) In list:\n";
-    for (PrecedencesGraph::iteratorIn i = p.out().begin();
-         i != p.out().end(); ++i) {
-        o << "- (" << (*i) << ")\n";
-    }
-    return o << "\n";
+    p.write(o);
+    return o;
 }
 
 }}} // namespace vle model decision
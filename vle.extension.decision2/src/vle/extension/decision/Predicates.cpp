@@ -113,4 +113,136 @@ std::string PredicateParameters::getString(const std::string& name) const
     return getParam <std::string>(m_lst, name);
 }
 
+PredicateOperator toPredicateOperator(const std::string& op)
+{
+    if (op == "<")
+        return PredicateOperatorLess;
+    if (op == "<=")
+        return PredicateOperatorLessEqual;
+    if (op == "=" or op == "==")
+        return PredicateOperatorEqual;
+    if (op == "!=")
+        return PredicateOperatorNotEqual;
+    if (op == ">=")
+        return PredicateOperatorGreaterEqual;
+    if (op == ">")
+        return PredicateOperatorGreater;
+
+    throw vle::utils::ModellingError(
+        vle::fmt("Decision: unknown predicate operator %1%") % op);
+}
+
+std::string toString(PredicateOperator op)
+{
+    switch (op) {
+    case PredicateOperatorLess:
+        return "<";
+    case PredicateOperatorLessEqual:
+        return "<=";
+    case PredicateOperatorEqual:
+        return "=";
+    case PredicateOperatorNotEqual:
+        return "!=";
+    case PredicateOperatorGreaterEqual:
+        return ">=";
+    case PredicateOperatorGreater:
+        return ">";
+    }
+
+    return "?";
+}
+
+bool comparePredicateOperator(PredicateOperator op, double lhs, double rhs)
+{
+    switch (op) {
+    case PredicateOperatorLess:
+        return lhs < rhs;
+    case PredicateOperatorLessEqual:
+        return lhs <= rhs;
+    case PredicateOperatorEqual:
+        return lhs == rhs;
+    case PredicateOperatorNotEqual:
+        return lhs != rhs;
+    case PredicateOperatorGreaterEqual:
+        return lhs >= rhs;
+    case PredicateOperatorGreater:
+        return lhs > rhs;
+    }
+
+    return false;
+}
+
+TypedPredicateParameters::TypedPredicateParameters(
+    const PredicateSignature& signature,
+    const PredicateParameters& params)
+{
+    for (PredicateSignature::const_iterator it = signature.begin();
+         it != signature.end(); ++it) {
+        switch (it->second) {
+        case PredicateSignature::RealSlot:
+            m_reals.push_back(params.getDouble(it->first));
+            break;
+        case PredicateSignature::StringSlot:
+            m_strings.push_back(params.getString(it->first));
+            break;
+        case PredicateSignature::OperatorSlot:
+            m_operators.push_back(
+                toPredicateOperator(params.getString(it->first)));
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Find the result of a predicate in a map or evaluate it and store
+ * it.
+ */
+template < typename Map >
+static bool lookup(Map& lst, const typename Map::key_type& key,
+                   const Predicate& predicate, const std::string& activity,
+                   const std::string& rule, const ActivityMetadata& metadata,
+                   unsigned long& hits, unsigned long& misses)
+{
+    typename Map::const_iterator it = lst.find(key);
+
+    if (it != lst.end()) {
+        ++hits;
+        return it->second;
+    }
+
+    ++misses;
+    bool result = predicate.isAvailable(activity, rule, metadata);
+    lst.insert(std::make_pair(key, result));
+
+    return result;
+}
+
+bool PredicateCache::isAvailable(const Predicate& predicate,
+                                 const Activity* owner,
+                                 const std::string& activity,
+                                 const std::string& rule,
+                                 const ActivityMetadata& metadata)
+{
+    switch (predicate.scope()) {
+    case PredicateGlobal:
+        return lookup(m_lst, key_type(&predicate, 0), predicate, activity,
+                      rule, metadata, m_hits, m_misses);
+    case PredicatePerActivity:
+        if (owner) {
+            return lookup(m_lst, key_type(&predicate, owner), predicate,
+                          activity, rule, metadata, m_hits, m_misses);
+        }
+        break;
+    case PredicatePerKey:
+        return lookup(m_keys,
+                      string_key_type(&predicate,
+                                      predicate.cacheKey(activity)),
+                      predicate, activity, rule, metadata, m_hits, m_misses);
+    case PredicateNotCached:
+        break;
+    }
+
+    return predicate.isAvailable(activity, rule, metadata);
+}
+
 }}} // namespace vle model decision
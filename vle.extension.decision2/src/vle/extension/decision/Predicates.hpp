@@ -29,6 +29,8 @@
 #ifndef VLE_EXT_DECISION_PREDICATES_HPP
 #define VLE_EXT_DECISION_PREDICATES_HPP
 
+#include <vle/extension/decision/ActivityMetadata.hpp>
+#include <vle/devs/Time.hpp>
 #include <vle/utils/Exception.hpp>
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
@@ -41,6 +43,8 @@
 
 namespace vle { namespace extension { namespace decision {
 
+class Activity;
+
 /**
  * @brief Defines parameter type for predicates.
  */
@@ -92,6 +96,122 @@ private:
     container_type m_lst;
 };
 
+/**
+ * @brief Defines the comparison operators of the typed predicate
+ * parameters.
+ */
+enum PredicateOperator
+{
+    PredicateOperatorLess, /**< `<' */
+    PredicateOperatorLessEqual, /**< `<=' */
+    PredicateOperatorEqual, /**< `=' or `==' */
+    PredicateOperatorNotEqual, /**< `!=' */
+    PredicateOperatorGreaterEqual, /**< `>=' */
+    PredicateOperatorGreater /**< `>' */
+};
+
+/**
+ * @brief Convert a string into a PredicateOperator.
+ * @param op The string to convert.
+ * @return The operator.
+ * @throw utils::ModellingError if the string is not an operator.
+ */
+PredicateOperator toPredicateOperator(const std::string& op);
+
+/**
+ * @brief Convert a PredicateOperator into a string.
+ * @param op The operator to convert.
+ * @return The string of the operator, `=' for PredicateOperatorEqual.
+ */
+std::string toString(PredicateOperator op);
+
+/**
+ * @brief Compare two reals with an operator.
+ * @param op The operator.
+ * @param lhs The left operand.
+ * @param rhs The right operand.
+ * @return The result of the comparison.
+ */
+bool comparePredicateOperator(PredicateOperator op, double lhs, double rhs);
+
+/**
+ * @brief PredicateSignature lists the parameters expected by a typed
+ * predicate function and their types.
+ * @code
+ * PredicateSignature().addOperator("rain_operator").addReal("rain_threshold");
+ * @endcode
+ */
+class PredicateSignature
+{
+public:
+    enum SlotType { RealSlot, StringSlot, OperatorSlot };
+
+    typedef std::pair <std::string, SlotType> slot_type;
+    typedef std::vector <slot_type> container_type;
+    typedef container_type::const_iterator const_iterator;
+    typedef container_type::size_type size_type;
+
+    PredicateSignature& addReal(const std::string& name)
+    {
+        m_lst.push_back(slot_type(name, RealSlot));
+        return *this;
+    }
+
+    PredicateSignature& addString(const std::string& name)
+    {
+        m_lst.push_back(slot_type(name, StringSlot));
+        return *this;
+    }
+
+    PredicateSignature& addOperator(const std::string& name)
+    {
+        m_lst.push_back(slot_type(name, OperatorSlot));
+        return *this;
+    }
+
+    const_iterator begin() const { return m_lst.begin(); }
+    const_iterator end() const { return m_lst.end(); }
+    size_type size() const { return m_lst.size(); }
+    bool empty() const { return m_lst.empty(); }
+
+private:
+    container_type m_lst;
+};
+
+/**
+ * @brief TypedPredicateParameters stores the parameters of a predicate
+ * resolved once with a PredicateSignature: reals, strings and operators
+ * are read by index without string comparison. Indices are counted by type
+ * in the order of the signature, ie. the second real of the signature is
+ * getReal(1).
+ */
+class TypedPredicateParameters
+{
+public:
+    typedef std::vector <double>::size_type size_type;
+
+    TypedPredicateParameters() {}
+
+    /**
+     * @brief Build the typed parameters.
+     * @param signature The parameters to resolve.
+     * @param params The sorted parameters of the predicate.
+     * @throw utils::ModellingError if a parameter is missing, has a bad
+     * type or if an operator is unknown.
+     */
+    TypedPredicateParameters(const PredicateSignature& signature,
+                             const PredicateParameters& params);
+
+    double getReal(size_type i) const { return m_reals[i]; }
+    const std::string& getString(size_type i) const { return m_strings[i]; }
+    PredicateOperator getOperator(size_type i) const { return m_operators[i]; }
+
+private:
+    std::vector <double> m_reals;
+    std::vector <std::string> m_strings;
+    std::vector <PredicateOperator> m_operators;
+};
+
 /**
  * @brief Defines a Predicate like a function which returns a boolean
  * without parameter.
@@ -100,6 +220,35 @@ typedef boost::function <bool (const std::string& activity,
                                const std::string& rule,
                                const PredicateParameters& params)> PredicateFunction;
 
+/**
+ * @brief Defines a Predicate function which reads its parameters from a
+ * TypedPredicateParameters and gets the metadata of the activity.
+ */
+typedef boost::function <bool (const std::string& activity,
+                               const std::string& rule,
+                               const ActivityMetadata& metadata,
+                               const TypedPredicateParameters& params)> TypedPredicateFunction;
+
+/**
+ * @brief Defines on what the result of a predicate depends during a time
+ * step, between two changes of facts. The rule name is never used as key.
+ */
+enum PredicateScope
+{
+    PredicateNotCached, /**< The result is never cached (default). */
+    PredicateGlobal, /**< The result depends only on the facts and on the
+                       parameters. */
+    PredicatePerActivity, /**< The result depends on the activity. */
+    PredicatePerKey /**< The result depends on a key computed from the
+                      activity name, for instance a plot. */
+};
+
+/**
+ * @brief Defines a function which computes the key of a PredicatePerKey
+ * predicate from the name of an activity.
+ */
+typedef boost::function <std::string (const std::string& activity)> PredicateKeyFunction;
+
 class Predicate
 {
 public:
@@ -109,28 +258,168 @@ public:
         : m_name(name)
         , m_function(function)
         , m_parameters(params)
+        , m_scope(PredicateNotCached)
     {}
 
     Predicate(const std::string& name,
               const PredicateFunction& function)
         : m_name(name)
         , m_function(function)
+        , m_scope(PredicateNotCached)
+    {}
+
+    Predicate(const std::string& name,
+              const TypedPredicateFunction& function,
+              const PredicateParameters& params,
+              const TypedPredicateParameters& typed)
+        : m_name(name)
+        , m_parameters(params)
+        , m_typedFunction(function)
+        , m_typedParameters(typed)
+        , m_scope(PredicateNotCached)
     {}
 
     bool isAvailable(const std::string& activity,
-                     const std::string& rule) const
+                     const std::string& rule,
+                     const ActivityMetadata& metadata = ActivityMetadata()) const
     {
+        if (m_typedFunction)
+            return m_typedFunction(activity, rule, metadata,
+                                   m_typedParameters);
+
         return m_function(activity, rule, m_parameters);
     }
 
+    /**
+     * @brief Declare how the result of the predicate can be cached.
+     * @param scope The scope of the predicate.
+     * @param key The function to compute the key if scope is
+     * PredicatePerKey.
+     */
+    void setScope(PredicateScope scope,
+                  const PredicateKeyFunction& key = PredicateKeyFunction())
+    {
+        m_scope = scope;
+        m_key = key;
+    }
+
+    /**
+     * @brief Get the key of the result of a PredicatePerKey predicate in a
+     * cache.
+     * @param activity The name of the activity.
+     * @return The key computed from the activity name or the activity name
+     * if the predicate has no key function.
+     */
+    std::string cacheKey(const std::string& activity) const
+    { return m_key ? m_key(activity) : activity; }
+
     const std::string& name() const { return m_name; }
     const PredicateFunction& function() const { return m_function; }
     const PredicateParameters& params() const { return m_parameters; }
+    const TypedPredicateFunction& typedFunction() const
+    { return m_typedFunction; }
+    const TypedPredicateParameters& typedParams() const
+    { return m_typedParameters; }
+    PredicateScope scope() const { return m_scope; }
 
 private:
-    std::string         m_name;
-    PredicateFunction   m_function;
-    PredicateParameters m_parameters;
+    std::string          m_name;
+    PredicateFunction    m_function;
+    PredicateParameters  m_parameters;
+    TypedPredicateFunction m_typedFunction;
+    TypedPredicateParameters m_typedParameters;
+    PredicateScope       m_scope;
+    PredicateKeyFunction m_key;
+};
+
+/**
+ * @brief PredicateCache memoises the results of the predicates during a
+ * time step. The cache is cleared when the time changes and when the fact
+ * epoch is incremented, ie. each time a fact is applied.
+ */
+class PredicateCache
+{
+public:
+    PredicateCache()
+        : m_time(devs::negativeInfinity), m_epoch(0), m_hits(0),
+        m_misses(0), m_enabled(false)
+    {}
+
+    void setEnabled(bool enabled)
+    {
+        m_enabled = enabled;
+        clear();
+    }
+
+    bool enabled() const { return m_enabled; }
+
+    /**
+     * @brief Clear the cache if the time changes.
+     * @param time The current time.
+     */
+    void setTime(const devs::Time& time)
+    {
+        if (time != m_time) {
+            m_time = time;
+            clear();
+        }
+    }
+
+    /**
+     * @brief Increment the fact epoch and clear the cache.
+     */
+    void factsChanged()
+    {
+        ++m_epoch;
+        clear();
+    }
+
+    /**
+     * @brief Remove all the results, for instance when activities are
+     * destroyed: their addresses are keys.
+     */
+    void clear()
+    {
+        m_lst.clear();
+        m_keys.clear();
+    }
+
+    /**
+     * @brief Get the result of the predicate from the cache or call the
+     * predicate and store its result if its scope allows it.
+     * @param predicate The predicate to evaluate.
+     * @param owner The activity evaluated: the key of the results of the
+     * PredicatePerActivity predicates, which are not cached if it is null.
+     * @param activity The name of the activity.
+     * @param rule The name of the rule.
+     * @param metadata The metadata of the activity.
+     * @return The result of the predicate.
+     */
+    bool isAvailable(const Predicate& predicate,
+                     const Activity* owner,
+                     const std::string& activity,
+                     const std::string& rule,
+                     const ActivityMetadata& metadata);
+
+    unsigned long epoch() const { return m_epoch; }
+    unsigned long hits() const { return m_hits; }
+    unsigned long misses() const { return m_misses; }
+    std::size_t size() const { return m_lst.size() + m_keys.size(); }
+
+private:
+    /* The activity is null for the PredicateGlobal predicates. */
+    typedef std::pair < const Predicate*, const Activity* > key_type;
+    typedef boost::unordered_map < key_type, bool > container_type;
+    typedef std::pair < const Predicate*, std::string > string_key_type;
+    typedef boost::unordered_map < string_key_type, bool > keys_type;
+
+    container_type m_lst;
+    keys_type      m_keys; /**< Results of the PredicatePerKey predicates. */
+    devs::Time     m_time;
+    unsigned long  m_epoch;
+    unsigned long  m_hits;
+    unsigned long  m_misses;
+    bool           m_enabled;
 };
 
 struct PredicateEqual
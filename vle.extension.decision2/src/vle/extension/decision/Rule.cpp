@@ -51,11 +51,21 @@ void Rule::add(const PredicateFunction& function)
 }
 
 bool Rule::isAvailable(const std::string& activity,
-                       const std::string& rule) const
+                       const std::string& rule,
+                       const ActivityMetadata& metadata,
+                       PredicateCache* cache,
+                       const Activity* owner) const
 {
-    for (size_t i = 0, e = m_predicates.size(); i != e; ++i)
-        if (not m_predicates[i]->isAvailable(activity, rule))
-            return false;
+    if (cache) {
+        for (size_t i = 0, e = m_predicates.size(); i != e; ++i)
+            if (not cache->isAvailable(*m_predicates[i], owner, activity,
+                                       rule, metadata))
+                return false;
+    } else {
+        for (size_t i = 0, e = m_predicates.size(); i != e; ++i)
+            if (not m_predicates[i]->isAvailable(activity, rule, metadata))
+                return false;
+    }
 
     if (not m_predicates_function.empty()) {
         PredicateParameters empty;
@@ -47,7 +47,33 @@ public:
      */
     void add(const PredicateFunction& function);
 
-    bool isAvailable(const std::string& activity, const std::string& rule) const;
+    /**
+     * @brief Check if all the predicates of the rule are true.
+     * @param activity The name of the activity.
+     * @param rule The name of the rule.
+     * @param cache If not null, the predicates are evaluated through the
+     * cache.
+     * @return true if all the predicates are true.
+     */
+    bool isAvailable(const std::string& activity, const std::string& rule,
+                     PredicateCache* cache = 0) const
+    { return isAvailable(activity, rule, ActivityMetadata(), cache); }
+
+    /**
+     * @brief Check if all the predicates of the rule are true.
+     * @param activity The name of the activity.
+     * @param rule The name of the rule.
+     * @param metadata The metadata of the activity given to the typed
+     * predicates.
+     * @param cache If not null, the predicates are evaluated through the
+     * cache.
+     * @param owner The activity, the key of its results in the cache.
+     * @return true if all the predicates are true.
+     */
+    bool isAvailable(const std::string& activity, const std::string& rule,
+                     const ActivityMetadata& metadata,
+                     PredicateCache* cache = 0,
+                     const Activity* owner = 0) const;
 
 private:
     std::vector <const Predicate *> m_predicates;
@@ -29,6 +29,7 @@
 #include <vle/extension/decision/Rules.hpp>
 #include <vle/utils/Exception.hpp>
 #include <vle/utils/i18n.hpp>
+#include <algorithm>
 
 namespace vle { namespace extension { namespace decision {
 
@@ -58,18 +59,22 @@ Rule& Rules::add(const std::string& name, const Predicate& pred)
     }
 }
 
-Rules::result_t Rules::apply(const std::string& activity) const
+Rules::result_t Rules::apply(const std::string& activity,
+                             const ActivityMetadata& metadata,
+                             PredicateCache* cache,
+                             const Activity* owner) const
 {
     result_t result;
 
     for (const_iterator it = m_lst.begin(), et = m_lst.end(); it != et; ++it)
-        if (it->second.isAvailable(activity, it->first))
+        if (it->second.isAvailable(activity, it->first, metadata, cache,
+                                   owner))
             result.push_back(it);
 
     return result;
 }
 
-const Rule& Rules::get(const std::string& name) const
+Rules::const_iterator Rules::lookup(const std::string& name) const
 {
     const_iterator it = m_lst.find(name);
 
@@ -78,7 +83,135 @@ const Rule& Rules::get(const std::string& name) const
             % name);
     }
 
-    return it->second;
+    return it;
+}
+
+namespace {
+
+struct CompareRuleName
+{
+    bool operator()(Rules::const_iterator x, const std::string& y) const
+    { return x->first < y; }
+};
+
+} // anonymous namespace
+
+const SharedRules::refs_t SharedRules::s_none;
+
+SharedRules::refs_t& SharedRules::ownRefs()
+{
+    if (not m_refs) {
+        m_refs.reset(new refs_t());
+    } else if (not m_refs.unique()) {
+        m_refs.reset(new refs_t(*m_refs));
+    }
+
+    return *m_refs;
+}
+
+void SharedRules::add(Rules::const_iterator rule)
+{
+    *insert(rule->first) = rule;
+}
+
+Rule& SharedRules::add(const std::string& name, const Rule& rule)
+{
+    if (exist(name)) {
+        throw utils::ArgError(vle::fmt(_("Decision: rule '%1%' already exists"))
+            % name);
+    }
+
+    if (not m_owned) {
+        m_owned.reset(new Rules());
+    } else if (not m_owned.unique()) {
+        const Rules& shared = *m_owned;
+        boost::shared_ptr < Rules > owned(new Rules(shared));
+
+        refs_t& refs = ownRefs();
+
+        for (refs_t::iterator it = refs.begin(); it != refs.end(); ++it) {
+            Rules::const_iterator jt = shared.find((*it)->first);
+
+            if (jt != shared.end() and &jt->second == &(*it)->second) {
+                *it = const_cast < const Rules& >(*owned).find(jt->first);
+            }
+        }
+
+        m_owned = owned;
+    }
+
+    Rule& result = m_owned->add(name, rule);
+    *insert(name) = const_cast < const Rules& >(*m_owned).find(name);
+    return result;
+}
+
+void SharedRules::assign(const Rules& rules)
+{
+    refs_t& refs = ownRefs();
+    refs.clear();
+    m_owned.reset(new Rules(rules));
+
+    const Rules& owned = *m_owned;
+    for (Rules::const_iterator it = owned.begin(); it != owned.end(); ++it) {
+        refs.push_back(it);
+    }
+}
+
+const Rule& SharedRules::get(const std::string& name) const
+{
+    refs_t::const_iterator it = find(name);
+
+    if (it == refs().end()) {
+        throw utils::ArgError(vle::fmt(_("Decision: rule '%1%' does not exist"))
+            % name);
+    }
+
+    return (*it)->second;
+}
+
+SharedRules::result_t SharedRules::apply(const std::string& activity,
+                                         const ActivityMetadata& metadata,
+                                         PredicateCache* cache,
+                                         const Activity* owner) const
+{
+    result_t result;
+
+    const refs_t& lst = refs();
+
+    for (refs_t::const_iterator it = lst.begin(); it != lst.end(); ++it)
+        if ((*it)->second.isAvailable(activity, (*it)->first, metadata, cache,
+                                      owner))
+            result.push_back(*it);
+
+    return result;
+}
+
+SharedRules::refs_t::const_iterator
+SharedRules::find(const std::string& name) const
+{
+    const refs_t& lst = refs();
+    refs_t::const_iterator it = std::lower_bound(lst.begin(), lst.end(),
+                                                 name, CompareRuleName());
+
+    if (it != lst.end() and (*it)->first == name) {
+        return it;
+    }
+
+    return lst.end();
+}
+
+SharedRules::refs_t::iterator SharedRules::insert(const std::string& name)
+{
+    refs_t& lst = ownRefs();
+    refs_t::iterator it = std::lower_bound(lst.begin(), lst.end(),
+                                           name, CompareRuleName());
+
+    if (it != lst.end() and (*it)->first == name) {
+        throw utils::ArgError(vle::fmt(_("Decision: rule '%1%' already exists"))
+            % name);
+    }
+
+    return lst.insert(it, Rules::const_iterator());
 }
 
 }}} // namespace vle model decision
@@ -30,8 +30,10 @@
 #define VLE_EXT_DECISION_RULES_HPP
 
 #include <vle/extension/decision/Rule.hpp>
+#include <boost/shared_ptr.hpp>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace vle { namespace extension { namespace decision {
 
@@ -66,9 +68,25 @@ public:
 
     Rule& add(const std::string& name, const Predicate& pred);
 
-    result_t apply(const std::string& activity) const;
+    result_t apply(const std::string& activity,
+                   PredicateCache* cache = 0) const
+    { return apply(activity, ActivityMetadata(), cache); }
 
-    const Rule& get(const std::string& name) const;
+    result_t apply(const std::string& activity,
+                   const ActivityMetadata& metadata,
+                   PredicateCache* cache = 0,
+                   const Activity* owner = 0) const;
+
+    const Rule& get(const std::string& name) const
+    { return lookup(name)->second; }
+
+    /**
+     * @brief Get a rule to share it with SharedRules::add.
+     * @param name The name of the rule.
+     * @return An iterator to the rule.
+     * @throw utils::ArgError if the rule does not exist.
+     */
+    const_iterator lookup(const std::string& name) const;
 
     iterator begin() { return m_lst.begin(); }
     const_iterator begin() const { return m_lst.begin(); }
@@ -81,6 +99,100 @@ private:
     rules_t m_lst;
 };
 
+/**
+ * @brief SharedRules is the set of rules of an activity. The rules of a
+ * plan are referenced, not copied: an activity costs a pointer per rule
+ * and all the activities of a plan share the same Rule objects. A rule
+ * given by value is copied into a Rules container shared by the copies of
+ * the activity and cloned by the first copy which adds a rule. The list of
+ * references is shared the same way: copying an activity does not copy
+ * its rules.
+ *
+ * The referenced Rules container must outlive the activity, and a shared
+ * rule changed after the creation of the activities is changed for all
+ * of them.
+ */
+class SharedRules
+{
+public:
+    typedef std::vector < Rules::const_iterator > refs_t;
+    typedef refs_t::const_iterator const_iterator;
+    typedef Rules::size_type size_type;
+    typedef Rules::result_t result_t;
+
+    /**
+     * @brief Reference a rule of a Rules container.
+     * @param rule The rule to share.
+     * @throw utils::ArgError if a rule with the same name exists.
+     */
+    void add(Rules::const_iterator rule);
+
+    /**
+     * @brief Copy a rule.
+     * @param name The name of the rule.
+     * @param rule The rule to copy.
+     * @return A reference to the copy.
+     * @throw utils::ArgError if a rule with the same name exists.
+     */
+    Rule& add(const std::string& name, const Rule& rule = Rule());
+
+    /**
+     * @brief Replace the rules by copies of the rules of a container.
+     * @param rules The rules to copy.
+     */
+    void assign(const Rules& rules);
+
+    bool exist(const std::string& name) const
+    { return find(name) != refs().end(); }
+
+    /**
+     * @brief Get a rule.
+     * @param name The name of the rule.
+     * @return A reference to the rule.
+     * @throw utils::ArgError if the rule does not exist.
+     */
+    const Rule& get(const std::string& name) const;
+
+    result_t apply(const std::string& activity,
+                   PredicateCache* cache = 0) const
+    { return apply(activity, ActivityMetadata(), cache); }
+
+    /**
+     * @brief Get the rules where all the predicates are true, sorted by
+     * name as Rules::apply does.
+     */
+    result_t apply(const std::string& activity,
+                   const ActivityMetadata& metadata,
+                   PredicateCache* cache = 0,
+                   const Activity* owner = 0) const;
+
+    const_iterator begin() const { return refs().begin(); }
+    const_iterator end() const { return refs().end(); }
+    size_type size() const { return refs().size(); }
+    bool empty() const { return refs().empty(); }
+
+    void swap(SharedRules& other)
+    { m_refs.swap(other.m_refs); m_owned.swap(other.m_owned); }
+
+private:
+    boost::shared_ptr < refs_t > m_refs; /**< Sorted by name, null if
+                                           there is no rule. */
+    boost::shared_ptr < Rules > m_owned; /**< Rules given by value. */
+
+    static const refs_t s_none;
+
+    const refs_t& refs() const { return m_refs ? *m_refs : s_none; }
+
+    /**
+     * @brief Get the references to change them, cloned first if they are
+     * shared with a copy.
+     */
+    refs_t& ownRefs();
+
+    refs_t::const_iterator find(const std::string& name) const;
+    refs_t::iterator insert(const std::string& name);
+};
+
 inline std::ostream& operator<<(std::ostream& s, const Rules& o)
 {
     std::ios_base::fmtflags fl = s.flags();
@@ -92,6 +204,17 @@ inline std::ostream& operator<<(std::ostream& s, const Rules& o)
     return s;
 }
 
+inline std::ostream& operator<<(std::ostream& s, const SharedRules& o)
+{
+    std::ios_base::fmtflags fl = s.flags();
+    s << std::boolalpha << "rules:";
+    for (SharedRules::const_iterator it = o.begin(); it != o.end(); ++it) {
+        s << " (" << (*it)->first << ")";
+    }
+    s.flags(fl);
+    return s;
+}
+
 }}} // namespace vle model decision
 
 #endif
@@ -0,0 +1,348 @@
+/*
+ * @file vle/extension/decision/StaticPlan.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <vle/extension/decision/StaticPlan.hpp>
+#include <vle/utils/i18n.hpp>
+#include <vle/utils/DateTime.hpp>
+#include <vle/utils/Exception.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <limits>
+#include <sstream>
+#include <cstdio>
+
+namespace vle { namespace extension { namespace decision {
+
+Plan::DateResult StaticPlan::evaluate(const StaticDate& date,
+                                      const devs::Time& loadTime)
+{
+    char buffer[32];
+
+    switch (date.type) {
+    case StaticDate::Absolute:
+        return Plan::DateResult(true, date.value);
+    case StaticDate::Relative:
+        return Plan::DateResult(true, loadTime + date.value);
+    case StaticDate::RelativeDate:
+        if (utils::DateTime::isValidYear(loadTime)) {
+            std::sprintf(buffer, "%d-%d-%d",
+                         date.year + utils::DateTime::year(loadTime),
+                         date.month, date.day);
+            return Plan::DateResult(true, devs::Time(
+                    (int)utils::DateTime::toJulianDayNumber(buffer)));
+        } else {
+            std::sprintf(buffer, "1401-%d-%d", date.month, date.day);
+            return Plan::DateResult(true, utils::DateTime::dayOfYear(
+                    utils::DateTime::toJulianDayNumber(buffer)) +
+                365 * date.year);
+        }
+    case StaticDate::None:
+    default:
+        return Plan::DateResult(false, 0.0);
+    }
+}
+
+void StaticPlan::setTemporal(Activity& activity, const StaticDate& minstart,
+                             const StaticDate& maxfinish,
+                             const devs::Time& loadTime)
+{
+    if (minstart.type == StaticDate::None and
+        maxfinish.type == StaticDate::None) {
+        return;
+    }
+
+    const Plan::DateResult none(false, 0.0);
+
+    Plan::setTemporal(activity, none, evaluate(minstart, loadTime), none,
+                      none, none, evaluate(maxfinish, loadTime));
+}
+
+std::size_t StaticPlan::index(std::size_t index, std::size_t size)
+{
+    if (index >= size) {
+        throw utils::ArgError(fmt(
+                _("Decision: static plan index %1% out of range [0, %2%[")) %
+            index % size);
+    }
+
+    return index;
+}
+
+StaticPlanSource::StaticPlanSource(const std::string& classname)
+    : mClassname(classname), mNbRules(0), mNbActivities(0),
+    mNbPrecedences(0)
+{
+    mFunctions = "/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *"
+        "\n * Plan rules"
+        "\n * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */\n";
+}
+
+void StaticPlanSource::addRule(const std::string& id,
+                               const Strings& predicates)
+{
+    std::string function = "staticRule" +
+        boost::lexical_cast < std::string >(mNbRules);
+
+    mRuleIndex[id] = mNbRules++;
+
+    if (predicates.empty()) {
+        mRules += "            { " + literal(id) + ", 0 },\n";
+        return;
+    }
+
+    mRules += "            { " + literal(id) + ", &" + mClassname + "::" +
+        function + " },\n";
+
+    // The predicates are called directly from a member function.
+    mFunctions += "bool " + function + "(const std::string&, "
+        "const std::string&,\n    const vmd::PredicateParameters&) "
+        "const\n{\n    return ";
+    for (Strings::const_iterator it = predicates.begin();
+         it != predicates.end(); ++it) {
+        if (it != predicates.begin()) {
+            mFunctions += " and ";
+        }
+        mFunctions += *it + "()";
+    }
+    mFunctions += ";\n}\n\n";
+}
+
+void StaticPlanSource::addActivity(const std::string& id,
+                                   const Strings& rules,
+                                   const std::string& ack,
+                                   const std::string& output,
+                                   const std::string& minstart,
+                                   const std::string& maxfinish,
+                                   bool relative, bool human)
+{
+    std::string index = boost::lexical_cast < std::string >(mNbActivities);
+    std::string indices;
+
+    for (Strings::const_iterator it = rules.begin(); it != rules.end();
+         ++it) {
+        std::map < std::string, unsigned int >::const_iterator r =
+            mRuleIndex.find(*it);
+
+        if (r == mRuleIndex.end()) {
+            throw utils::ArgError(fmt(
+                    _("Decision: unknown rule `%1%' of activity `%2%'")) %
+                *it % id);
+        }
+
+        indices += (it == rules.begin() ? "" : ", ") +
+            boost::lexical_cast < std::string >(r->second);
+    }
+
+    mActivityIndex[id] = mNbActivities++;
+
+    mActivities += "            { " + literal(id) + ", ";
+    if (rules.empty()) {
+        mActivities += "0, 0, ";
+    } else {
+        mActivityRules += "        static const unsigned int rules" + index +
+            "[] = { " + indices + " };\n";
+        mActivities += "rules" + index + ", " +
+            boost::lexical_cast < std::string >(rules.size()) + ", ";
+    }
+
+    mActivities += (ack.empty() ? "0" : "&" + mClassname + "::" + ack) +
+        ", ";
+    mActivities += (output.empty() ? "0" : "&" + mClassname + "::" +
+                    output) + ",\n";
+    mActivities += "              " + date(id, minstart, relative, human) +
+        ",\n";
+    mActivities += "              " + date(id, maxfinish, relative, human) +
+        " },\n";
+}
+
+void StaticPlanSource::addPrecedence(const std::string& type,
+                                     const std::string& first,
+                                     const std::string& second,
+                                     const std::string& mintimelag,
+                                     const std::string& maxtimelag)
+{
+    std::map < std::string, unsigned int >::const_iterator x =
+        mActivityIndex.find(first);
+    std::map < std::string, unsigned int >::const_iterator y =
+        mActivityIndex.find(second);
+
+    if (x == mActivityIndex.end() or y == mActivityIndex.end()) {
+        return;
+    }
+
+    if (type != "SS" and type != "FS" and type != "FF") {
+        throw utils::ArgError(fmt(
+                _("Decision: precendence type `%1%' unknown")) % type);
+    }
+
+    mPrecedences += "            { vmd::PrecedenceConstraint::" + type +
+        ", " + boost::lexical_cast < std::string >(x->second) + ", " +
+        boost::lexical_cast < std::string >(y->second) + ", " +
+        (mintimelag.empty() ? "0" : real(mintimelag, "mintimelag")) + ", " +
+        (maxtimelag.empty() ? "vd::infinity" :
+         real(maxtimelag, "maxtimelag")) + " },\n";
+    mNbPrecedences++;
+}
+
+std::string StaticPlanSource::init() const
+{
+    const std::string esp8 = "        ";
+    const std::string esp12 = esp8 + "    ";
+    std::string result = esp8 + "//Plan initialisation (static tables)\n" +
+        mActivityRules;
+
+    if (mNbRules) {
+        result += esp8 + "static const vmd::StaticRule < " + mClassname +
+            " > rules[] = {\n" + mRules + esp8 + "};\n";
+    }
+    if (mNbActivities) {
+        result += esp8 + "static const vmd::StaticActivity < " + mClassname +
+            " > activities[] = {\n" + mActivities + esp8 + "};\n";
+    }
+    if (mNbPrecedences) {
+        result += esp8 + "static const vmd::StaticPrecedence precedences[] = "
+            "{\n" + mPrecedences + esp8 + "};\n";
+    }
+
+    result += esp8 + "vmd::StaticPlan::fill < " + mClassname +
+        " >(*this, 0,\n" + esp12 + (mNbRules ? "rules, " : "0, ") +
+        boost::lexical_cast < std::string >(mNbRules) + ",\n" + esp12 +
+        (mNbActivities ? "activities, " : "0, ") +
+        boost::lexical_cast < std::string >(mNbActivities) + ",\n" + esp12 +
+        (mNbPrecedences ? "precedences, " : "0, ") +
+        boost::lexical_cast < std::string >(mNbPrecedences) + ");\n";
+
+    return result;
+}
+
+std::string StaticPlanSource::literal(const std::string& str)
+{
+    std::string result("\"");
+
+    for (std::string::const_iterator it = str.begin(); it != str.end();
+         ++it) {
+        unsigned char c = static_cast < unsigned char >(*it);
+
+        switch (c) {
+        case '"':
+            result += "\\\"";
+            break;
+        case '\\':
+            result += "\\\\";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        case '\t':
+            result += "\\t";
+            break;
+        case '\r':
+            result += "\\r";
+            break;
+        case '?': // avoid the trigraphs
+            result += "\\?";
+            break;
+        default:
+            if (c < 0x20 or c == 0x7f) {
+                char buffer[8];
+                std::sprintf(buffer, "\\%03o", c);
+                result += buffer;
+            } else {
+                result += *it;
+            }
+        }
+    }
+
+    return result + "\"";
+}
+
+std::string StaticPlanSource::date(const std::string& activity,
+                                   const std::string& date, bool relative,
+                                   bool human)
+{
+    std::string value = boost::trim_copy(date);
+
+    if (value.empty()) {
+        return "{ vmd::StaticDate::None, 0, 0, 0, 0 }";
+    } else if (not relative) {
+        return "{ vmd::StaticDate::Absolute, " +
+            real(value, "date of " + activity) + ", 0, 0, 0 }";
+    } else if (not human) {
+        return "{ vmd::StaticDate::Relative, " +
+            real(value, "date of " + activity) + ", 0, 0, 0 }";
+    }
+
+    std::vector < std::string > ymd;
+    boost::split(ymd, value, boost::is_any_of("-"));
+
+    try {
+        if (ymd.size() == 3) {
+            return "{ vmd::StaticDate::RelativeDate, 0, " +
+                boost::lexical_cast < std::string >(
+                    boost::lexical_cast < int >(ymd[0])) + ", " +
+                boost::lexical_cast < std::string >(
+                    boost::lexical_cast < int >(ymd[1])) + ", " +
+                boost::lexical_cast < std::string >(
+                    boost::lexical_cast < int >(ymd[2])) + " }";
+        }
+    } catch (const boost::bad_lexical_cast& /*e*/) {
+    }
+
+    throw utils::ArgError(fmt(
+            _("Decision: bad relative date `%1%' of activity `%2%'")) %
+        value % activity);
+}
+
+std::string StaticPlanSource::real(const std::string& value,
+                                   const std::string& what)
+{
+    double result;
+
+    try {
+        result = boost::lexical_cast < double >(boost::trim_copy(value));
+    } catch (const boost::bad_lexical_cast& /*e*/) {
+        throw utils::ArgError(fmt(_("Decision: bad real `%1%' for %2%")) %
+                              value % what);
+    }
+
+    if (result != result or
+        result == std::numeric_limits < double >::infinity() or
+        result == -std::numeric_limits < double >::infinity()) {
+        throw utils::ArgError(fmt(_("Decision: bad real `%1%' for %2%")) %
+                              value % what);
+    }
+
+    std::ostringstream out;
+    out.precision(std::numeric_limits < double >::digits10 + 2);
+    out << result;
+
+    return out.str();
+}
+
+}}} // namespace vle model decision
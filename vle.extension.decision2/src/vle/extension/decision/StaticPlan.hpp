@@ -0,0 +1,322 @@
+/*
+ * @file vle/extension/decision/StaticPlan.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef VLE_EXT_DECISION_STATICPLAN_HPP
+#define VLE_EXT_DECISION_STATICPLAN_HPP 1
+
+#include <vle/extension/decision/KnowledgeBase.hpp>
+#include <vle/extension/decision/PrecedenceConstraint.hpp>
+#include <vle/devs/Time.hpp>
+#include <boost/bind.hpp>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief A date of a static plan. It is the C++ form of the minstart and
+ * maxfinish dates of a temporal block.
+ */
+struct StaticDate
+{
+    enum Type {
+        None, /**< No date. */
+        Absolute, /**< value. */
+        Relative, /**< loadTime + value. */
+        RelativeDate /**< "+year-month-day". */
+    };
+
+    Type type;
+    double value; /**< Date or offset if Absolute or Relative. */
+    int year; /**< Years to add to the load time if RelativeDate. */
+    int month;
+    int day;
+};
+
+/**
+ * @brief A rule of a static plan. The predicates of the rule are compiled
+ * into one member function of the knowledge base.
+ */
+template < typename X >
+struct StaticRule
+{
+    typedef bool (X::*Function)(const std::string&, const std::string&,
+                                const PredicateParameters&) const;
+
+    const char* id;
+    Function function; /**< 0 if the rule has no predicate. */
+};
+
+/**
+ * @brief An activity of a static plan. Rules are indices into the rules
+ * table, functions are members of the knowledge base or 0.
+ */
+template < typename X >
+struct StaticActivity
+{
+    typedef void (X::*AckFunction)(const std::string&, const Activity&);
+    typedef void (X::*OutFunction)(const std::string&, const Activity&,
+                                   devs::ExternalEventList&);
+
+    const char* id;
+    const unsigned int* rules;
+    unsigned int rulesSize;
+    AckFunction ack;
+    OutFunction output;
+    StaticDate minstart;
+    StaticDate maxfinish;
+};
+
+/**
+ * @brief A precedence constraint of a static plan. Activities are indices
+ * into the activities table.
+ */
+struct StaticPrecedence
+{
+    PrecedenceConstraint::Type type;
+    unsigned int first;
+    unsigned int second;
+    double mintimelag;
+    double maxtimelag;
+};
+
+/**
+ * @brief StaticPlan fills a plan from the C++ tables generated by the gvle
+ * decision plugin. Nothing is parsed and the predicates are bound directly
+ * to the member functions of the knowledge base, without lookup into the
+ * PredicatesTable.
+ * @code
+ * static const vmd::StaticRule < Farmer > rules[] = {
+ *     { "rule1", &Farmer::rule_rule1 } };
+ * static const unsigned int rules_a[] = { 0 };
+ * static const vmd::StaticActivity < Farmer > activities[] = {
+ *     { "a", rules_a, 1, 0, &Farmer::out,
+ *       { vmd::StaticDate::Relative, 10, 0, 0, 0 },
+ *       { vmd::StaticDate::None, 0, 0, 0, 0 } } };
+ *
+ * vmd::StaticPlan::fill(*this, 0, rules, 1, activities, 1, 0, 0);
+ * @endcode
+ */
+class StaticPlan
+{
+public:
+    /**
+     * @brief Add the rules, the activities and the precedence constraints
+     * of the tables to the plan of the knowledge base.
+     * @param kb, the knowledge base which receives the plan.
+     * @param loadTime, the time of plan loading.
+     * @throw utils::ArgError if an index is out of range or if an
+     * activity already exists.
+     */
+    template < typename X >
+    static void fill(X& kb, const devs::Time& loadTime,
+                     const StaticRule < X >* rules, std::size_t rulesSize,
+                     const StaticActivity < X >* acts, std::size_t actsSize,
+                     const StaticPrecedence* precs, std::size_t precsSize)
+    {
+        std::vector < Rules::const_iterator > rls(rulesSize);
+        std::vector < Activities::iterator > its;
+        Activities& activities = kb.plan().activities();
+
+        for (std::size_t i = 0; i < rulesSize; ++i) {
+            Rule& rule = kb.addRule(rules[i].id);
+
+            if (rules[i].function) {
+                rule.add(PredicateFunction(
+                        boost::bind(rules[i].function, &kb, _1, _2, _3)));
+            }
+            rls[i] = kb.rules().lookup(rules[i].id);
+        }
+
+        its.reserve(actsSize);
+        for (std::size_t i = 0; i < actsSize; ++i) {
+            Activity& act = activities.add(acts[i].id);
+
+            for (unsigned int j = 0; j < acts[i].rulesSize; ++j) {
+                std::size_t r = index(acts[i].rules[j], rulesSize);
+
+                act.addRule(rls[r]);
+            }
+
+            if (acts[i].ack) {
+                act.addAcknowledgeFunction(
+                    boost::bind(acts[i].ack, &kb, _1, _2));
+            }
+
+            if (acts[i].output) {
+                act.addOutputFunction(
+                    boost::bind(acts[i].output, &kb, _1, _2, _3));
+            }
+
+            setTemporal(act, acts[i].minstart, acts[i].maxfinish, loadTime);
+            its.push_back(activities.get(acts[i].id));
+        }
+
+        for (std::size_t i = 0; i < precsSize; ++i) {
+            activities.addPrecedenceConstraint(
+                PrecedenceConstraint(its[index(precs[i].first, actsSize)],
+                                     its[index(precs[i].second, actsSize)],
+                                     precs[i].type,
+                                     precs[i].mintimelag,
+                                     precs[i].maxtimelag));
+        }
+    }
+
+private:
+    /**
+     * @brief Assign the time window of an activity as Plan does for a
+     * temporal block with minstart and maxfinish dates.
+     */
+    static void setTemporal(Activity& activity, const StaticDate& minstart,
+                            const StaticDate& maxfinish,
+                            const devs::Time& loadTime);
+
+    static Plan::DateResult evaluate(const StaticDate& date,
+                                     const devs::Time& loadTime);
+
+    /**
+     * @brief Check an index of a table.
+     * @throw utils::ArgError if index is greater or equal than size.
+     */
+    static std::size_t index(std::size_t index, std::size_t size);
+};
+
+/**
+ * @brief StaticPlanSource generates the C++ source of the tables of a
+ * StaticPlan. It is used by the gvle decision plugin: the rules, the
+ * activities and the precedences are added in the order of the tables,
+ * then init() returns the code of the constructor which fills the plan and
+ * functions() the member functions of the rules.
+ * @code
+ * StaticPlanSource source("Farmer");
+ * source.addRule("rule1", predicates);
+ * source.addActivity("a", rules, "", "out", "10", "", true, false);
+ * std::string code = source.init();
+ * @endcode
+ */
+class StaticPlanSource
+{
+public:
+    typedef std::vector < std::string > Strings;
+
+    /**
+     * @brief Build an empty source.
+     * @param classname, the knowledge base class of the generated model.
+     */
+    StaticPlanSource(const std::string& classname);
+
+    /**
+     * @brief Add a rule, its predicates are member functions of the class
+     * without parameter.
+     */
+    void addRule(const std::string& id, const Strings& predicates);
+
+    /**
+     * @brief Add an activity.
+     * @param id, the identifier of the activity.
+     * @param rules, the rules of the activity, added before.
+     * @param ack, the acknowledge member function or an empty string.
+     * @param output, the output member function or an empty string.
+     * @param minstart, the minstart date as written in the plan or an
+     * empty string.
+     * @param maxfinish, the maxfinish date as written in the plan or an
+     * empty string.
+     * @param relative, true if the dates are relative to the load time.
+     * @param human, true if the relative dates are "year-month-day" dates.
+     * @throw utils::ArgError if a rule is unknown or a date can not be
+     * read.
+     */
+    void addActivity(const std::string& id, const Strings& rules,
+                     const std::string& ack, const std::string& output,
+                     const std::string& minstart,
+                     const std::string& maxfinish, bool relative,
+                     bool human);
+
+    /**
+     * @brief Add a precedence constraint between two activities added
+     * before. A precedence with an unknown activity is ignored.
+     * @param type, "SS", "FS" or "FF".
+     * @param mintimelag, the time lag or an empty string for 0.
+     * @param maxtimelag, the time lag or an empty string for infinity.
+     * @throw utils::ArgError if a time lag is not a real.
+     */
+    void addPrecedence(const std::string& type, const std::string& first,
+                       const std::string& second,
+                       const std::string& mintimelag,
+                       const std::string& maxtimelag);
+
+    /**
+     * @brief Get the code of the constructor which fills the plan.
+     */
+    std::string init() const;
+
+    /**
+     * @brief Get the member functions of the rules.
+     */
+    const std::string& functions() const { return mFunctions; }
+
+    /**
+     * @brief Get the C++ string literal of a string.
+     */
+    static std::string literal(const std::string& str);
+
+    /**
+     * @brief Get the StaticDate initializer of a date of an activity.
+     * @throw utils::ArgError if the date can not be read.
+     */
+    static std::string date(const std::string& activity,
+                            const std::string& date, bool relative,
+                            bool human);
+
+private:
+    /**
+     * @brief Get a real as written in the plan as a C++ literal.
+     * @throw utils::ArgError if value is not a finite real.
+     */
+    static std::string real(const std::string& value,
+                            const std::string& what);
+
+    std::string mClassname;
+    std::map < std::string, unsigned int > mRuleIndex;
+    std::map < std::string, unsigned int > mActivityIndex;
+    std::string mRules;
+    std::string mActivities;
+    std::string mPrecedences;
+    std::string mActivityRules;
+    std::string mFunctions;
+    unsigned int mNbRules;
+    unsigned int mNbActivities;
+    unsigned int mNbPrecedences;
+};
+
+}}} // namespace vle model decision
+
+#endif
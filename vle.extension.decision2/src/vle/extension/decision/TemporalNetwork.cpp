@@ -0,0 +1,543 @@
+/*
+ * @file vle/extension/decision/TemporalNetwork.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <vle/extension/decision/TemporalNetwork.hpp>
+
+namespace vle { namespace extension { namespace decision {
+
+namespace {
+
+devs::Time earliest(const Activity& activity)
+{
+    if (activity.date() & Activity::START) {
+        return activity.start();
+    } else if (activity.date() & Activity::MINS) {
+        return activity.minstart();
+    }
+    return devs::negativeInfinity;
+}
+
+devs::Time latest(const Activity& activity)
+{
+    if (activity.date() & Activity::FINISH) {
+        return activity.finish();
+    } else if (activity.date() & Activity::MAXF) {
+        return activity.maxfinish();
+    }
+    return devs::infinity;
+}
+
+} // anonymous namespace
+
+void TemporalNetwork::propagate(activities_t& activities,
+                                const PrecedencesGraph& graph,
+                                const devs::Time& time)
+{
+    m_time = time;
+    ++m_propagations;
+    m_nbVisits = 0;
+    m_changed.clear();
+
+    if (m_rebuild) {
+        build(activities);
+    } else {
+        for (std::vector < std::pair < iterator, bool > >::iterator it =
+             m_touched.begin(); it != m_touched.end(); ++it) {
+            index_type i;
+            bool constraints = it->second;
+
+            if (not find(&it->first->second, &i)) {
+                i = insert(it->first);
+                constraints = true;
+            }
+
+            if ((seed(i) or constraints) and not m_reset[2 * i]) {
+                reset(2 * i);
+            }
+        }
+        m_touched.clear();
+
+        /*
+         * The cone of the touched nodes is closed under the successors:
+         * the bounds of the other nodes do not depend on the touched ones.
+         * Each node of the cone starts again from its own bounds and
+         * relaxes the constraints of its predecessors.
+         */
+        for (std::vector < index_type >::size_type k = 0; k < m_cone.size();
+             ++k) {
+            index_type node = m_cone[k];
+            PrecedenceConstraint::Type type;
+
+            if (node % 2 == 0) {
+                if (not m_reset[node + 1]) {
+                    reset(node + 1);
+                }
+                type = PrecedenceConstraint::SS;
+            } else {
+                type = PrecedenceConstraint::FS;
+            }
+
+            PrecedencesGraph::findOut out =
+                graph.findPrecedenceOut(m_activities[node / 2]);
+            for (PrecedencesGraph::iteratorOut it = out.first;
+                 it != out.second; ++it) {
+                index_type successor;
+
+                if (it->type() == type and
+                    it->second()->second.waitAllFsBeforeStart() and
+                    find(&it->second()->second, &successor) and
+                    not m_reset[2 * successor]) {
+                    reset(2 * successor);
+                }
+            }
+        }
+
+        for (std::vector < index_type >::iterator it = m_cone.begin();
+             it != m_cone.end(); ++it) {
+            pull(*it, graph);
+            push(*it);
+        }
+    }
+
+    relaxAll(graph);
+
+    if (m_inconsistent) {
+        m_deadlines.clear();
+        for (index_type i = 0; i < m_activities.size(); ++i) {
+            if (m_alive[i]) {
+                m_changed.push_back(m_activities[i]);
+            }
+        }
+    } else {
+        for (std::vector < index_type >::iterator it = m_cone.begin();
+             it != m_cone.end(); ++it) {
+            if (*it % 2 == 0) {
+                m_changed.push_back(m_activities[*it / 2]);
+                schedule(*it / 2);
+            }
+        }
+        expire();
+    }
+
+    for (std::vector < index_type >::iterator it = m_cone.begin();
+         it != m_cone.end(); ++it) {
+        m_reset[*it] = false;
+    }
+    m_cone.clear();
+}
+
+void TemporalNetwork::touch(iterator activity, bool constraints)
+{
+    if (not m_rebuild) {
+        m_touched.push_back(std::make_pair(activity, constraints));
+    }
+}
+
+void TemporalNetwork::erase(iterator activity, const PrecedencesGraph& graph)
+{
+    std::vector < std::pair < iterator, bool > >::iterator last =
+        m_touched.begin();
+
+    for (std::vector < std::pair < iterator, bool > >::iterator it =
+         m_touched.begin(); it != m_touched.end(); ++it) {
+        if (it->first != activity) {
+            *last++ = *it;
+        }
+    }
+    m_touched.erase(last, m_touched.end());
+
+    index_type i;
+
+    if (m_rebuild or not find(&activity->second, &i)) {
+        return;
+    }
+
+    PrecedencesGraph::findOut out = graph.findPrecedenceOut(activity);
+    for (PrecedencesGraph::iteratorOut it = out.first; it != out.second;
+         ++it) {
+        index_type successor;
+
+        if (find(&it->second()->second, &successor)) {
+            touch(m_activities[successor], true);
+        }
+    }
+
+    m_deadlines.erase(activity);
+    m_index.erase(&activity->second);
+    m_alive[i] = false;
+    m_free.push_back(i);
+
+    for (index_type node = 2 * i; node < 2 * i + 2; ++node) {
+        m_lower[node] = m_seedLower[node] = devs::negativeInfinity;
+        m_offset[node] = m_seedOffset[node] = devs::negativeInfinity;
+        m_upper[node] = m_seedUpper[node] = devs::infinity;
+        m_fixed[node] = m_seedFixed[node] = false;
+    }
+}
+
+bool TemporalNetwork::infeasible(const Activity* activity) const
+{
+    index_type i;
+
+    if (m_inconsistent or not find(activity, &i) or m_fixed[2 * i]) {
+        return false;
+    }
+
+    return m_upper[2 * i] < lower(2 * i);
+}
+
+devs::Time TemporalNetwork::earliestStart(const Activity* activity) const
+{
+    index_type i;
+
+    if (m_inconsistent or not find(activity, &i)) {
+        return devs::negativeInfinity;
+    }
+
+    return lower(2 * i);
+}
+
+devs::Time TemporalNetwork::latestStart(const Activity* activity) const
+{
+    index_type i;
+
+    if (m_inconsistent or not find(activity, &i)) {
+        return devs::infinity;
+    }
+
+    return m_upper[2 * i];
+}
+
+devs::Time TemporalNetwork::startOffset(const Activity* activity) const
+{
+    index_type i;
+
+    if (m_inconsistent or not find(activity, &i)) {
+        return devs::negativeInfinity;
+    }
+
+    return m_offset[2 * i];
+}
+
+void TemporalNetwork::clear()
+{
+    m_activities.clear();
+    m_alive.clear();
+    m_free.clear();
+    m_index.clear();
+    m_lower.clear();
+    m_offset.clear();
+    m_upper.clear();
+    m_fixed.clear();
+    m_seedLower.clear();
+    m_seedOffset.clear();
+    m_seedUpper.clear();
+    m_seedFixed.clear();
+    m_queued.clear();
+    m_reset.clear();
+    m_visits.clear();
+    m_queue.clear();
+    m_touched.clear();
+    m_cone.clear();
+    m_deadlines.clear();
+    m_changed.clear();
+    m_inconsistent = false;
+    m_rebuild = true;
+}
+
+void TemporalNetwork::build(activities_t& activities)
+{
+    clear();
+    m_rebuild = false;
+
+    for (iterator it = activities.begin(); it != activities.end(); ++it) {
+        index_type i = insert(it);
+
+        seed(i);
+        reset(2 * i);
+        reset(2 * i + 1);
+        push(2 * i);
+        push(2 * i + 1);
+    }
+}
+
+TemporalNetwork::index_type TemporalNetwork::insert(iterator activity)
+{
+    index_type i;
+
+    if (m_free.empty()) {
+        i = m_activities.size();
+        m_activities.push_back(activity);
+        m_alive.push_back(true);
+
+        index_type nodes = 2 * m_activities.size();
+        m_lower.resize(nodes, devs::negativeInfinity);
+        m_offset.resize(nodes, devs::negativeInfinity);
+        m_upper.resize(nodes, devs::infinity);
+        m_fixed.resize(nodes, false);
+        m_seedLower.resize(nodes, devs::negativeInfinity);
+        m_seedOffset.resize(nodes, devs::negativeInfinity);
+        m_seedUpper.resize(nodes, devs::infinity);
+        m_seedFixed.resize(nodes, false);
+        m_queued.resize(nodes, false);
+        m_reset.resize(nodes, false);
+        m_visits.resize(nodes, 0);
+    } else {
+        i = m_free.back();
+        m_free.pop_back();
+        m_activities[i] = activity;
+        m_alive[i] = true;
+    }
+
+    m_index[&activity->second] = i;
+    return i;
+}
+
+/*
+ * A failed activity keeps its nodes but they neither bound nor are bounded
+ * by anything: their bounds are infinite and fixed.
+ */
+bool TemporalNetwork::seed(index_type i)
+{
+    const Activity& activity = m_activities[i]->second;
+    devs::Time lower[2] = { devs::negativeInfinity, devs::negativeInfinity };
+    devs::Time offset[2] = { devs::negativeInfinity, devs::negativeInfinity };
+    devs::Time upper[2] = { devs::infinity, devs::infinity };
+    bool fixed[2] = { true, true };
+
+    if (not activity.isInFailedState()) {
+        fixed[0] = false;
+        fixed[1] = false;
+
+        if (activity.isInWaitState()) {
+            lower[0] = earliest(activity);
+            offset[0] = 0.0;
+            upper[0] = latest(activity);
+        } else if (not devs::isNegativeInfinity(activity.startedDate())) {
+            lower[0] = activity.startedDate();
+            upper[0] = activity.startedDate();
+            fixed[0] = true;
+        }
+
+        if (activity.isInDoneState()) {
+            lower[1] = activity.doneDate();
+            upper[1] = activity.doneDate();
+            fixed[1] = true;
+        } else {
+            offset[1] = 0.0;
+            upper[1] = latest(activity);
+        }
+    }
+
+    bool changed = false;
+
+    for (int k = 0; k < 2; ++k) {
+        index_type node = 2 * i + k;
+
+        if (m_seedLower[node] != lower[k] or
+            m_seedOffset[node] != offset[k] or
+            m_seedUpper[node] != upper[k] or
+            m_seedFixed[node] != fixed[k]) {
+            m_seedLower[node] = lower[k];
+            m_seedOffset[node] = offset[k];
+            m_seedUpper[node] = upper[k];
+            m_seedFixed[node] = fixed[k];
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+void TemporalNetwork::reset(index_type node)
+{
+    m_lower[node] = m_seedLower[node];
+    m_offset[node] = m_seedOffset[node];
+    m_upper[node] = m_seedUpper[node];
+    m_fixed[node] = m_seedFixed[node];
+    m_visits[node] = 0;
+    m_reset[node] = true;
+    m_cone.push_back(node);
+}
+
+void TemporalNetwork::pull(index_type node, const PrecedencesGraph& graph)
+{
+    if (node % 2 == 1) {
+        relax(node - 1, node, 0.0, devs::infinity);
+        return;
+    }
+
+    iterator activity = m_activities[node / 2];
+
+    if (not activity->second.waitAllFsBeforeStart()) {
+        return;
+    }
+
+    PrecedencesGraph::findIn in = graph.findPrecedenceIn(activity);
+    for (PrecedencesGraph::iteratorIn it = in.first; it != in.second; ++it) {
+        index_type predecessor;
+
+        if (find(&it->first()->second, &predecessor)) {
+            if (it->type() == PrecedenceConstraint::SS) {
+                relax(2 * predecessor, node, it->mintimelag(),
+                      it->maxtimelag());
+            } else if (it->type() == PrecedenceConstraint::FS) {
+                relax(2 * predecessor + 1, node, it->mintimelag(),
+                      it->maxtimelag());
+            }
+        }
+    }
+}
+
+void TemporalNetwork::relaxAll(const PrecedencesGraph& graph)
+{
+    index_type nodes = 2 * m_activities.size();
+
+    while (not m_queue.empty()) {
+        index_type node = m_queue.front();
+        m_queue.pop_front();
+        m_queued[node] = false;
+        ++m_nbVisits;
+
+        if (++m_visits[node] > nodes) {
+            for (std::deque < index_type >::iterator it = m_queue.begin();
+                 it != m_queue.end(); ++it) {
+                m_queued[*it] = false;
+            }
+            m_queue.clear();
+            m_inconsistent = true;
+            m_rebuild = true;
+            break;
+        }
+
+        iterator activity = m_activities[node / 2];
+        PrecedenceConstraint::Type type;
+
+        if (node % 2 == 0) {
+            if (relax(node, node + 1, 0.0, devs::infinity)) {
+                push(node + 1);
+            }
+            type = PrecedenceConstraint::SS;
+        } else {
+            type = PrecedenceConstraint::FS;
+        }
+
+        PrecedencesGraph::findOut out = graph.findPrecedenceOut(activity);
+        for (PrecedencesGraph::iteratorOut it = out.first; it != out.second;
+             ++it) {
+            index_type successor;
+
+            if (it->type() == type and
+                it->second()->second.waitAllFsBeforeStart() and
+                find(&it->second()->second, &successor) and
+                relax(node, 2 * successor, it->mintimelag(),
+                      it->maxtimelag())) {
+                push(2 * successor);
+            }
+        }
+    }
+}
+
+/*
+ * The lower bound of a start node grows with the date: an activity in
+ * wait state becomes infeasible as soon as the date is greater than
+ * m_upper - m_offset.
+ */
+void TemporalNetwork::schedule(index_type i)
+{
+    iterator activity = m_activities[i];
+    index_type start = 2 * i;
+
+    if (not m_alive[i] or not activity->second.isInWaitState() or
+        m_fixed[start] or m_upper[start] < lower(start) or
+        devs::isInfinity(m_upper[start]) or
+        devs::isNegativeInfinity(m_offset[start])) {
+        m_deadlines.erase(activity);
+    } else {
+        m_deadlines.update(activity, m_upper[start] - m_offset[start]);
+    }
+}
+
+void TemporalNetwork::expire()
+{
+    while (not m_deadlines.empty() and m_deadlines.top().date < m_time) {
+        m_changed.push_back(m_deadlines.top().activity);
+        m_deadlines.pop();
+    }
+}
+
+void TemporalNetwork::push(index_type node)
+{
+    if (not m_queued[node]) {
+        m_queued[node] = true;
+        m_queue.push_back(node);
+    }
+}
+
+bool TemporalNetwork::relax(index_type from, index_type to,
+                            const devs::Time& mintimelag,
+                            const devs::Time& maxtimelag)
+{
+    if (m_fixed[to]) {
+        return false;
+    }
+
+    bool changed = false;
+
+    if (m_lower[from] + mintimelag > m_lower[to]) {
+        m_lower[to] = m_lower[from] + mintimelag;
+        changed = true;
+    }
+
+    if (m_offset[from] + mintimelag > m_offset[to]) {
+        m_offset[to] = m_offset[from] + mintimelag;
+        changed = true;
+    }
+
+    if (m_upper[from] + maxtimelag < m_upper[to]) {
+        m_upper[to] = m_upper[from] + maxtimelag;
+        changed = true;
+    }
+
+    return changed;
+}
+
+bool TemporalNetwork::find(const Activity* activity, index_type* node) const
+{
+    index_t::const_iterator it = m_index.find(activity);
+
+    if (it == m_index.end()) {
+        return false;
+    }
+
+    *node = it->second;
+    return true;
+}
+
+}}} // namespace vle model decision
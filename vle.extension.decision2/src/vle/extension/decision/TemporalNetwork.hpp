@@ -0,0 +1,237 @@
+/*
+ * @file vle/extension/decision/TemporalNetwork.hpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef VLE_EXT_DECISION_TEMPORALNETWORK_HPP
+#define VLE_EXT_DECISION_TEMPORALNETWORK_HPP 1
+
+#include <vle/extension/decision/Activity.hpp>
+#include <vle/extension/decision/DeadlineQueue.hpp>
+#include <vle/extension/decision/PrecedencesGraph.hpp>
+#include <vle/devs/Time.hpp>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+namespace vle { namespace extension { namespace decision {
+
+/**
+ * @brief TemporalNetwork propagates the time windows of the activities
+ * along the SS and FS precedence constraints, as a simple temporal
+ * network where each activity has a start and a finish node. The
+ * propagation gives, for each activity in wait state, the earliest and the
+ * latest dates where it can start given its own time window, the dates of
+ * its started and done predecessors and the windows of the others.
+ *
+ * Only the constraints of the predecessors are propagated: an activity is
+ * never constrained by the deadlines of its successors. The FF
+ * constraints and the activities waiting for only one FS are ignored
+ * since they do not forbid the start of the successor.
+ *
+ * The network is kept between two propagations. The Activities container
+ * touches the activities which are added or whose state or constraints
+ * change, and only the nodes reachable from them are computed again.
+ */
+class TemporalNetwork
+{
+public:
+    typedef std::map < std::string, Activity > activities_t;
+    typedef activities_t::iterator iterator;
+    typedef std::vector < iterator > result_t;
+
+    TemporalNetwork()
+        : m_time(devs::negativeInfinity), m_inconsistent(false),
+        m_rebuild(true), m_propagations(0), m_nbVisits(0)
+    {}
+
+    /**
+     * @brief Compute the bounds of the activities at the specified date.
+     * The bounds are relaxed with a label-correcting algorithm, linear on
+     * an acyclic graph. The first propagation, and the one after a clear
+     * or a cycle, builds the whole network. The others reset the nodes
+     * reachable from the touched activities and relax them again from
+     * their predecessors. If a cycle of constraints keeps increasing the
+     * bounds, the propagation stops and no activity is infeasible.
+     * @param activities The activities.
+     * @param graph The precedence constraints of the activities.
+     * @param time The current date.
+     */
+    void propagate(activities_t& activities, const PrecedencesGraph& graph,
+                   const devs::Time& time);
+
+    /**
+     * @brief Notify the network that an activity is added or that its
+     * state may have changed. The next propagation compares the activity
+     * with the bounds it gave to the network.
+     * @param activity The activity.
+     * @param constraints true if the constraints where the activity is
+     * the successor have changed: its bounds are computed again even if
+     * the activity is unchanged.
+     */
+    void touch(iterator activity, bool constraints = false);
+
+    /**
+     * @brief Remove an activity from the network, before its constraints
+     * are removed from the graph. Its successors are touched.
+     * @param activity The activity to remove.
+     * @param graph The precedence constraints of the activities.
+     */
+    void erase(iterator activity, const PrecedencesGraph& graph);
+
+    /**
+     * @brief Get the activities whose start bounds have been computed by
+     * the latest propagation, or which became infeasible since the
+     * previous one because the date has passed their latest start. After
+     * a full build, all the activities of the network.
+     * @return The list of activities.
+     */
+    const result_t& changed() const { return m_changed; }
+
+    /**
+     * @brief Check if an activity in wait state cannot start anymore: its
+     * earliest start is greater than its latest start.
+     * @param activity The activity to check.
+     * @return true if the activity is infeasible.
+     */
+    bool infeasible(const Activity* activity) const;
+
+    /**
+     * @brief Get the earliest start of an activity in wait state, given
+     * that no waiting or started activity can start or finish before the
+     * date of the latest propagation.
+     * @param activity The activity.
+     * @return The earliest start or devs::negativeInfinity if unknown.
+     */
+    devs::Time earliestStart(const Activity* activity) const;
+
+    /**
+     * @brief Get the delay after the current date before which an
+     * activity in wait state cannot start because its predecessors are not
+     * yet reached. The earliest start at a later date is the maximum of
+     * the earliestStart and of this date plus the offset.
+     * @param activity The activity.
+     * @return The offset or devs::negativeInfinity if unknown.
+     */
+    devs::Time startOffset(const Activity* activity) const;
+
+    /**
+     * @brief Get the latest start of an activity in wait state.
+     * @param activity The activity.
+     * @return The latest start or devs::infinity if unknown.
+     */
+    devs::Time latestStart(const Activity* activity) const;
+
+    /**
+     * @brief Check if the latest propagation has been stopped by a cycle.
+     * @return true if the bounds are not reliable.
+     */
+    bool inconsistent() const { return m_inconsistent; }
+
+    /**
+     * @brief Get the number of calls to the propagate function.
+     * @return The number of propagations.
+     */
+    unsigned int propagations() const { return m_propagations; }
+
+    /**
+     * @brief Get the number of nodes relaxed by the latest propagation.
+     * @return The number of visits.
+     */
+    unsigned int visits() const { return m_nbVisits; }
+
+    /**
+     * @brief Forget the network, the next propagation builds it again.
+     */
+    void clear();
+
+private:
+    typedef std::vector < devs::Time > bounds_t;
+    typedef std::vector < unsigned int >::size_type index_type;
+    typedef boost::unordered_map < const Activity*, index_type > index_t;
+
+    /*
+     * Each activity has a start node, at the index 2 * i, and a finish
+     * node, at 2 * i + 1. The lower bound of a node in the current date is
+     * max(m_lower, m_time + m_offset): m_lower comes from the dates and
+     * m_offset from the nodes which are not yet reached. The m_seed
+     * vectors store the bounds of the node given by its own activity,
+     * before the relaxation. The slots of the erased activities are
+     * reused.
+     */
+    std::vector < iterator > m_activities;
+    std::vector < bool >     m_alive;
+    std::vector < index_type > m_free;
+    index_t                  m_index;
+    bounds_t                 m_lower;
+    bounds_t                 m_offset;
+    bounds_t                 m_upper;
+    std::vector < bool >     m_fixed;
+    bounds_t                 m_seedLower;
+    bounds_t                 m_seedOffset;
+    bounds_t                 m_seedUpper;
+    std::vector < bool >     m_seedFixed;
+    std::vector < bool >     m_queued;
+    std::vector < bool >     m_reset;
+    std::vector < unsigned int > m_visits;
+    std::deque < index_type > m_queue;
+    std::vector < std::pair < iterator, bool > > m_touched;
+    std::vector < index_type > m_cone;
+    DeadlineQueue            m_deadlines; /**< Date after which each
+                                            activity in wait state is
+                                            infeasible. */
+    result_t                 m_changed;
+    devs::Time               m_time;
+    bool                     m_inconsistent;
+    bool                     m_rebuild;
+    unsigned int             m_propagations;
+    unsigned int             m_nbVisits;
+
+    void build(activities_t& activities);
+    index_type insert(iterator activity);
+    bool seed(index_type i);
+    void reset(index_type node);
+    void pull(index_type node, const PrecedencesGraph& graph);
+    void relaxAll(const PrecedencesGraph& graph);
+    void expire();
+    void schedule(index_type i);
+
+    void push(index_type node);
+    bool relax(index_type from, index_type to, const devs::Time& mintimelag,
+               const devs::Time& maxtimelag);
+    bool find(const Activity* activity, index_type* node) const;
+
+    devs::Time lower(index_type node) const
+    { return std::max(m_lower[node], m_time + m_offset[node]); }
+};
+
+}}} // namespace vle model decision
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * @file vle/extension/decision/decision-compile.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <vle/extension/decision/PlanBinary.hpp>
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+namespace vmd = vle::extension::decision;
+
+/**
+ * Compile the text plans given on the command line into binary plans. By
+ * default, each plan is written next to its source with the ".bin"
+ * extension: Plan::fillFile and PlanBinaryFile map it while it is newer
+ * than the source.
+ *
+ * @code
+ * decision-compile ITK-BH.txt ITK-MA.txt
+ * decision-compile -o /tmp/itk.bin ITK-BH.txt
+ * @endcode
+ */
+int main(int argc, char* argv[])
+{
+    std::string output;
+    int ret = EXIT_SUCCESS;
+    int i = 1;
+
+    if (argc > 2 and std::strcmp(argv[1], "-o") == 0) {
+        output = argv[2];
+        i = 3;
+
+        if (argc != 4) {
+            std::cerr << "decision-compile: -o expects one plan\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (i >= argc) {
+        std::cerr << "usage: decision-compile [-o output.bin] plan.txt...\n";
+        return EXIT_FAILURE;
+    }
+
+    for (; i < argc; ++i) {
+        std::string destination = output.empty() ?
+            vmd::planBinaryPath(argv[i]) : output;
+
+        try {
+            vmd::compilePlanFile(argv[i], destination);
+            std::cout << argv[i] << " -> " << destination << "\n";
+        } catch (const std::exception& e) {
+            std::cerr << "decision-compile: " << argv[i] << ": " << e.what()
+                << "\n";
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    return ret;
+}
@@ -26,6 +26,7 @@
  */
 
 #include <vle/gvle/modeling/decision/Plugin.hpp>
+#include <vle/extension/decision/StaticPlan.hpp>
 #include <vle/utils/Package.hpp>
 
 namespace vle {
@@ -56,12 +57,13 @@ const std::string PluginDecision::TEMPLATE_DEFINITION =
     "{{end for}};pm:"                                                   \
     "{{for i in parameters}}"                                           \
     "{{parameters^i}}|"                                                 \
-    "{{end for}}"                                                       \
+    "{{end for}};sp:{{staticplan}}"                                     \
     "@@end tag@@\n"                                                     \
     "  */\n\n"                                                          \
     "#include <vle/extension/decision/Agent.hpp>\n"                     \
     "#include <vle/extension/decision/Activity.hpp>\n"                  \
     "#include <vle/extension/decision/KnowledgeBase.hpp>\n"             \
+    "#include <vle/extension/decision/StaticPlan.hpp>\n"                \
     "#include <vle/utils/Package.hpp>\n"                                \
     "#include <sstream>\n"                                              \
     "#include <numeric>\n"                                              \
@@ -106,18 +108,7 @@ const std::string PluginDecision::TEMPLATE_DEFINITION =
     "{{for i in addAckFunctionList}}"                                   \
     "{{addAckFunctionList^i}}"                                          \
     "{{end for}}\n"                                                     \
-    "        //Plan initialisation\n"                                   \
-    "        std::string dataPackageParam;\n"                           \
-    "        if (evts.exist(\"PackageName\"))\n"                        \
-    "          dataPackageParam = evts.getString(\"PackageName\");\n"   \
-    "        else\n"                                                    \
-    "          throw vle::utils::ModellingError(\n"                     \
-    "             \"Package where to find the data is not set\");\n"    \
-    "        vle::utils::Package mPack(dataPackageParam);\n"            \
-    "        std::string filePath =\n"                                  \
-    "        mPack.getDataFile(\"{{classname}}.txt\");\n"               \
-    "        std::ifstream fileStream(filePath.c_str());\n"             \
-    "        KnowledgeBase::plan().fill(fileStream);\n"                 \
+    "{{planinit}}"                                                      \
     "    }\n"                                                           \
     "\n"                                                                \
     "    virtual ~{{classname}}()\n"                                    \
@@ -149,6 +140,7 @@ const std::string PluginDecision::TEMPLATE_DEFINITION =
     "\n{{for i in ackFunctionList}}"                                    \
     "{{ackFunctionList^i}}\n\n"                                         \
     "{{end for}}"                                                       \
+    "{{planrules}}"                                                     \
     "private:\n"                                                        \
     "        //Custom members"                                          \
     "//@@begin:custommembers@@\n"                                       \
@@ -238,6 +230,7 @@ PluginDecision::PluginDecision(const std::string& package,
     mXml->get_widget("imagemenuitem2", mOpenMenu);
     mXml->get_widget("MenuItemChooseFileName", mChooseFileNameMenu);
     mXml->get_widget("imagemenuitem4", mSaveAsMenu);
+    mXml->get_widget("MenuItemStaticPlan", mStaticPlanMenu);
 
     mList.push_back(mIncludeButton->signal_clicked().connect(
             sigc::mem_fun(*this,
@@ -359,6 +352,7 @@ bool PluginDecision::create(vpz::AtomicModel& model,
     mNamespace = namespace_;
 
     mDialog->set_title("Decision - Plugin : " + mPlanFile + ".txt");
+    mStaticPlanMenu->set_active(false);
 
     mDecision = new Decision(mClassname);
 
@@ -423,6 +417,8 @@ void PluginDecision::generateSource(const std::string& classname,
     tpl_.stringSymbol().append("namespace", namespace_);
     tpl_.stringSymbol().append("classname", classname);
     tpl_.stringSymbol().append("planfilename", mPlanFile);
+    tpl_.stringSymbol().append("staticplan",
+                               mStaticPlanMenu->get_active() ? "1" : "0");
 
     // User parameters
     tpl_.stringSymbol().append("include", mInclude);
@@ -705,6 +701,28 @@ void PluginDecision::generateSource(const std::string& classname,
     hierarchicalPred += "@@end:hierarchicalPreds@@*/";
     tpl_.stringSymbol().append("hierarchicalPreds", hierarchicalPred);
 
+    // Plan initialisation
+    std::string planinit, planrules;
+    if (mStaticPlanMenu->get_active()) {
+        generatePlanTables(classname, &planinit, &planrules);
+    } else {
+        planinit =
+            "        //Plan initialisation\n"
+            "        std::string dataPackageParam;\n"
+            "        if (evts.exist(\"PackageName\"))\n"
+            "          dataPackageParam = evts.getString(\"PackageName\");\n"
+            "        else\n"
+            "          throw vle::utils::ModellingError(\n"
+            "             \"Package where to find the data is not set\");\n"
+            "        vle::utils::Package mPack(dataPackageParam);\n"
+            "        std::string filePath =\n"
+            "        mPack.getDataFile(\"" + classname + ".txt\");\n"
+            "        std::ifstream fileStream(filePath.c_str());\n"
+            "        KnowledgeBase::plan().fill(fileStream);\n";
+    }
+    tpl_.stringSymbol().append("planinit", planinit);
+    tpl_.stringSymbol().append("planrules", planrules);
+
     // Custom members
     tpl_.stringSymbol().append("custommembers", mMembers);
 
@@ -844,6 +862,7 @@ bool PluginDecision::modify(vpz::AtomicModel& model,
     parseOutputFunctions(lst);
     parseAckFunctions(lst);
     parseParameters(model, lst, conditions);
+    parseStaticPlan(lst);
 
     // parse the hierarchical predicates informations
     std::string hierP = parseFunction(buffer, "@@begin:hierarchicalPreds@@",
@@ -1065,10 +1084,10 @@ bool PluginDecision::loadPlanFile(std::string filename)
     for (vle::extension::decision::Activities::const_iterator it =
              mDecision->getKnowledgeBase()->activities().begin();
          it != mDecision->getKnowledgeBase()->activities().end(); ++it) {
-        for (vle::extension::decision::Rules::const_iterator it2 =
+        for (vle::extension::decision::SharedRules::const_iterator it2 =
                  it->second.rules().begin();
              it2 != it->second.rules().end(); ++it2) {
-            mDecision->activityModel(it->first)->addRule(it2->first);
+            mDecision->activityModel(it->first)->addRule((*it2)->first);
         }
     }
 
@@ -1360,6 +1379,50 @@ void PluginDecision::generateConditions(vpz::AtomicModel& model,
     model.addCondition(conditionParametersName);
 }
 
+void PluginDecision::generatePlanTables(const std::string& classname,
+                                        std::string* init,
+                                        std::string* functions)
+{
+    vle::extension::decision::StaticPlanSource source(classname);
+
+    for (std::map < std::string, strings_t > ::const_iterator it =
+            mRule.begin(); it != mRule.end(); ++it) {
+        source.addRule(it->first, it->second);
+    }
+
+    // A plan activity has at most one acknowledge and one output function.
+    for (activitiesModel_t::const_iterator it = mDecision->
+            activitiesModel().begin(); it != mDecision->
+            activitiesModel().end(); ++it) {
+        const ActivityModel* act = it->second;
+        strings_t ack = act->getAckFunc();
+        strings_t output = act->getOutputFunc();
+
+        if (ack.size() > 1 or output.size() > 1) {
+            throw utils::ArgError(fmt(_("Decision plugin error, activity "
+                        "`%1%' has several acknowledge or output "
+                        "functions")) % act->name());
+        }
+
+        source.addActivity(act->name(), act->getRules(),
+                           ack.empty() ? std::string() : ack.front(),
+                           output.empty() ? std::string() : output.front(),
+                           act->minstart(), act->maxfinish(),
+                           act->getRelativeDate(), act->isHumanDate());
+    }
+
+    for (precedenceConstraints_t::const_iterator it =
+            mDecision->precedenceConstraints().begin();
+            it != mDecision->precedenceConstraints().end(); ++it) {
+        source.addPrecedence((*it)->cType(), (*it)->source(),
+                             (*it)->destination(), (*it)->actTlMin(),
+                             (*it)->actTlMax());
+    }
+
+    *init = source.init();
+    *functions = source.functions();
+}
+
 void PluginDecision::generateObservables(vpz::AtomicModel& model,
                                     vpz::Observables& observables) {
     std::string observableName((fmt("obs_Decision_%1%") %
@@ -2036,6 +2099,11 @@ void PluginDecision::parsePlanFileName(const strings_t& lst)
     mPlanFile = rules_lst;
 }
 
+void PluginDecision::parseStaticPlan(const strings_t& lst)
+{
+    mStaticPlanMenu->set_active(lst.size() > 8 and lst[8] == "sp:1");
+}
+
 void PluginDecision::decodePredicates(std::string& pPred)
 {
     strings_t preds;
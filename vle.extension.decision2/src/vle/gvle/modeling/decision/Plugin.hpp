@@ -200,6 +200,19 @@ private:
     void generateSource(const std::string& classname,
                         const std::string& namespace_);
 
+/**
+ * @brief Generate the plan as static C++ tables of rules, activities and
+ * precedences filled with vmd::StaticPlan.
+ * @throw utils::ArgError if an activity has several acknowledge or output
+ * functions or if a date or a time lag can not be read.
+ * @param reference to the classname
+ * @param the plan initialisation of the constructor
+ * @param the rules member functions
+ */
+    void generatePlanTables(const std::string& classname,
+                            std::string* init,
+                            std::string* functions);
+
 /**
  * @brief Generate the observables
  * @param reference to the model of the vpz
@@ -359,6 +372,13 @@ private:
 
     void parsePlanFileName(const strings_t& lst);
 
+/**
+ * @brief Parse the generation mode of the plan, text file or static C++
+ * tables.
+ * @param the list of the tag fields
+ */
+    void parseStaticPlan(const strings_t& lst);
+
     void parseParameters(vpz::AtomicModel& model,
                          const strings_t& lst,
                          vpz::Conditions& pConditions);
@@ -498,6 +518,7 @@ strings_t::iterator* generatePred(std::string *pPred,
     Gtk::MenuItem* mOpenMenu;
     Gtk::MenuItem* mChooseFileNameMenu;
     Gtk::MenuItem* mSaveAsMenu;
+    Gtk::CheckMenuItem* mStaticPlanMenu;
 
 // Link to the decision diagram
     Decision* mDecision;
@@ -33,8 +33,11 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/auto_unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
+#include <algorithm>
 #include <iostream>
 #include <iterator>
+#include <cstdlib>
+#include <new>
 #include <vle/value/Double.hpp>
 #include <vle/extension/decision/KnowledgeBase.hpp>
 #include <vle/vle.hpp>
@@ -43,6 +46,31 @@ namespace vmd = vle::extension::decision;
 namespace vd = vle::devs;
 using vle::fmt;
 
+/*
+ * Allocation-counting hook: the global operator new counts its calls
+ * while countAllocations is set.
+ */
+static bool countAllocations = false;
+static unsigned long allocations = 0;
+
+void* operator new(std::size_t size) throw (std::bad_alloc)
+{
+    if (countAllocations) {
+        ++allocations;
+    }
+
+    void* result = std::malloc(size ? size : 1);
+    if (not result) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+void operator delete(void* ptr) throw ()
+{
+    std::free(ptr);
+}
+
 namespace vle { namespace extension { namespace decision { namespace ex {
 
 class KnowledgeBase : public vmd::KnowledgeBase
@@ -264,6 +292,70 @@ public:
     }
 };
 
+class KnowledgeBaseCache : public vmd::KnowledgeBase
+{
+public:
+    KnowledgeBaseCache()
+        : today(0), nbGood(0), nbPlot(0)
+    {
+        addFact("today", boost::bind(&vmd::ex::KnowledgeBaseCache::date,
+                                     this, _1));
+
+        Predicate good("good",
+                       boost::bind(&vmd::ex::KnowledgeBaseCache::isGood,
+                                   this, _1, _2, _3));
+        good.setScope(PredicateGlobal);
+        mPredicates.add(good);
+
+        Predicate plot("plot",
+                       boost::bind(&vmd::ex::KnowledgeBaseCache::isPlotReady,
+                                   this, _1, _2, _3));
+        plot.setScope(PredicatePerKey,
+                      boost::bind(&vmd::ex::KnowledgeBaseCache::plotOf,
+                                  this, _1));
+        mPredicates.add(plot);
+
+        vmd::Rule& rule = addRule("Rule");
+        rule.add(&mPredicates.get("good"));
+        rule.add(&mPredicates.get("plot"));
+
+        const char* names[] = { "p1-a", "p1-b", "p2-a", "p2-b" };
+        for (int i = 0; i < 4; ++i) {
+            addActivity(names[i]).addRule("Rule", rule);
+        }
+    }
+
+    virtual ~KnowledgeBaseCache() {}
+
+    void date(const vle::value::Value& val)
+    {
+        today = val.toDouble().value();
+    }
+
+    bool isGood(const std::string&, const std::string&,
+                const PredicateParameters&)
+    {
+        nbGood++;
+        return today > 0.0;
+    }
+
+    bool isPlotReady(const std::string&, const std::string&,
+                     const PredicateParameters&)
+    {
+        nbPlot++;
+        return today > 20.0;
+    }
+
+    std::string plotOf(const std::string& activity) const
+    {
+        return activity.substr(0, 2);
+    }
+
+    Predicates mPredicates;
+    double today;
+    int nbGood, nbPlot;
+};
+
 }}}} // namespace vle ext decision
 
 BOOST_AUTO_TEST_CASE(kb)
@@ -529,3 +621,842 @@ BOOST_AUTO_TEST_CASE(Activities_test_slot_function)
     std::cout << fmt("%1% %2%\n") % base.getNumberOfOut() %
         base.getNumberOfUpdate();
 }
+
+BOOST_AUTO_TEST_CASE(Activities_differential_rules)
+{
+    vle::Init app;
+
+    vmd::ex::KnowledgeBase base;
+    base.plan().activities().setProcessMode(vmd::Activities::Differential);
+
+    vmd::Activities::result_t lst;
+    double date = 0.0;
+    ++date;
+
+    base.applyFact("today", vle::value::Double(16));
+    base.processChanges(date);
+    lst = base.startedActivities();
+    BOOST_REQUIRE_EQUAL(lst.size(), vmd::Activities::result_t::size_type(0));
+    ++date;
+
+    base.applyFact("today", vle::value::Double(21));
+    base.processChanges(date);
+    lst = base.startedActivities();
+    BOOST_REQUIRE_EQUAL(lst.size(), vmd::Activities::result_t::size_type(2));
+    ++date;
+
+    base.applyFact("today", vle::value::Double(18));
+    base.processChanges(date);
+    lst = base.startedActivities();
+    BOOST_REQUIRE_EQUAL(lst.size(), vmd::Activities::result_t::size_type(1));
+    lst = base.waitedActivities();
+    BOOST_REQUIRE_EQUAL(lst.size(), vmd::Activities::result_t::size_type(1));
+    lst = base.failedActivities();
+    BOOST_REQUIRE_EQUAL(lst.size(), vmd::Activities::result_t::size_type(1));
+    ++date;
+
+    base.applyFact("today", vle::value::Double(22));
+    base.processChanges(date);
+    lst = base.startedActivities();
+    BOOST_REQUIRE_EQUAL(lst.size(), vmd::Activities::result_t::size_type(2));
+}
+
+BOOST_AUTO_TEST_CASE(Activities_differential_graph)
+{
+    vle::Init app;
+
+    vmd::ex::KnowledgeBaseGraph2 base;
+    base.plan().activities().setProcessMode(vmd::Activities::Differential);
+
+    const char* names[] = { "A", "B", "C", "D", "E", "F", "G" };
+
+    for (int i = 0; i < 7; ++i) {
+        base.processChanges(0.0);
+        base.processChanges(0.0);
+        BOOST_REQUIRE(base.activities().get(names[i])->second.isInStartedState());
+        base.setActivityDone(names[i], 0.0);
+    }
+
+    base.processChanges(0.0);
+    BOOST_REQUIRE_EQUAL(base.activities().endedAct().size(),
+                        vmd::Activities::result_t::size_type(7));
+}
+
+BOOST_AUTO_TEST_CASE(Activities_differential_slot_function)
+{
+    vle::Init app;
+
+    vmd::ex::KB5 base;
+    base.plan().activities().setProcessMode(vmd::Activities::Differential);
+
+    BOOST_REQUIRE_CLOSE((double)base.duration(0.), 0., 1.);
+    base.processChanges(0.);
+    base.setActivityDone("A", 0.5);
+    BOOST_REQUIRE_CLOSE((double)base.duration(.5), .5, 1.);
+    base.processChanges(1.);
+    base.setActivityDone("B", 1.);
+    BOOST_REQUIRE_CLOSE((double)base.duration(1.), 0., 1.);
+    base.processChanges(1.);
+    base.setActivityDone("C", 1.5);
+    base.processChanges(2.);
+    base.setActivityDone("D", 2.5);
+    base.processChanges(3.);
+    base.setActivityDone("E", 3.5);
+    base.processChanges(4.);
+    base.setActivityDone("F", 4.5);
+    base.processChanges(5.);
+
+    BOOST_REQUIRE_EQUAL(base.getNumberOfUpdate(), 12);
+}
+
+BOOST_AUTO_TEST_CASE(Activities_differential_random)
+{
+    vle::Init app;
+
+    unsigned long seed = 12345;
+
+    for (int run = 0; run < 20; ++run) {
+        vmd::KnowledgeBase base;
+        std::vector < std::string > names;
+
+        for (int i = 0; i < 30; ++i) {
+            seed = (seed * 1103515245 + 12345) % 2147483648UL;
+            double start = (seed % 20) / 2.0;
+            double finish = start + 1.0 + (seed % 7);
+            names.push_back((fmt("act%1%") % i).str());
+            base.addActivity(names.back(), start, finish);
+        }
+
+        for (int i = 1; i < 30; ++i) {
+            seed = (seed * 1103515245 + 12345) % 2147483648UL;
+            const std::string& first = names[seed % i];
+            double lag = (seed % 3);
+
+            switch ((seed / 3) % 3) {
+            case 0:
+                base.addFinishToStartConstraint(first, names[i], 0.0,
+                                                lag + 2.0);
+                break;
+            case 1:
+                base.addStartToStartConstraint(first, names[i], lag,
+                                               lag + 3.0);
+                break;
+            default:
+                base.addFinishToFinishConstraint(first, names[i], lag + 4.0);
+                break;
+            }
+        }
+
+        base.plan().activities().setProcessMode(
+            vmd::Activities::Differential);
+
+        for (double time = 0.0; time < 25.0; time += 0.5) {
+            base.processChanges(time);
+
+            vmd::Activities::result_t started =
+                base.activities().startedAct();
+            for (vmd::Activities::result_t::iterator it = started.begin();
+                 it != started.end(); ++it) {
+                seed = (seed * 1103515245 + 12345) % 2147483648UL;
+                if (seed % 3 == 0) {
+                    base.setActivityDone((*it)->first, time);
+                }
+            }
+
+            base.processChanges(time);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Activities_nextDate_queue)
+{
+    vle::Init app;
+
+    vmd::KnowledgeBase base;
+    unsigned long seed = 4321;
+
+    for (int i = 0; i < 200; ++i) {
+        seed = (seed * 1103515245 + 12345) % 2147483648UL;
+        double start = (seed % 100) / 4.0;
+        double finish = start + (seed % 13) / 2.0;
+
+        vmd::Activity& act = base.addActivity((fmt("act%1%") % i).str());
+        if (seed % 2) {
+            act.initStartTimeFinishTime(start, finish);
+        } else {
+            act.initStartRangeFinishRange(start, start + 1.0, finish + 1.0,
+                                          finish + 2.0);
+        }
+    }
+
+    for (double time = 0.0; time < 40.0; time += 0.25) {
+        double expected = vd::infinity;
+        for (vmd::Activities::const_iterator it = base.activities().begin();
+             it != base.activities().end(); ++it) {
+            vmd::Activity act = it->second;
+            expected = std::min(expected, (double)act.nextTime(time));
+        }
+
+        BOOST_REQUIRE_EQUAL((double)base.nextDate(time), expected);
+
+        base.processChanges(time);
+        vmd::Activities::result_t started = base.activities().startedAct();
+        for (vmd::Activities::result_t::iterator it = started.begin();
+             it != started.end(); ++it) {
+            seed = (seed * 1103515245 + 12345) % 2147483648UL;
+            if (seed % 4 == 0) {
+                base.setActivityDone((*it)->first, time);
+            } else if (seed % 4 == 1) {
+                base.setActivityFailed((*it)->first, time);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Activities_compaction)
+{
+    vle::Init app;
+
+    vmd::ex::KnowledgeBaseGraph2 base;
+    base.plan().activities().setCompaction(true);
+
+    const char* names[] = { "A", "B", "C", "D", "E", "F", "G" };
+
+    for (int i = 0; i < 7; ++i) {
+        base.processChanges(0.0);
+        base.processChanges(0.0);
+        BOOST_REQUIRE(not base.activities().archive().exist(names[i]));
+        BOOST_REQUIRE(base.activities().get(names[i])->second.isInStartedState());
+        base.setActivityDone(names[i], 0.0);
+        base.clearLatestActivitiesLists();
+    }
+
+    base.processChanges(0.0);
+    base.clearLatestActivitiesLists();
+    base.processChanges(0.0);
+
+    const vmd::ActivityArchive& archive = base.activities().archive();
+    BOOST_REQUIRE(not archive.empty());
+    BOOST_REQUIRE_EQUAL(base.activities().endedAct().size() + archive.size(),
+                        vmd::Activities::result_t::size_type(7));
+    BOOST_REQUIRE_EQUAL(base.activities().size() + archive.size(),
+                        vmd::Activities::size_type(7));
+
+    for (vmd::ActivityArchive::const_iterator it = archive.begin();
+         it != archive.end(); ++it) {
+        BOOST_REQUIRE(it->second.isInDoneState());
+        BOOST_REQUIRE(not base.activities().exist(it->first));
+        BOOST_REQUIRE_THROW(base.activities().get(it->first),
+                            vle::utils::ArgError);
+        BOOST_REQUIRE(archive.get(it->first) == it);
+    }
+
+    BOOST_REQUIRE(not archive.precedences().empty());
+    BOOST_REQUIRE_THROW(base.addActivity(archive.begin()->first),
+                        vle::utils::ArgError);
+}
+
+static bool compareName(vmd::Activities::const_iterator x,
+                        vmd::Activities::const_iterator y)
+{
+    return x->first < y->first;
+}
+
+BOOST_AUTO_TEST_CASE(Activities_horizon_index)
+{
+    vle::Init app;
+
+    vmd::KnowledgeBase base;
+    vmd::KnowledgeBase indexed;
+    unsigned long seed = 1357;
+
+    indexed.plan().activities().setHorizonIndex(true);
+    indexed.plan().activities().setProcessMode(vmd::Activities::Incremental);
+    indexed.plan().activities().setCompaction(true);
+
+    for (int i = 0; i < 100; ++i) {
+        seed = (seed * 1103515245 + 12345) % 2147483648UL;
+        double start = (seed % 100) / 4.0;
+        double finish = start + (seed % 13) / 2.0;
+        std::string name = (fmt("act%1%") % i).str();
+
+        if (i % 3 == 0) {
+            base.addActivity(name).initStartRangeFinishRange(
+                start, start + 1.0, finish + 1.0, finish + 2.0);
+            indexed.addActivity(name).initStartRangeFinishRange(
+                start, start + 1.0, finish + 1.0, finish + 2.0);
+        } else {
+            base.addActivity(name, start, finish);
+            indexed.addActivity(name, start, finish);
+        }
+    }
+
+    for (double time = 0.0; time < 40.0; time += 0.5) {
+        base.processChanges(time);
+        indexed.processChanges(time);
+
+        vmd::Activities::result_t started = base.activities().startedAct();
+        for (vmd::Activities::result_t::iterator it = started.begin();
+             it != started.end(); ++it) {
+            seed = (seed * 1103515245 + 12345) % 2147483648UL;
+            if (seed % 4 == 0) {
+                base.setActivityDone((*it)->first, time);
+                indexed.setActivityDone((*it)->first, time);
+            } else if (seed % 4 == 1) {
+                base.setActivityFailed((*it)->first, time);
+                indexed.setActivityFailed((*it)->first, time);
+            }
+        }
+
+        for (double width = 0.0; width < 20.0; width += 4.5) {
+            vmd::Activities::const_result_t expected =
+                base.activities().beforeTimeHorizonAct(time, time + width);
+            vmd::Activities::const_result_t result =
+                indexed.activities().beforeTimeHorizonAct(time, time + width);
+
+            BOOST_REQUIRE_EQUAL(result.size(), expected.size());
+            for (vmd::Activities::const_result_t::size_type i = 1;
+                 i < result.size(); ++i) {
+                std::pair < vle::devs::Time, vle::devs::Time > previous =
+                    result[i - 1]->second.horizonWindow();
+                std::pair < vle::devs::Time, vle::devs::Time > current =
+                    result[i]->second.horizonWindow();
+
+                BOOST_REQUIRE(previous.first < current.first or
+                              (previous.first == current.first and
+                               result[i - 1]->first < result[i]->first));
+            }
+
+            std::sort(result.begin(), result.end(), compareName);
+            for (vmd::Activities::const_result_t::size_type i = 0;
+                 i < result.size(); ++i) {
+                BOOST_REQUIRE_EQUAL(result[i]->first, expected[i]->first);
+            }
+        }
+    }
+
+    BOOST_REQUIRE(indexed.activities().beforeTimeHorizonAct(
+            0.0, 100.0).empty());
+}
+
+static void copyActivitiesLists(const vmd::Activities& acts,
+                                vmd::Activities::result_t* lists)
+{
+    lists[0] = acts.waitedAct();
+    lists[1] = acts.startedAct();
+    lists[2] = acts.failedAct();
+    lists[3] = acts.doneAct();
+    lists[4] = acts.endedAct();
+    lists[5] = acts.latestWaitedAct();
+    lists[6] = acts.latestStartedAct();
+    lists[7] = acts.latestFailedAct();
+    lists[8] = acts.latestDoneAct();
+    lists[9] = acts.latestEndedAct();
+}
+
+BOOST_AUTO_TEST_CASE(Activities_lists_membership)
+{
+    vle::Init app;
+
+    const vmd::Activities::ProcessMode modes[] = {
+        vmd::Activities::FullScan, vmd::Activities::Incremental };
+
+    for (int mode = 0; mode < 2; ++mode) {
+        vmd::Activities acts;
+        vmd::Activities::result_t expected[10], result[10];
+        unsigned long seed = 1357;
+
+        acts.setProcessMode(modes[mode]);
+
+        for (int i = 0; i < 60; ++i) {
+            seed = (seed * 1103515245 + 12345) % 2147483648UL;
+            double start = (seed % 10);
+            acts.add((fmt("act%1%") % i).str(), start,
+                     start + 1.0 + (seed % 5));
+        }
+
+        for (int step = 0; step < 1000; ++step) {
+            if (step % 100 == 0) {
+                acts.process(step / 100);
+                copyActivitiesLists(acts, expected);
+            }
+
+            if (step % 30 == 0) {
+                acts.clearLatestActivitiesLists();
+                for (int i = 5; i < 10; ++i) {
+                    expected[i].clear();
+                }
+            }
+
+            seed = (seed * 1103515245 + 12345) % 2147483648UL;
+            vmd::Activities::iterator it = acts.begin();
+            std::advance(it, seed % acts.size());
+
+            int state = 0;
+            switch (it->second.state()) {
+            case vmd::Activity::WAIT: state = 0; break;
+            case vmd::Activity::STARTED: state = 1; break;
+            case vmd::Activity::FAILED: state = 2; break;
+            case vmd::Activity::FF: state = 3; break;
+            case vmd::Activity::DONE: state = 4; break;
+            }
+
+            int target = (seed / 7) % 5;
+
+            /* Reference implementation with std::find and vector::erase. */
+            vmd::Activities::removeAct(expected[state], it);
+            for (int i = 5; i < 10; ++i) {
+                vmd::Activities::removeAct(expected[i], it);
+            }
+            vmd::Activities::addAct(expected[5 + state], it);
+            vmd::Activities::addAct(expected[target == 0 ? state : target],
+                                    it);
+
+            switch (target) {
+            case 0: acts.setWaitedAct(it); break;
+            case 1: acts.setStartedAct(it); break;
+            case 2: acts.setFailedAct(it); break;
+            case 3: acts.setFFAct(it); break;
+            default: acts.setEndedAct(it); break;
+            }
+
+            /* The removals keep the order of the other activities. */
+            copyActivitiesLists(acts, result);
+            for (int i = 0; i < 10; ++i) {
+                BOOST_REQUIRE(expected[i] == result[i]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PrecedencesGraph_adjacency)
+{
+    vle::Init app;
+
+    vmd::Activities acts;
+    acts.add("A");
+    acts.add("B");
+    acts.add("C");
+    acts.add("D");
+
+    acts.addFinishToStartConstraint("A", "C", 0.0, 1.0);
+    acts.addStartToStartConstraint("B", "C", 2.0);
+    acts.addFinishToFinishConstraint("A", "D", 3.0);
+    acts.addFinishToStartConstraint("C", "D", 0.0, 4.0);
+
+    const vmd::PrecedencesGraph& graph = acts.precedencesGraph();
+    BOOST_REQUIRE_EQUAL(graph.size(), vmd::PrecedencesGraph::size_type(4));
+
+    vmd::PrecedencesGraph::findIn in = graph.findPrecedenceIn(acts.get("C"));
+    BOOST_REQUIRE_EQUAL(std::distance(in.first, in.second), 2);
+    BOOST_REQUIRE_EQUAL(in.first->first()->first, "A");
+    BOOST_REQUIRE_EQUAL((in.first + 1)->first()->first, "B");
+
+    vmd::PrecedencesGraph::findOut out =
+        graph.findPrecedenceOut(acts.get("A"));
+    BOOST_REQUIRE_EQUAL(std::distance(out.first, out.second), 2);
+    BOOST_REQUIRE_EQUAL(out.first->second()->first, "C");
+    BOOST_REQUIRE_EQUAL((out.first + 1)->second()->first, "D");
+
+    in = graph.findPrecedenceIn(acts.get("A"));
+    BOOST_REQUIRE(in.first == in.second);
+    out = graph.findPrecedenceOut(acts.get("D"));
+    BOOST_REQUIRE(out.first == out.second);
+
+    vmd::PrecedencesGraph copy(graph);
+    std::vector < vmd::PrecedenceConstraint > removed;
+    copy.remove(acts.get("C"), removed);
+
+    BOOST_REQUIRE_EQUAL(removed.size(), std::size_t(3));
+    BOOST_REQUIRE_EQUAL(copy.size(), vmd::PrecedencesGraph::size_type(1));
+    out = copy.findPrecedenceOut(acts.get("A"));
+    BOOST_REQUIRE_EQUAL(std::distance(out.first, out.second), 1);
+    BOOST_REQUIRE_EQUAL(out.first->second()->first, "D");
+    out = copy.findPrecedenceOut(acts.get("B"));
+    BOOST_REQUIRE(out.first == out.second);
+}
+
+BOOST_AUTO_TEST_CASE(Activities_predicate_cache)
+{
+    vle::Init app;
+
+    vmd::ex::KnowledgeBaseCache base;
+    base.plan().activities().setPredicateCache(true);
+
+    base.applyFact("today", vle::value::Double(10));
+    base.processChanges(1.0);
+    BOOST_REQUIRE_EQUAL(base.nbGood, 1);
+    BOOST_REQUIRE_EQUAL(base.nbPlot, 2);
+    BOOST_REQUIRE_EQUAL(base.activities().predicateCache().size(),
+                        std::size_t(3));
+    BOOST_REQUIRE_EQUAL(base.activities().predicateCache().hits(), 5ul);
+
+    base.processChanges(1.0);
+    BOOST_REQUIRE_EQUAL(base.nbGood, 1);
+    BOOST_REQUIRE_EQUAL(base.nbPlot, 2);
+
+    base.processChanges(2.0);
+    BOOST_REQUIRE_EQUAL(base.nbGood, 2);
+    BOOST_REQUIRE_EQUAL(base.nbPlot, 4);
+    BOOST_REQUIRE(base.startedActivities().empty());
+
+    base.applyFact("today", vle::value::Double(25));
+    BOOST_REQUIRE_EQUAL(base.activities().predicateCache().size(),
+                        std::size_t(0));
+    base.processChanges(2.0);
+    BOOST_REQUIRE_EQUAL(base.nbGood, 3);
+    BOOST_REQUIRE_EQUAL(base.nbPlot, 6);
+    BOOST_REQUIRE_EQUAL(base.startedActivities().size(),
+                        vmd::Activities::result_t::size_type(4));
+
+    vmd::ex::KnowledgeBaseCache reference;
+
+    reference.applyFact("today", vle::value::Double(10));
+    reference.processChanges(1.0);
+    BOOST_REQUIRE_EQUAL(reference.nbGood, 4);
+    BOOST_REQUIRE_EQUAL(reference.nbPlot, 4);
+    BOOST_REQUIRE(reference.startedActivities().empty());
+
+    reference.applyFact("today", vle::value::Double(25));
+    reference.processChanges(2.0);
+    BOOST_REQUIRE_EQUAL(reference.startedActivities().size(),
+                        vmd::Activities::result_t::size_type(4));
+
+    /* The PredicatePerActivity results are keyed by the activity. */
+    vmd::Predicate perActivity("good",
+        boost::bind(&vmd::ex::KnowledgeBaseCache::isGood, &reference, _1, _2,
+                    _3));
+    perActivity.setScope(vmd::PredicatePerActivity);
+
+    vmd::PredicateCache cache;
+    vmd::Activity a, b;
+    vmd::ActivityMetadata metadata;
+    int calls = reference.nbGood;
+
+    cache.isAvailable(perActivity, &a, "a", "r", metadata);
+    cache.isAvailable(perActivity, &a, "a", "r", metadata);
+    cache.isAvailable(perActivity, &b, "a", "r", metadata);
+    BOOST_REQUIRE_EQUAL(reference.nbGood, calls + 2);
+    BOOST_REQUIRE_EQUAL(cache.size(), std::size_t(2));
+    BOOST_REQUIRE_EQUAL(cache.hits(), 1ul);
+
+    cache.isAvailable(perActivity, 0, "a", "r", metadata);
+    BOOST_REQUIRE_EQUAL(reference.nbGood, calls + 3);
+    BOOST_REQUIRE_EQUAL(cache.size(), std::size_t(2));
+}
+
+BOOST_AUTO_TEST_CASE(Activities_topological_order)
+{
+    vle::Init app;
+
+    const vmd::Activities::ProcessMode modes[] = { vmd::Activities::FullScan,
+        vmd::Activities::Incremental, vmd::Activities::Differential };
+
+    for (int i = 0; i < 3; ++i) {
+        vmd::KnowledgeBase base;
+        base.plan().activities().setProcessMode(modes[i]);
+        base.addActivity("A");
+        base.addActivity("B");
+        base.addActivity("C");
+        base.addStartToStartConstraint("C", "B", 10.0);
+        base.addStartToStartConstraint("B", "A", 10.0);
+
+        base.processChanges(0.0);
+        BOOST_REQUIRE(base.activities().get("A")->second.isInWaitState());
+        BOOST_REQUIRE(base.activities().get("B")->second.isInStartedState());
+        BOOST_REQUIRE(base.activities().get("C")->second.isInStartedState());
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        vmd::KnowledgeBase base;
+        base.plan().activities().setProcessMode(modes[i]);
+        base.plan().activities().setTopologicalOrder(true);
+        base.addActivity("A");
+        base.addActivity("B");
+        base.addActivity("C");
+        base.addStartToStartConstraint("C", "B", 10.0);
+        base.addStartToStartConstraint("B", "A", 10.0);
+
+        base.processChanges(0.0);
+        BOOST_REQUIRE(base.activities().get("A")->second.isInStartedState());
+        BOOST_REQUIRE(base.activities().get("B")->second.isInStartedState());
+        BOOST_REQUIRE(base.activities().get("C")->second.isInStartedState());
+        BOOST_REQUIRE_EQUAL(base.activities().cycles(),
+                            vmd::Activities::size_type(0));
+
+        if (modes[i] == vmd::Activities::FullScan) {
+            BOOST_REQUIRE_EQUAL(base.activities().passes(), 2u);
+        }
+
+        base.addActivity("D");
+        base.addActivity("E");
+        base.addStartToStartConstraint("D", "E", 0.0);
+        base.addFinishToFinishConstraint("E", "D", 0.0);
+        base.processChanges(1.0);
+        BOOST_REQUIRE_EQUAL(base.activities().cycles(),
+                            vmd::Activities::size_type(1));
+        BOOST_REQUIRE(base.activities().get("D")->second.isInStartedState());
+    }
+
+    vmd::ex::KnowledgeBaseGraph2 graph;
+    graph.plan().activities().setTopologicalOrder(true);
+    graph.plan().activities().setProcessMode(vmd::Activities::Differential);
+
+    const char* names[] = { "A", "B", "C", "D", "E", "F", "G" };
+
+    for (int i = 0; i < 7; ++i) {
+        graph.processChanges(0.0);
+        BOOST_REQUIRE(graph.activities().get(names[i])->second.isInStartedState());
+        graph.setActivityDone(names[i], 0.0);
+    }
+
+    graph.processChanges(0.0);
+    BOOST_REQUIRE_EQUAL(graph.activities().endedAct().size(),
+                        vmd::Activities::result_t::size_type(7));
+}
+
+BOOST_AUTO_TEST_CASE(Activities_temporal_propagation)
+{
+    vle::Init app;
+
+    const vmd::Activities::ProcessMode modes[] = { vmd::Activities::FullScan,
+        vmd::Activities::Incremental, vmd::Activities::Differential };
+
+    for (int i = 0; i < 6; ++i) {
+        bool propagation = i >= 3;
+        vmd::KnowledgeBase base;
+        base.plan().activities().setProcessMode(modes[i % 3]);
+        base.plan().activities().setTemporalPropagation(propagation);
+        base.addActivity("A", 0.0, 100.0);
+        base.addActivity("B", 0.0, 20.0);
+        base.addActivity("C", 0.0, 18.0);
+        base.addFinishToStartConstraint("A", "B", 5.0, vd::infinity);
+        base.addFinishToStartConstraint("B", "C", 10.0, vd::infinity);
+
+        base.processChanges(0.0);
+        BOOST_REQUIRE(base.activities().get("A")->second.isInStartedState());
+        BOOST_REQUIRE(base.activities().get("B")->second.isInWaitState());
+        BOOST_REQUIRE(base.activities().get("C")->second.isInWaitState());
+
+        base.processChanges(4.0);
+        BOOST_REQUIRE(base.activities().get("B")->second.isInWaitState());
+        BOOST_REQUIRE_EQUAL(
+            base.activities().get("C")->second.isInFailedState(), propagation);
+
+        base.processChanges(16.0);
+        BOOST_REQUIRE_EQUAL(
+            base.activities().get("B")->second.isInFailedState(), propagation);
+        BOOST_REQUIRE_EQUAL(
+            base.activities().get("C")->second.isInFailedState(), propagation);
+    }
+
+    for (int i = 0; i < 6; ++i) {
+        bool propagation = i >= 3;
+        vmd::KnowledgeBase base;
+        base.plan().activities().setProcessMode(modes[i % 3]);
+        base.plan().activities().setTemporalPropagation(propagation);
+        base.addActivity("A", 0.0, 100.0);
+        base.addActivity("B", 0.0, 20.0);
+        base.addActivity("C", 12.0, 40.0);
+        base.addFinishToStartConstraint("A", "B", 5.0, vd::infinity);
+        base.addFinishToStartConstraint("B", "C", 10.0, vd::infinity);
+
+        base.processChanges(0.0);
+        base.setActivityDone("A", 10.0);
+        base.processChanges(10.0);
+        BOOST_REQUIRE(base.activities().get("B")->second.isInWaitState());
+        BOOST_REQUIRE(base.activities().get("C")->second.isInWaitState());
+        BOOST_REQUIRE_EQUAL(base.nextDate(10.0), (propagation ? 20.0 : 12.0));
+
+        if (propagation) {
+            const vmd::TemporalNetwork& network =
+                base.activities().temporalNetwork();
+            const vmd::Activity* c = &base.activities().get("C")->second;
+
+            BOOST_REQUIRE_EQUAL(network.earliestStart(c), 25.0);
+            BOOST_REQUIRE_EQUAL(network.latestStart(c), 40.0);
+            BOOST_REQUIRE(not network.infeasible(c));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Activities_temporal_propagation_incremental)
+{
+    vle::Init app;
+
+    /*
+     * The first knowledge base builds its network again before each
+     * process, the second one only computes the touched activities.
+     */
+    vmd::KnowledgeBase bases[2];
+    const char* names[] = { "A", "B", "C", "D", "E" };
+
+    for (int i = 0; i < 2; ++i) {
+        bases[i].plan().activities().setTemporalPropagation(true);
+        bases[i].addActivity("A", 0.0, 100.0);
+        bases[i].addActivity("B", 0.0, 100.0);
+        bases[i].addActivity("C", 0.0, 30.0);
+        bases[i].addActivity("D", 0.0, 100.0);
+        bases[i].addActivity("E", 0.0, 100.0);
+        bases[i].addFinishToStartConstraint("A", "B", 5.0, vd::infinity);
+        bases[i].addFinishToStartConstraint("B", "C", 10.0, vd::infinity);
+        bases[i].addFinishToStartConstraint("D", "E", 1.0, vd::infinity);
+    }
+
+    for (int time = 0; time < 25; ++time) {
+        for (int i = 0; i < 2; ++i) {
+            if (time == 2) {
+                bases[i].setActivityDone("D", 2.0);
+            } else if (time == 8) {
+                bases[i].setActivityDone("A", 8.0);
+            }
+
+            if (i == 0) {
+                bases[i].plan().activities().setTemporalPropagation(true);
+            }
+            bases[i].processChanges(time);
+        }
+
+        const vmd::TemporalNetwork& full =
+            bases[0].activities().temporalNetwork();
+        const vmd::TemporalNetwork& network =
+            bases[1].activities().temporalNetwork();
+
+        for (int j = 0; j < 5; ++j) {
+            const vmd::Activity* expected =
+                &bases[0].activities().get(names[j])->second;
+            const vmd::Activity* activity =
+                &bases[1].activities().get(names[j])->second;
+
+            BOOST_REQUIRE_EQUAL(expected->state(), activity->state());
+            BOOST_REQUIRE_EQUAL(full.earliestStart(expected),
+                                network.earliestStart(activity));
+            BOOST_REQUIRE_EQUAL(full.latestStart(expected),
+                                network.latestStart(activity));
+            BOOST_REQUIRE_EQUAL(full.infeasible(expected),
+                                network.infeasible(activity));
+        }
+
+        BOOST_REQUIRE_EQUAL(bases[0].nextDate(time), bases[1].nextDate(time));
+
+        if (time == 3) {
+            /* Only the nodes of D and E, after the end of D. */
+            BOOST_REQUIRE_EQUAL(network.visits(), 4u);
+            BOOST_REQUIRE_EQUAL(network.earliestStart(
+                    &bases[1].activities().get("B")->second), 8.0);
+        }
+    }
+
+    BOOST_REQUIRE(bases[1].activities().get("B")->second.isInStartedState());
+    BOOST_REQUIRE(bases[1].activities().get("C")->second.isInFailedState());
+    BOOST_REQUIRE(bases[1].activities().get("E")->second.isInStartedState());
+    BOOST_REQUIRE_EQUAL(bases[1].activities().temporalNetwork().propagations(),
+                        25u);
+}
+
+BOOST_AUTO_TEST_CASE(Activities_emplace_adopt)
+{
+    vle::Init app;
+
+    vmd::KnowledgeBase base;
+    vmd::Activities& activities = base.plan().activities();
+    activities.reserve(3);
+
+    vmd::Activity model;
+    model.initStartTimeFinishTime(5.0, 10.0);
+    model.addRule("rule", vmd::Rule());
+
+    vmd::Activities::iterator a = activities.emplace("A");
+    BOOST_REQUIRE_EQUAL(a->first, "A");
+    BOOST_REQUIRE(a == activities.get("A"));
+
+    vmd::Activities::iterator b = activities.emplace("B", model);
+    BOOST_REQUIRE_EQUAL(b->second.start(), 5.0);
+    BOOST_REQUIRE_EQUAL(b->second.rules().size(), 1u);
+    BOOST_REQUIRE_EQUAL(model.rules().size(), 1u);
+
+    vmd::Activities::iterator c = activities.adopt("C", model);
+    BOOST_REQUIRE_EQUAL(c->second.start(), 5.0);
+    BOOST_REQUIRE_EQUAL(c->second.finish(), 10.0);
+    BOOST_REQUIRE_EQUAL(c->second.rules().size(), 1u);
+    BOOST_REQUIRE(model.rules().empty());
+
+    BOOST_REQUIRE_THROW(activities.emplace("B"), vle::utils::ArgError);
+    BOOST_REQUIRE_THROW(activities.adopt("C", model), vle::utils::ArgError);
+    BOOST_REQUIRE_EQUAL(activities.size(), 3u);
+
+    base.processChanges(6.0);
+    BOOST_REQUIRE(activities.get("A")->second.isInStartedState());
+    BOOST_REQUIRE(activities.get("B")->second.isInStartedState());
+    BOOST_REQUIRE(activities.get("C")->second.isInStartedState());
+}
+
+BOOST_AUTO_TEST_CASE(Activities_insertion_allocations)
+{
+    vle::Init app;
+
+    vmd::ex::KnowledgeBase base;
+    vmd::Activities& activities = base.plan().activities();
+    vmd::Activity model;
+    model.initStartTimeFinishTime(5.0, 10.0);
+    model.addRule("Rule 1", base.rules().get("Rule 1"));
+    model.addRule("Rule 2", base.rules().get("Rule 2"));
+    vmd::ex::KB5 outputs;
+    model.addOutputFunction(outputs.outputFunctions()["out"]);
+
+    const std::string copied("copied activity with a long name");
+    const std::string adopted("adopted activity with a long name");
+    vmd::Activity moved(model);
+    activities.reserve(2);
+
+    allocations = 0;
+    countAllocations = true;
+    activities.add(copied, model);
+    countAllocations = false;
+    const unsigned long copying = allocations;
+
+    allocations = 0;
+    countAllocations = true;
+    activities.adopt(adopted, moved);
+    countAllocations = false;
+    const unsigned long adopting = allocations;
+
+    BOOST_TEST_MESSAGE("allocations: copy " << copying << ", adopt "
+                       << adopting);
+    /* The copy shares the rules and the functions of the model. */
+    BOOST_REQUIRE_EQUAL(adopting, copying);
+    BOOST_REQUIRE(activities.get(copied)->second.rules().begin() ==
+                  model.rules().begin());
+    BOOST_REQUIRE(moved.rules().empty());
+    BOOST_REQUIRE_EQUAL(activities.get(adopted)->second.rules().size(), 2u);
+
+    vmd::KnowledgeBase bulk;
+    vmd::KnowledgeBase reserved;
+    std::vector < std::string > names;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back((fmt("activity with a long name %1%") % i).str());
+    }
+
+    allocations = 0;
+    countAllocations = true;
+    for (int i = 0; i < 1000; ++i) {
+        bulk.plan().activities().add(names[i], model);
+    }
+    countAllocations = false;
+    const unsigned long added = allocations;
+
+    allocations = 0;
+    countAllocations = true;
+    reserved.plan().activities().reserve(1000);
+    for (int i = 0; i < 1000; ++i) {
+        reserved.plan().activities().emplace(names[i], model);
+    }
+    countAllocations = false;
+    const unsigned long emplaced = allocations;
+
+    BOOST_TEST_MESSAGE("allocations: add " << added << ", reserve and emplace "
+                       << emplaced);
+    BOOST_REQUIRE(emplaced < added);
+    BOOST_REQUIRE_EQUAL(bulk.activities().size(),
+                        reserved.activities().size());
+}
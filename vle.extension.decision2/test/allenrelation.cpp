@@ -575,3 +575,58 @@ BOOST_AUTO_TEST_CASE(EqualFail)
     lst = base.failedActivities();
     BOOST_REQUIRE_EQUAL(lst.size(), vmd::Activities::result_t::size_type(1));
 }
+
+/**
+ * Replay a relation and check, at each step, the transition table of the
+ * isValid function against the nested switch implementation for all the
+ * constraints.
+ */
+template < typename T >
+void checkIsValidTable()
+{
+    T base;
+    const vmd::PrecedencesGraph& graph =
+        base.activities().precedencesGraph();
+
+    for (double time = 0.0; time <= 8.0; time += 0.5) {
+        base.processChanges(time);
+
+        for (vmd::Activities::const_iterator it = base.activities().begin();
+             it != base.activities().end(); ++it) {
+            vmd::PrecedencesGraph::findIn in = graph.findPrecedenceIn(it);
+
+            for (vmd::PrecedencesGraph::iteratorIn jt = in.first;
+                 jt != in.second; ++jt) {
+                for (double t = time - 1.0; t <= time + 1.0; t += 0.25) {
+                    vmd::PrecedenceConstraint::Result result =
+                        jt->isValid(t);
+                    vmd::PrecedenceConstraint::Result expected =
+                        jt->isValidReference(t);
+
+                    BOOST_REQUIRE(result.first == expected.first);
+                    BOOST_REQUIRE(result.second == expected.second);
+                }
+            }
+        }
+
+        vmd::Activities::result_t started = base.startedActivities();
+        for (vmd::Activities::result_t::iterator it = started.begin();
+             it != started.end(); ++it) {
+            if (it - started.begin() == (int)time % 2) {
+                base.setActivityDone((*it)->first, time);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(isValid_table)
+{
+    checkIsValidTable < vmd::ex::Before >();
+    checkIsValidTable < vmd::ex::Meets >();
+    checkIsValidTable < vmd::ex::Overlaps >();
+    checkIsValidTable < vmd::ex::During >();
+    checkIsValidTable < vmd::ex::Starts >();
+    checkIsValidTable < vmd::ex::StartsFailed >();
+    checkIsValidTable < vmd::ex::Finishes >();
+    checkIsValidTable < vmd::ex::Equal >();
+}
@@ -0,0 +1,223 @@
+/*
+ * @file test/bench-parser.cpp
+ *
+ * This file is part of VLE, a framework for multi-modeling, simulation
+ * and analysis of complex dynamical systems
+ * http://www.vle-project.org
+ *
+ * Copyright (c) 2003-2007 Gauthier Quesnel <quesnel@users.sourceforge.net>
+ * Copyright (c) 2003-2011 ULCO http://www.univ-littoral.fr
+ * Copyright (c) 2007-2011 INRA http://www.inra.fr
+ *
+ * See the AUTHORS or Authors.txt file for copyright owners and contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <vle/extension/decision/KnowledgeBase.hpp>
+#include <vle/extension/decision/PlanParser.hpp>
+#include <vle/utils/Parser.hpp>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstdlib>
+
+namespace vmd = vle::extension::decision;
+
+/**
+ * Number of calls to the global operator new.
+ */
+static long allocations = 0;
+
+void* operator new(std::size_t size) throw (std::bad_alloc)
+{
+    ++allocations;
+
+    void* result = std::malloc(size ? size : 1);
+    if (not result) {
+        throw std::bad_alloc();
+    }
+
+    return result;
+}
+
+void operator delete(void* ptr) throw ()
+{
+    std::free(ptr);
+}
+
+/**
+ * Count the elements read by the PlanParser.
+ */
+class Counter : public vmd::PlanParser::Handler
+{
+public:
+    Counter()
+        : blocks(0), values(0)
+    {}
+
+    virtual ~Counter() {}
+
+    virtual void beginBlock(const vmd::PlanParser::Token&) { ++blocks; }
+    virtual void endBlock() {}
+    virtual void string(const vmd::PlanParser::Token&,
+                        const vmd::PlanParser::Token&) { ++values; }
+    virtual void real(const vmd::PlanParser::Token&, double) { ++values; }
+    virtual void relativeReal(const vmd::PlanParser::Token&, double)
+    { ++values; }
+
+    long blocks;
+    long values;
+};
+
+/**
+ * A knowledge base which accepts the functions used by the plans: each
+ * predicate type, predicate of a rule and acknowledge, output or update
+ * function found in the plans is defined and does nothing.
+ */
+class KnowledgeBase : public vmd::KnowledgeBase,
+                      public vmd::PlanParser::Handler
+{
+public:
+    KnowledgeBase(const std::vector < std::string >& plans)
+    {
+        for (std::vector < std::string >::const_iterator it = plans.begin();
+             it != plans.end(); ++it) {
+            vmd::PlanParser parser(it->data(), it->data() + it->size());
+            parser.parse(*this);
+        }
+    }
+
+    virtual ~KnowledgeBase() {}
+
+    virtual void beginBlock(const vmd::PlanParser::Token&) {}
+    virtual void endBlock() {}
+    virtual void real(const vmd::PlanParser::Token&, double) {}
+    virtual void relativeReal(const vmd::PlanParser::Token&, double) {}
+
+    virtual void string(const vmd::PlanParser::Token& key,
+                        const vmd::PlanParser::Token& value)
+    {
+        const std::string name(value.str());
+
+        if ((key == "type" or key == "predicates") and
+            not predicates().exist(name)) {
+            predicates().add(name, &KnowledgeBase::predicate);
+        } else if (key == "ack" and not acknowledgeFunctions().exist(name)) {
+            acknowledgeFunctions().add(name, &KnowledgeBase::ack);
+        } else if (key == "output" and not outputFunctions().exist(name)) {
+            outputFunctions().add(name, &KnowledgeBase::output);
+        } else if (key == "update" and not updateFunctions().exist(name)) {
+            updateFunctions().add(name, &KnowledgeBase::ack);
+        }
+    }
+
+    static bool predicate(const std::string&, const std::string&,
+                          const vmd::PredicateParameters&)
+    { return true; }
+
+    static void ack(const std::string&, const vmd::Activity&) {}
+
+    static void output(const std::string&, const vmd::Activity&,
+                       vle::devs::ExternalEventList&) {}
+};
+
+/**
+ * Compare the utils::Parser and the PlanParser on the concatenation of the
+ * plans given on the command line (for example the ITK files of safihr),
+ * then count the allocations of a Plan::fill of each plan into a new
+ * knowledge base:
+ * @code
+ * bench-parser 1000 ITK-*.txt
+ * @endcode
+ */
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        std::cerr << "usage: bench-parser loops plan.txt...\n";
+        return EXIT_FAILURE;
+    }
+
+    long loops = std::atol(argv[1]);
+    std::vector < std::string > plans;
+    std::string buffer;
+
+    for (int i = 2; i < argc; ++i) {
+        std::ifstream ifs(argv[i]);
+        if (not ifs.is_open()) {
+            std::cerr << "bench-parser: fail to open " << argv[i] << "\n";
+            return EXIT_FAILURE;
+        }
+
+        plans.push_back(std::string(std::istreambuf_iterator < char >(ifs),
+                                    std::istreambuf_iterator < char >()));
+        buffer.append(plans.back());
+        buffer.append("\n");
+    }
+
+    long allocated = allocations;
+    std::clock_t start = std::clock();
+    for (long i = 0; i < loops; ++i) {
+        std::istringstream in(buffer);
+        vle::utils::Parser parser(in);
+    }
+    std::clock_t tree = std::clock() - start;
+    long treeAllocations = (allocations - allocated) / loops;
+
+    Counter counter;
+    allocated = allocations;
+    start = std::clock();
+    for (long i = 0; i < loops; ++i) {
+        vmd::PlanParser parser(buffer.data(), buffer.data() + buffer.size());
+        parser.parse(counter);
+    }
+    std::clock_t stream = std::clock() - start;
+    long streamAllocations = (allocations - allocated) / loops;
+
+    std::clock_t fill = 0;
+    long fillAllocations = 0;
+    for (long i = 0; i < loops; ++i) {
+        KnowledgeBase kb(plans);
+
+        allocated = allocations;
+        start = std::clock();
+        for (std::vector < std::string >::size_type j = 0; j < plans.size();
+             ++j) {
+            std::ostringstream suffixe;
+            suffixe << '_' << j;
+            kb.plan().fill(plans[j], 0, suffixe.str());
+        }
+        fill += std::clock() - start;
+        fillAllocations += allocations - allocated;
+    }
+
+    std::cout << buffer.size() << " bytes, "
+        << counter.blocks / loops << " blocks, "
+        << counter.values / loops << " values\n"
+        << "utils::Parser: " << (double)tree / CLOCKS_PER_SEC << " s, "
+        << treeAllocations << " allocations\n"
+        << "PlanParser:    " << (double)stream / CLOCKS_PER_SEC << " s, "
+        << streamAllocations << " allocations\n"
+        << "Plan::fill:    " << (double)fill / CLOCKS_PER_SEC << " s, "
+        << fillAllocations / loops << " allocations\n";
+
+    return EXIT_SUCCESS;
+}
@@ -33,8 +33,11 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/auto_unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
+#include <algorithm>
+#include <deque>
 #include <iostream>
 #include <iterator>
+#include <numeric>
 #include <vle/value/Double.hpp>
 #include <vle/extension/decision/KnowledgeBase.hpp>
 #include <vle/vle.hpp>
@@ -121,3 +124,65 @@ BOOST_AUTO_TEST_CASE(kb)
     lst = base.startedActivities();
     BOOST_CHECK_EQUAL(lst.size(), vmd::Activities::result_t::size_type(2));
 }
+
+BOOST_AUTO_TEST_CASE(kb_fact_history)
+{
+    vle::Init app;
+
+    vmd::FactHistory < double > history(5);
+    std::deque < double > values;
+    BOOST_REQUIRE(history.empty());
+    BOOST_REQUIRE_THROW(history.minimum(), vle::utils::ArgError);
+    BOOST_REQUIRE_THROW(vmd::FactHistory < double >(0), vle::utils::ArgError);
+
+    for (int i = 0; i < 50; ++i) {
+        double value = ((i * 7) % 11) - 3.5;
+        history.push(value);
+        values.push_front(value);
+        if (values.size() > 5) {
+            values.pop_back();
+        }
+
+        BOOST_REQUIRE_EQUAL(history.size(), values.size());
+        BOOST_REQUIRE_EQUAL(history.at(0), value);
+        BOOST_REQUIRE_EQUAL(history.minimum(),
+                            *std::min_element(values.begin(), values.end()));
+        BOOST_REQUIRE_EQUAL(history.maximum(),
+                            *std::max_element(values.begin(), values.end()));
+
+        for (std::size_t n = 1; n <= values.size(); ++n) {
+            double sum = std::accumulate(values.begin(), values.begin() + n,
+                                         0.0);
+            BOOST_REQUIRE_CLOSE(history.sum(n) + 100.0, sum + 100.0, 1e-9);
+            BOOST_REQUIRE_CLOSE(history.mean(n) + 100.0, sum / n + 100.0,
+                                1e-9);
+            BOOST_REQUIRE_EQUAL(history.difference(n - 1),
+                                values[0] - values[n - 1]);
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL(history.count(), 50u);
+    BOOST_REQUIRE_THROW(history.sum(6), vle::utils::ArgError);
+    BOOST_REQUIRE_THROW(history.at(5), vle::utils::ArgError);
+    history.clear();
+    BOOST_REQUIRE(history.empty());
+    BOOST_REQUIRE_EQUAL(history.size(), 0u);
+
+    vmd::ex::KnowledgeBase base;
+    const vmd::FactHistory < double >& today =
+        base.addFactHistory("today", 2);
+    base.addFactHistory("rain", 3);
+    BOOST_REQUIRE_THROW(base.addFactHistory("rain", 3), vle::utils::ArgError);
+
+    base.applyFact("today", vle::value::Double(16));
+    base.applyFact("today", vle::value::Double(21));
+    base.applyFact("today", vle::value::Double(18));
+    base.applyFact("rain", vle::value::Double(2));
+    BOOST_REQUIRE_EQUAL(base.today, 18.0);
+    BOOST_REQUIRE_EQUAL(base.yesterday, 21.0);
+    BOOST_REQUIRE_EQUAL(today.size(), 2u);
+    BOOST_REQUIRE_EQUAL(today.sum(2), 39.0);
+    BOOST_REQUIRE_EQUAL(&today, &base.factHistory("today"));
+    BOOST_REQUIRE_EQUAL(base.factHistory("rain").at(0), 2.0);
+    BOOST_REQUIRE_THROW(base.factHistory("etp"), vle::utils::ArgError);
+}
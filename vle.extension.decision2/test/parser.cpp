@@ -35,6 +35,11 @@
 #include <boost/test/floating_point_comparison.hpp>
 #include <iostream>
 #include <iterator>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <clocale>
+#include <cstring>
 #include <boost/assign/list_of.hpp>
 #include <boost/assign.hpp>
 #include <vle/version.hpp>
@@ -300,6 +305,390 @@ std::string Block(
     " second = \"activity4\";\n"
     "}\n");
 
+class KnowledgeBaseTyped : public vmd::KnowledgeBase
+{
+public:
+    KnowledgeBaseTyped()
+        : vmd::KnowledgeBase(), rain(0.0)
+    {
+        addPredicates(this) +=
+            P("rain", &KnowledgeBaseTyped::isRainValid,
+              PredicateSignature()
+              .addOperator("rain_operator")
+              .addReal("rain_threshold")),
+            P("always", &KnowledgeBaseTyped::isAlwaysTrue);
+    }
+
+    virtual ~KnowledgeBaseTyped() {}
+
+    bool isRainValid(const std::string&, const std::string&,
+                     const ActivityMetadata&,
+                     const TypedPredicateParameters& params) const
+    {
+        return comparePredicateOperator(params.getOperator(0), rain,
+                                        params.getReal(0));
+    }
+
+    bool isAlwaysTrue(const std::string&, const std::string&,
+                      const PredicateParameters&) const
+    {
+        return true;
+    }
+
+    double rain;
+};
+
+const char* TypedPlan = \
+"predicates {\n"
+"    predicate {\n"
+"        id = \"rain_5\";\n"
+"        type = \"rain\";\n"
+"        parameter {\n"
+"            rain_operator = \"<=\";\n"
+"            rain_threshold = 5.0;\n"
+"        }\n"
+"    }\n"
+"    predicate {\n"
+"        id = \"rain_sup_2\";\n"
+"        type = \"rain\";\n"
+"        parameter {\n"
+"            rain_operator = \">\";\n"
+"            rain_threshold = 2.0;\n"
+"        }\n"
+"    }\n"
+"    predicate {\n"
+"        id = \"always\";\n"
+"        type = \"always\";\n"
+"    }\n"
+"}\n"
+"rules {\n"
+"    rule {\n"
+"        id = \"rule\";\n"
+"        predicates = \"rain_5\", \"rain_sup_2\", \"always\";\n"
+"    }\n"
+"}\n"
+"activities {\n"
+"    activity {\n"
+"        id = \"activity\";\n"
+"        rules = \"rule\";\n"
+"    }\n"
+"}\n";
+
+const char* TypedPlanBadOperator = \
+"predicates {\n"
+"    predicate {\n"
+"        id = \"rain_5\";\n"
+"        type = \"rain\";\n"
+"        parameter {\n"
+"            rain_operator = \"=<\";\n"
+"            rain_threshold = 5.0;\n"
+"        }\n"
+"    }\n"
+"}\n";
+
+class KnowledgeBaseMetadata : public vmd::KnowledgeBase
+{
+public:
+    KnowledgeBaseMetadata()
+        : vmd::KnowledgeBase()
+    {
+        addPredicates(this) +=
+            P("sowing", &KnowledgeBaseMetadata::isSowing,
+              PredicateSignature());
+    }
+
+    virtual ~KnowledgeBaseMetadata() {}
+
+    bool isSowing(const std::string&, const std::string&,
+                  const ActivityMetadata& metadata,
+                  const TypedPredicateParameters&) const
+    {
+        return metadata.operation == ActivityOperationSow;
+    }
+
+    ActivityMetadata metadata(const std::string& id, int plot) const
+    {
+        ActivityMetadata result;
+
+        result.plot = plot;
+        result.year = 0;
+        result.crop = "W";
+
+        if (id.compare(0, 6, "Sowing") == 0) {
+            result.operation = ActivityOperationSow;
+        } else if (id.compare(0, 9, "Herbicide") == 0) {
+            result.index = 1;
+        }
+
+        return result;
+    }
+};
+
+const char* MetadataPlan = \
+"predicates {\n"
+"    predicate {\n"
+"        id = \"sowing\";\n"
+"        type = \"sowing\";\n"
+"    }\n"
+"}\n"
+"rules {\n"
+"    rule {\n"
+"        id = \"rule\";\n"
+"        predicates = \"sowing\";\n"
+"    }\n"
+"}\n"
+"activities {\n"
+"    activity {\n"
+"        id = \"Sowing_W\";\n"
+"        rules = \"rule\";\n"
+"    }\n"
+"    activity {\n"
+"        id = \"Herbicide_1_W\";\n"
+"        rules = \"rule\";\n"
+"    }\n"
+"}\n";
+
+const char* MetadataRulePlan = \
+"rules {\n"
+"    rule {\n"
+"        id = \"rule\";\n"
+"        predicates = \"sowing\";\n"
+"    }\n"
+"}\n"
+"activities {\n"
+"    activity {\n"
+"        id = \"Sowing_W\";\n"
+"        rules = \"rule\";\n"
+"    }\n"
+"}\n";
+
+class ParserRecorder : public vmd::PlanParser::Handler
+{
+public:
+    virtual ~ParserRecorder() {}
+
+    virtual void beginBlock(const vmd::PlanParser::Token& name)
+    { out << name.str() << "{"; }
+
+    virtual void endBlock()
+    { out << "}"; }
+
+    virtual void string(const vmd::PlanParser::Token& key,
+                        const vmd::PlanParser::Token& value)
+    { out << key.str() << "='" << value.str() << "'"; }
+
+    virtual void real(const vmd::PlanParser::Token& key, double value)
+    { out << key.str() << "=" << value; }
+
+    virtual void relativeReal(const vmd::PlanParser::Token& key, double value)
+    { out << key.str() << "=+" << value; }
+
+    std::ostringstream out;
+};
+
+class KnowledgeBaseStatic : public vmd::KnowledgeBase
+{
+public:
+    KnowledgeBaseStatic()
+        : vmd::KnowledgeBase(), acks(0)
+    {}
+
+    virtual ~KnowledgeBaseStatic() {}
+
+    void fill(const vle::devs::Time& loadTime)
+    {
+        static const vmd::StaticRule < KnowledgeBaseStatic > rules[] = {
+            { "r1", &KnowledgeBaseStatic::rule_r1 },
+            { "r2", &KnowledgeBaseStatic::rule_r2 },
+            { "r3", 0 } };
+
+        static const unsigned int rules_a[] = { 0, 2 };
+        static const unsigned int rules_b[] = { 1 };
+
+        static const vmd::StaticActivity < KnowledgeBaseStatic > acts[] = {
+            { "a", rules_a, 2, &KnowledgeBaseStatic::ack,
+              &KnowledgeBaseStatic::out,
+              { vmd::StaticDate::Relative, 10.0, 0, 0, 0 },
+              { vmd::StaticDate::None, 0.0, 0, 0, 0 } },
+            { "b", rules_b, 1, 0, 0,
+              { vmd::StaticDate::Absolute, 5.0, 0, 0, 0 },
+              { vmd::StaticDate::Absolute, 100.0, 0, 0, 0 } },
+            { "c", 0, 0, 0, 0,
+              { vmd::StaticDate::None, 0.0, 0, 0, 0 },
+              { vmd::StaticDate::RelativeDate, 0.0, 1, 2, 1 } } };
+
+        static const vmd::StaticPrecedence precs[] = {
+            { vmd::PrecedenceConstraint::FS, 0, 1, 1.0, 2.0 },
+            { vmd::PrecedenceConstraint::SS, 1, 2, 0.0, vle::devs::infinity } };
+
+        vmd::StaticPlan::fill(*this, loadTime, rules, 3, acts, 3, precs, 2);
+    }
+
+    void fillBadIndex()
+    {
+        static const vmd::StaticRule < KnowledgeBaseStatic > rules[] = {
+            { "r1", &KnowledgeBaseStatic::rule_r1 } };
+
+        static const unsigned int rules_a[] = { 1 };
+
+        static const vmd::StaticActivity < KnowledgeBaseStatic > acts[] = {
+            { "a", rules_a, 1, 0, 0,
+              { vmd::StaticDate::None, 0.0, 0, 0, 0 },
+              { vmd::StaticDate::None, 0.0, 0, 0, 0 } } };
+
+        vmd::StaticPlan::fill(*this, 0.0, rules, 1, acts, 1, 0, 0);
+    }
+
+    bool rule_r1(const std::string&, const std::string&,
+                 const PredicateParameters&) const
+    { return true; }
+
+    bool rule_r2(const std::string&, const std::string&,
+                 const PredicateParameters&) const
+    { return false; }
+
+    void ack(const std::string&, const Activity&)
+    { ++acks; }
+
+    void out(const std::string&, const Activity&, vle::devs::ExternalEventList&)
+    {}
+
+    int acks;
+};
+
+/**
+ * The plan generated by vmd::StaticPlanSource in test_staticplan_source:
+ * the code between the generated comments is the generated source, it must
+ * compile and be equal to GeneratedInit and GeneratedFunctions.
+ */
+class KnowledgeBaseGenerated : public vmd::KnowledgeBase
+{
+public:
+    KnowledgeBaseGenerated()
+        : vmd::KnowledgeBase(), acks(0)
+    {}
+
+    virtual ~KnowledgeBaseGenerated() {}
+
+    void fill()
+    {
+        // generated
+        //Plan initialisation (static tables)
+        static const unsigned int rules0[] = { 0, 1 };
+        static const vmd::StaticRule < KnowledgeBaseGenerated > rules[] = {
+            { "rule \"1\"", &KnowledgeBaseGenerated::staticRule0 },
+            { "r2", 0 },
+        };
+        static const vmd::StaticActivity < KnowledgeBaseGenerated > activities[] = {
+            { "a\\b", rules0, 2, &KnowledgeBaseGenerated::ack, 0,
+              { vmd::StaticDate::Relative, 10, 0, 0, 0 },
+              { vmd::StaticDate::None, 0, 0, 0, 0 } },
+            { "c\?\?=d", 0, 0, 0, &KnowledgeBaseGenerated::out,
+              { vmd::StaticDate::None, 0, 0, 0, 0 },
+              { vmd::StaticDate::RelativeDate, 0, 1, 2, 1 } },
+            { "e", 0, 0, 0, 0,
+              { vmd::StaticDate::Absolute, 5, 0, 0, 0 },
+              { vmd::StaticDate::Absolute, 100.5, 0, 0, 0 } },
+        };
+        static const vmd::StaticPrecedence precedences[] = {
+            { vmd::PrecedenceConstraint::FS, 0, 1, 1, vd::infinity },
+            { vmd::PrecedenceConstraint::SS, 1, 2, 0, 2.5 },
+        };
+        vmd::StaticPlan::fill < KnowledgeBaseGenerated >(*this, 0,
+            rules, 2,
+            activities, 3,
+            precedences, 2);
+        // end generated
+    }
+
+    // generated
+    /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+     * Plan rules
+     * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+    bool staticRule0(const std::string&, const std::string&,
+        const vmd::PredicateParameters&) const
+    {
+        return p1() and p2();
+    }
+    // end generated
+
+    bool p1() const { return true; }
+    bool p2() const { return true; }
+
+    void ack(const std::string&, const Activity&)
+    { ++acks; }
+
+    void out(const std::string&, const Activity&, vle::devs::ExternalEventList&)
+    {}
+
+    int acks;
+};
+
+const char* GeneratedInit = \
+"        //Plan initialisation (static tables)\n"
+"        static const unsigned int rules0[] = { 0, 1 };\n"
+"        static const vmd::StaticRule < KnowledgeBaseGenerated > rules[] = {\n"
+"            { \"rule \\\"1\\\"\", &KnowledgeBaseGenerated::staticRule0 },\n"
+"            { \"r2\", 0 },\n"
+"        };\n"
+"        static const vmd::StaticActivity < KnowledgeBaseGenerated > activities[] = {\n"
+"            { \"a\\\\b\", rules0, 2, &KnowledgeBaseGenerated::ack, 0,\n"
+"              { vmd::StaticDate::Relative, 10, 0, 0, 0 },\n"
+"              { vmd::StaticDate::None, 0, 0, 0, 0 } },\n"
+"            { \"c\\\?\\\?=d\", 0, 0, 0, &KnowledgeBaseGenerated::out,\n"
+"              { vmd::StaticDate::None, 0, 0, 0, 0 },\n"
+"              { vmd::StaticDate::RelativeDate, 0, 1, 2, 1 } },\n"
+"            { \"e\", 0, 0, 0, 0,\n"
+"              { vmd::StaticDate::Absolute, 5, 0, 0, 0 },\n"
+"              { vmd::StaticDate::Absolute, 100.5, 0, 0, 0 } },\n"
+"        };\n"
+"        static const vmd::StaticPrecedence precedences[] = {\n"
+"            { vmd::PrecedenceConstraint::FS, 0, 1, 1, vd::infinity },\n"
+"            { vmd::PrecedenceConstraint::SS, 1, 2, 0, 2.5 },\n"
+"        };\n"
+"        vmd::StaticPlan::fill < KnowledgeBaseGenerated >(*this, 0,\n"
+"            rules, 2,\n"
+"            activities, 3,\n"
+"            precedences, 2);\n";
+
+const char* GeneratedFunctions = \
+"/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\n"
+" * Plan rules\n"
+" * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */\n"
+"bool staticRule0(const std::string&, const std::string&,\n"
+"    const vmd::PredicateParameters&) const\n"
+"{\n"
+"    return p1() and p2();\n"
+"}\n"
+"\n";
+
+const char* StaticEquivalentPlan = \
+"activities {\n"
+"    activity {\n"
+"        id = \"a\";\n"
+"    }\n"
+"    activity {\n"
+"        id = \"b\";\n"
+"    }\n"
+"    activity {\n"
+"        id = \"c\";\n"
+"    }\n"
+"}\n"
+"precedences {\n"
+"    precedence {\n"
+"        type = FS;\n"
+"        first = \"a\";\n"
+"        second = \"b\";\n"
+"        mintimelag = 1;\n"
+"        maxtimelag = 2;\n"
+"    }\n"
+"    precedence {\n"
+"        type = SS;\n"
+"        first = \"b\";\n"
+"        second = \"c\";\n"
+"    }\n"
+"}\n";
+
 }}}} // namespace vle ext decision ex
 
 BOOST_AUTO_TEST_CASE(parser_00)
@@ -385,3 +774,479 @@ BOOST_AUTO_TEST_CASE(test_relativehumandates)
         BOOST_REQUIRE_EQUAL(act9.finish(), vu::DateTime::toJulianDayNumber("1969-02-01"));
     }
 }
+
+BOOST_AUTO_TEST_CASE(test_typedpredicates)
+{
+    vle::Init app;
+
+    vmd::ex::KnowledgeBaseTyped b;
+    b.plan().fill(std::string(vmd::ex::TypedPlan));
+
+    const vmd::Rule& rule =
+        b.activities().get("activity")->second.rules().get("rule");
+
+    b.rain = 1.0;
+    BOOST_REQUIRE(not rule.isAvailable("activity", "rule"));
+    b.rain = 3.0;
+    BOOST_REQUIRE(rule.isAvailable("activity", "rule"));
+    b.rain = 5.0;
+    BOOST_REQUIRE(rule.isAvailable("activity", "rule"));
+    b.rain = 6.0;
+    BOOST_REQUIRE(not rule.isAvailable("activity", "rule"));
+
+    vmd::ex::KnowledgeBaseTyped bad;
+    BOOST_REQUIRE_THROW(
+        bad.plan().fill(std::string(vmd::ex::TypedPlanBadOperator)),
+        vle::utils::ArgError);
+
+    BOOST_REQUIRE_EQUAL(vmd::toPredicateOperator("=="),
+                        vmd::PredicateOperatorEqual);
+    BOOST_REQUIRE_EQUAL(vmd::toPredicateOperator(">="),
+                        vmd::PredicateOperatorGreaterEqual);
+    BOOST_REQUIRE(vmd::comparePredicateOperator(vmd::PredicateOperatorNotEqual,
+                                                1.0, 2.0));
+
+    const char* operators[] = { "<", "<=", "=", "!=", ">=", ">" };
+    for (int i = 0; i < 6; ++i) {
+        BOOST_REQUIRE_EQUAL(vmd::toString(vmd::toPredicateOperator(
+                    operators[i])), operators[i]);
+    }
+    BOOST_REQUIRE_EQUAL(vmd::toString(vmd::toPredicateOperator("==")), "=");
+}
+
+BOOST_AUTO_TEST_CASE(test_activitymetadata)
+{
+    vle::Init app;
+
+    vmd::ex::KnowledgeBaseMetadata b;
+    b.plan().fill(std::string(vmd::ex::MetadataPlan), 0, "_0_p3",
+                  boost::bind(&vmd::ex::KnowledgeBaseMetadata::metadata,
+                              &b, _1, 3));
+    b.plan().fill(std::string(vmd::ex::MetadataPlan), 0, "_0_p4");
+
+    const vmd::Activity& sowing = b.activities().get("Sowing_W_0_p3")->second;
+    BOOST_REQUIRE_EQUAL(sowing.metadata().plot, 3);
+    BOOST_REQUIRE_EQUAL(sowing.metadata().crop, "W");
+    BOOST_REQUIRE_EQUAL(sowing.metadata().operation,
+                        vmd::ActivityOperationSow);
+    BOOST_REQUIRE(sowing.validRules("Sowing_W_0_p3"));
+
+    const vmd::Activity& herbicide =
+        b.activities().get("Herbicide_1_W_0_p3")->second;
+    BOOST_REQUIRE_EQUAL(herbicide.metadata().index, 1);
+    BOOST_REQUIRE_EQUAL(herbicide.metadata().operation,
+                        vmd::ActivityOperationOther);
+    BOOST_REQUIRE(not herbicide.validRules("Herbicide_1_W_0_p3"));
+
+    const vmd::Activity& other = b.activities().get("Sowing_W_0_p4")->second;
+    BOOST_REQUIRE_EQUAL(other.metadata().plot, -1);
+    BOOST_REQUIRE(not other.validRules("Sowing_W_0_p4"));
+
+    vmd::ex::KnowledgeBaseMetadata c;
+    c.plan().fill(std::string(vmd::ex::MetadataRulePlan), 0, "_0_p5",
+                  boost::bind(&vmd::ex::KnowledgeBaseMetadata::metadata,
+                              &c, _1, 5));
+    BOOST_REQUIRE(c.activities().get("Sowing_W_0_p5")->second.validRules(
+            "Sowing_W_0_p5"));
+
+    vmd::ex::KnowledgeBaseTyped d;
+    BOOST_REQUIRE_THROW(d.plan().fill(
+            std::string("rules { rule { id = \"rule\"; "
+                        "predicates = \"rain\"; } }")),
+        vle::utils::ArgError);
+}
+
+BOOST_AUTO_TEST_CASE(test_planprototype)
+{
+    vle::Init app;
+
+    const vle::devs::Time loads[] = {
+        0.0, vu::DateTime::toJulianDayNumber("1966-11-08") };
+
+    for (int i = 0; i < 2; ++i) {
+        vmd::ex::KnowledgeBase a, b;
+        a.plan().fill(std::string(vmd::ex::Plan1), loads[i], "_0_p1");
+        a.plan().fill(std::string(vmd::ex::Plan1), loads[i], "_0_p2");
+
+        vmd::PlanPrototype prototype(b, std::string(vmd::ex::Plan1));
+        BOOST_REQUIRE_EQUAL(prototype.size(), (vmd::PlanPrototype::size_type)9);
+        prototype.instantiate(loads[i], "_0_p1");
+        prototype.instantiate(loads[i], "_0_p2");
+
+        BOOST_REQUIRE_EQUAL(a.activities().size(), b.activities().size());
+
+        for (vmd::Activities::const_iterator it = a.activities().begin();
+             it != a.activities().end(); ++it) {
+            const vmd::Activity& x = it->second;
+            const vmd::Activity& y = b.activities().get(it->first)->second;
+
+            BOOST_REQUIRE_EQUAL(x.start(), y.start());
+            BOOST_REQUIRE_EQUAL(x.finish(), y.finish());
+            BOOST_REQUIRE_EQUAL(x.minstart(), y.minstart());
+            BOOST_REQUIRE_EQUAL(x.maxstart(), y.maxstart());
+            BOOST_REQUIRE_EQUAL(x.minfinish(), y.minfinish());
+            BOOST_REQUIRE_EQUAL(x.maxfinish(), y.maxfinish());
+            BOOST_REQUIRE_EQUAL(x.rules().size(), y.rules().size());
+        }
+
+        std::ostringstream ga, gb;
+        ga << a.activities().precedencesGraph();
+        gb << b.activities().precedencesGraph();
+        BOOST_REQUIRE_EQUAL(ga.str(), gb.str());
+    }
+
+    vmd::ex::KnowledgeBase c;
+    vmd::PlanPrototype prototype(c, std::string(vmd::ex::Plan1));
+    prototype.instantiate(0, "_0_p1");
+    BOOST_REQUIRE_THROW(prototype.instantiate(0, "_0_p1"), vle::utils::ArgError);
+}
+
+BOOST_AUTO_TEST_CASE(test_staticplan_source)
+{
+    vle::Init app;
+
+    vmd::StaticPlanSource source("KnowledgeBaseGenerated");
+    std::vector < std::string > preds, rules, none;
+    preds.push_back("p1");
+    preds.push_back("p2");
+    rules.push_back("rule \"1\"");
+    rules.push_back("r2");
+    source.addRule("rule \"1\"", preds);
+    source.addRule("r2", none);
+    source.addActivity("a\\b", rules, "ack", "", "10", "", true, false);
+    source.addActivity("c\?\?=d", none, "", "out", "", "1-2-1", true, true);
+    source.addActivity("e", none, "", "", "5", "100.5", false, false);
+    source.addPrecedence("FS", "a\\b", "c\?\?=d", "1", "");
+    source.addPrecedence("SS", "c\?\?=d", "e", "", "2.5");
+
+    BOOST_REQUIRE_EQUAL(source.init(), std::string(vmd::ex::GeneratedInit));
+    BOOST_REQUIRE_EQUAL(source.functions(),
+                        std::string(vmd::ex::GeneratedFunctions));
+
+    vmd::ex::KnowledgeBaseGenerated kb;
+    kb.fill();
+    BOOST_REQUIRE_EQUAL(kb.activities().size(),
+                        (vmd::Activities::size_type)3);
+    BOOST_REQUIRE(kb.rules().get("rule \"1\"").isAvailable("a\\b", "rule"));
+
+    const vmd::Activity& a = kb.activities().get("a\\b")->second;
+    BOOST_REQUIRE_EQUAL(a.rules().size(), (vmd::Rules::size_type)2);
+    BOOST_REQUIRE_EQUAL(a.minstart(), 10.0);
+
+    const vmd::Activity& c = kb.activities().get("c\?\?=d")->second;
+    BOOST_REQUIRE_EQUAL(c.maxfinish(), 365.0 + 32.0);
+
+    const vmd::Activity& e = kb.activities().get("e")->second;
+    BOOST_REQUIRE_EQUAL(e.maxfinish(), 100.5);
+
+    BOOST_REQUIRE_EQUAL(vmd::StaticPlanSource::literal("\n\001"),
+                        "\"\\n\\001\"");
+    BOOST_REQUIRE_THROW(vmd::StaticPlanSource::date("a", "1-x-2", true, true),
+                        vle::utils::ArgError);
+    BOOST_REQUIRE_THROW(vmd::StaticPlanSource::date("a", "2001-08-10", false,
+                                                    false),
+                        vle::utils::ArgError);
+    BOOST_REQUIRE_THROW(source.addActivity("f", preds, "", "", "", "", false,
+                                           false),
+                        vle::utils::ArgError);
+    BOOST_REQUIRE_THROW(source.addPrecedence("FS", "e", "a\\b", "x", ""),
+                        vle::utils::ArgError);
+}
+
+BOOST_AUTO_TEST_CASE(test_planbinary)
+{
+    vle::Init app;
+
+    std::istringstream in((std::string(vmd::ex::Plan1)));
+    vle::utils::Parser parser(in);
+    std::ostringstream out;
+    vmd::writePlanBinary(parser.root(), 42, out);
+
+    std::string buffer = out.str();
+    vmd::PlanBinaryView view(buffer.data(), buffer.size());
+    BOOST_REQUIRE_EQUAL(view.sourceSize(), 42u);
+    BOOST_REQUIRE_EQUAL(view.activities(), 9u);
+    BOOST_REQUIRE_EQUAL(view.rules(), 4u);
+
+    vmd::PlanBinaryView::Activity act = view.activity(0);
+    BOOST_REQUIRE_EQUAL(std::string(act.id), "activity1");
+    BOOST_REQUIRE_EQUAL(std::string(act.ack), "ack function");
+    BOOST_REQUIRE(not act.update);
+    BOOST_REQUIRE_EQUAL(act.rules, 2u);
+    BOOST_REQUIRE_EQUAL(std::string(view.name(act.rule + 1)), "rule 2");
+    BOOST_REQUIRE_EQUAL(act.temporals, 1u);
+    BOOST_REQUIRE_EQUAL(view.temporal(act.temporal).start.type,
+                        vmd::PlanBinaryView::DateAbsolute);
+    BOOST_REQUIRE_EQUAL(view.temporal(act.temporal).start.value, 0.0);
+    BOOST_REQUIRE_THROW(view.activity(9), vle::utils::ArgError);
+
+    vmd::ex::KnowledgeBase a, b;
+    a.plan().fill(std::string(vmd::ex::Plan1), 5, "_0_p1");
+    vmd::PlanPrototype prototype(b, view);
+    prototype.instantiate(5, "_0_p1");
+
+    BOOST_REQUIRE_EQUAL(a.activities().size(), b.activities().size());
+    for (vmd::Activities::const_iterator it = a.activities().begin();
+         it != a.activities().end(); ++it) {
+        const vmd::Activity& x = it->second;
+        const vmd::Activity& y = b.activities().get(it->first)->second;
+
+        BOOST_REQUIRE_EQUAL(x.start(), y.start());
+        BOOST_REQUIRE_EQUAL(x.finish(), y.finish());
+        BOOST_REQUIRE_EQUAL(x.rules().size(), y.rules().size());
+    }
+
+    std::ostringstream ga, gb;
+    ga << a.activities().precedencesGraph();
+    gb << b.activities().precedencesGraph();
+    BOOST_REQUIRE_EQUAL(ga.str(), gb.str());
+
+    BOOST_REQUIRE_THROW(vmd::PlanBinaryView(buffer.data(), buffer.size() - 1),
+                        vle::utils::ArgError);
+
+    std::string old(buffer);
+    old[8] = 0;
+    BOOST_REQUIRE(not vmd::PlanBinaryView::isValid(old.data(), old.size()));
+    BOOST_REQUIRE_THROW(vmd::PlanBinaryView(old.data(), old.size()),
+                        vle::utils::ArgError);
+}
+
+BOOST_AUTO_TEST_CASE(test_planbinary_file)
+{
+    vle::Init app;
+
+    const std::string source("test_planbinary_file.txt");
+    const std::string binary(vmd::planBinaryPath(source));
+    BOOST_REQUIRE_EQUAL(binary, "test_planbinary_file.bin");
+
+    {
+        std::ofstream ofs(source.c_str());
+        ofs << vmd::ex::Plan1;
+    }
+    std::remove(binary.c_str());
+
+    BOOST_REQUIRE(not vmd::PlanBinaryFile(source).isMapped());
+
+    vmd::compilePlanFile(source, binary);
+    {
+        vmd::PlanBinaryFile compiled(source);
+        BOOST_REQUIRE(compiled.isMapped());
+        BOOST_REQUIRE_EQUAL(compiled.view().activities(), 9u);
+    }
+
+    vmd::ex::KnowledgeBase a;
+    a.plan().fillFile(source, 0, "_0_p1");
+    BOOST_REQUIRE_EQUAL(a.activities().size(), (vmd::Activities::size_type)9);
+
+    {
+        std::ofstream ofs(source.c_str());
+        ofs << vmd::ex::Plan1 << "\n";
+    }
+    BOOST_REQUIRE(not vmd::PlanBinaryFile(source).isMapped());
+
+    std::remove(source.c_str());
+    std::remove(binary.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_planparser)
+{
+    vle::Init app;
+
+    const std::string buffer(
+        "# comment\n"
+        "a { # comment\n"
+        "    x = \"s t\", FS, 1.5, -2, +10;\n"
+        "    b { y = +0.5; }\n"
+        "}\n"
+        "c { }\n");
+
+    vmd::ex::ParserRecorder recorder;
+    vmd::PlanParser parser(buffer.data(), buffer.data() + buffer.size());
+    parser.parse(recorder);
+    BOOST_REQUIRE_EQUAL(recorder.out.str(),
+                        "a{x='s t'x='FS'x=1.5x=-2x=+10b{y=+0.5}}c{}");
+
+    std::vector < vmd::PlanParser::Token > sections = parser.sections();
+    BOOST_REQUIRE_EQUAL(sections.size(), 2u);
+    BOOST_REQUIRE(sections[0] == "a");
+    BOOST_REQUIRE(sections[1] == "c");
+
+    const std::string bad("a {\n    x = 1;\n    y = 2\n}\n");
+    vmd::PlanParser badparser(bad.data(), bad.data() + bad.size());
+    try {
+        badparser.parse(recorder);
+        BOOST_FAIL("parser accepts a missing `;'");
+    } catch (const vle::utils::ArgError& e) {
+        BOOST_REQUIRE(std::string(e.what()).find("at 4:1") !=
+                      std::string::npos);
+    }
+
+    vmd::ex::KnowledgeBase b;
+    BOOST_REQUIRE_THROW(b.plan().fill(std::string("activities {"), 0),
+                        vle::utils::ArgError);
+}
+
+BOOST_AUTO_TEST_CASE(test_parsereal)
+{
+    const char* numbers[] = { "1.5", "-2", "+10", ".25", "3.", "2452132",
+                              "1e3", "-1.5E-2", "1e", "-", "e5" };
+    const double values[] = { 1.5, -2.0, 10.0, 0.25, 3.0, 2452132.0, 1000.0,
+                              -0.015 };
+
+    for (std::size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); ++i) {
+        const char* begin = numbers[i];
+        const char* end = begin + std::strlen(begin);
+        double value = 0.0;
+
+        if (i < sizeof(values) / sizeof(values[0])) {
+            BOOST_REQUIRE(vmd::parseReal(begin, end, &value) == end);
+            BOOST_REQUIRE_CLOSE(value, values[i], 1e-12);
+        } else {
+            BOOST_REQUIRE(vmd::parseReal(begin, end, &value) == 0);
+        }
+    }
+
+    // With a decimal comma, std::strtod stops at the `.'.
+    const char* locales[] = { "fr_FR.UTF-8", "de_DE.UTF-8", "fr_FR", 0 };
+    std::string previous(std::setlocale(LC_NUMERIC, 0));
+    for (const char** locale = locales; *locale; ++locale) {
+        if (std::setlocale(LC_NUMERIC, *locale)) {
+            const std::string buffer("a { x = 1.5; }");
+            vmd::ex::ParserRecorder recorder;
+            vmd::PlanParser parser(buffer.data(),
+                                   buffer.data() + buffer.size());
+            parser.parse(recorder);
+            std::setlocale(LC_NUMERIC, previous.c_str());
+            BOOST_REQUIRE_EQUAL(recorder.out.str(), "a{x=1.5}");
+            break;
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_planparser_sections_order)
+{
+    vle::Init app;
+
+    std::string plan(vmd::ex::Plan1);
+    std::string::size_type rules = plan.find("rules {");
+    std::string::size_type activities = plan.find("activities {");
+    BOOST_REQUIRE(rules < activities);
+
+    std::string reordered = plan.substr(0, rules) + plan.substr(activities) +
+        plan.substr(rules, activities - rules);
+
+    vmd::ex::KnowledgeBase a, b;
+    a.plan().fill(plan, 0, "_0_p1");
+    b.plan().fill(reordered, 0, "_0_p1");
+
+    BOOST_REQUIRE_EQUAL(a.activities().size(), b.activities().size());
+    BOOST_REQUIRE_EQUAL(
+        b.activities().get("activity2_0_p1")->second.rules().size(), 2);
+
+    std::ostringstream ga, gb;
+    ga << a.activities().precedencesGraph();
+    gb << b.activities().precedencesGraph();
+    BOOST_REQUIRE_EQUAL(ga.str(), gb.str());
+}
+
+BOOST_AUTO_TEST_CASE(test_planparser_atomic)
+{
+    vle::Init app;
+
+    // The last `;' of the precedences is removed.
+    std::string broken(vmd::ex::Plan1);
+    broken.erase(broken.rfind(';'), 1);
+
+    vmd::ex::KnowledgeBase a;
+    a.plan().fill(std::string(vmd::ex::Plan1), 0, "_0_p1");
+    const vmd::Activities::size_type activities = a.activities().size();
+    const vmd::Rules::size_type rules = a.rules().size();
+    std::ostringstream before;
+    before << a.activities().precedencesGraph();
+
+    BOOST_REQUIRE_THROW(a.plan().fill(broken, 0, "_0_p2"),
+                        vle::utils::ArgError);
+    BOOST_REQUIRE_EQUAL(a.activities().size(), activities);
+    BOOST_REQUIRE_EQUAL(a.rules().size(), rules);
+    BOOST_REQUIRE(not a.activities().exist("activity1_0_p2"));
+
+    std::ostringstream after;
+    after << a.activities().precedencesGraph();
+    BOOST_REQUIRE_EQUAL(before.str(), after.str());
+
+    vmd::ex::KnowledgeBase b;
+    BOOST_REQUIRE_THROW(b.plan().fill(broken, 0), vle::utils::ArgError);
+    BOOST_REQUIRE_EQUAL(b.activities().size(), 0u);
+    BOOST_REQUIRE_EQUAL(b.rules().size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_sharedrules)
+{
+    vle::Init app;
+
+    vmd::ex::KnowledgeBase b;
+    b.plan().fill(std::string(vmd::ex::Plan1));
+
+    const vmd::Activity& a1 = b.activities().get("activity1")->second;
+    const vmd::Activity& a2 = b.activities().get("activity2")->second;
+    BOOST_REQUIRE_EQUAL(&a1.rules().get("rule 1"), &b.rules().get("rule 1"));
+    BOOST_REQUIRE_EQUAL(&a2.rules().get("rule 1"), &b.rules().get("rule 1"));
+    BOOST_REQUIRE_EQUAL(a1.rules().apply("activity1").size(),
+                        (vmd::Rules::size_type)2);
+    BOOST_REQUIRE_THROW(a1.rules().get("rule 3"), vle::utils::ArgError);
+
+    vmd::Activity x(a1);
+    x.addRule("own", vmd::Rule());
+    BOOST_REQUIRE_THROW(x.addRule("rule 1"), vle::utils::ArgError);
+    BOOST_REQUIRE_EQUAL(x.rules().size(), (vmd::Rules::size_type)3);
+    BOOST_REQUIRE_EQUAL(a1.rules().size(), (vmd::Rules::size_type)2);
+
+    vmd::Activity y(x);
+    y.addRule("other");
+    BOOST_REQUIRE_EQUAL(x.rules().size(), (vmd::Rules::size_type)3);
+    BOOST_REQUIRE_EQUAL(y.rules().size(), (vmd::Rules::size_type)4);
+    BOOST_REQUIRE(&x.rules().get("own") != &y.rules().get("own"));
+    BOOST_REQUIRE_EQUAL(&y.rules().get("rule 2"), &b.rules().get("rule 2"));
+
+    vle::devs::ExternalEventList events;
+    y.acknowledge("activity1");
+    y.output("activity1", events);
+    BOOST_REQUIRE_EQUAL(b.getNumberOfAck(), 1);
+    BOOST_REQUIRE_EQUAL(b.getNumberOfOut(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_staticplan)
+{
+    vle::Init app;
+
+    vmd::ex::KnowledgeBaseStatic b;
+    b.fill(10.0);
+
+    BOOST_REQUIRE_EQUAL(b.rules().size(), (vmd::Rules::size_type)3);
+    BOOST_REQUIRE(b.rules().get("r1").isAvailable("a", "r1"));
+    BOOST_REQUIRE(not b.rules().get("r2").isAvailable("b", "r2"));
+    BOOST_REQUIRE(b.rules().get("r3").isAvailable("a", "r3"));
+
+    const vmd::Activity& a = b.activities().get("a")->second;
+    BOOST_REQUIRE_EQUAL(a.rules().size(), (vmd::Rules::size_type)2);
+    BOOST_REQUIRE_EQUAL(a.minstart(), 20.0);
+    BOOST_REQUIRE_EQUAL(a.maxfinish(), vle::devs::infinity);
+
+    const vmd::Activity& bb = b.activities().get("b")->second;
+    BOOST_REQUIRE_EQUAL(bb.rules().size(), (vmd::Rules::size_type)1);
+    BOOST_REQUIRE_EQUAL(bb.minstart(), 5.0);
+    BOOST_REQUIRE_EQUAL(bb.maxfinish(), 100.0);
+
+    const vmd::Activity& c = b.activities().get("c")->second;
+    BOOST_REQUIRE_EQUAL(c.maxfinish(), 365.0 + 32.0);
+
+    vmd::ex::KnowledgeBase t;
+    t.plan().fill(std::string(vmd::ex::StaticEquivalentPlan), 10.0);
+    std::ostringstream gb, gt;
+    gb << b.activities().precedencesGraph();
+    gt << t.activities().precedencesGraph();
+    BOOST_REQUIRE_EQUAL(gb.str(), gt.str());
+
+    vmd::ex::KnowledgeBaseStatic e;
+    BOOST_REQUIRE_THROW(e.fillBadIndex(), vle::utils::ArgError);
+}
@@ -118,3 +118,87 @@ BOOST_AUTO_TEST_CASE(ss)
         BOOST_REQUIRE(B.isInStartedState());
     }
 }
+
+static void setState(vmd::Activity& activity, vmd::Activity::State state,
+                     double started, double ff, double done)
+{
+    activity.start(started);
+    activity.ff(ff);
+    activity.end(done);
+
+    switch (state) {
+    case vmd::Activity::WAIT: activity.wait(); break;
+    case vmd::Activity::STARTED: activity.start(started); break;
+    case vmd::Activity::FF: activity.ff(ff); break;
+    case vmd::Activity::DONE: activity.end(done); break;
+    case vmd::Activity::FAILED: activity.fail(done); break;
+    }
+}
+
+static void compareIsValid(const vmd::PrecedenceConstraint& pc, double time)
+{
+    vmd::PrecedenceConstraint::Result result, expected;
+    bool thrown = false, expectedThrown = false;
+
+    try {
+        result = pc.isValid(time);
+    } catch (const vle::utils::InternalError& /*e*/) {
+        thrown = true;
+    }
+
+    try {
+        expected = pc.isValidReference(time);
+    } catch (const vle::utils::InternalError& /*e*/) {
+        expectedThrown = true;
+    }
+
+    BOOST_REQUIRE_EQUAL(thrown, expectedThrown);
+    if (not thrown) {
+        BOOST_REQUIRE(result.first == expected.first);
+        BOOST_REQUIRE(result.second == expected.second);
+    }
+}
+
+/**
+ * Check the transition table of the isValid function against the nested
+ * switch implementation for all the types, the states and a set of dates.
+ */
+BOOST_AUTO_TEST_CASE(isValid_table)
+{
+    vmd::Activities acts;
+    acts.add("A");
+    acts.add("B");
+
+    vmd::Activities::iterator a = acts.get("A");
+    vmd::Activities::iterator b = acts.get("B");
+
+    const vmd::PrecedenceConstraint::Type types[] = {
+        vmd::PrecedenceConstraint::SS, vmd::PrecedenceConstraint::FS,
+        vmd::PrecedenceConstraint::FF };
+    const vmd::Activity::State states[] = { vmd::Activity::WAIT,
+        vmd::Activity::STARTED, vmd::Activity::FF, vmd::Activity::DONE,
+        vmd::Activity::FAILED };
+    const double dates[] = { 0.0, 1.0, 2.5, vle::devs::infinity };
+    const double lags[][2] = { { 0.0, 0.0 }, { 0.0, 1.0 }, { 1.0, 1.0 },
+        { 1.0, 3.0 }, { 3.0, 3.0 }, { 0.0, vle::devs::infinity } };
+    const double times[] = { -1.0, 0.0, 0.5, 1.0, 2.0, 2.5, 3.0, 3.5, 4.0,
+        5.0, 7.0, vle::devs::infinity };
+
+    for (int t = 0; t < 3; ++t)
+    for (int l = 0; l < 6; ++l) {
+        vmd::PrecedenceConstraint pc(a, b, types[t], lags[l][0], lags[l][1]);
+
+        for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 5; ++j)
+        for (int s = 0; s < 4; ++s)
+        for (int f = 0; f < 4; ++f)
+        for (int d = 0; d < 4; ++d) {
+            setState(a->second, states[i], dates[s], dates[f], dates[d]);
+            setState(b->second, states[j], dates[d], dates[s], dates[f]);
+
+            for (int k = 0; k < 12; ++k) {
+                compareIsValid(pc, times[k]);
+            }
+        }
+    }
+}